@@ -0,0 +1,48 @@
+# Generates precalculated conversion tables for GammaConverter_PlainGamma.
+# Formulas and rounding are the same as in GammaConverter_PlainGamma.cpp,
+# so precalculated tables are equal to tables built at runtime.
+# Output files are written to the working directory and included from Source/data.
+
+import math
+
+MAX_8BIT = 255
+MAX_16BIT = 65535
+WIDTH_8BIT = 256
+WIDTH_16BIT = 65536
+
+GAMMAS = [1.8, 2.2, 2.4]
+
+
+def lround(value):
+    # Same as std::lround for non-negative values: halves are rounded away from zero
+    return int(math.floor(value + 0.5))
+
+
+def clamp(value, max_value):
+    return min(max(value, 0), max_value)
+
+
+def to_linear(value, max_value, gamma):
+    return clamp(lround(math.pow(value / max_value, gamma) * MAX_16BIT), MAX_16BIT)
+
+
+def to_gamma(linear_value, max_value, gamma):
+    return clamp(lround(math.pow(linear_value / MAX_16BIT, 1.0 / gamma) * max_value), max_value)
+
+
+def write_table(file_name, values):
+    with open(file_name, "w", newline="\n") as file:
+        file.write(",\n".join(str(v) for v in values))
+
+
+def gamma_name(gamma):
+    # 2.2 -> "22"
+    return ("%.1f" % gamma).replace(".", "")
+
+
+for gamma in GAMMAS:
+    name = gamma_name(gamma)
+    write_table("table_Gamma%stoLinear_8.data" % name, [to_linear(v, MAX_8BIT, gamma) for v in range(WIDTH_8BIT)])
+    write_table("table_Gamma%stoLinear_16.data" % name, [to_linear(v, MAX_16BIT, gamma) for v in range(WIDTH_16BIT)])
+    write_table("table_LinearToGamma%s_8.data" % name, [to_gamma(v, MAX_8BIT, gamma) for v in range(WIDTH_16BIT)])
+    write_table("table_LinearToGamma%s_16.data" % name, [to_gamma(v, MAX_16BIT, gamma) for v in range(WIDTH_16BIT)])
@@ -0,0 +1,47 @@
+# Polynomial coefficients for FloatGammaConverter fast log2/exp2.
+# Polynomials interpolate the function at Chebyshev nodes, which is close to minimax.
+#   log2(1 + t) = t * P(t),    t in [0, 1)
+#   exp2(f) = Q(f),             f in [0, 1)
+# Prints coefficients from the constant term up and maximum errors on a dense grid.
+import math
+
+def chebyshev_fit(func, a, b, degree):
+    n = degree + 1
+    nodes = [0.5 * (a + b) + 0.5 * (b - a) * math.cos(math.pi * (k + 0.5) / n) for k in range(n)]
+    values = [func(x) for x in nodes]
+    # Solving Vandermonde system with Gaussian elimination
+    rows = [[x ** p for p in range(n)] + [v] for x, v in zip(nodes, values)]
+    for col in range(n):
+        pivot = max(range(col, n), key=lambda r: abs(rows[r][col]))
+        rows[col], rows[pivot] = rows[pivot], rows[col]
+        for r in range(n):
+            if r != col:
+                factor = rows[r][col] / rows[col][col]
+                rows[r] = [rv - factor * cv for rv, cv in zip(rows[r], rows[col])]
+    return [rows[i][n] / rows[i][i] for i in range(n)]
+
+def horner(coefs, x):
+    result = 0.0
+    for c in reversed(coefs):
+        result = result * x + c
+    return result
+
+def log2_ratio(t):
+    return 1.0 / math.log(2.0) if t == 0.0 else math.log2(1.0 + t) / t
+
+LOG2_DEGREE = 7
+EXP2_DEGREE = 5
+
+log2_coefs = chebyshev_fit(log2_ratio, 0.0, 1.0, LOG2_DEGREE)
+exp2_coefs = chebyshev_fit(lambda f: 2.0 ** f, 0.0, 1.0, EXP2_DEGREE)
+
+grid = [i / 100000.0 for i in range(100001)]
+log2_error = max(abs(t * horner(log2_coefs, t) - math.log2(1.0 + t)) for t in grid[:-1])
+exp2_error = max(abs(horner(exp2_coefs, f) / 2.0 ** f - 1.0) for f in grid[:-1])
+
+print("log2 coefficients (degree %d):" % LOG2_DEGREE)
+print(",\n".join("%.9ef" % c for c in log2_coefs))
+print("max absolute error: %.3e" % log2_error)
+print("exp2 coefficients (degree %d):" % EXP2_DEGREE)
+print(",\n".join("%.9ef" % c for c in exp2_coefs))
+print("max relative error: %.3e" % exp2_error)
@@ -17,6 +17,9 @@
 int main()
 {
 	try {
+		//Building sRGB tables before any test so they are not counted in the first measurement
+		GammaDispatcher::WarmUp(RawImageGammaProfile::sRGB, NULL);
+
 		if (false) {
 			Tester_IO::TestJpegReader("parrot.jpg");
 		}
@@ -53,14 +56,94 @@ int main()
 			Tester_IO::TestPngReaderByChunks("parrot_RGB_16bit_sRGB.png", 117);
 		}
 
+		if (false) {
+			Tester_IO::TestJpegTransform("parrot.jpg");
+		}
+
+		if (false) {
+			Tester_IO::TestJpegRequantize("parrot.jpg");
+		}
+
+		if (false) {
+			Tester_IO::TestJpegTransformMetadata("parrot.jpg");
+		}
+
+		if (false) {
+			Tester_IO::BenchmarkJpegBackends("parrot.jpg", 20);
+		}
+
+		if (false) {
+			Tester_IO::BenchmarkDecodeProfiles("parrot.jpg", "parrot_RGB_16bit_sRGB.png", 20);
+		}
+
+		if (false) {
+			Tester_IO::BenchmarkEncoderProfiles("parrot.jpg", "parrot_RGB_16bit_sRGB.png", 10);
+		}
+
+		if (false) {
+			Tester_IO::TestJpegToSize("parrot.jpg", 320);
+		}
+
+		if (false) {
+			Tester_IO::TestJpegBandDecoding("parrot.jpg");
+		}
+
+		if (false) {
+			Tester_IO::TestJpegReducedMultiScan("parrot.jpg", 200);
+		}
+
+		if (false) {
+			Tester_IO::TestImageProbe();
+		}
+
 		if (false) {
 			Tester_Gamma::TestSRGBConversion("parrot.jpg");
 		}
 
+		if (false) {
+			Tester_Gamma::BenchmarkSRGBConversion("parrot.jpg", 20);
+		}
+
+		if (false) {
+			Tester_Gamma::BenchmarkGrayscaleConversion("parrot.jpg", 20);
+		}
+
+		if (false) {
+			Tester_Gamma::BenchmarkFloatConversion("parrot_RGB_16bit_sRGB.png", 20);
+		}
+
+		if (false) {
+			Tester_Gamma::TestSlicedLinearization("parrot_RGB_16bit_sRGB.png", 64, 0.25);
+		}
+
+		if (false) {
+			Tester_Gamma::TestRowKernels(100);
+		}
+
 		if (false) {
 			Tester_DS::Test_DownscalerSliced(2842, 0.33, "parrot.jpg");
 		}
 
+		if (false) {
+			Tester_DS::Test_DownscaleReduced(0.1, "parrot.jpg");
+		}
+
+		if (false) {
+			Tester_DS::Test_DownscalePlanar(0.25, "parrot.jpg");
+		}
+
+		if (false) {
+			Tester_DS::Test_DownscalePooled(256, 0.33, 3, "parrot.jpg");
+		}
+
+		if (false) {
+			Tester_DS::Test_DownscaleStreamed(128, 0.33, 4, "parrot.jpg");
+		}
+
+		if (false) {
+			Tester_DS::Test_AppendSlices(64, 500, 1000);
+		}
+
 		if (false) {
 			Tester_Gauss::TestValue32(20, true);
 			Tester_Gauss::TestValue32(10000000, false);
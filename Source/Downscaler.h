@@ -32,33 +32,81 @@ public:
 	/// New height and width should be less or equal to the old ones.
 	/// </summary>
 	Downscaler(ImagePixelLayout layout, uint32_t src_height, uint32_t src_width, uint32_t new_height, uint32_t new_width) :
+		Downscaler(layout, src_height, src_width, new_height, new_width, ExifOrientation::EO_NORMAL) {
+	}
+
+	/// <summary>
+	/// Builds new Downscaler object for specified image and scaling that also brings the image to upright orientation.
+	/// New height and width are given for the upright (output) image, so for orientations 5-8 they are swapped relative to the source.
+	/// Source width and height should be less than 2^16 = 65536 (not inclusive).
+	/// </summary>
+	/// <remarks>
+	/// Orientation is applied at output resolution.
+	/// Horizontal mirroring is done by reversing destination table for columns, so output is still streamed slice by slice.
+	/// Vertical mirroring and transposition move source rows to the end or to columns of the output,
+	/// so for those orientations downscaled rows are collected in output sized buffer and returned all at once with the last slice.
+	/// </remarks>
+	Downscaler(ImagePixelLayout layout, uint32_t src_height, uint32_t src_width, uint32_t new_height, uint32_t new_width, ExifOrientation orientation) :
+		Downscaler(layout, src_height, src_width, new_height, new_width, orientation, nullptr) {
+	}
+
+	/// <summary>
+	/// Builds new Downscaler object that allocates intermediate and resulting buffers from given memory resource.
+	/// Memory resource should outlive the downscaler and returned buffers, null memory resource means global heap.
+	/// See other constructors for the rest of arguments.
+	/// </summary>
+	Downscaler(ImagePixelLayout layout, uint32_t src_height, uint32_t src_width, uint32_t new_height, uint32_t new_width, ExifOrientation orientation, std::pmr::memory_resource* memory) :
 		_layout(layout),
 		_src_height(src_height),
 		_src_width(src_width),
-		_trg_height(new_height),
-		_trg_width(new_width) 
+		_trg_height(orientation >= ExifOrientation::EO_TRANSPOSE ? new_width : new_height),
+		_trg_width(orientation >= ExifOrientation::EO_TRANSPOSE ? new_height : new_width),
+		_out_height(new_height),
+		_out_width(new_width),
+		_orientation(orientation),
+		_memory(memory),
+		_hcompressed(0, 0, layout, false, memory),
+		_compressed(0, 0, layout, false, memory),
+		_averaged(0, 0, layout, false, memory)
 	{
 		if (layout == ImagePixelLayout::UNDEF)
 			throw new std::runtime_error("Downscaler init: Cannot downscale image with undefined layout.");
 
+		if (orientation < ExifOrientation::EO_NORMAL || orientation > ExifOrientation::EO_ROTATE_90_CCW)
+			throw new std::invalid_argument("Downscaler init: Unknown orientation.");
+
+		// Decomposing orientation into column mirroring, row mirroring and transposition (applied in that order)
+		_mirror_cols = orientation == EO_MIRROR_H || orientation == EO_ROTATE_180 || orientation == EO_TRANSVERSE || orientation == EO_ROTATE_90_CCW;
+		_mirror_rows = orientation == EO_ROTATE_180 || orientation == EO_MIRROR_V || orientation == EO_ROTATE_90_CW || orientation == EO_TRANSVERSE;
+		_transpose = orientation >= ExifOrientation::EO_TRANSPOSE;
+
 		_destinations_for_rows = new uint32_t[_src_height * 2];
 		_destinations_for_cols = new uint32_t[_src_width * 2];
 			
 		_weigths_for_rows = new fxdfrc_t[_src_height * 2];
 		_weigths_for_cols = new fxdfrc_t[_src_width * 2];
 
-		_partial_row = new uint32_t[new_width * NumComponentsOfLayout(_layout)];
+		_partial_row = new uint32_t[_trg_width * NumComponentsOfLayout(_layout)];
 		ResetPartialRow();
 
-		_frame_height = (static_cast<uint32_t>(_src_height) << 16) / new_height;
-		_frame_width = (static_cast<uint32_t>(_src_width) << 16) / new_width;
+		_frame_height = (static_cast<uint32_t>(_src_height) << 16) / _trg_height;
+		_frame_width = (static_cast<uint32_t>(_src_width) << 16) / _trg_width;
 		uint64_t temp = static_cast<uint64_t>(_frame_height) * static_cast<uint64_t>(_frame_width);
 		if ((temp >> 32) > 65536)
 			throw std::runtime_error("Downscaler: Scaling factor is too small - uint overflow is possible. Do not downscale to less than 1/256 in one step.");
 		_frame_area = static_cast<uint32_t>(temp >> 16);
 
-		FindDestinations(_destinations_for_rows, _weigths_for_rows, _src_height, new_height, _frame_height);
-		FindDestinations(_destinations_for_cols, _weigths_for_cols, _src_width, new_width, _frame_width);
+		FindDestinations(_destinations_for_rows, _weigths_for_rows, _src_height, _trg_height, _frame_height);
+		FindDestinations(_destinations_for_cols, _weigths_for_cols, _src_width, _trg_width, _frame_width);
+
+		// Horizontal mirroring costs nothing - columns are accumulated directly into mirrored positions
+		if (_mirror_cols)
+			for (uint32_t dest_index = 0; dest_index < _src_width * 2; dest_index++)
+				_destinations_for_cols[dest_index] = _trg_width - 1 - _destinations_for_cols[dest_index];
+
+		// Output sized buffer for orientations that can not be streamed
+		if (_mirror_rows || _transpose)
+			_oriented = ImageBuffer_uint16(_out_height, _out_width, _layout, true, _memory);
 
 		// Setting state
 		SetState_Start();
@@ -76,14 +124,33 @@ public:
 	}
 
 	/// <summary>
-	/// 
+	/// Downscales next slice of the source image and returns resulting rows.
+	/// Number of returned rows depends on how many target rows are completed by this slice (can be 0).
+	/// </summary>
+	ImageBuffer_uint16 DownscaleNext(const ImageBufferView_uint16& slice) {
+		if (CheckStateForNext() == false)
+			return ImageBuffer_uint16(0, _out_width, _layout, false, _memory);
+
+		ImageBuffer_uint16 downscaled(0, _out_width, _layout, false, _memory);
+		DownscaleNextInto(slice, downscaled);
+		return downscaled;
+	}
+
+	/// <summary>
+	/// Downscales next slice of the source image and writes resulting rows into caller provided buffer.
+	/// Buffer is reshaped to the number of completed target rows (can be 0) reusing its memory when possible.
+	/// Intermediate buffers are kept by the downscaler between calls, so streaming slices of the same height
+	/// does not allocate after the first slice.
+	/// If orientation requires vertical mirroring or transposition rows are returned all at once with the last slice.
 	/// </summary>
-	ImageBuffer_uint16 DownscaleNext(const ImageBuffer_uint16& slice) {
+	void DownscaleNextInto(const ImageBufferView_uint16& slice, ImageBuffer_uint16& downscaled) {
 		// 0) --------------------------------------------------------------------------------
 		// Checking state and argument
 
-		if (CheckStateForNext() == false)
-			return ImageBuffer_uint16(0, _trg_width, _layout, false);
+		if (CheckStateForNext() == false) {
+			downscaled.Reshape(0, _out_width, _layout);
+			return;
+		}
 
 		if (slice.GetLayout() != _layout)
 			throw new std::invalid_argument("Downscaler: Chunk layout mismatch.");
@@ -97,43 +164,37 @@ public:
 		// 1) --------------------------------------------------------------------------------
 		// Compressing horizontally
 
-		ImageBuffer_uint32 hcompressed;
-
-		// If scaling is only vertical we skip horizontal compression
-		if (_src_width == _trg_width) {
-			hcompressed = ImageBuffer_uint32(slice.GetHeight(), slice.GetWidth(), _layout, true);
+		// If scaling is only vertical we skip horizontal compression (unless columns are mirrored by the destination table)
+		if (_src_width == _trg_width && !_mirror_cols) {
+			_hcompressed.Reshape(slice.GetHeight(), slice.GetWidth(), _layout);
 			for (uint32_t row = 0; row < slice.GetHeight(); row++)
 				for (uint32_t cmp = 0; cmp < slice.GetCmpWidth(); cmp++)
-					hcompressed[row][cmp] = static_cast<uint32_t>(slice[row][cmp]);
+					_hcompressed[row][cmp] = static_cast<uint32_t>(slice[row][cmp]);
 		}
 		else
-			hcompressed = CompressHorizontally(slice);
+			CompressHorizontally(slice, _hcompressed);
 
 		// 2) --------------------------------------------------------------------------------
 		// Compressing vertically
 
-		ImageBuffer_uint32 compressed;
-
 		if (_src_height == _trg_height) {
-			compressed = ImageBuffer_uint32(hcompressed.GetHeight(), hcompressed.GetWidth(), hcompressed.GetLayout(), true);
-			for (uint32_t row = 0; row < hcompressed.GetHeight(); row++)
-				for (uint32_t cmp = 0; cmp < hcompressed.GetCmpWidth(); cmp++)
-					compressed[row][cmp] = hcompressed[row][cmp];
+			_compressed.Reshape(_hcompressed.GetHeight(), _hcompressed.GetWidth(), _hcompressed.GetLayout());
+			for (uint32_t row = 0; row < _hcompressed.GetHeight(); row++)
+				for (uint32_t cmp = 0; cmp < _hcompressed.GetCmpWidth(); cmp++)
+					_compressed[row][cmp] = _hcompressed[row][cmp];
 		}
 		else
-			compressed = CompressNextVertically(hcompressed);
-
-		// This version is no longer needed
-		hcompressed.~ImageBuffer(); 
+			CompressNextVertically(_hcompressed, _compressed);
 
 		// 3) --------------------------------------------------------------------------------
 		// Averaging
 
-		ImageBuffer_uint16 downscaled = AverageDown(compressed);
-
-		// Area of the frame
-		uint64_t temp = static_cast<uint64_t>(_frame_height) * static_cast<uint64_t>(_frame_width);
-		fxdfrc_t area = static_cast<uint32_t>(temp >> 16);
+		if (!_mirror_rows && !_transpose)
+			AverageDown(_compressed, downscaled);
+		else {
+			AverageDown(_compressed, _averaged);
+			PlaceOriented(_averaged);
+		}
 
 		// 4) --------------------------------------------------------------------------------
 		// Advancing the state
@@ -146,7 +207,15 @@ public:
 		if (_next_row_index >= _src_height)
 			SetState_Finished();
 
-		return downscaled;
+		// 5) --------------------------------------------------------------------------------
+		// Returning oriented image
+
+		if (_mirror_rows || _transpose) {
+			if (_state == SliceProcessorState::Finished)
+				downscaled = std::move(_oriented);
+			else
+				downscaled.Reshape(0, _out_width, _layout);
+		}
 	}
 
 
@@ -163,8 +232,17 @@ protected:
 	uint32_t _src_height = 0;
 	uint32_t _src_width = 0;
 
-	uint32_t _trg_height = 0;
-	uint32_t _trg_width = 0;
+	uint32_t _trg_height = 0; //Target height before orientation is applied
+	uint32_t _trg_width = 0; //Target width before orientation is applied
+
+	uint32_t _out_height = 0; //Height of upright output image
+	uint32_t _out_width = 0; //Width of upright output image
+
+	ExifOrientation _orientation = ExifOrientation::EO_NORMAL;
+	bool _mirror_cols = false; //Columns are mirrored by destination table
+	bool _mirror_rows = false; //Rows are mirrored when placed to the output buffer
+	bool _transpose = false; //Rows become columns when placed to the output buffer
+	uint32_t _trg_rows_done = 0; //Number of target rows already placed to the output buffer
 
 	uint32_t* _destinations_for_rows = nullptr; //Destination row indices for rows
 	uint32_t* _destinations_for_cols = nullptr; //Destination column indices for columns
@@ -179,16 +257,22 @@ protected:
 
 	uint32_t _next_row_index = 0;
 
+	std::pmr::memory_resource* _memory = nullptr; //Memory resource for intermediate and resulting buffers, null means global heap
+	ImageBuffer_uint32 _hcompressed; //Scratch buffer for horizontally compressed slice, reused between slices
+	ImageBuffer_uint32 _compressed; //Scratch buffer for compressed slice, reused between slices
+	ImageBuffer_uint16 _averaged; //Scratch buffer for averaged rows before orientation is applied
+	ImageBuffer_uint16 _oriented; //Output buffer for orientations that can not be streamed
+
 	//--------------------------------
 	//	PRIVATE METHODS
 	//--------------------------------
 
-	ImageBuffer_uint16 AverageDown(const ImageBuffer_uint32& src_image) {
+	void AverageDown(const ImageBuffer_uint32& src_image, ImageBuffer_uint16& trg_image) {
 		//Alias for lambda capture
 		fxdfrc_t area = _frame_area;
 
 		// Result
-		ImageBuffer_uint16 trg_image(src_image.GetHeight(), src_image.GetWidth(), src_image.GetLayout(), true);
+		trg_image.Reshape(src_image.GetHeight(), src_image.GetWidth(), src_image.GetLayout());
 
 		//Creating task for each row
 		tbb::task_group tg;
@@ -207,8 +291,34 @@ protected:
 		}
 		//Waiting for tasks to finish
 		tg.wait();
-		
-		return trg_image;
+	}
+
+
+	/// <summary>
+	/// Places downscaled rows (already mirrored horizontally) to the output buffer
+	/// mirroring rows and transposing if required by the orientation.
+	/// Works on output resolution.
+	/// </summary>
+	void PlaceOriented(const ImageBuffer_uint16& rows) {
+		int num_cmp = NumComponentsOfLayout(_layout);
+
+		for (uint32_t row = 0; row < rows.GetHeight(); row++) {
+			uint32_t trg_row = _trg_rows_done + row;
+			uint32_t oriented_row = _mirror_rows ? _trg_height - 1 - trg_row : trg_row;
+
+			if (_transpose) {
+				// Row of the downscaled image becomes column of the output
+				for (uint32_t col = 0; col < rows.GetWidth(); col++)
+					for (int cmp = 0; cmp < num_cmp; cmp++)
+						_oriented[col][oriented_row * num_cmp + cmp] = rows[row][col * num_cmp + cmp];
+			}
+			else {
+				for (uint32_t cmp = 0; cmp < rows.GetCmpWidth(); cmp++)
+					_oriented[oriented_row][cmp] = rows[row][cmp];
+			}
+		}
+
+		_trg_rows_done += rows.GetHeight();
 	}
 
 
@@ -302,7 +412,7 @@ protected:
 
 
 
-	ImageBuffer_uint32 CompressNextVertically(const ImageBuffer_uint32& src_slice) {
+	void CompressNextVertically(const ImageBuffer_uint32& src_slice, ImageBuffer_uint32& trg_image) {
 		// Aliases for lambda captures
 		uint32_t* partial_row = _partial_row;
 		uint32_t* destinations_rows = _destinations_for_rows;
@@ -355,7 +465,8 @@ protected:
 			CompressToLine(src_slice, _partial_row);
 
 			// Returning empty image buffer
-			return ImageBuffer_uint32(0, src_slice.GetWidth(), src_slice.GetLayout(), false);
+			trg_image.Reshape(0, src_slice.GetWidth(), src_slice.GetLayout());
+			return;
 		}
 
 		// 3) --------------------------------------------------------------------------------
@@ -363,7 +474,7 @@ protected:
 		// Now we know that there is at least one line to output
 		
 		// Allocating the result
-		ImageBuffer_uint32 trg_image(trg_height, src_slice.GetWidth(), src_slice.GetLayout(), true);
+		trg_image.Reshape(trg_height, src_slice.GetWidth(), src_slice.GetLayout());
 		trg_image.SetToZero();
 
 		// Copying contents of previously accumulated partial row
@@ -694,8 +805,6 @@ protected:
 			default:
 				break;
 		}
-
-		return trg_image;
 	}
 
 
@@ -704,9 +813,9 @@ protected:
 	/// Compresses the image horizontally to given width.
 	/// In the returned image value of each pixel is the accumulated sum of values of corresponding pixels in the same row of original image.
 	/// </summary>
-	/// <param name="src_image"></param>
-	/// <returns></returns>
-	ImageBuffer_uint32 CompressHorizontally(const ImageBuffer_uint16& src_image) {
+	/// <param name="src_image">Source slice.</param>
+	/// <param name="trg_image">Buffer for the result, reshaped to the slice height and target width.</param>
+	void CompressHorizontally(const ImageBufferView_uint16& src_image, ImageBuffer_uint32& trg_image) {
 
 		//Aliases
 		int src_height = src_image.GetHeight();
@@ -716,7 +825,7 @@ protected:
 		uint32_t* weights_cols = _weigths_for_cols;
 
 		//Result
-		ImageBuffer_uint32 trg_image(src_height, _trg_width, layout, true);
+		trg_image.Reshape(src_height, _trg_width, layout);
 
 		//First we initialize all image values to 0
 		trg_image.SetToZero();
@@ -859,9 +968,6 @@ protected:
 			default:
 				break;
 		}
-
-		//Result
-		return trg_image;
 	}
 
 
@@ -0,0 +1,185 @@
+#include "FloatGammaConverter.h"
+
+//--------------------------------
+//	IMAGE CONVERSION
+//--------------------------------
+
+/// <summary>
+/// Converts 8 or 16 bit gamma-corrected image to float image with linear brightness [0..1].
+/// Alpha channel is scaled to [0..1] without conversion.
+/// </summary>
+ImageBuffer_float FloatGammaConverter::RemoveGammaCorrection(const ImageBufferView_Byte& image) const {
+	ImageBuffer_float linear_image(image.GetHeight(), image.GetWidth(), image.GetLayout(), false);
+	RemoveGammaCorrectionInto(image, linear_image);
+	return linear_image;
+}
+
+
+
+/// <summary>
+/// Converts 8 or 16 bit gamma-corrected image to float image with linear brightness [0..1]
+/// and writes the result into caller provided buffer reshaped to the size of the source image.
+/// <para>Throws std::invalid_argument if image is not 8 or 16 bit.</para>
+/// </summary>
+void FloatGammaConverter::RemoveGammaCorrectionInto(const ImageBufferView_Byte& image, ImageBuffer_float& linear_image) const {
+	if (image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+	if (image.GetBitPerComponent() != BitDepth::BD_8_BIT && image.GetBitPerComponent() != BitDepth::BD_16_BIT)
+		throw std::invalid_argument("FloatGammaConverter -- Only 8 and 16 bit images are supported.");
+
+	//Aliases
+	int image_width = image.GetWidth();
+	int num_cmp = image.GetNumCmp();
+	bool has_alpha = image.GetHasAlpha();
+	bool is_8bit = image.GetBitPerComponent() == BitDepth::BD_8_BIT;
+	const ImageBufferView_Byte& data = image; //View rows can start in the middle of buffer rows
+
+	linear_image.Reshape(image.GetHeight(), image_width, image.GetLayout());
+	float** linear_data = linear_image.GetDataPtr();
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, image.GetHeight()), [&](const tbb::blocked_range<int>& range) {
+		for (int row = range.begin(); row < range.end(); row++) {
+			if (is_8bit)
+				RemoveRow(data[row], linear_data[row], image_width, num_cmp, has_alpha);
+			else
+				RemoveRow(reinterpret_cast<const uint16_t*>(data[row]), linear_data[row], image_width, num_cmp, has_alpha);
+		}
+	});
+}
+
+
+
+/// <summary>
+/// Converts float image with linear brightness [0..1] to gamma-corrected image of given bit depth.
+/// Values outside of [0..1] are clamped. Alpha channel is scaled without conversion.
+/// </summary>
+ImageBuffer_Byte FloatGammaConverter::ApplyGammaCorrection(const ImageBufferView_float& linear_image, BitDepth bitDepth) const {
+	ImageBuffer_Byte image(linear_image.GetHeight(), linear_image.GetWidth(), linear_image.GetLayout(), bitDepth, false);
+	ApplyGammaCorrectionInto(linear_image, bitDepth, image);
+	return image;
+}
+
+
+
+/// <summary>
+/// Converts float image with linear brightness [0..1] to gamma-corrected image of given bit depth
+/// and writes the result into caller provided buffer. If buffer bit depth does not match bitDepth argument the buffer is replaced.
+/// <para>Throws std::invalid_argument if bit depth is not 8 or 16 bit.</para>
+/// </summary>
+void FloatGammaConverter::ApplyGammaCorrectionInto(const ImageBufferView_float& linear_image, BitDepth bitDepth, ImageBuffer_Byte& image) const {
+	if (bitDepth != BitDepth::BD_8_BIT && bitDepth != BitDepth::BD_16_BIT)
+		throw std::invalid_argument("FloatGammaConverter -- Only 8 and 16 bit images are supported.");
+	if (linear_image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+
+	//Aliases
+	int image_height = linear_image.GetHeight();
+	int image_width = linear_image.GetWidth();
+	int num_cmp = linear_image.GetNumCmp();
+	bool has_alpha = linear_image.GetHasAlpha();
+	const ImageBufferView_float& linear_data = linear_image; //View rows can start in the middle of buffer rows
+
+	//Preparing resulting image
+	if (image.GetBitPerComponent() == bitDepth)
+		image.Reshape(image_height, image_width, linear_image.GetLayout());
+	else
+		image = ImageBuffer_Byte(image_height, image_width, linear_image.GetLayout(), bitDepth);
+	uint8_t** data = image.GetDataPtr();
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, image_height), [&](const tbb::blocked_range<int>& range) {
+		for (int row = range.begin(); row < range.end(); row++) {
+			if (bitDepth == BitDepth::BD_8_BIT)
+				ApplyRow(linear_data[row], data[row], image_width, num_cmp, has_alpha);
+			else
+				ApplyRow(linear_data[row], reinterpret_cast<uint16_t*>(data[row]), image_width, num_cmp, has_alpha);
+		}
+	});
+}
+
+
+
+//--------------------------------
+//	ROW CONVERSION
+//--------------------------------
+
+/// <summary>
+/// Converts run of gamma-corrected samples [0..1] to linear brightness [0..1]. Source and destination can be the same.
+/// </summary>
+void FloatGammaConverter::ToLinearRow(const float* src, float* dst, int count) const {
+	//Profile is checked once per row so loops stay branch-free
+	if (_profile == RawImageGammaProfile::sRGB) {
+		for (int i = 0; i < count; i++)
+			dst[i] = SRGBToLinear(Clamp01(src[i]));
+	}
+	else {
+		float power = _power_toLinear;
+		for (int i = 0; i < count; i++)
+			dst[i] = FastPow(Clamp01(src[i]), power);
+	}
+}
+
+
+
+/// <summary>
+/// Converts run of linear samples [0..1] to gamma-corrected values [0..1]. Source and destination can be the same.
+/// </summary>
+void FloatGammaConverter::ToGammaRow(const float* src, float* dst, int count) const {
+	if (_profile == RawImageGammaProfile::sRGB) {
+		for (int i = 0; i < count; i++)
+			dst[i] = LinearToSRGB(Clamp01(src[i]));
+	}
+	else {
+		float power = _power_toGamma;
+		for (int i = 0; i < count; i++)
+			dst[i] = FastPow(Clamp01(src[i]), power);
+	}
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+/// <summary>
+/// Converts integer row to linear float row, alpha samples are only scaled.
+/// </summary>
+template <typename TSrc>
+void FloatGammaConverter::RemoveRow(const TSrc* src, float* dst, int width, int num_cmp, bool has_alpha) const {
+	constexpr float scale = sizeof(TSrc) == 1 ? 1.0f / 255.0f : 1.0f / 65535.0f;
+	int row_length = width * num_cmp;
+
+	//Whole row is normalized and converted, alpha is overwritten after
+	for (int i = 0; i < row_length; i++)
+		dst[i] = static_cast<float>(src[i]) * scale;
+	ToLinearRow(dst, dst, row_length);
+
+	if (has_alpha)
+		for (int px = 0; px < width; px++)
+			dst[px * num_cmp + num_cmp - 1] = static_cast<float>(src[px * num_cmp + num_cmp - 1]) * scale;
+}
+
+
+
+/// <summary>
+/// Converts linear float row to integer row, alpha samples are only scaled.
+/// </summary>
+template <typename TDst>
+void FloatGammaConverter::ApplyRow(const float* src, TDst* dst, int width, int num_cmp, bool has_alpha) const {
+	constexpr float max_value = sizeof(TDst) == 1 ? 255.0f : 65535.0f;
+	int row_length = width * num_cmp;
+
+	//Gamma-corrected values are computed in chunks that stay in L1 cache
+	constexpr int CHUNK_SIZE = 256;
+	float chunk[CHUNK_SIZE];
+	for (int start = 0; start < row_length; start += CHUNK_SIZE) {
+		int count = std::min(CHUNK_SIZE, row_length - start);
+		ToGammaRow(src + start, chunk, count);
+		for (int i = 0; i < count; i++)
+			dst[start + i] = static_cast<TDst>(chunk[i] * max_value + 0.5f);
+	}
+
+	if (has_alpha)
+		for (int px = 0; px < width; px++)
+			dst[px * num_cmp + num_cmp - 1] = static_cast<TDst>(Clamp01(src[px * num_cmp + num_cmp - 1]) * max_value + 0.5f);
+}
@@ -0,0 +1,221 @@
+#pragma once
+//STL
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+//Third party
+#include "oneapi/tbb.h"
+//Internal
+#include "ImageBuffer_Byte.h"
+
+/// <summary>
+/// Gamma converter for float linear-light processing with ImageBuffer_float.
+/// Transfer functions are evaluated directly instead of looked up, so conversions are plain arithmetic loops
+/// that compiler vectorizes at full SIMD width without gathers.
+/// </summary>
+/// <remarks>
+/// x^p is computed as exp2(p * log2(x)) with polynomial approximations of log2 on mantissa and exp2 on fraction,
+/// coefficients are generated by Math/Python/TransferFunction_Approximation.py.
+/// Both sRGB branches are computed and one is selected, so loops have no branches.
+///
+/// Maximum absolute error compared to double precision functions, measured on every float in [0..1]
+/// with and without FMA contraction of the polynomials (larger of the two is given):
+/// sRGB to linear 7.8e-7, linear to sRGB 3.3e-7, plain gamma 2.2 6.2e-7 and 1/2.2 2.3e-7.
+/// That is about 1/20 of 16 bit step, 8 and 16 bit values converted to float and back are restored exactly.
+///
+/// Supports sRGB and PlainGamma profiles.
+/// </remarks>
+class FloatGammaConverter {
+public:
+	//--------------------------------
+	//	GET/SET
+	//--------------------------------
+
+	RawImageGammaProfile GetProfile() const { return _profile; }
+	double GetGamma() const { return _gamma; }
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Builds converter for sRGB or plain gamma profile. Gamma is used only for plain gamma profile.
+	/// <para>Throws std::invalid_argument for other profiles or non-positive gamma.</para>
+	/// </summary>
+	FloatGammaConverter(RawImageGammaProfile profile, double gamma) :
+		_profile(profile),
+		_gamma(gamma),
+		_power_toLinear(static_cast<float>(gamma)),
+		_power_toGamma(static_cast<float>(1.0 / gamma))
+	{
+		if (profile != RawImageGammaProfile::sRGB && profile != RawImageGammaProfile::PlainGamma)
+			throw std::invalid_argument("FloatGammaConverter -- Only sRGB and plain gamma profiles are supported.");
+		if (profile == RawImageGammaProfile::PlainGamma && gamma <= 0.0)
+			throw std::invalid_argument("FloatGammaConverter -- Gamma should be positive.");
+	}
+
+	/// <summary>
+	/// Builds sRGB converter.
+	/// </summary>
+	FloatGammaConverter() : FloatGammaConverter(RawImageGammaProfile::sRGB, 2.4) {}
+
+	//--------------------------------
+	//	IMAGE CONVERSION
+	//--------------------------------
+
+	/// <summary>
+	/// Converts 8 or 16 bit gamma-corrected image to float image with linear brightness [0..1].
+	/// Alpha channel is scaled to [0..1] without conversion.
+	/// </summary>
+	ImageBuffer_float RemoveGammaCorrection(const ImageBufferView_Byte& corrected_image) const;
+
+	/// <summary>
+	/// Converts 8 or 16 bit gamma-corrected image to float image with linear brightness [0..1]
+	/// and writes the result into caller provided buffer reshaped to the size of the source image.
+	/// <para>Throws std::invalid_argument if image is not 8 or 16 bit.</para>
+	/// </summary>
+	void RemoveGammaCorrectionInto(const ImageBufferView_Byte& corrected_image, ImageBuffer_float& linear_image) const;
+
+	/// <summary>
+	/// Converts float image with linear brightness [0..1] to gamma-corrected image of given bit depth.
+	/// Values outside of [0..1] are clamped. Alpha channel is scaled without conversion.
+	/// </summary>
+	ImageBuffer_Byte ApplyGammaCorrection(const ImageBufferView_float& linear_image, BitDepth bitDepth) const;
+
+	/// <summary>
+	/// Converts float image with linear brightness [0..1] to gamma-corrected image of given bit depth
+	/// and writes the result into caller provided buffer. If buffer bit depth does not match bitDepth argument the buffer is replaced.
+	/// <para>Throws std::invalid_argument if bit depth is not 8 or 16 bit.</para>
+	/// </summary>
+	void ApplyGammaCorrectionInto(const ImageBufferView_float& linear_image, BitDepth bitDepth, ImageBuffer_Byte& corrected_image) const;
+
+	//--------------------------------
+	//	ROW CONVERSION
+	//--------------------------------
+
+	/// <summary>
+	/// Converts run of gamma-corrected samples [0..1] to linear brightness [0..1]. Source and destination can be the same.
+	/// </summary>
+	void ToLinearRow(const float* src, float* dst, int count) const;
+
+	/// <summary>
+	/// Converts run of linear samples [0..1] to gamma-corrected values [0..1]. Source and destination can be the same.
+	/// </summary>
+	void ToGammaRow(const float* src, float* dst, int count) const;
+
+	//--------------------------------
+	//	TRANSFER FUNCTIONS
+	//--------------------------------
+
+	/// <summary>
+	/// Approximate log2 for positive normal x, absolute error is below 1e-6. Zero gives -127.
+	/// </summary>
+	static inline float FastLog2(float x) {
+		uint32_t bits = std::bit_cast<uint32_t>(x);
+		float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+		float t = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u) - 1.0f;
+		//log2(1 + t) = t * P(t)
+		float p = -1.207702027e-02f;
+		p = p * t + 6.274843357e-02f;
+		p = p * t - 1.541520064e-01f;
+		p = p * t + 2.551763492e-01f;
+		p = p * t - 3.530963533e-01f;
+		p = p * t + 4.800124608e-01f;
+		p = p * t - 7.213067574e-01f;
+		p = p * t + 1.442694725e+00f;
+		return exponent + t * p;
+	}
+
+	/// <summary>
+	/// Approximate 2^x for x below 127, relative error is below 2e-7. Results below 2^-126 are flushed to zero.
+	/// </summary>
+	static inline float FastExp2(float x) {
+		//Offset makes truncation round toward minus infinity for x > -1024, fraction can be slightly negative after rounding of the sum
+		int32_t whole = static_cast<int32_t>(x + 1024.0f) - 1024;
+		float f = x - static_cast<float>(whole);
+		//2^f = Q(f)
+		float q = 1.893754058e-03f;
+		q = q * f + 8.949590423e-03f;
+		q = q * f + 5.586033708e-02f;
+		q = q * f + 2.401418182e-01f;
+		q = q * f + 6.931544897e-01f;
+		q = q * f + 9.999998984e-01f;
+		//Adding whole part to the exponent
+		float result = std::bit_cast<float>(std::bit_cast<uint32_t>(q) + (static_cast<uint32_t>(whole) << 23));
+		return Select(whole >= -126, result, 0.0f);
+	}
+
+	/// <summary>
+	/// Approximate x^p for x in [0..1].
+	/// </summary>
+	static inline float FastPow(float x, float p) {
+		return FastExp2(p * FastLog2(x));
+	}
+
+	/// <summary>
+	/// Clamps value to [0..1] on its bit pattern. NaN becomes 0 or 1 depending on its sign.
+	/// </summary>
+	/// <remarks>
+	/// Float comparisons can trap, so some compilers keep them as branches and do not vectorize the loop.
+	/// Non-negative floats are ordered the same as their bit patterns and negative floats have negative bit patterns as integers.
+	/// </remarks>
+	static inline float Clamp01(float x) {
+		int32_t bits = std::bit_cast<int32_t>(x);
+		bits = std::min(std::max(bits, 0), 0x3F800000);
+		return std::bit_cast<float>(bits);
+	}
+
+	/// <summary>
+	/// Returns a if condition is true and b otherwise, without a branch that could hold computation of a or b.
+	/// </summary>
+	static inline float Select(bool condition, float a, float b) {
+		uint32_t mask = 0u - static_cast<uint32_t>(condition);
+		return std::bit_cast<float>((std::bit_cast<uint32_t>(a) & mask) | (std::bit_cast<uint32_t>(b) & ~mask));
+	}
+
+	/// <summary>
+	/// sRGB value [0..1] to linear brightness [0..1]. Value should be clamped.
+	/// </summary>
+	static inline float SRGBToLinear(float value) {
+		float linear_segment = value * (1.0f / 12.92f);
+		float power_segment = FastPow((value + 0.055f) * (1.0f / 1.055f), 2.4f);
+		//Value is non-negative, so comparison of bit patterns is the same as comparison of values
+		return Select(std::bit_cast<int32_t>(value) <= std::bit_cast<int32_t>(0.04045f), linear_segment, power_segment);
+	}
+
+	/// <summary>
+	/// Linear brightness [0..1] to sRGB value [0..1]. Value should be clamped.
+	/// </summary>
+	static inline float LinearToSRGB(float linear) {
+		float linear_segment = linear * 12.92f;
+		float power_segment = 1.055f * FastPow(linear, 1.0f / 2.4f) - 0.055f;
+		return Select(std::bit_cast<int32_t>(linear) <= std::bit_cast<int32_t>(0.0031308f), linear_segment, power_segment);
+	}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	RawImageGammaProfile _profile = RawImageGammaProfile::sRGB;
+	double _gamma = 2.4;
+	float _power_toLinear = 2.4f;
+	float _power_toGamma = 1.0f / 2.4f;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Converts integer row to linear float row, alpha samples are only scaled.
+	/// </summary>
+	template <typename TSrc>
+	void RemoveRow(const TSrc* src, float* dst, int width, int num_cmp, bool has_alpha) const;
+
+	/// <summary>
+	/// Converts linear float row to integer row, alpha samples are only scaled.
+	/// </summary>
+	template <typename TDst>
+	void ApplyRow(const float* src, TDst* dst, int width, int num_cmp, bool has_alpha) const;
+};
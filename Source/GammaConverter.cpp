@@ -11,195 +11,89 @@
 /// Converts image with linear scale brightness values [0..65535] to gamma-corrected color space.
 /// Resulting image bit depth is specified in bitDepth argument.
 /// </summary>
-ImageBuffer_Byte GammaConverter::ApplyGammaCorrection(const ImageBuffer_uint16& linear_image, BitDepth bitDepth) {
+ImageBuffer_Byte GammaConverter::ApplyGammaCorrection(const ImageBufferView_uint16& linear_image, BitDepth bitDepth) {
+	//Allocating resulting image
+	ImageBuffer_Byte image(linear_image.GetHeight(), linear_image.GetWidth(), linear_image.GetLayout(), bitDepth);
+
+	ApplyGammaCorrectionInto(linear_image, bitDepth, image);
+
+	return image;
+}
+
+
+
+/// <summary>
+/// Converts image with linear scale brightness values [0..65535] to gamma-corrected color space
+/// and writes the result into caller provided buffer.
+/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+/// If buffer bit depth does not match bitDepth argument the buffer is replaced.
+/// </summary>
+void GammaConverter::ApplyGammaCorrectionInto(const ImageBufferView_uint16& linear_image, BitDepth bitDepth, ImageBuffer_Byte& image) {
 	//Aliases
 	int image_height = linear_image.GetHeight();
 	int image_width = linear_image.GetWidth();
-	uint16_t** linear_data = linear_image.GetDataPtr();
-
-	
-	//Allocating resulting image
-	ImageBuffer_Byte image(image_height, image_width, linear_image.GetLayout(), bitDepth);
+	int num_cmp = linear_image.GetNumCmp();
+	int row_length = linear_image.GetCmpWidth();
+	bool has_alpha = linear_image.GetHasAlpha();
+	const ImageBufferView_uint16& linear_data = linear_image; //View rows can start in the middle of buffer rows
+
+	//Preparing resulting image
+	if (image.GetBitPerComponent() == bitDepth)
+		image.Reshape(image_height, image_width, linear_image.GetLayout());
+	else
+		image = ImageBuffer_Byte(image_height, image_width, linear_image.GetLayout(), bitDepth);
 	uint8_t** data = image.GetDataPtr(); //Alias
 
+	if (linear_image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+
 	//Depending on bit depth
 	if (bitDepth == BitDepth::BD_8_BIT) { //8 bit
-		//Checking if conversion table is initialized
-		if (_is_table_toGamma_8bit_initialized == false)
-			InitializeTable_ToGamma_8bit();
-
-		switch (linear_image.GetLayout()) {
-			case ImagePixelLayout::G: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								//Retrieving converted value
-								data[row][px] = _table_toGamma_8bit[linear_data[row][px]];
-							}
-						}
-					); //tg.run
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::GA: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								data[row][px * 2 + 0] = _table_toGamma_8bit[linear_data[row][px * 2 + 0]];
-								data[row][px * 2 + 1] = static_cast<uint8_t>(linear_data[row][px * 2 + 1] / 257); //Alpha is scaled down
-							}
-						}
-					); //tg.run
+		//Building conversion table if it is not built yet
+		std::call_once(_once_table_toGamma_8bit, &GammaConverter::InitializeTable_ToGamma_8bit, this);
+
+		//Running threads processing rows
+		tbb::task_group tg;
+		for (int row = 0; row < image_height; row++) {
+			tg.run(
+				[&, row] {
+					//Whole row is converted as one run of samples, alpha is overwritten after
+					if (_is_table_toGamma_8bit_compact)
+						LookupRow_ToGamma_8bit_Compact(linear_data[row], data[row], row_length, _table_toGamma_8bit_compact);
+					else
+						LookupRow(linear_data[row], data[row], row_length, _table_toGamma_8bit);
+
+					if (has_alpha)
+						for (int px = 0; px < image_width; px++)
+							data[row][px * num_cmp + num_cmp - 1] = static_cast<uint8_t>(linear_data[row][px * num_cmp + num_cmp - 1] / 257); //Alpha is scaled down
 				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::RGB: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							//Iterating row pixels				
-							for (int px = 0; px < image_width; px++) {
-								data[row][px * 3 + 0] = _table_toGamma_8bit[linear_data[row][px * 3 + 0]];
-								data[row][px * 3 + 1] = _table_toGamma_8bit[linear_data[row][px * 3 + 1]];
-								data[row][px * 3 + 2] = _table_toGamma_8bit[linear_data[row][px * 3 + 2]];
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::RGBA: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							//Iterating row pixels
-							for (int px = 0; px < image_width; px++) {
-								data[row][px * 4 + 0] = _table_toGamma_8bit[linear_data[row][px * 4 + 0]];
-								data[row][px * 4 + 1] = _table_toGamma_8bit[linear_data[row][px * 4 + 1]];
-								data[row][px * 4 + 2] = _table_toGamma_8bit[linear_data[row][px * 4 + 2]];
-								data[row][px * 4 + 3] = static_cast<uint8_t>(linear_data[row][px * 4 + 3] / 257); //Alpha is scaled down
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			default:
-				break;
+			); //tg.run
 		}
+		//Waiting for threads to finish
+		tg.wait();
 	}
 	else { //16 bit
-		//Checking if conversion table is initialized
-		if (_is_table_toGamma_16bit_initialized == false)
-			InitializeTable_ToGamma_16bit();
+		//Building conversion table if it is not built yet
+		std::call_once(_once_table_toGamma_16bit, &GammaConverter::InitializeTable_ToGamma_16bit, this);
 
 		uint16_t** data_16 = reinterpret_cast<uint16_t**>(data); //Alias for output data array allows to write 16-bit values
 
-		switch (linear_image.GetLayout())
-		{
-
-			case ImagePixelLayout::G: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								data_16[row][px] = _table_toGamma_16bit[linear_data[row][px]];
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::GA: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								data_16[row][px * 2 + 0] = _table_toGamma_16bit[linear_data[row][px * 2 + 0]];
-								data_16[row][px * 2 + 1] = linear_data[row][px * 2 + 1]; //Alpha is copied
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::RGB: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								data_16[row][px * 3 + 0] = _table_toGamma_16bit[linear_data[row][px * 3 + 0]];
-								data_16[row][px * 3 + 1] = _table_toGamma_16bit[linear_data[row][px * 3 + 1]];
-								data_16[row][px * 3 + 2] = _table_toGamma_16bit[linear_data[row][px * 3 + 2]];
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
-
-			case ImagePixelLayout::RGBA: {
-				//Running threads processing rows
-				tbb::task_group tg;
-				for (int row = 0; row < image_height; row++) {
-					tg.run<>(
-						[&, row] {
-							for (int px = 0; px < image_width; px++) { //Iterating row pixels
-								data_16[row][px * 4 + 0] = _table_toGamma_16bit[linear_data[row][px * 4 + 0]];
-								data_16[row][px * 4 + 1] = _table_toGamma_16bit[linear_data[row][px * 4 + 1]];
-								data_16[row][px * 4 + 2] = _table_toGamma_16bit[linear_data[row][px * 4 + 2]];
-								data_16[row][px * 4 + 3] = _table_toGamma_16bit[linear_data[row][px * 4 + 3]];
-							}
-						}
-					);
-				}
-				//Waiting for threads to finish
-				tg.wait();
-			}
-			break;
+		//Running threads processing rows
+		tbb::task_group tg;
+		for (int row = 0; row < image_height; row++) {
+			tg.run(
+				[&, row] {
+					LookupRow_16bit(linear_data[row], data_16[row], row_length, _table_toGamma_16bit);
 
-			default:
-				break;
+					if (has_alpha)
+						for (int px = 0; px < image_width; px++)
+							data_16[row][px * num_cmp + num_cmp - 1] = linear_data[row][px * num_cmp + num_cmp - 1]; //Alpha is copied
+				}
+			); //tg.run
 		}
+		//Waiting for threads to finish
+		tg.wait();
 	}
-
-	return image;
 }
 
 
@@ -207,192 +101,430 @@ ImageBuffer_Byte GammaConverter::ApplyGammaCorrection(const ImageBuffer_uint16&
 /// <summary>
 /// Converts image brightness values from gamma-corrected color space to brightness linear scale 16 bit [0..65535].
 /// </summary>
-ImageBuffer_uint16 GammaConverter::RemoveGammaCorrection(const ImageBuffer_Byte& image) {
+ImageBuffer_uint16 GammaConverter::RemoveGammaCorrection(const ImageBufferView_Byte& image) {
+	//Allocating resulting image
+	ImageBuffer_uint16 linear_image(image.GetHeight(), image.GetWidth(), image.GetLayout());
+
+	RemoveGammaCorrectionInto(image, linear_image);
+
+	return linear_image;
+}
+
+
+
+/// <summary>
+/// Converts image brightness values from gamma-corrected color space to brightness linear scale 16 bit [0..65535]
+/// and writes the result into caller provided buffer.
+/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+/// </summary>
+void GammaConverter::RemoveGammaCorrectionInto(const ImageBufferView_Byte& image, ImageBuffer_uint16& linear_image) {
 	//Aliases
 	int image_height = image.GetHeight();
 	int image_width = image.GetWidth();
-	uint8_t** data = image.GetDataPtr();
+	int num_cmp = image.GetNumCmp();
+	int row_length = image.GetCmpWidth();
+	bool has_alpha = image.GetHasAlpha();
+	const ImageBufferView_Byte& data = image; //View rows can start in the middle of buffer rows
 
-	//Allocating resulting image
-	ImageBuffer_uint16 linear_image(image_height, image_width, image.GetLayout());
+	//Preparing resulting image
+	linear_image.Reshape(image_height, image_width, image.GetLayout());
 	uint16_t** linear_data = linear_image.GetDataPtr(); //Alias
 
+	if (image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+
 	//Depending on bit depth
 	if (image.GetBitPerComponent() == BitDepth::BD_8_BIT) { //8 bit
-		//Checking if conversion table is initialized
-		if (_is_table_toLinear_8bit_initialized == false)
-			InitializeTable_ToLinear_8bit();
-
-		switch (image.GetLayout())
-		{
-		case ImagePixelLayout::G: {
-			//Running thread processing rows
-			//Task for each row
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px] = _table_toLinear_8bit[data[row][px]];
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
-		}
-		break;
-
-		case ImagePixelLayout::GA: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 2 + 0] = _table_toLinear_8bit[data[row][px * 2 + 0]]; //Gray
-							linear_data[row][px * 2 + 1] = data[row][px * 2 + 1] * 257; //Alpha channel is scaled
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
-		}
-		break;
-
-		case ImagePixelLayout::RGB: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 3 + 0] = _table_toLinear_8bit[data[row][px * 3 + 0]]; //Red
-							linear_data[row][px * 3 + 1] = _table_toLinear_8bit[data[row][px * 3 + 1]]; //Green
-							linear_data[row][px * 3 + 2] = _table_toLinear_8bit[data[row][px * 3 + 2]]; //Blue
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
-		}
-		break;
-
-		case ImagePixelLayout::RGBA: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 4 + 0] = _table_toLinear_8bit[data[row][px * 4 + 0]]; //Red
-							linear_data[row][px * 4 + 1] = _table_toLinear_8bit[data[row][px * 4 + 1]]; //Green
-							linear_data[row][px * 4 + 2] = _table_toLinear_8bit[data[row][px * 4 + 2]]; //Blue
-							linear_data[row][px * 4 + 3] = data[row][px * 4 + 3] * 257; //Alpha is scaled
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
-		}
-		break;
-
-		default:
-			break;
+		//Building conversion table if it is not built yet
+		std::call_once(_once_table_toLinear_8bit, &GammaConverter::InitializeTable_ToLinear_8bit, this);
+
+		//Running threads processing rows
+		//Task for each row
+		tbb::task_group tg;
+		for (int row = 0; row < image_height; row++) {
+			tg.run(
+				[&, row] {
+					//Whole row is converted as one run of samples, alpha is overwritten after
+					LookupRow(data[row], linear_data[row], row_length, _table_toLinear_8bit);
+
+					if (has_alpha)
+						for (int px = 0; px < image_width; px++)
+							linear_data[row][px * num_cmp + num_cmp - 1] = data[row][px * num_cmp + num_cmp - 1] * 257; //Alpha channel is scaled
+				}
+			);
 		}
+		//Waiting for tasks to finish
+		tg.wait();
 	}
 	else { //16 bit
-		//Checking if conversion table is initialized
-		if (_is_table_toLinear_16bit_initialized == false)
-			InitializeTable_ToLinear_16bit();
-
-		uint16_t** data_16 = reinterpret_cast<uint16_t**>(data);
-
-		switch (image.GetLayout())
-		{
-		case ImagePixelLayout::G: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px] = _table_toLinear_16bit[data_16[row][px]];	//Gray
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
+		//Building conversion table if it is not built yet
+		std::call_once(_once_table_toLinear_16bit, &GammaConverter::InitializeTable_ToLinear_16bit, this);
+
+		//Running threads processing rows
+		tbb::task_group tg;
+		for (int row = 0; row < image_height; row++) {
+			tg.run(
+				[&, row] {
+					const uint16_t* data_16 = reinterpret_cast<const uint16_t*>(data[row]); //Alias for input row allows to read 16-bit values
+					LookupRow_16bit(data_16, linear_data[row], row_length, _table_toLinear_16bit);
+
+					if (has_alpha)
+						for (int px = 0; px < image_width; px++)
+							linear_data[row][px * num_cmp + num_cmp - 1] = data_16[px * num_cmp + num_cmp - 1]; //Alpha is copied
+				}
+			);
 		}
-		break;
-
-		case ImagePixelLayout::GA: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 2 + 0] = _table_toLinear_16bit[data_16[row][px * 2 + 0]]; //Gray
-							linear_data[row][px * 2 + 1] = data_16[row][px * 2 + 1]; //Alpha is copied
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
+		//Waiting for tasks to finish
+		tg.wait();
+	}
+}
+
+
+
+//--------------------------------
+//	LAYOUT CONVERSION METHODS
+//--------------------------------
+
+/// <summary>
+/// Converts gamma-corrected image to other pixel layout and bit depth in a single pass.
+/// Color to grayscale conversion is done on linear scale with Rec.709 luma weights, other channels are copied.
+/// Alpha channel is dropped or added (fully opaque) as the target layout requires.
+/// <para>Throws std::invalid_argument if layout is undefined or bit depth is not 8 or 16 bit.</para>
+/// </summary>
+ImageBuffer_Byte GammaConverter::ConvertLayout(const ImageBufferView_Byte& image, ImagePixelLayout layout, BitDepth bitDepth) {
+	ImageBuffer_Byte result(0, image.GetWidth(), layout, bitDepth, false);
+	ConvertLayoutInto(image, layout, bitDepth, result);
+	return result;
+}
+
+
+
+/// <summary>
+/// Converts gamma-corrected image to other pixel layout and bit depth in a single pass
+/// and writes the result into caller provided buffer.
+/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+/// If buffer bit depth does not match bitDepth argument the buffer is replaced.
+/// <para>Throws std::invalid_argument if layout is undefined or bit depth is not 8 or 16 bit.</para>
+/// </summary>
+void GammaConverter::ConvertLayoutInto(const ImageBufferView_Byte& image, ImagePixelLayout layout, BitDepth bitDepth, ImageBuffer_Byte& result) {
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	if (layout == ImagePixelLayout::UNDEF || image.GetLayout() == ImagePixelLayout::UNDEF)
+		throw std::invalid_argument("GammaConverter -- Cannot convert undefined layout.");
+	if ((bitDepth != BitDepth::BD_8_BIT && bitDepth != BitDepth::BD_16_BIT) || (image.GetBitPerComponent() != BitDepth::BD_8_BIT && image.GetBitPerComponent() != BitDepth::BD_16_BIT))
+		throw std::invalid_argument("GammaConverter -- Only 8 and 16 bit images are supported.");
+
+	//Aliases
+	int image_height = image.GetHeight();
+	int image_width = image.GetWidth();
+	int src_num_cmp = image.GetNumCmp();
+	bool src_has_alpha = image.GetHasAlpha();
+	int dst_num_cmp = NumComponentsOfLayout(layout);
+	bool dst_has_alpha = layout == ImagePixelLayout::GA || layout == ImagePixelLayout::RGBA;
+	bool src_is_8bit = image.GetBitPerComponent() == BitDepth::BD_8_BIT;
+	bool dst_is_8bit = bitDepth == BitDepth::BD_8_BIT;
+
+	//----------------------------------------------------------------------
+	// 2 - Preparing resulting image
+
+	if (result.GetBitPerComponent() == bitDepth)
+		result.Reshape(image_height, image_width, layout);
+	else
+		result = ImageBuffer_Byte(image_height, image_width, layout, bitDepth);
+
+	//----------------------------------------------------------------------
+	// 3 - Building tables needed for luma
+
+	bool is_luma_needed = src_num_cmp - (src_has_alpha ? 1 : 0) == 3 && dst_num_cmp - (dst_has_alpha ? 1 : 0) == 1;
+	if (is_luma_needed) {
+		if (src_is_8bit)
+			std::call_once(_once_table_toLinear_8bit, &GammaConverter::InitializeTable_ToLinear_8bit, this);
+		else
+			std::call_once(_once_table_toLinear_16bit, &GammaConverter::InitializeTable_ToLinear_16bit, this);
+		if (dst_is_8bit)
+			std::call_once(_once_table_toGamma_8bit, &GammaConverter::InitializeTable_ToGamma_8bit, this);
+		else
+			std::call_once(_once_table_toGamma_16bit, &GammaConverter::InitializeTable_ToGamma_16bit, this);
+	}
+
+	//----------------------------------------------------------------------
+	// 4 - Converting rows
+
+	const ImageBufferView_Byte& src_data = image; //View rows can start in the middle of buffer rows
+	uint8_t** dst_data = result.GetDataPtr();
+	tbb::parallel_for(tbb::blocked_range<int>(0, image_height), [&](const tbb::blocked_range<int>& range) {
+		//Scratch rows are shared by rows of the range and stay in cache, memory is kept by the thread for the next calls
+		uint16_t* luma_scratch = is_luma_needed ? _scratch.Get<uint16_t>(SCRATCH_SLOT_LUMA, image_width) : nullptr;
+		uint16_t* gamma_scratch = is_luma_needed ? _scratch.Get<uint16_t>(SCRATCH_SLOT_GAMMA, image_width) : nullptr;
+		uint8_t* gamma_scratch_8 = reinterpret_cast<uint8_t*>(gamma_scratch);
+
+		for (int row = range.begin(); row < range.end(); row++) {
+			if (src_is_8bit && dst_is_8bit)
+				ConvertLayoutRow(src_data[row], src_num_cmp, src_has_alpha, dst_data[row], dst_num_cmp, dst_has_alpha, image_width, luma_scratch, gamma_scratch_8);
+			else if (src_is_8bit)
+				ConvertLayoutRow(src_data[row], src_num_cmp, src_has_alpha, reinterpret_cast<uint16_t*>(dst_data[row]), dst_num_cmp, dst_has_alpha, image_width, luma_scratch, gamma_scratch);
+			else if (dst_is_8bit)
+				ConvertLayoutRow(reinterpret_cast<const uint16_t*>(src_data[row]), src_num_cmp, src_has_alpha, dst_data[row], dst_num_cmp, dst_has_alpha, image_width, luma_scratch, gamma_scratch_8);
+			else
+				ConvertLayoutRow(reinterpret_cast<const uint16_t*>(src_data[row]), src_num_cmp, src_has_alpha, reinterpret_cast<uint16_t*>(dst_data[row]), dst_num_cmp, dst_has_alpha, image_width, luma_scratch, gamma_scratch);
 		}
-		break;
-
-		case ImagePixelLayout::RGB: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 3 + 0] = _table_toLinear_16bit[data_16[row][px * 3 + 0]]; //Red
-							linear_data[row][px * 3 + 1] = _table_toLinear_16bit[data_16[row][px * 3 + 1]]; //Green
-							linear_data[row][px * 3 + 2] = _table_toLinear_16bit[data_16[row][px * 3 + 2]]; //Blue
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
+	});
+}
+
+
+
+/// <summary>
+/// Converts one row for ConvertLayoutInto.
+/// Luma and gamma scratch rows should hold at least width samples.
+/// </summary>
+template <typename TSrc, typename TDst>
+void GammaConverter::ConvertLayoutRow(const TSrc* src, int src_num_cmp, bool src_has_alpha, TDst* dst, int dst_num_cmp, bool dst_has_alpha, int width, uint16_t* luma_scratch, TDst* gamma_scratch) {
+	constexpr TDst dst_max = static_cast<TDst>(sizeof(TDst) == 1 ? MAX_8BIT : MAX_16BIT);
+	int src_num_color = src_num_cmp - (src_has_alpha ? 1 : 0);
+	int dst_num_color = dst_num_cmp - (dst_has_alpha ? 1 : 0);
+
+	// 1 - Color samples
+	if (src_num_color == 3 && dst_num_color == 1) {
+		//Luma on linear scale, then back to gamma-corrected output scale
+		const uint16_t* to_linear = sizeof(TSrc) == 1 ? _table_toLinear_8bit : _table_toLinear_16bit;
+		LumaRow(src, src_num_cmp, luma_scratch, width, to_linear);
+
+		//Single channel output is written directly
+		TDst* gamma_row = dst_num_cmp == 1 ? dst : gamma_scratch;
+		if constexpr (sizeof(TDst) == 1) {
+			if (_is_table_toGamma_8bit_compact)
+				LookupRow_ToGamma_8bit_Compact(luma_scratch, gamma_row, width, _table_toGamma_8bit_compact);
+			else
+				LookupRow(luma_scratch, gamma_row, width, _table_toGamma_8bit);
 		}
-		break;
-
-		case ImagePixelLayout::RGBA: {
-			//Running threads processing rows
-			tbb::task_group tg;
-			for (int row = 0; row < image_height; row++) {
-				tg.run(
-					[&, row] {
-						for (int px = 0; px < image_width; px++) { //Iterating row pixels
-							linear_data[row][px * 4 + 0] = _table_toLinear_16bit[data_16[row][px * 4 + 0]]; //Red
-							linear_data[row][px * 4 + 1] = _table_toLinear_16bit[data_16[row][px * 4 + 1]]; //Green
-							linear_data[row][px * 4 + 2] = _table_toLinear_16bit[data_16[row][px * 4 + 2]]; //Blue
-							linear_data[row][px * 4 + 3] = data_16[row][px * 4 + 2]; //Alpha is copied
-						}
-					}
-				);
-			}
-			//Waiting for tasks to finish
-			tg.wait();
+		else
+			LookupRow_16bit(luma_scratch, gamma_row, width, _table_toGamma_16bit);
+
+		if (dst_num_cmp != 1)
+			for (int px = 0; px < width; px++)
+				dst[px * dst_num_cmp] = gamma_scratch[px];
+	}
+	else if (src_num_color == 1 && dst_num_color == 3) {
+		//Gray value is the same on every channel
+		for (int px = 0; px < width; px++) {
+			TDst value = ScaleSample<TSrc, TDst>(src[px * src_num_cmp]);
+			dst[px * dst_num_cmp + 0] = value;
+			dst[px * dst_num_cmp + 1] = value;
+			dst[px * dst_num_cmp + 2] = value;
 		}
-		break;
+	}
+	else {
+		for (int px = 0; px < width; px++)
+			for (int cmp = 0; cmp < dst_num_color; cmp++)
+				dst[px * dst_num_cmp + cmp] = ScaleSample<TSrc, TDst>(src[px * src_num_cmp + cmp]);
+	}
+
+	// 2 - Alpha
+	if (dst_has_alpha) {
+		if (src_has_alpha)
+			for (int px = 0; px < width; px++)
+				dst[px * dst_num_cmp + dst_num_color] = ScaleSample<TSrc, TDst>(src[px * src_num_cmp + src_num_color]);
+		else
+			for (int px = 0; px < width; px++)
+				dst[px * dst_num_cmp + dst_num_color] = dst_max;
+	}
+}
+
+
+
+//--------------------------------
+//	IN-PLACE CONVERSION METHODS
+//--------------------------------
+
+/// <summary>
+/// Converts 16 bit gamma-corrected image to brightness on the linear scale [0..65535] without allocating.
+/// Samples are 16 bit on both sides, so values are replaced in the same buffer. Alpha channel is left unchanged.
+/// <para>Throws std::invalid_argument if image is not 16 bit.</para>
+/// </summary>
+void GammaConverter::RemoveGammaCorrectionInPlace(ImageBuffer_Byte& image) {
+	if (image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+	if (image.GetBitPerComponent() != BitDepth::BD_16_BIT)
+		throw std::invalid_argument("GammaConverter -- In-place conversion requires 16 bit image.");
+
+	std::call_once(_once_table_toLinear_16bit, &GammaConverter::InitializeTable_ToLinear_16bit, this);
 
-		default:
-			break;
+	LookupRowsInPlace(reinterpret_cast<uint16_t**>(image.GetDataPtr()), image.GetHeight(), image.GetWidth(), image.GetNumCmp(), image.GetHasAlpha(), _table_toLinear_16bit);
+}
+
+
+
+/// <summary>
+/// Converts image holding 16 bit gamma-corrected values to brightness on the linear scale [0..65535] without allocating.
+/// Alpha channel is left unchanged.
+/// </summary>
+void GammaConverter::RemoveGammaCorrectionInPlace(ImageBuffer_uint16& image) {
+	if (image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+
+	std::call_once(_once_table_toLinear_16bit, &GammaConverter::InitializeTable_ToLinear_16bit, this);
+
+	LookupRowsInPlace(image.GetDataPtr(), image.GetHeight(), image.GetWidth(), image.GetNumCmp(), image.GetHasAlpha(), _table_toLinear_16bit);
+}
+
+
+
+/// <summary>
+/// Converts image with linear scale brightness values [0..65535] to 16 bit gamma-corrected values without allocating.
+/// Alpha channel is left unchanged.
+/// </summary>
+void GammaConverter::ApplyGammaCorrectionInPlace(ImageBuffer_uint16& image) {
+	if (image.GetLayout() == ImagePixelLayout::UNDEF)
+		return;
+
+	std::call_once(_once_table_toGamma_16bit, &GammaConverter::InitializeTable_ToGamma_16bit, this);
+
+	LookupRowsInPlace(image.GetDataPtr(), image.GetHeight(), image.GetWidth(), image.GetNumCmp(), image.GetHasAlpha(), _table_toGamma_16bit);
+}
+
+
+
+/// <summary>
+/// Replaces 16 bit samples of every row with their table values, rows are processed in parallel.
+/// </summary>
+void GammaConverter::LookupRowsInPlace(uint16_t** data, int height, int width, int num_cmp, bool has_alpha, const uint16_t* table) {
+	tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& range) {
+		for (int row = range.begin(); row < range.end(); row++) {
+			if (has_alpha)
+				LookupRow_SkipAlpha(data[row], data[row], width, num_cmp, table);
+			else
+				LookupRow_16bit(data[row], data[row], width * num_cmp, table);
 		}
+	});
+}
+
+
+
+//--------------------------------
+//	AVX2 ROW KERNELS
+//--------------------------------
+
+const bool GammaConverter::HAS_AVX2 = GammaConverter::IsAVX2Supported();
+
+
+
+/// <summary>
+/// Checks CPUID AVX2 bit and that OS saves YMM registers.
+/// </summary>
+bool GammaConverter::IsAVX2Supported() {
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	//OSXSAVE and AVX bits
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	//XMM and YMM state enabled by OS
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	//AVX2 bit
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+
+
+/// <summary>
+/// Gathers 32 bit values at table + 2 * index and keeps low 16 bits.
+/// Last table entry has no 2 bytes after it, so lanes with index 65535 are masked out of the gather and take the entry from the source.
+/// </summary>
+void GammaConverter::LookupRow_16bit_AVX2(const uint16_t* src, uint16_t* dst, int count, const uint16_t* table) {
+	const int* table_int = reinterpret_cast<const int*>(table);
+	const __m256i last_index = _mm256_set1_epi32(MAX_16BIT);
+	const __m256i last_value = _mm256_set1_epi32(table[MAX_16BIT]);
+	const __m256i low_mask = _mm256_set1_epi32(0xFFFF);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		__m256i gather_mask = _mm256_xor_si256(_mm256_cmpeq_epi32(index, last_index), _mm256_set1_epi32(-1));
+		__m256i value = _mm256_mask_i32gather_epi32(last_value, table_int, index, gather_mask, 2);
+		value = _mm256_and_si256(value, low_mask);
+
+		//Packing 8 values to 16 bits, packus works inside 128 bit lanes so halves are packed separately
+		__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
 	}
 
-	return linear_image;
+	for (; i < count; i++)
+		dst[i] = table[src[i]];
+}
+
+
+
+/// <summary>
+/// Gathers bucket entries of compact table,
+/// bucket output is incremented where linear value reached the threshold of the next output.
+/// </summary>
+void GammaConverter::LookupRow_ToGamma_8bit_Compact_AVX2(const uint16_t* src, uint8_t* dst, int count, const uint32_t* compact) {
+	const int* compact_int = reinterpret_cast<const int*>(compact);
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i lin = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		__m256i entry = _mm256_i32gather_epi32(compact_int, _mm256_srli_epi32(lin, COMPACT_TABLE_SHIFT), 4);
+		__m256i base = _mm256_and_si256(entry, byte_mask);
+
+		//Thresholds are at most 65536 so signed comparison is safe, lin >= threshold is !(threshold > lin)
+		__m256i threshold = _mm256_srli_epi32(entry, 8);
+		__m256i below = _mm256_cmpgt_epi32(threshold, lin);
+		__m256i value = _mm256_add_epi32(base, _mm256_andnot_si256(below, one));
+
+		//Packing 8 values to bytes
+		__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+		packed = _mm_packus_epi16(packed, packed);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+
+	LookupRow_ToGamma_8bit_Compact_Scalar(src + i, dst + i, count - i, compact);
+}
+
+
+
+
+
+
+
+/// <summary>
+/// Builds all conversion tables that are not built yet, in parallel.
+/// Allows to move table building cost out of the first conversion.
+/// </summary>
+void GammaConverter::InitializeTables() {
+	tbb::parallel_invoke(
+		[this] { std::call_once(_once_table_toLinear_8bit, &GammaConverter::InitializeTable_ToLinear_8bit, this); },
+		[this] { std::call_once(_once_table_toLinear_16bit, &GammaConverter::InitializeTable_ToLinear_16bit, this); },
+		[this] { std::call_once(_once_table_toGamma_8bit, &GammaConverter::InitializeTable_ToGamma_8bit, this); },
+		[this] { std::call_once(_once_table_toGamma_16bit, &GammaConverter::InitializeTable_ToGamma_16bit, this); }
+	);
+}
+
+
+
+
+/// <summary>
+/// Releases conversion tables.
+/// </summary>
+GammaConverter::~GammaConverter() {
+	if (!_is_table_toLinear_8bit_compiled)
+		delete[] _table_toLinear_8bit;
+	if (!_is_table_toLinear_16bit_compiled)
+		delete[] _table_toLinear_16bit;
+	if (!_is_table_toGamma_8bit_compiled)
+		delete[] _table_toGamma_8bit;
+	if (!_is_table_toGamma_16bit_compiled)
+		delete[] _table_toGamma_16bit;
+	delete[] _table_toGamma_8bit_compact;
 }
 
 
@@ -406,48 +538,112 @@ ImageBuffer_uint16 GammaConverter::RemoveGammaCorrection(const ImageBuffer_Byte&
 //--------------------------------
 
 void GammaConverter::InitializeTable_ToLinear_8bit() {
-	//Allocating the table
-	_table_toLinear_8bit = new uint16_t[WIDTH_8BIT];
-
-	//Filling the table (defined in the derived class)
-	FillTableToLinear_8bit();
+	//Using compiled-in table if there is one
+	_table_toLinear_8bit = GetCompiledTableToLinear_8bit();
+	if (_table_toLinear_8bit != nullptr) {
+		_is_table_toLinear_8bit_compiled = true;
+		return;
+	}
 
-	//Setting flag telling that table was initialized
-	_is_table_toLinear_8bit_initialized = true;
+	//Allocating and filling the table (defined in the derived class)
+	uint16_t* table = new uint16_t[WIDTH_8BIT];
+	FillTableToLinear_8bit(table);
+	_table_toLinear_8bit = table;
 }
 
 
 void GammaConverter::InitializeTable_ToLinear_16bit() {
-	//Allocating the table
-	_table_toLinear_16bit = new uint16_t[WIDTH_16BIT];
-
-	//Filling the table (defined in the derived class)
-	FillTableToLinear_16bit();
+	//Using compiled-in table if there is one
+	_table_toLinear_16bit = GetCompiledTableToLinear_16bit();
+	if (_table_toLinear_16bit != nullptr) {
+		_is_table_toLinear_16bit_compiled = true;
+		return;
+	}
 
-	//Setting flag telling that table was initialized
-	_is_table_toLinear_16bit_initialized = true;
+	//Allocating and filling the table (defined in the derived class)
+	uint16_t* table = new uint16_t[WIDTH_16BIT];
+	FillTableToLinear_16bit(table);
+	_table_toLinear_16bit = table;
 }
 
 
 void GammaConverter::InitializeTable_ToGamma_8bit() {
-	//Allocating the table
-	_table_toGamma_8bit = new uint8_t[WIDTH_16BIT];
-
-	//Filling the table (defined in the derived class)
-	FillTableToGamma_8bit();
+	//Using compiled-in table if there is one
+	_table_toGamma_8bit = GetCompiledTableToGamma_8bit();
+	if (_table_toGamma_8bit != nullptr) {
+		_is_table_toGamma_8bit_compiled = true;
+	}
+	else {
+		//Allocating and filling the table (defined in the derived class)
+		uint8_t* table = new uint8_t[WIDTH_16BIT];
+		FillTableToGamma_8bit(table);
+		_table_toGamma_8bit = table;
+	}
 
-	//Setting flag telling that table was initialized
-	_is_table_toGamma_8bit_initialized = true;
+	//Replacing 64 KB table with compact one if it gives exactly the same values.
+	//Compact table is used for compiled-in table too, since it is much smaller in cache.
+	if (BuildCompactTable_ToGamma_8bit()) {
+		if (!_is_table_toGamma_8bit_compiled)
+			delete[] _table_toGamma_8bit;
+		_table_toGamma_8bit = nullptr;
+		_is_table_toGamma_8bit_compiled = false;
+		_is_table_toGamma_8bit_compact = true;
+	}
 }
 
 
 void GammaConverter::InitializeTable_ToGamma_16bit() {
-	//Allocating the table
-	_table_toGamma_16bit = new uint16_t[WIDTH_16BIT];
+	//Using compiled-in table if there is one
+	_table_toGamma_16bit = GetCompiledTableToGamma_16bit();
+	if (_table_toGamma_16bit != nullptr) {
+		_is_table_toGamma_16bit_compiled = true;
+		return;
+	}
+
+	//Allocating and filling the table (defined in the derived class)
+	uint16_t* table = new uint16_t[WIDTH_16BIT];
+	FillTableToGamma_16bit(table);
+	_table_toGamma_16bit = table;
+}
 
-	//Filling the table (defined in the derived class)
-	FillTableToGamma_16bit();
 
-	//Setting flag telling that table was initialized
-	_is_table_toGamma_16bit_initialized = true;
-}
\ No newline at end of file
+
+/// <summary>
+/// Builds compact table from filled full 8 bit to-gamma table.
+/// Returns false and leaves compact table unallocated if compact lookup does not reproduce the full table exactly.
+/// </summary>
+bool GammaConverter::BuildCompactTable_ToGamma_8bit() {
+	//Thresholds exist only for non-decreasing table
+	for (int v = 1; v < WIDTH_16BIT; v++)
+		if (_table_toGamma_8bit[v] < _table_toGamma_8bit[v - 1])
+			return false;
+
+	//Threshold of an output value is the smallest linear value converted to it or above
+	uint32_t thresholds[WIDTH_8BIT + 1];
+	int v = 0;
+	for (int out = 0; out < WIDTH_8BIT; out++) {
+		while (v < WIDTH_16BIT && _table_toGamma_8bit[v] < out)
+			v++;
+		thresholds[out] = v;
+	}
+	thresholds[WIDTH_8BIT] = WIDTH_16BIT; //Never reached
+
+	//Output for the first value of every bucket and threshold of the next output
+	uint32_t* compact = new uint32_t[COMPACT_TABLE_WIDTH];
+	for (int bucket = 0; bucket < COMPACT_TABLE_WIDTH; bucket++) {
+		uint32_t base = _table_toGamma_8bit[bucket << COMPACT_TABLE_SHIFT];
+		compact[bucket] = base | (thresholds[base + 1] << 8);
+	}
+
+	//Compact lookup is exact only if output grows at most by one inside every bucket
+	for (int lin = 0; lin < WIDTH_16BIT; lin++) {
+		uint32_t entry = compact[lin >> COMPACT_TABLE_SHIFT];
+		if ((entry & 0xFF) + (static_cast<uint32_t>(lin) >= (entry >> 8) ? 1 : 0) != _table_toGamma_8bit[lin]) {
+			delete[] compact;
+			return false;
+		}
+	}
+
+	_table_toGamma_8bit_compact = compact;
+	return true;
+}
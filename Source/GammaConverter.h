@@ -1,10 +1,15 @@
 #pragma once
 //STL
 #include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <intrin.h>
 //Third party
 #include "oneapi\tbb.h"
 //Internal
 #include "ImageBuffer_Byte.h"
+#include "ScratchArena.h"
 
 //Constants definitions to improve code readibility
 #define WIDTH_8BIT 256
@@ -24,10 +29,22 @@
 /// To process image (i.e. downscale) we should correct for this non-uniformity and recalculate values so brightness is uniformly distributed between them. (so 127 will represent 50% brightness).
 /// Linear brightness will be stored in unsigned integer 16bit [0..65535] to preserve precision for calculations.
 /// This class uses lookup tables for the conversion to and from linear brightness scale.
-/// Tables are created on-demand when first requested.
+/// Tables are created on-demand when first requested, or all at once with InitializeTables.
+/// Each table is built exactly once even if several threads request it at the same time,
+/// so one converter can be shared by concurrent jobs.
+///
+/// Full 8 bit to-gamma table has 65536 entries. When output grows at most by one inside every 16 consecutive linear values
+/// (true for sRGB, which is linear near black) it is replaced by 16 KB table holding for every bucket its output
+/// and the threshold of the next output, and lookup adds one to the bucket output if the value reached the threshold.
+/// Single load per sample from a table that stays in L1 cache next to the image rows.
+///
+/// 16 bit table lookups and compact lookups use AVX2 gathers when processor supports them.
 ///</remarks>
 class GammaConverter
 {
+	//Compares AVX2 and scalar row kernels
+	friend class Tester_Gamma;
+
 public:
 	//--------------------------------
 	//	PUBLIC CONVERSION METHODS
@@ -37,25 +54,119 @@ public:
 	/// Converts image with linear scale brightness values [0..65535] to gamma-corrected color space.
 	/// Resulting image bit depth is specified in bitDepth argument.
 	/// </summary>
-	ImageBuffer_Byte ApplyGammaCorrection(const ImageBuffer_uint16& linear_image, BitDepth bitDepth);
+	ImageBuffer_Byte ApplyGammaCorrection(const ImageBufferView_uint16& linear_image, BitDepth bitDepth);
 
 	/// <summary>
 	/// Converts image brightness values from gamma-corrected color space to brightness on the linear scale [0..65535].
 	/// </summary>
-	ImageBuffer_uint16 RemoveGammaCorrection(const ImageBuffer_Byte& corrected_image);
+	ImageBuffer_uint16 RemoveGammaCorrection(const ImageBufferView_Byte& corrected_image);
+
+	/// <summary>
+	/// Converts image with linear scale brightness values [0..65535] to gamma-corrected color space
+	/// and writes the result into caller provided buffer.
+	/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+	/// If buffer bit depth does not match bitDepth argument the buffer is replaced.
+	/// </summary>
+	void ApplyGammaCorrectionInto(const ImageBufferView_uint16& linear_image, BitDepth bitDepth, ImageBuffer_Byte& corrected_image);
+
+	/// <summary>
+	/// Converts image brightness values from gamma-corrected color space to brightness on the linear scale [0..65535]
+	/// and writes the result into caller provided buffer.
+	/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+	/// </summary>
+	void RemoveGammaCorrectionInto(const ImageBufferView_Byte& corrected_image, ImageBuffer_uint16& linear_image);
+
+	//--------------------------------
+	//	LAYOUT CONVERSION METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Converts gamma-corrected image to other pixel layout and bit depth in a single pass.
+	/// Color to grayscale conversion is done on linear scale with Rec.709 luma weights, other channels are copied.
+	/// Alpha channel is dropped or added (fully opaque) as the target layout requires.
+	/// <para>Throws std::invalid_argument if layout is undefined or bit depth is not 8 or 16 bit.</para>
+	/// </summary>
+	ImageBuffer_Byte ConvertLayout(const ImageBufferView_Byte& corrected_image, ImagePixelLayout layout, BitDepth bitDepth);
+
+	/// <summary>
+	/// Converts gamma-corrected image to other pixel layout and bit depth in a single pass
+	/// and writes the result into caller provided buffer.
+	/// Buffer is reshaped to the size of the source image reusing its memory when possible.
+	/// If buffer bit depth does not match bitDepth argument the buffer is replaced.
+	/// <para>Throws std::invalid_argument if layout is undefined or bit depth is not 8 or 16 bit.</para>
+	/// </summary>
+	void ConvertLayoutInto(const ImageBufferView_Byte& corrected_image, ImagePixelLayout layout, BitDepth bitDepth, ImageBuffer_Byte& result);
+
+	//--------------------------------
+	//	IN-PLACE CONVERSION METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Converts 16 bit gamma-corrected image to brightness on the linear scale [0..65535] without allocating.
+	/// Samples are 16 bit on both sides, so values are replaced in the same buffer. Alpha channel is left unchanged.
+	/// <para>Throws std::invalid_argument if image is not 16 bit.</para>
+	/// </summary>
+	void RemoveGammaCorrectionInPlace(ImageBuffer_Byte& corrected_image);
+
+	/// <summary>
+	/// Converts image holding 16 bit gamma-corrected values to brightness on the linear scale [0..65535] without allocating.
+	/// Alpha channel is left unchanged.
+	/// </summary>
+	void RemoveGammaCorrectionInPlace(ImageBuffer_uint16& image);
+
+	/// <summary>
+	/// Converts image with linear scale brightness values [0..65535] to 16 bit gamma-corrected values without allocating.
+	/// Alpha channel is left unchanged.
+	/// </summary>
+	void ApplyGammaCorrectionInPlace(ImageBuffer_uint16& image);
+
+	/// <summary>
+	/// Builds all conversion tables that are not built yet, in parallel.
+	/// Allows to move table building cost out of the first conversion.
+	/// </summary>
+	void InitializeTables();
+
+	//--------------------------------
+	//	DESTRUCTOR
+	//--------------------------------
+
+	/// <summary>
+	/// Releases conversion tables.
+	/// Converters are deleted through base class pointers, so destructor is virtual.
+	/// </summary>
+	virtual ~GammaConverter();
 
 protected:
 	//--------------------------------
 	//  CONVERSION TABLES
 	//--------------------------------
 
+	//Tables point either to memory allocated by the converter or to data compiled in by concrete class.
+	//Compiled-in tables are flagged and are not released.
+
 	//Table index is gamma corrected brightness and the value is corresponding value on linear brightness scale, 16bit
-	uint16_t* _table_toLinear_8bit = nullptr;
-	uint16_t* _table_toLinear_16bit = nullptr;
+	const uint16_t* _table_toLinear_8bit = nullptr;
+	const uint16_t* _table_toLinear_16bit = nullptr;
 
 	//Table index is a value on linear brightness scale and value is corresponding gamma corrected value - 8 or 16 bit
-	uint8_t* _table_toGamma_8bit = nullptr;
-	uint16_t* _table_toGamma_16bit = nullptr;
+	const uint8_t* _table_toGamma_8bit = nullptr;
+	const uint16_t* _table_toGamma_16bit = nullptr;
+
+	//Compact form of 8 bit to-gamma table.
+	//Index is linear value shifted right by COMPACT_TABLE_SHIFT. Low 8 bits of the value are output for the first linear value of the bucket,
+	//upper bits are threshold of the next output - the smallest linear value converted to it or above (65536 if there is none).
+	uint32_t* _table_toGamma_8bit_compact = nullptr;
+
+	//Rec.709 luma weights of linear R, G and B scaled to 2^16, sum is exactly 65536
+	static constexpr uint32_t LUMA_WEIGHT_R = 13933;
+	static constexpr uint32_t LUMA_WEIGHT_G = 46871;
+	static constexpr uint32_t LUMA_WEIGHT_B = 4732;
+
+	static constexpr int COMPACT_TABLE_SHIFT = 4;
+	static constexpr int COMPACT_TABLE_WIDTH = WIDTH_16BIT >> COMPACT_TABLE_SHIFT;
+
+	//Processor supports AVX2, checked once at startup
+	static const bool HAS_AVX2;
 
 
 
@@ -63,10 +174,30 @@ protected:
 	//  INITIALIZATION FLAGS
 	//--------------------------------
 
-	bool _is_table_toLinear_8bit_initialized = false;
-	bool _is_table_toLinear_16bit_initialized = false;
-	bool _is_table_toGamma_8bit_initialized = false;
-	bool _is_table_toGamma_16bit_initialized = false;
+	//Each table is built by the first thread that needs it, other threads wait for it.
+	//After that check of the flag is a single atomic load.
+	std::once_flag _once_table_toLinear_8bit;
+	std::once_flag _once_table_toLinear_16bit;
+	std::once_flag _once_table_toGamma_8bit;
+	std::once_flag _once_table_toGamma_16bit;
+	//8 bit to-gamma conversion uses compact table and full table is released
+	bool _is_table_toGamma_8bit_compact = false;
+	//Table points to compiled-in data
+	bool _is_table_toLinear_8bit_compiled = false;
+	bool _is_table_toLinear_16bit_compiled = false;
+	bool _is_table_toGamma_8bit_compiled = false;
+	bool _is_table_toGamma_16bit_compiled = false;
+
+
+
+	//--------------------------------
+	//  SCRATCH MEMORY
+	//--------------------------------
+
+	//Per-thread scratch rows for luma conversion, kept between calls
+	ScratchArena _scratch;
+	static constexpr int SCRATCH_SLOT_LUMA = 0;
+	static constexpr int SCRATCH_SLOT_GAMMA = 1;
 
 
 
@@ -80,6 +211,121 @@ protected:
 	void InitializeTable_ToGamma_8bit();
 	void InitializeTable_ToGamma_16bit();
 
+	/// <summary>
+	/// Builds compact table from filled full 8 bit to-gamma table.
+	/// Returns false and leaves compact table unallocated if compact lookup does not reproduce the full table exactly.
+	/// </summary>
+	bool BuildCompactTable_ToGamma_8bit();
+
+
+
+	//--------------------------------
+	//	ROW KERNELS
+	//--------------------------------
+
+	/// <summary>
+	/// Converts run of samples with lookup table.
+	/// Loop has no dependencies between iterations so compiler can unroll and vectorize it.
+	/// </summary>
+	template <typename TSrc, typename TDst>
+	static inline void LookupRow(const TSrc* src, TDst* dst, int count, const TDst* table) {
+		for (int i = 0; i < count; i++)
+			dst[i] = table[src[i]];
+	}
+
+	/// <summary>
+	/// Converts run of 16 bit samples with 16 bit table.
+	/// Uses AVX2 gathers when processor supports them.
+	/// </summary>
+	static inline void LookupRow_16bit(const uint16_t* src, uint16_t* dst, int count, const uint16_t* table) {
+		if (HAS_AVX2)
+			LookupRow_16bit_AVX2(src, dst, count, table);
+		else
+			LookupRow(src, dst, count, table);
+	}
+
+	/// <summary>
+	/// Converts run of linear samples to 8 bit gamma corrected samples with compact table.
+	/// Uses AVX2 gathers when processor supports them.
+	/// </summary>
+	static inline void LookupRow_ToGamma_8bit_Compact(const uint16_t* src, uint8_t* dst, int count, const uint32_t* compact) {
+		if (HAS_AVX2)
+			LookupRow_ToGamma_8bit_Compact_AVX2(src, dst, count, compact);
+		else
+			LookupRow_ToGamma_8bit_Compact_Scalar(src, dst, count, compact);
+	}
+
+	static inline void LookupRow_ToGamma_8bit_Compact_Scalar(const uint16_t* src, uint8_t* dst, int count, const uint32_t* compact) {
+		for (int i = 0; i < count; i++) {
+			uint32_t lin = src[i];
+			uint32_t entry = compact[lin >> COMPACT_TABLE_SHIFT];
+			dst[i] = static_cast<uint8_t>((entry & 0xFF) + (lin >= (entry >> 8) ? 1 : 0));
+		}
+	}
+
+	/// <summary>
+	/// AVX2 versions of the lookups, 8 samples per step with scalar tail.
+	/// Should be called only if HAS_AVX2 is set.
+	/// </summary>
+	static void LookupRow_16bit_AVX2(const uint16_t* src, uint16_t* dst, int count, const uint16_t* table);
+	static void LookupRow_ToGamma_8bit_Compact_AVX2(const uint16_t* src, uint8_t* dst, int count, const uint32_t* compact);
+
+	/// <summary>
+	/// Checks that processor and OS support AVX2.
+	/// </summary>
+	static bool IsAVX2Supported();
+
+
+
+	/// <summary>
+	/// Converts color samples of a row with lookup table, skipping alpha samples.
+	/// Used for in-place conversion where alpha can not be restored from the source after whole row lookup.
+	/// </summary>
+	template <typename T>
+	static inline void LookupRow_SkipAlpha(const T* src, T* dst, int width, int num_cmp, const T* table) {
+		int num_color_cmp = num_cmp - 1;
+		for (int px = 0; px < width; px++)
+			for (int cmp = 0; cmp < num_color_cmp; cmp++)
+				dst[px * num_cmp + cmp] = table[src[px * num_cmp + cmp]];
+	}
+
+	/// <summary>
+	/// Converts sample between 8 and 16 bit scales.
+	/// </summary>
+	template <typename TSrc, typename TDst>
+	static inline TDst ScaleSample(TSrc value) {
+		if constexpr (sizeof(TSrc) == sizeof(TDst))
+			return static_cast<TDst>(value);
+		else if constexpr (sizeof(TSrc) < sizeof(TDst))
+			return static_cast<TDst>(value * 257);
+		else
+			return static_cast<TDst>((static_cast<uint32_t>(value) + 128) / 257);
+	}
+
+	/// <summary>
+	/// Computes linear luma of a run of gamma-corrected color pixels with Rec.709 weights.
+	/// </summary>
+	template <typename TSrc>
+	static inline void LumaRow(const TSrc* src, int src_num_cmp, uint16_t* luma, int width, const uint16_t* to_linear) {
+		for (int px = 0; px < width; px++) {
+			const TSrc* pixel = src + px * src_num_cmp;
+			uint32_t sum = LUMA_WEIGHT_R * to_linear[pixel[0]] + LUMA_WEIGHT_G * to_linear[pixel[1]] + LUMA_WEIGHT_B * to_linear[pixel[2]];
+			luma[px] = static_cast<uint16_t>((sum + 32768) >> 16);
+		}
+	}
+
+	/// <summary>
+	/// Converts one row for ConvertLayoutInto.
+	/// Luma and gamma scratch rows should hold at least width samples.
+	/// </summary>
+	template <typename TSrc, typename TDst>
+	void ConvertLayoutRow(const TSrc* src, int src_num_cmp, bool src_has_alpha, TDst* dst, int dst_num_cmp, bool dst_has_alpha, int width, uint16_t* luma_scratch, TDst* gamma_scratch);
+
+	/// <summary>
+	/// Replaces 16 bit samples of every row with their table values, rows are processed in parallel.
+	/// </summary>
+	static void LookupRowsInPlace(uint16_t** data, int height, int width, int num_cmp, bool has_alpha, const uint16_t* table);
+
 
 
 	//--------------------------------
@@ -87,11 +333,20 @@ protected:
 	//  TO BE DEFINED BY CONCRETE CLASSES
 	//--------------------------------
 
-	virtual void FillTableToLinear_8bit() = 0;
-	virtual void FillTableToLinear_16bit() = 0;
+	//Fill allocated table with conversion values
+	virtual void FillTableToLinear_8bit(uint16_t* table) = 0;
+	virtual void FillTableToLinear_16bit(uint16_t* table) = 0;
+
+	virtual void FillTableToGamma_8bit(uint8_t* table) = 0;
+	virtual void FillTableToGamma_16bit(uint16_t* table) = 0;
+
+	//Return table compiled into the binary, or nullptr if the table has to be allocated and filled.
+	//Returned data is used directly and must live as long as the converter.
+	virtual const uint16_t* GetCompiledTableToLinear_8bit() { return nullptr; }
+	virtual const uint16_t* GetCompiledTableToLinear_16bit() { return nullptr; }
 
-	virtual void FillTableToGamma_8bit() = 0;
-	virtual void FillTableToGamma_16bit() = 0;
+	virtual const uint8_t* GetCompiledTableToGamma_8bit() { return nullptr; }
+	virtual const uint16_t* GetCompiledTableToGamma_16bit() { return nullptr; }
 
 
 
@@ -0,0 +1,64 @@
+#include "GammaConverter_IccCurve.h"
+
+
+//--------------------------------------------
+//	TO LINEAR TABLE BUILDING METHODS
+//--------------------------------------------
+
+/// <summary>
+/// Builds conversion table for 8 bit values with ICC tone curve.
+/// Table is used to convert gamma corrected brightness value (non-linear) to 16 bit linear scale [0..65535].
+/// </summary>
+void GammaConverter_IccCurve::FillTableToLinear_8bit(uint16_t* table) {
+	for (int gamma_value = 0; gamma_value < WIDTH_8BIT; gamma_value++) {
+		double linear_value = _curve.ToLinear(static_cast<double>(gamma_value) / MAX_8BIT_DOUBLE) * MAX_16BIT_DOUBLE;
+		table[gamma_value] = static_cast<uint16_t>(std::lround(linear_value));
+	}
+}
+
+
+/// <summary>
+/// Builds conversion table for 16 bit values with ICC tone curve.
+/// Table is used to convert gamma corrected brightness value (non-linear) to 16 bit linear scale [0..65535].
+/// </summary>
+void GammaConverter_IccCurve::FillTableToLinear_16bit(uint16_t* table) {
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int gamma_value = range.begin(); gamma_value < range.end(); gamma_value++) {
+			double linear_value = _curve.ToLinear(static_cast<double>(gamma_value) / MAX_16BIT_DOUBLE) * MAX_16BIT_DOUBLE;
+			table[gamma_value] = static_cast<uint16_t>(std::lround(linear_value));
+		}
+	});
+}
+
+
+
+//--------------------------------------------
+//	FROM LINEAR TABLE BUILDING METHODS
+//--------------------------------------------
+
+/// <summary>
+/// Builds conversion table for 8 bit values with inverse of ICC tone curve.
+/// Table is used to convert 16 bit linear scale brightness values to gamma corrected brightness value.
+/// </summary>
+void GammaConverter_IccCurve::FillTableToGamma_8bit(uint8_t* table) {
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int linear_value = range.begin(); linear_value < range.end(); linear_value++) {
+			double gamma_value = _curve.ToEncoded(static_cast<double>(linear_value) / MAX_16BIT_DOUBLE) * MAX_8BIT_DOUBLE;
+			table[linear_value] = static_cast<uint8_t>(std::lround(gamma_value));
+		}
+	});
+}
+
+
+/// <summary>
+/// Builds conversion table for 16 bit values with inverse of ICC tone curve.
+/// Table is used to convert 16 bit linear scale brightness values to gamma corrected brightness value.
+/// </summary>
+void GammaConverter_IccCurve::FillTableToGamma_16bit(uint16_t* table) {
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int linear_value = range.begin(); linear_value < range.end(); linear_value++) {
+			double gamma_value = _curve.ToEncoded(static_cast<double>(linear_value) / MAX_16BIT_DOUBLE) * MAX_16BIT_DOUBLE;
+			table[linear_value] = static_cast<uint16_t>(std::lround(gamma_value));
+		}
+	});
+}
@@ -0,0 +1,72 @@
+#pragma once
+//Internal
+#include "GammaConverter.h"
+#include "IccToneCurve.h"
+
+/// <summary>
+/// Gamma converter built from tone curve of embedded ICC profile.
+/// Used for Adobe RGB, Display P3, ProPhoto and other profiles that are not plain sRGB.
+/// </summary>
+/// <remarks>
+/// Tables are built in parallel on first use like for other converters.
+/// GammaDispatcher keeps one converter per curve hash, so images with the same profile reuse built tables.
+/// </remarks>
+class GammaConverter_IccCurve : public GammaConverter
+{
+public:
+	//--------------------------------------------
+	//	GET/SET
+	//--------------------------------------------
+
+	const IccToneCurve& GetCurve() const { return _curve; }
+
+	//--------------------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------------------
+
+	GammaConverter_IccCurve(const IccToneCurve& curve) : _curve(curve) {}
+
+private:
+	//--------------------------------------------
+	//	PRIVATE DATA
+	//--------------------------------------------
+
+	IccToneCurve _curve;
+
+
+
+	//--------------------------------------------
+	//	TO LINEAR TABLE BUILDING METHODS
+	//--------------------------------------------
+
+	/// <summary>
+	/// Builds conversion table for 8 bit values with ICC tone curve.
+	/// Table is used to convert gamma corrected brightness value (non-linear) to 16 bit linear scale [0..65535].
+	/// </summary>
+	void FillTableToLinear_8bit(uint16_t* table) override;
+
+	/// <summary>
+	/// Builds conversion table for 16 bit values with ICC tone curve.
+	/// Table is used to convert gamma corrected brightness value (non-linear) to 16 bit linear scale [0..65535].
+	/// </summary>
+	void FillTableToLinear_16bit(uint16_t* table) override;
+
+
+
+	//--------------------------------------------
+	//	FROM LINEAR TABLE BUILDING METHODS
+	//--------------------------------------------
+
+	/// <summary>
+	/// Builds conversion table for 8 bit values with inverse of ICC tone curve.
+	/// Table is used to convert 16 bit linear scale brightness values to gamma corrected brightness value.
+	/// </summary>
+	void FillTableToGamma_8bit(uint8_t* table) override;
+
+	/// <summary>
+	/// Builds conversion table for 16 bit values with inverse of ICC tone curve.
+	/// Table is used to convert 16 bit linear scale brightness values to gamma corrected brightness value.
+	/// </summary>
+	void FillTableToGamma_16bit(uint16_t* table) override;
+
+};
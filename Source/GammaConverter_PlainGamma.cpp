@@ -1,6 +1,177 @@
 #include "GammaConverter_PlainGamma.h"
 
 
+//--------------------------------------------
+//	PRE-CALCULATED TABLES
+//--------------------------------------------
+
+/// <summary>
+/// Returns pre-calculated tables for given gamma, or null pointers if gamma is not one of pre-calculated values.
+/// </summary>
+GammaConverter_PlainGamma::PrecalculatedTables GammaConverter_PlainGamma::FindPrecalculatedTables(double gamma) {
+	//Exact comparison, tables were generated for these literal values
+	if (gamma == 1.8)
+		return { _table_gamma18_toLinear_8bit_data, _table_gamma18_toLinear_16bit_data, _table_gamma18_toGamma_8bit_data, _table_gamma18_toGamma_16bit_data };
+	if (gamma == 2.2)
+		return { _table_gamma22_toLinear_8bit_data, _table_gamma22_toLinear_16bit_data, _table_gamma22_toGamma_8bit_data, _table_gamma22_toGamma_16bit_data };
+	if (gamma == 2.4)
+		return { _table_gamma24_toLinear_8bit_data, _table_gamma24_toLinear_16bit_data, _table_gamma24_toGamma_8bit_data, _table_gamma24_toGamma_16bit_data };
+	return PrecalculatedTables();
+}
+
+
+
+//--------------------------------------------
+//	TABLE CACHE
+//--------------------------------------------
+
+/// <summary>
+/// Returns cache directory, default one if it was not set. Empty path means cache is disabled.
+/// </summary>
+std::filesystem::path GammaConverter_PlainGamma::GetCacheDirectory() {
+	if (_is_cache_directory_set)
+		return _cache_directory;
+
+	std::error_code error;
+	std::filesystem::path temp_directory = std::filesystem::temp_directory_path(error);
+	if (error)
+		return std::filesystem::path();
+	return temp_directory / "DotScale" / "GammaCache";
+}
+
+
+
+/// <summary>
+/// Name of the table used in cache file name.
+/// </summary>
+const char* GammaConverter_PlainGamma::GetCachedTableName(CachedTable table_id) {
+	switch (table_id) {
+	case CT_TO_LINEAR_16BIT:
+		return "toLinear_16bit";
+	case CT_TO_GAMMA_8BIT:
+		return "toGamma_8bit";
+	case CT_TO_GAMMA_16BIT:
+		return "toGamma_16bit";
+	default:
+		return "unknown";
+	}
+}
+
+
+
+/// <summary>
+/// FNV-1a hash of table data.
+/// </summary>
+uint64_t GammaConverter_PlainGamma::GetTableChecksum(const void* table, size_t table_size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(table);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < table_size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+
+
+/// <summary>
+/// Path of the cache file for given table of this converter.
+/// </summary>
+std::filesystem::path GammaConverter_PlainGamma::GetCacheFilePath(CachedTable table_id) {
+	std::filesystem::path cache_directory = GetCacheDirectory();
+	if (cache_directory.empty())
+		return cache_directory;
+
+	//Key is exact bit pattern of gamma value, so close values never share the file
+	char file_name[96];
+	snprintf(file_name, sizeof(file_name), "PlainGamma_%016llx_%s.table", static_cast<unsigned long long>(std::bit_cast<uint64_t>(gamma)), GetCachedTableName(table_id));
+	return cache_directory / file_name;
+}
+
+
+
+/// <summary>
+/// Loads table from the cache file. Returns false if there is no valid cache file for the table.
+/// </summary>
+bool GammaConverter_PlainGamma::LoadCachedTable(CachedTable table_id, void* table, size_t table_size) {
+	std::filesystem::path file_path = GetCacheFilePath(table_id);
+	if (file_path.empty())
+		return false;
+
+	std::error_code error;
+	if (std::filesystem::file_size(file_path, error) != sizeof(CacheFileHeader) + table_size || error)
+		return false;
+
+	std::ifstream file_stream(file_path, std::ios::binary);
+	if (!file_stream.is_open())
+		return false;
+
+	//Header must describe exactly this table
+	CacheFileHeader header;
+	file_stream.read(reinterpret_cast<char*>(&header), sizeof(CacheFileHeader));
+	if (static_cast<size_t>(file_stream.gcount()) != sizeof(CacheFileHeader))
+		return false;
+	if (header.magic != CACHE_FILE_MAGIC ||
+		header.version != CACHE_FILE_VERSION ||
+		header.gamma_bits != std::bit_cast<uint64_t>(gamma) ||
+		header.table_id != static_cast<uint32_t>(table_id) ||
+		header.table_size != table_size)
+		return false;
+
+	//Data must match the checksum, otherwise the table is calculated again
+	file_stream.read(static_cast<char*>(table), table_size);
+	if (static_cast<size_t>(file_stream.gcount()) != table_size)
+		return false;
+	return GetTableChecksum(table, table_size) == header.checksum;
+}
+
+
+
+/// <summary>
+/// Saves table to the cache file. Failures are ignored since the cache is optional.
+/// </summary>
+void GammaConverter_PlainGamma::SaveCachedTable(CachedTable table_id, const void* table, size_t table_size) {
+	std::filesystem::path file_path = GetCacheFilePath(table_id);
+	if (file_path.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(file_path.parent_path(), error);
+	if (error)
+		return;
+
+	CacheFileHeader header;
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.gamma_bits = std::bit_cast<uint64_t>(gamma);
+	header.table_id = static_cast<uint32_t>(table_id);
+	header.table_size = static_cast<uint32_t>(table_size);
+	header.checksum = GetTableChecksum(table, table_size);
+
+	//Table is written to temporary file unique for this process and thread and then renamed,
+	//so readers never see partially written file
+	std::filesystem::path temp_path = file_path;
+	temp_path += "." + std::to_string(_getpid()) + "_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file_stream.is_open())
+			return;
+		file_stream.write(reinterpret_cast<const char*>(&header), sizeof(CacheFileHeader));
+		file_stream.write(static_cast<const char*>(table), table_size);
+		if (!file_stream) {
+			file_stream.close();
+			std::filesystem::remove(temp_path, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temp_path, file_path, error);
+	if (error)
+		std::filesystem::remove(temp_path, error);
+}
+
+
+
 //--------------------------------------------
 //	TO LINEAR TABLE BUILDING METHODS
 //--------------------------------------------
@@ -9,8 +180,9 @@
 /// Builds conversion table for 8 bit plain gamma corrected values.
 /// Table is used to convert plain gamma corrected brightness value (non-linear) to linear scale normalized to [0..1].
 /// </summary>
-void GammaConverter_PlainGamma::FillTableToLinear_8bit() {
+void GammaConverter_PlainGamma::FillTableToLinear_8bit(uint16_t* table) {
 	//Formula for conversion is (n/255)^gamma*65535.
+	//Table is small enough to be calculated every time.
 	for (int gamma_value = 0; gamma_value < WIDTH_8BIT; gamma_value++) {
 		double linear_value_float = std::pow(static_cast<double>(gamma_value) / MAX_8BIT_DOUBLE, gamma) * MAX_16BIT_DOUBLE;
 
@@ -21,7 +193,7 @@ void GammaConverter_PlainGamma::FillTableToLinear_8bit() {
 		if (linear_value_int < 0)
 			linear_value_int = 0;
 
-		_table_toLinear_8bit[gamma_value] = static_cast<uint16_t>(linear_value_int);
+		table[gamma_value] = static_cast<uint16_t>(linear_value_int);
 	}
 }
 
@@ -30,20 +202,27 @@ void GammaConverter_PlainGamma::FillTableToLinear_8bit() {
 /// Builds conversion table for 16 bit plain gamma corrected values.
 /// Table is used to convert plain gamma corrected brightness value (non-linear) to linear scale normalized to [0..1].
 /// </summary>
-void GammaConverter_PlainGamma::FillTableToLinear_16bit() {
+void GammaConverter_PlainGamma::FillTableToLinear_16bit(uint16_t* table) {
+	if (LoadCachedTable(CT_TO_LINEAR_16BIT, table, WIDTH_16BIT * sizeof(uint16_t)))
+		return;
+
 	//Formula for conversion is (n/65535)^gamma*65535.
-	for (int gamma_value = 0; gamma_value < WIDTH_16BIT; gamma_value++) {
-		double linear_value_float = std::pow(static_cast<double>(gamma_value) / MAX_16BIT_DOUBLE, gamma) * MAX_16BIT_DOUBLE;
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int gamma_value = range.begin(); gamma_value < range.end(); gamma_value++) {
+			double linear_value_float = std::pow(static_cast<double>(gamma_value) / MAX_16BIT_DOUBLE, gamma) * MAX_16BIT_DOUBLE;
 
-		long linear_value_int = std::lround(linear_value_float);
+			long linear_value_int = std::lround(linear_value_float);
 
-		if (linear_value_int > MAX_16BIT)
-			linear_value_int = MAX_16BIT;
-		if (linear_value_int < 0)
-			linear_value_int = 0;
+			if (linear_value_int > MAX_16BIT)
+				linear_value_int = MAX_16BIT;
+			if (linear_value_int < 0)
+				linear_value_int = 0;
 
-		_table_toLinear_16bit[gamma_value] = static_cast<uint16_t>(linear_value_int);
-	}
+			table[gamma_value] = static_cast<uint16_t>(linear_value_int);
+		}
+	});
+
+	SaveCachedTable(CT_TO_LINEAR_16BIT, table, WIDTH_16BIT * sizeof(uint16_t));
 }
 
 
@@ -56,24 +235,31 @@ void GammaConverter_PlainGamma::FillTableToLinear_16bit() {
 /// Builds conversion table for 8 bit plain gamma corrected values.
 /// Table is used to convert linear scale brightness values (normalized [0..1] to plain gamma corrected brightness value.
 /// </summary>
-void GammaConverter_PlainGamma::FillTableToGamma_8bit() {
+void GammaConverter_PlainGamma::FillTableToGamma_8bit(uint8_t* table) {
+	if (LoadCachedTable(CT_TO_GAMMA_8BIT, table, WIDTH_16BIT * sizeof(uint8_t)))
+		return;
+
 	//Formula for converting back is n = ((Linear/65535)^1/gamma)*255
 	double power = 1.0 / gamma;
 
-	for (int linear_value = 0; linear_value < WIDTH_16BIT; linear_value++) {
-		//Calculating
-		double gamma_value_float = std::pow(static_cast<double>(linear_value) / MAX_16BIT_DOUBLE, power) * MAX_8BIT_DOUBLE;
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int linear_value = range.begin(); linear_value < range.end(); linear_value++) {
+			//Calculating
+			double gamma_value_float = std::pow(static_cast<double>(linear_value) / MAX_16BIT_DOUBLE, power) * MAX_8BIT_DOUBLE;
 
-		long gamma_value_int = std::lround(gamma_value_float);
+			long gamma_value_int = std::lround(gamma_value_float);
 
-		//Boundary checks
-		if (gamma_value_int > MAX_8BIT)
-			gamma_value_int = MAX_8BIT;
-		if (gamma_value_int < 0)
-			gamma_value_int = 0;
-		//Writing the result
-		_table_toGamma_8bit[linear_value] = static_cast<uint8_t>(gamma_value_int);
-	}
+			//Boundary checks
+			if (gamma_value_int > MAX_8BIT)
+				gamma_value_int = MAX_8BIT;
+			if (gamma_value_int < 0)
+				gamma_value_int = 0;
+			//Writing the result
+			table[linear_value] = static_cast<uint8_t>(gamma_value_int);
+		}
+	});
+
+	SaveCachedTable(CT_TO_GAMMA_8BIT, table, WIDTH_16BIT * sizeof(uint8_t));
 }
 
 
@@ -81,22 +267,29 @@ void GammaConverter_PlainGamma::FillTableToGamma_8bit() {
 /// Builds conversion table for 16 bit plain gamma corrected values.
 /// Table is used to convert linear scale brightness values (normalized [0..1] to plain gamma corrected brightness value.
 /// </summary>
-void GammaConverter_PlainGamma::FillTableToGamma_16bit() {
+void GammaConverter_PlainGamma::FillTableToGamma_16bit(uint16_t* table) {
+	if (LoadCachedTable(CT_TO_GAMMA_16BIT, table, WIDTH_16BIT * sizeof(uint16_t)))
+		return;
+
 	//Formula for converting back is n = ((linear/65535)^1/gamma)*65535
 	double power = 1.0 / gamma;
 
-	for (int linear_value = 0; linear_value < WIDTH_16BIT; linear_value++) {
-		//Calculating
-		double gamma_value_float = std::pow(linear_value/MAX_16BIT_DOUBLE, power) * MAX_16BIT_DOUBLE;
-		long gamma_value_int = std::lround(gamma_value_float);
+	tbb::parallel_for(tbb::blocked_range<int>(0, WIDTH_16BIT), [&](const tbb::blocked_range<int>& range) {
+		for (int linear_value = range.begin(); linear_value < range.end(); linear_value++) {
+			//Calculating
+			double gamma_value_float = std::pow(linear_value/MAX_16BIT_DOUBLE, power) * MAX_16BIT_DOUBLE;
+			long gamma_value_int = std::lround(gamma_value_float);
 
-		//Boundary checks
-		if (gamma_value_int > MAX_16BIT)
-			gamma_value_int = MAX_16BIT;
-		if (gamma_value_int < 0)
-			gamma_value_int = 0;
+			//Boundary checks
+			if (gamma_value_int > MAX_16BIT)
+				gamma_value_int = MAX_16BIT;
+			if (gamma_value_int < 0)
+				gamma_value_int = 0;
 
-		//Writing the result
-		_table_toGamma_16bit[linear_value] = static_cast<uint16_t>(gamma_value_int);
-	}
+			//Writing the result
+			table[linear_value] = static_cast<uint16_t>(gamma_value_int);
+		}
+	});
+
+	SaveCachedTable(CT_TO_GAMMA_16BIT, table, WIDTH_16BIT * sizeof(uint16_t));
 }
\ No newline at end of file
@@ -1,8 +1,29 @@
 #pragma once
+//STL
 #include <cmath>
+#include <cstdio>
+#include <bit>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <process.h>
+//Internal
 #include "GammaConverter.h"
 
-
+/// <summary>
+/// Gamma converter for plain power law: linear = value^gamma.
+/// </summary>
+/// <remarks>
+/// Tables for gamma 1.8, 2.2 and 2.4 are pre-calculated and compiled in, and converter uses them directly without copying.
+/// Tables for other gamma values are calculated in parallel and saved to the cache directory,
+/// so next process asking for the same gamma loads them from disk.
+/// Cache files are keyed by exact gamma value and table, and are replaced atomically so concurrent processes can share the directory.
+/// Each cache file starts with a header identifying the format, gamma value and table, and holding checksum of the data,
+/// files that do not match are ignored and overwritten.
+/// </remarks>
 class GammaConverter_PlainGamma : public GammaConverter
 {
 public:
@@ -18,6 +39,21 @@ public:
 
 	GammaConverter_PlainGamma(double gamma) {
 		this->gamma = gamma;
+		_precalculated = FindPrecalculatedTables(gamma);
+	}
+
+	//--------------------------------------------
+	//	TABLE CACHE
+	//--------------------------------------------
+
+	/// <summary>
+	/// Sets directory where calculated tables are saved and loaded from. Empty path disables the cache.
+	/// Default is DotScale\GammaCache in system temporary directory.
+	/// Should be set before converters are used.
+	/// </summary>
+	static void SetCacheDirectory(std::filesystem::path cache_directory) {
+		_cache_directory = cache_directory;
+		_is_cache_directory_set = true;
 	}
 
 private:
@@ -28,6 +64,144 @@ private:
 
 
 
+	//--------------------------------------------
+	//	PRE-CALCULATED TABLES
+	//--------------------------------------------
+
+	//Generated by Math/Python/PlainGamma_ConversionTables_Generator.py
+
+	static constexpr uint16_t _table_gamma18_toLinear_8bit_data[] = {
+		#include ".\data\table_Gamma18toLinear_8.data"
+	};
+	static constexpr uint16_t _table_gamma18_toLinear_16bit_data[] = {
+		#include ".\data\table_Gamma18toLinear_16.data"
+	};
+	static constexpr uint8_t _table_gamma18_toGamma_8bit_data[] = {
+		#include ".\data\table_LinearToGamma18_8.data"
+	};
+	static constexpr uint16_t _table_gamma18_toGamma_16bit_data[] = {
+		#include ".\data\table_LinearToGamma18_16.data"
+	};
+
+	static constexpr uint16_t _table_gamma22_toLinear_8bit_data[] = {
+		#include ".\data\table_Gamma22toLinear_8.data"
+	};
+	static constexpr uint16_t _table_gamma22_toLinear_16bit_data[] = {
+		#include ".\data\table_Gamma22toLinear_16.data"
+	};
+	static constexpr uint8_t _table_gamma22_toGamma_8bit_data[] = {
+		#include ".\data\table_LinearToGamma22_8.data"
+	};
+	static constexpr uint16_t _table_gamma22_toGamma_16bit_data[] = {
+		#include ".\data\table_LinearToGamma22_16.data"
+	};
+
+	static constexpr uint16_t _table_gamma24_toLinear_8bit_data[] = {
+		#include ".\data\table_Gamma24toLinear_8.data"
+	};
+	static constexpr uint16_t _table_gamma24_toLinear_16bit_data[] = {
+		#include ".\data\table_Gamma24toLinear_16.data"
+	};
+	static constexpr uint8_t _table_gamma24_toGamma_8bit_data[] = {
+		#include ".\data\table_LinearToGamma24_8.data"
+	};
+	static constexpr uint16_t _table_gamma24_toGamma_16bit_data[] = {
+		#include ".\data\table_LinearToGamma24_16.data"
+	};
+
+	/// <summary>
+	/// Pointers to pre-calculated tables of one gamma value.
+	/// </summary>
+	struct PrecalculatedTables {
+		const uint16_t* toLinear_8bit = nullptr;
+		const uint16_t* toLinear_16bit = nullptr;
+		const uint8_t* toGamma_8bit = nullptr;
+		const uint16_t* toGamma_16bit = nullptr;
+	};
+
+	/// <summary>
+	/// Pre-calculated tables for gamma of this converter. Pointers are null if there are none.
+	/// </summary>
+	PrecalculatedTables _precalculated;
+
+	const uint16_t* GetCompiledTableToLinear_8bit() override { return _precalculated.toLinear_8bit; }
+	const uint16_t* GetCompiledTableToLinear_16bit() override { return _precalculated.toLinear_16bit; }
+	const uint8_t* GetCompiledTableToGamma_8bit() override { return _precalculated.toGamma_8bit; }
+	const uint16_t* GetCompiledTableToGamma_16bit() override { return _precalculated.toGamma_16bit; }
+
+	/// <summary>
+	/// Returns pre-calculated tables for given gamma, or null pointers if gamma is not one of pre-calculated values.
+	/// </summary>
+	static PrecalculatedTables FindPrecalculatedTables(double gamma);
+
+
+
+	//--------------------------------------------
+	//	TABLE CACHE
+	//--------------------------------------------
+
+	inline static std::filesystem::path _cache_directory;
+	inline static bool _is_cache_directory_set = false;
+
+	/// <summary>
+	/// Tables that are saved to the cache. Value is stored in the cache file header.
+	/// </summary>
+	enum CachedTable {
+		CT_TO_LINEAR_16BIT = 1,
+		CT_TO_GAMMA_8BIT = 2,
+		CT_TO_GAMMA_16BIT = 3
+	};
+
+	//"DSGT" in file byte order
+	static constexpr uint32_t CACHE_FILE_MAGIC = 0x54475344;
+	//Increased when header or table format changes
+	static constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+	/// <summary>
+	/// Header written before table data in the cache file.
+	/// </summary>
+	struct CacheFileHeader {
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint64_t gamma_bits = 0; //Bit pattern of gamma value
+		uint32_t table_id = 0; //CachedTable value
+		uint32_t table_size = 0; //Size of table data in bytes
+		uint64_t checksum = 0; //FNV-1a hash of table data
+	};
+
+	/// <summary>
+	/// Name of the table used in cache file name.
+	/// </summary>
+	static const char* GetCachedTableName(CachedTable table_id);
+
+	/// <summary>
+	/// FNV-1a hash of table data.
+	/// </summary>
+	static uint64_t GetTableChecksum(const void* table, size_t table_size);
+
+	/// <summary>
+	/// Returns cache directory, default one if it was not set. Empty path means cache is disabled.
+	/// </summary>
+	static std::filesystem::path GetCacheDirectory();
+
+	/// <summary>
+	/// Path of the cache file for given table of this converter.
+	/// </summary>
+	std::filesystem::path GetCacheFilePath(CachedTable table_id);
+
+	/// <summary>
+	/// Loads table from the cache file. Returns false if there is no valid cache file for the table,
+	/// which includes files of other format version, gamma or table, and files with wrong checksum.
+	/// </summary>
+	bool LoadCachedTable(CachedTable table_id, void* table, size_t table_size);
+
+	/// <summary>
+	/// Saves table to the cache file. Failures are ignored since the cache is optional.
+	/// </summary>
+	void SaveCachedTable(CachedTable table_id, const void* table, size_t table_size);
+
+
+
 	//--------------------------------------------
 	//	TO LINEAR TABLE BUILDING METHODS
 	//--------------------------------------------
@@ -36,13 +210,13 @@ private:
 	/// Builds conversion table for 8 bit plain gamma corrected values.
 	/// Table is used to convert plain gamma corrected brightness value (non-linear) to linear scale normalized to [0..1].
 	/// </summary>
-	void FillTableToLinear_8bit() override;
+	void FillTableToLinear_8bit(uint16_t* table) override;
 
 	/// <summary>
 	/// Builds conversion table for 16 bit plain gamma corrected values.
 	/// Table is used to convert plain gamma corrected brightness value (non-linear) to linear scale normalized to [0..1].
 	/// </summary>
-	void FillTableToLinear_16bit() override;
+	void FillTableToLinear_16bit(uint16_t* table) override;
 
 
 
@@ -54,13 +228,13 @@ private:
 	/// Builds conversion table for 8 bit plain gamma corrected values.
 	/// Table is used to convert linear scale brightness values (normalized [0..1] to plain gamma corrected brightness value.
 	/// </summary>
-	void FillTableToGamma_8bit() override;
+	void FillTableToGamma_8bit(uint8_t* table) override;
 
 	/// <summary>
 	/// Builds conversion table for 16 bit plain gamma corrected values.
 	/// Table is used to convert linear scale brightness values (normalized [0..1] to plain gamma corrected brightness value.
 	/// </summary>
-	void FillTableToGamma_16bit() override;
+	void FillTableToGamma_16bit(uint16_t* table) override;
 
 };
 
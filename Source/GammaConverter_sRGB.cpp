@@ -8,9 +8,9 @@
 /// Builds conversion table for converting 8 bit sRGB values.
 /// Table is used to convert sRGB brightness value (non-linear) to 16bit linear scale [0..65535].
 /// </summary>
-void GammaConverter_sRGB::FillTableToLinear_8bit() {
+void GammaConverter_sRGB::FillTableToLinear_8bit(uint16_t* table) {
 	for (int i = 0; i < WIDTH_8BIT; i++)
-		_table_toLinear_8bit[i] = _table_toLinear_8bit_data[i];
+		table[i] = _table_toLinear_8bit_data[i];
 }
 
 
@@ -19,9 +19,9 @@ void GammaConverter_sRGB::FillTableToLinear_8bit() {
 /// Builds conversion table for 16 bit sRGB values.
 /// Table is used to convert 16 bit sRGB brightness value (non-linear) to 16bit linear scale [0..65535].
 /// </summary>
-void GammaConverter_sRGB::FillTableToLinear_16bit() {
+void GammaConverter_sRGB::FillTableToLinear_16bit(uint16_t* table) {
 	for (int i = 0; i < WIDTH_16BIT; i++)
-		_table_toLinear_16bit[i] = _table_toLinear_16bit_data[i];
+		table[i] = _table_toLinear_16bit_data[i];
 }
 
 
@@ -34,9 +34,9 @@ void GammaConverter_sRGB::FillTableToLinear_16bit() {
 /// Builds conversion table for 8 bit sRGB values.
 /// Table is used to convert linear scale 16bit brightness values [0..65535] to sRGB 8bit brightness value.
 /// </summary>
-void GammaConverter_sRGB::FillTableToGamma_8bit() {
+void GammaConverter_sRGB::FillTableToGamma_8bit(uint8_t* table) {
 	for (int i = 0; i < WIDTH_16BIT; i++)
-		_table_toGamma_8bit[i] = _table_toSRGB_8bit_data[i];
+		table[i] = _table_toSRGB_8bit_data[i];
 }
 
 
@@ -45,7 +45,7 @@ void GammaConverter_sRGB::FillTableToGamma_8bit() {
 /// Builds conversion table for 16 bit sRGB values.
 /// Table is used to convert linear scale brightness values (normalized [0..1] to sRGB brightness value.
 /// </summary>
-void GammaConverter_sRGB::FillTableToGamma_16bit() {
+void GammaConverter_sRGB::FillTableToGamma_16bit(uint16_t* table) {
 	for (int i = 0; i < WIDTH_16BIT; i++)
-		_table_toGamma_16bit[i] = _table_toSRGB_16bit_data[i];
+		table[i] = _table_toSRGB_16bit_data[i];
 }
@@ -32,13 +32,13 @@ private:
 	/// Builds conversion table for 8 bit sRGB values.
 	/// Table is used to convert sRGB brightness value (non-linear) to linear scale normalized to [0..1].
 	/// </summary>
-	void FillTableToLinear_8bit() override;
+	void FillTableToLinear_8bit(uint16_t* table) override;
 
 	/// <summary>
 	/// Builds conversion table for 16 bit sRGB values.
 	/// Table is used to convert sRGB brightness value (non-linear) to linear scale normalized to [0..1].
 	/// </summary>
-	void FillTableToLinear_16bit() override;
+	void FillTableToLinear_16bit(uint16_t* table) override;
 
 
 	//--------------------------------------------
@@ -49,13 +49,13 @@ private:
 	/// Builds conversion table for 8 bit sRGB values.
 	/// Table is used to convert linear scale brightness values (normalized [0..1] to sRGB brightness value.
 	/// </summary>
-	void FillTableToGamma_8bit() override;
+	void FillTableToGamma_8bit(uint8_t* table) override;
 
 	/// <summary>
 	/// Builds conversion table for 16 bit sRGB values.
 	/// Table is used to convert linear scale brightness values (normalized [0..1] to sRGB brightness value.
 	/// </summary>
-	void FillTableToGamma_16bit() override;
+	void FillTableToGamma_16bit(uint16_t* table) override;
 
 };
 
@@ -4,8 +4,14 @@
 //	DATA FIELDS INITIALIZATION
 //--------------------------------
 
-std::map<double, GammaConverter_PlainGamma*> GammaDispatcher::PG_converters;
+tbb::concurrent_unordered_map<double, GammaConverter_PlainGamma*> GammaDispatcher::PG_converters;
+std::mutex GammaDispatcher::ICC_mutex;
+std::unordered_map<uint64_t, GammaDispatcher::IccConverterEntry> GammaDispatcher::ICC_converters;
+std::unordered_map<uint64_t, GammaDispatcher::IccProfileEntry> GammaDispatcher::ICC_profiles;
+std::vector<GammaConverter_IccCurve*> GammaDispatcher::ICC_evicted;
+uint64_t GammaDispatcher::ICC_use_counter = 0;
 GammaConverter_sRGB* GammaDispatcher::sRGB_conv = NULL;
+std::once_flag GammaDispatcher::sRGB_once;
 
 
 
@@ -15,24 +21,128 @@ GammaConverter* GammaDispatcher::GetConverter(RawImageGammaProfile colorspace, v
 	switch (colorspace)
 	{
 	case RawImageGammaProfile::sRGB:
-		if (sRGB_conv == NULL)
-			sRGB_conv = new GammaConverter_sRGB();
+		std::call_once(sRGB_once, [] { sRGB_conv = new GammaConverter_sRGB(); });
 		return static_cast<GammaConverter*>(sRGB_conv);
 		break;
 
-	case RawImageGammaProfile::PlainGamma:
+	case RawImageGammaProfile::PlainGamma: {
 		gamma = *reinterpret_cast<double*>(param);
-		if (PG_converters.count(gamma) == 0) {
-			GammaConverter_PlainGamma* pg_conv = new GammaConverter_PlainGamma(gamma);
-			PG_converters[gamma] = pg_conv;
-			return pg_conv;
-		}
-		else
-			return PG_converters[gamma];
+		auto found = PG_converters.find(gamma);
+		if (found != PG_converters.end())
+			return found->second;
+
+		//Constructing converter is cheap since tables are built on demand.
+		//If other thread has inserted converter for the same gamma first, ours is discarded.
+		GammaConverter_PlainGamma* pg_conv = new GammaConverter_PlainGamma(gamma);
+		auto inserted = PG_converters.emplace(gamma, pg_conv);
+		if (inserted.second == false)
+			delete pg_conv;
+		return inserted.first->second;
+	}
+		break;
+
+	case RawImageGammaProfile::IccProfile:
+		if (param == NULL)
+			return NULL;
+		return GetIccConverter(*reinterpret_cast<const std::vector<uint8_t>*>(param));
 		break;
 
 	default:
 		return NULL;
 		break;
 	}
+}
+
+
+
+GammaConverter* GammaDispatcher::WarmUp(RawImageGammaProfile colorspace, void* param) {
+	GammaConverter* converter = GetConverter(colorspace, param);
+	if (converter != NULL)
+		converter->InitializeTables();
+	return converter;
+}
+
+
+
+
+void GammaDispatcher::ReleaseEvictedConverters() {
+	std::lock_guard<std::mutex> lock(ICC_mutex);
+	for (GammaConverter_IccCurve* converter : ICC_evicted)
+		delete converter;
+	ICC_evicted.clear();
+}
+
+
+
+GammaConverter* GammaDispatcher::GetIccConverter(const std::vector<uint8_t>& profile) {
+	uint64_t profile_hash = IccToneCurve::GetDataHash(profile.data(), profile.size());
+
+	//1. Profile seen before
+	{
+		std::lock_guard<std::mutex> lock(ICC_mutex);
+		auto found = ICC_profiles.find(profile_hash);
+		if (found != ICC_profiles.end()) {
+			if (found->second.is_curve_converter)
+				ICC_converters[found->second.curve_hash].last_use = ++ICC_use_counter;
+			return found->second.converter;
+		}
+	}
+
+	//2. Parsing the profile without holding the lock
+	IccToneCurve curve;
+	IccProfileEntry entry = { NULL, false, 0 };
+	if (IccToneCurve::ReadFromProfile(profile, curve)) {
+		//Single gamma curves (like Adobe RGB) share plain gamma converters and their table cache
+		if (curve.GetType() == IccCurveType::ICT_GAMMA) {
+			double gamma = curve.GetGamma();
+			entry.converter = GetConverter(RawImageGammaProfile::PlainGamma, &gamma);
+		}
+		else {
+			entry.is_curve_converter = true;
+			entry.curve_hash = curve.GetHash();
+		}
+	}
+
+	//3. Getting curve converter and remembering the profile, unsupported profiles are remembered too
+	std::lock_guard<std::mutex> lock(ICC_mutex);
+	if (entry.is_curve_converter)
+		entry.converter = AcquireIccConverter(curve);
+	if (ICC_profiles.size() >= MAX_ICC_PROFILES)
+		ICC_profiles.clear();
+	ICC_profiles[profile_hash] = entry;
+	return entry.converter;
+}
+
+
+
+GammaConverter_IccCurve* GammaDispatcher::AcquireIccConverter(const IccToneCurve& curve) {
+	//1. Converter for the same curve exists
+	auto found = ICC_converters.find(curve.GetHash());
+	if (found != ICC_converters.end()) {
+		found->second.last_use = ++ICC_use_counter;
+		return found->second.converter;
+	}
+
+	//2. Evicting least recently used converter over the limit
+	if (ICC_converters.size() >= MAX_ICC_CONVERTERS) {
+		auto oldest = ICC_converters.begin();
+		for (auto it = ICC_converters.begin(); it != ICC_converters.end(); it++)
+			if (it->second.last_use < oldest->second.last_use)
+				oldest = it;
+
+		//Profiles pointing to evicted converter are forgotten
+		uint64_t evicted_hash = oldest->first;
+		std::erase_if(ICC_profiles, [evicted_hash](const auto& profile) {
+			return profile.second.is_curve_converter && profile.second.curve_hash == evicted_hash;
+		});
+
+		//Converter can still be used by callers, so it is kept until ReleaseEvictedConverters
+		ICC_evicted.push_back(oldest->second.converter);
+		ICC_converters.erase(oldest);
+	}
+
+	//3. Creating new converter, which is cheap since tables are built on demand
+	GammaConverter_IccCurve* converter = new GammaConverter_IccCurve(curve);
+	ICC_converters.emplace(curve.GetHash(), IccConverterEntry{ converter, ++ICC_use_counter });
+	return converter;
 }
\ No newline at end of file
@@ -1,21 +1,118 @@
 #pragma once
-#include <map>
+//STL
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+//Third party
+#include "oneapi\tbb.h"
+//Internal
 #include "GammaConverter.h"
 #include "GammaConverter_sRGB.h"
 #include "GammaConverter_PlainGamma.h"
+#include "GammaConverter_IccCurve.h"
+#include "IccToneCurve.h"
 
+/// <summary>
+/// Provides shared gamma converters.
+/// One converter is created for each profile (and each gamma value for plain gamma) and lives until the program ends.
+/// Only ICC curve converters are limited in number, see GetConverter.
+/// Can be called from several threads at once.
+/// </summary>
 class GammaDispatcher
 {
 public:
+	/// <summary>
+	/// Returns shared converter for the profile. For plain gamma param points to double gamma value.
+	/// For ICC profile param points to std::vector&lt;uint8_t&gt; with profile data.
+	/// Returns NULL for unsupported profile, including ICC profiles without supported tone curve.
+	/// </summary>
+	/// <remarks>
+	/// ICC converters are shared by all profiles with the same tone curve, found by curve hash.
+	/// ICC curves that are a single gamma value are served by plain gamma converter.
+	/// Profiles seen before are recognized by hash of profile data and are not parsed again.
+	///
+	/// At most MAX_ICC_CONVERTERS ICC curve converters are kept. When a new curve comes over the limit
+	/// the least recently requested converter is evicted. Evicted converter stays valid, since callers may still use it,
+	/// until ReleaseEvictedConverters is called.
+	/// </remarks>
 	static GammaConverter* GetConverter(RawImageGammaProfile colorspace, void* param);
 
+	/// <summary>
+	/// Returns shared converter for the profile with all its tables built.
+	/// Intended to be called at startup so the first conversion does not pay for table building.
+	/// For plain gamma param points to double gamma value. Returns NULL for unsupported profile.
+	/// </summary>
+	static GammaConverter* WarmUp(RawImageGammaProfile colorspace, void* param);
+
+	/// <summary>
+	/// Deletes ICC converters evicted from the dispatcher.
+	/// Should not be called while converters returned for ICC profiles before may be in use.
+	/// </summary>
+	static void ReleaseEvictedConverters();
+
+	//--------------------------------
+	//	CONSTANTS
+	//--------------------------------
+
+	/// <summary>
+	/// Maximum number of ICC curve converters kept by the dispatcher.
+	/// </summary>
+	static constexpr size_t MAX_ICC_CONVERTERS = 16;
+
+	/// <summary>
+	/// Maximum number of remembered ICC profiles. Remembered profiles are forgotten all at once when limit is reached.
+	/// </summary>
+	static constexpr size_t MAX_ICC_PROFILES = 256;
+
 private:
+	//--------------------------------
+	//	PRIVATE TYPES
+	//--------------------------------
+
+	/// <summary>
+	/// ICC curve converter with the time it was last requested.
+	/// </summary>
+	struct IccConverterEntry {
+		GammaConverter_IccCurve* converter;
+		uint64_t last_use;
+	};
+
+	/// <summary>
+	/// Result of parsing ICC profile.
+	/// </summary>
+	struct IccProfileEntry {
+		GammaConverter* converter; //NULL for unsupported profile
+		bool is_curve_converter; //Converter is in ICC_converters under curve_hash
+		uint64_t curve_hash;
+	};
+
 	//--------------------------------
 	//	DATA FIELDS
 	//--------------------------------
 
-	static std::map<double, GammaConverter_PlainGamma*> PG_converters;
+	static tbb::concurrent_unordered_map<double, GammaConverter_PlainGamma*> PG_converters;
+	//ICC data is guarded by ICC_mutex
+	static std::mutex ICC_mutex;
+	static std::unordered_map<uint64_t, IccConverterEntry> ICC_converters; //By curve hash
+	static std::unordered_map<uint64_t, IccProfileEntry> ICC_profiles; //By profile data hash
+	static std::vector<GammaConverter_IccCurve*> ICC_evicted;
+	static uint64_t ICC_use_counter;
 	static GammaConverter_sRGB* sRGB_conv;
+	static std::once_flag sRGB_once;
 
-};
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns converter for ICC profile data.
+	/// </summary>
+	static GammaConverter* GetIccConverter(const std::vector<uint8_t>& profile);
 
+	/// <summary>
+	/// Finds or creates converter for the curve, evicting least recently used one over the limit.
+	/// Called with ICC_mutex locked.
+	/// </summary>
+	static GammaConverter_IccCurve* AcquireIccConverter(const IccToneCurve& curve);
+
+};
@@ -0,0 +1,197 @@
+#pragma once
+//STL
+#include <cstdint>
+#include <stdexcept>
+//Internal
+#include "SliceProcessor.h"
+#include "GammaConverter.h"
+#include "ImageBuffer_Byte.h"
+
+/// <summary>
+/// Direction of conversion done by GammaSliceConverter.
+/// </summary>
+enum GammaSliceDirection {
+	GSD_REMOVE, // Gamma-corrected slices are converted to linear scale.
+	GSD_APPLY // Linear slices are converted to gamma-corrected values.
+};
+
+
+/// <summary>
+/// Converts image to or from linear brightness scale slice by slice.
+/// </summary>
+/// <remarks>
+/// Sits between a reader and Downscaler (or between Downscaler and a writer),
+/// so the whole image is never held in memory in either form.
+/// Output buffers passed to the Into methods are reused between calls,
+/// so streaming slices of the same height does not allocate after the first slice.
+/// Converter is not owned and should outlive this object.
+/// </remarks>
+class GammaSliceConverter : public SliceProcessor {
+public:
+	//--------------------------------
+	//	ACCESSORS
+	//--------------------------------
+
+	/// <summary>
+	/// Number of image rows converted so far.
+	/// </summary>
+	uint32_t GetRowsConverted() const { return _rows_converted; }
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Builds slice converter for the image of given size.
+	/// Bit depth is the depth of gamma-corrected side: depth of source slices for removal, depth of resulting slices for application.
+	/// </summary>
+	GammaSliceConverter(GammaConverter* converter, GammaSliceDirection direction, ImagePixelLayout layout, BitDepth bit_depth, uint32_t height, uint32_t width) :
+		_converter(converter),
+		_direction(direction),
+		_layout(layout),
+		_bit_depth(bit_depth),
+		_height(height),
+		_width(width)
+	{
+		SetSliceProcessorName("Gamma slice converter");
+
+		if (converter == nullptr)
+			throw std::invalid_argument("GammaSliceConverter init: Converter is null.");
+		if (layout == ImagePixelLayout::UNDEF)
+			throw std::invalid_argument("GammaSliceConverter init: Cannot convert image with undefined layout.");
+		if (bit_depth != BitDepth::BD_8_BIT && bit_depth != BitDepth::BD_16_BIT)
+			throw std::invalid_argument("GammaSliceConverter init: Only 8 and 16 bit images are supported.");
+
+		if (height == 0)
+			SetState_Finished();
+		else
+			SetState_Start();
+	}
+
+	//--------------------------------
+	//	SLICE CONVERSION
+	//--------------------------------
+
+	/// <summary>
+	/// Converts next gamma-corrected slice to linear scale and returns the result.
+	/// When all rows are converted returns empty slice.
+	/// </summary>
+	ImageBuffer_uint16 RemoveNext(const ImageBufferView_Byte& slice) {
+		ImageBuffer_uint16 linear_slice(0, _width, _layout, false);
+		RemoveNextInto(slice, linear_slice);
+		return linear_slice;
+	}
+
+	/// <summary>
+	/// Converts next gamma-corrected slice to linear scale into caller provided buffer.
+	/// Buffer is reshaped to the slice size reusing its memory when possible.
+	/// When all rows are converted buffer is reshaped to zero rows.
+	/// <para>Throws std::invalid_argument if slice does not match the image or goes past its last row.</para>
+	/// </summary>
+	void RemoveNextInto(const ImageBufferView_Byte& slice, ImageBuffer_uint16& linear_slice) {
+		if (_direction != GammaSliceDirection::GSD_REMOVE)
+			throw std::logic_error("GammaSliceConverter: Converter was built for gamma application.");
+		if (CheckStateForNext() == false) {
+			linear_slice.Reshape(0, _width, _layout);
+			return;
+		}
+		if (slice.GetBitPerComponent() != _bit_depth)
+			throw std::invalid_argument("GammaSliceConverter: Slice bit depth does not match the image.");
+		CheckSlice(slice.GetHeight(), slice.GetWidth(), slice.GetLayout());
+
+		_converter->RemoveGammaCorrectionInto(slice, linear_slice);
+
+		AdvanceRows(slice.GetHeight());
+	}
+
+	/// <summary>
+	/// Converts next linear slice to gamma-corrected values and returns the result.
+	/// When all rows are converted returns empty slice.
+	/// </summary>
+	ImageBuffer_Byte ApplyNext(const ImageBufferView_uint16& slice) {
+		ImageBuffer_Byte gamma_slice(0, _width, _layout, _bit_depth, false);
+		ApplyNextInto(slice, gamma_slice);
+		return gamma_slice;
+	}
+
+	/// <summary>
+	/// Converts next linear slice to gamma-corrected values into caller provided buffer.
+	/// Buffer is reshaped to the slice size reusing its memory when possible.
+	/// When all rows are converted buffer is reshaped to zero rows.
+	/// <para>Throws std::invalid_argument if slice does not match the image or goes past its last row.</para>
+	/// </summary>
+	void ApplyNextInto(const ImageBufferView_uint16& slice, ImageBuffer_Byte& gamma_slice) {
+		if (_direction != GammaSliceDirection::GSD_APPLY)
+			throw std::logic_error("GammaSliceConverter: Converter was built for gamma removal.");
+		if (CheckStateForNext() == false) {
+			if (gamma_slice.GetBitPerComponent() == _bit_depth)
+				gamma_slice.Reshape(0, _width, _layout);
+			else
+				gamma_slice = ImageBuffer_Byte(0, _width, _layout, _bit_depth, false);
+			return;
+		}
+		CheckSlice(slice.GetHeight(), slice.GetWidth(), slice.GetLayout());
+
+		_converter->ApplyGammaCorrectionInto(slice, _bit_depth, gamma_slice);
+
+		AdvanceRows(slice.GetHeight());
+	}
+
+	/// <summary>
+	/// Converts next slice in place. Works for 16 bit images only since samples keep their width.
+	/// Removal expects gamma-corrected values and leaves linear ones, application does the opposite.
+	/// <para>Throws std::invalid_argument if slice does not match the image or goes past its last row.</para>
+	/// </summary>
+	void ConvertNextInPlace(ImageBuffer_uint16& slice) {
+		if (CheckStateForNext() == false)
+			return;
+		if (_bit_depth != BitDepth::BD_16_BIT)
+			throw std::invalid_argument("GammaSliceConverter: In-place conversion requires 16 bit image.");
+		CheckSlice(slice.GetHeight(), slice.GetWidth(), slice.GetLayout());
+
+		if (_direction == GammaSliceDirection::GSD_REMOVE)
+			_converter->RemoveGammaCorrectionInPlace(slice);
+		else
+			_converter->ApplyGammaCorrectionInPlace(slice);
+
+		AdvanceRows(slice.GetHeight());
+	}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	GammaConverter* _converter = nullptr;
+	GammaSliceDirection _direction = GammaSliceDirection::GSD_REMOVE;
+	ImagePixelLayout _layout = ImagePixelLayout::UNDEF;
+	BitDepth _bit_depth = BitDepth::BD_8_BIT;
+	uint32_t _height = 0;
+	uint32_t _width = 0;
+	uint32_t _rows_converted = 0;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Checks that slice has image width and layout and fits into remaining rows.
+	/// </summary>
+	void CheckSlice(int slice_height, int slice_width, ImagePixelLayout slice_layout) {
+		if (static_cast<uint32_t>(slice_width) != _width || slice_layout != _layout)
+			throw std::invalid_argument("GammaSliceConverter: Slice width or layout does not match the image.");
+		if (static_cast<uint32_t>(slice_height) > _height - _rows_converted)
+			throw std::invalid_argument("GammaSliceConverter: Slice goes past the last row of the image.");
+	}
+
+	/// <summary>
+	/// Advances row counter and updates the state.
+	/// </summary>
+	void AdvanceRows(int slice_height) {
+		_rows_converted += static_cast<uint32_t>(slice_height);
+		if (_rows_converted == _height)
+			SetState_Finished();
+		else
+			SetState_Continue();
+	}
+};
@@ -0,0 +1,239 @@
+#include "IccToneCurve.h"
+
+//--------------------------------
+//	EVALUATION
+//--------------------------------
+
+/// <summary>
+/// Converts gamma-corrected value [0..1] to linear brightness [0..1].
+/// </summary>
+double IccToneCurve::ToLinear(double value) const {
+	value = std::clamp(value, 0.0, 1.0);
+	double linear = value;
+
+	switch (_type) {
+	case IccCurveType::ICT_IDENTITY:
+		break;
+
+	case IccCurveType::ICT_GAMMA:
+		linear = std::pow(value, _params[0]);
+		break;
+
+	case IccCurveType::ICT_PARAMETRIC: {
+		double g = _params[0], a = _params[1], b = _params[2], c = _params[3], d = _params[4], e = _params[5], f = _params[6];
+		switch (_function_type) {
+		case 0:
+			linear = std::pow(value, g);
+			break;
+		case 1:
+			linear = value >= -b / a ? std::pow(std::max(a * value + b, 0.0), g) : 0.0;
+			break;
+		case 2:
+			linear = value >= -b / a ? std::pow(std::max(a * value + b, 0.0), g) + c : c;
+			break;
+		case 3:
+			linear = value >= d ? std::pow(std::max(a * value + b, 0.0), g) : c * value;
+			break;
+		default:
+			linear = value >= d ? std::pow(std::max(a * value + b, 0.0), g) + e : c * value + f;
+			break;
+		}
+	}
+		break;
+
+	case IccCurveType::ICT_SAMPLED: {
+		double position = value * static_cast<double>(_samples.size() - 1);
+		size_t index = static_cast<size_t>(position);
+		if (index >= _samples.size() - 1)
+			return _samples.back();
+		double fraction = position - static_cast<double>(index);
+		linear = _samples[index] + (_samples[index + 1] - _samples[index]) * fraction;
+	}
+		break;
+	}
+
+	return std::clamp(linear, 0.0, 1.0);
+}
+
+
+
+/// <summary>
+/// Converts linear brightness [0..1] to gamma-corrected value [0..1].
+/// Curve has no closed form inverse in general, so the smallest value with ToLinear(value) >= linear is found by bisection.
+/// </summary>
+double IccToneCurve::ToEncoded(double linear) const {
+	if (_type == IccCurveType::ICT_IDENTITY)
+		return std::clamp(linear, 0.0, 1.0);
+	if (_type == IccCurveType::ICT_GAMMA)
+		return std::pow(std::clamp(linear, 0.0, 1.0), 1.0 / _params[0]);
+
+	//Curves are non-decreasing, 40 steps give precision far below 16 bit step
+	double low = 0.0;
+	double high = 1.0;
+	for (int step = 0; step < 40; step++) {
+		double middle = (low + high) * 0.5;
+		if (ToLinear(middle) < linear)
+			low = middle;
+		else
+			high = middle;
+	}
+	return high;
+}
+
+
+
+//--------------------------------
+//	PARSING
+//--------------------------------
+
+/// <summary>
+/// Reads tone curve from ICC profile data.
+/// Returns false if profile is malformed, has no supported tone curve or its RGB channel curves differ.
+/// </summary>
+bool IccToneCurve::ReadFromProfile(const uint8_t* profile, size_t size, IccToneCurve& curve) {
+	//----------------------------------------------------------------------
+	// 1 - Header
+
+	//128 bytes header followed by tag count
+	if (profile == nullptr || size < 132)
+		return false;
+	//Profile signature 'acsp'
+	if (ReadUInt32(profile + 36) != 0x61637370)
+		return false;
+	size = std::min(size, static_cast<size_t>(ReadUInt32(profile)));
+
+	//Data colour space 'RGB ' or 'GRAY'
+	uint32_t color_space = ReadUInt32(profile + 16);
+	if (color_space != 0x52474220 && color_space != 0x47524159)
+		return false;
+
+	uint32_t tag_count = ReadUInt32(profile + 128);
+	if (tag_count > (size - 132) / 12)
+		return false;
+
+	//----------------------------------------------------------------------
+	// 2 - Grayscale profile, single kTRC curve
+
+	if (color_space == 0x47524159)
+		return ReadCurveBySignature(profile, size, 0x6B545243, curve); //'kTRC'
+
+	//----------------------------------------------------------------------
+	// 3 - RGB profile, rTRC, gTRC and bTRC curves must be the same
+
+	IccToneCurve red, green, blue;
+	if (!ReadCurveBySignature(profile, size, 0x72545243, red) ||	//'rTRC'
+		!ReadCurveBySignature(profile, size, 0x67545243, green) ||	//'gTRC'
+		!ReadCurveBySignature(profile, size, 0x62545243, blue))		//'bTRC'
+		return false;
+
+	if (!AreCurvesEqual(green, red) || !AreCurvesEqual(green, blue))
+		return false;
+
+	curve = std::move(green);
+	return true;
+}
+
+
+
+/// <summary>
+/// Finds tag with given signature in the tag table and reads curve from it.
+/// Returns false if there is no such tag, it is out of profile bounds or is not a supported curve.
+/// </summary>
+bool IccToneCurve::ReadCurveBySignature(const uint8_t* profile, size_t size, uint32_t signature, IccToneCurve& curve) {
+	uint32_t tag_count = ReadUInt32(profile + 128);
+
+	for (uint32_t tag = 0; tag < tag_count; tag++) {
+		const uint8_t* entry = profile + 132 + static_cast<size_t>(tag) * 12;
+		if (ReadUInt32(entry) != signature)
+			continue;
+
+		uint32_t offset = ReadUInt32(entry + 4);
+		uint32_t tag_size = ReadUInt32(entry + 8);
+		if (offset > size || tag_size > size - offset)
+			return false;
+
+		return ReadCurveTag(profile + offset, tag_size, curve);
+	}
+
+	return false;
+}
+
+
+
+/// <summary>
+/// Checks if two curves give the same linear values up to half of 16 bit step.
+/// Same curve may be stored in different forms, like one entry 'curv' and type 0 'para'.
+/// </summary>
+bool IccToneCurve::AreCurvesEqual(const IccToneCurve& first, const IccToneCurve& second) {
+	//Channel tags usually point to the same data or hold identical copies of it
+	if (first._hash == second._hash)
+		return true;
+
+	for (int i = 0; i <= 1024; i++) {
+		double value = static_cast<double>(i) / 1024.0;
+		if (std::abs(first.ToLinear(value) - second.ToLinear(value)) > 0.5 / 65535.0)
+			return false;
+	}
+	return true;
+}
+
+
+
+/// <summary>
+/// Reads curve from 'curv' or 'para' tag data. Returns false if tag type is not a curve or data is truncated.
+/// </summary>
+bool IccToneCurve::ReadCurveTag(const uint8_t* tag, size_t size, IccToneCurve& curve) {
+	if (size < 12)
+		return false;
+
+	IccToneCurve result;
+	uint32_t type = ReadUInt32(tag);
+	size_t used_size = 0;
+
+	if (type == 0x63757276) { //'curv'
+		uint32_t count = ReadUInt32(tag + 8);
+		if (count > (size - 12) / 2)
+			return false;
+		used_size = 12 + static_cast<size_t>(count) * 2;
+
+		if (count == 0)
+			result._type = IccCurveType::ICT_IDENTITY;
+		else if (count == 1) {
+			//u8Fixed8Number
+			result._type = IccCurveType::ICT_GAMMA;
+			result._params[0] = static_cast<double>(ReadUInt16(tag + 12)) / 256.0;
+			if (result._params[0] <= 0.0)
+				return false;
+		}
+		else {
+			result._type = IccCurveType::ICT_SAMPLED;
+			result._samples.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+				result._samples[i] = static_cast<double>(ReadUInt16(tag + 12 + static_cast<size_t>(i) * 2)) / 65535.0;
+		}
+	}
+	else if (type == 0x70617261) { //'para'
+		static constexpr int num_params[] = { 1, 3, 4, 5, 7 };
+		int function_type = ReadUInt16(tag + 8);
+		if (function_type > 4)
+			return false;
+		used_size = 12 + static_cast<size_t>(num_params[function_type]) * 4;
+		if (size < used_size)
+			return false;
+
+		result._type = IccCurveType::ICT_PARAMETRIC;
+		result._function_type = function_type;
+		for (int p = 0; p < num_params[function_type]; p++)
+			result._params[p] = ReadS15Fixed16(tag + 12 + p * 4);
+		if (result._params[0] <= 0.0 || (function_type > 0 && result._params[1] == 0.0))
+			return false;
+	}
+	else
+		return false;
+
+	//Hash of used tag bytes
+	result._hash = GetDataHash(tag, used_size);
+
+	curve = std::move(result);
+	return true;
+}
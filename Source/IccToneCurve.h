@@ -0,0 +1,142 @@
+#pragma once
+//STL
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/// <summary>
+/// Kinds of ICC tone reproduction curves.
+/// </summary>
+enum IccCurveType {
+	ICT_IDENTITY,	//'curv' with no entries, linear = value
+	ICT_GAMMA,		//'curv' with one entry, linear = value^gamma
+	ICT_PARAMETRIC,	//'para' function of types 0-4
+	ICT_SAMPLED		//'curv' with table of samples, linearly interpolated
+};
+
+
+/// <summary>
+/// Tone reproduction curve (TRC) read from ICC profile.
+/// Maps gamma-corrected value normalized to [0..1] to linear brightness normalized to [0..1].
+/// </summary>
+/// <remarks>
+/// Curve is taken from rTRC, gTRC and bTRC tags of RGB profiles and from kTRC tag of grayscale profiles.
+/// Gamma converters apply one curve to all color channels, which is exact for Adobe RGB, Display P3, ProPhoto and sRGB
+/// where all three channel curves are the same. Profiles with different channel curves are not supported,
+/// since any single curve would shift colors of such images.
+/// Profiles built on LUT tags (A2B0 and similar) have no TRC and are not supported.
+/// </remarks>
+class IccToneCurve {
+public:
+	//--------------------------------
+	//	ACCESSORS
+	//--------------------------------
+
+	IccCurveType GetType() const { return _type; }
+
+	/// <summary>
+	/// Gamma value of ICT_GAMMA curve.
+	/// </summary>
+	double GetGamma() const { return _params[0]; }
+
+	/// <summary>
+	/// Hash of the curve tag contents. Profiles with the same curve have the same hash even if other tags differ.
+	/// </summary>
+	uint64_t GetHash() const { return _hash; }
+
+	//--------------------------------
+	//	EVALUATION
+	//--------------------------------
+
+	/// <summary>
+	/// Converts gamma-corrected value [0..1] to linear brightness [0..1].
+	/// </summary>
+	double ToLinear(double value) const;
+
+	/// <summary>
+	/// Converts linear brightness [0..1] to gamma-corrected value [0..1].
+	/// Curve has no closed form inverse in general, so the smallest value with ToLinear(value) >= linear is found by bisection.
+	/// </summary>
+	double ToEncoded(double linear) const;
+
+	//--------------------------------
+	//	PARSING
+	//--------------------------------
+
+	/// <summary>
+	/// Reads tone curve from ICC profile data.
+	/// Returns false if profile is malformed, has no supported tone curve or its RGB channel curves differ.
+	/// </summary>
+	static bool ReadFromProfile(const uint8_t* profile, size_t size, IccToneCurve& curve);
+
+	/// <summary>
+	/// Reads tone curve from ICC profile data.
+	/// Returns false if profile is malformed, has no supported tone curve or its RGB channel curves differ.
+	/// </summary>
+	static bool ReadFromProfile(const std::vector<uint8_t>& profile, IccToneCurve& curve) {
+		return ReadFromProfile(profile.data(), profile.size(), curve);
+	}
+
+	/// <summary>
+	/// FNV-1a hash of data. Used for curve hash and to recognize profiles seen before without parsing them.
+	/// </summary>
+	static uint64_t GetDataHash(const uint8_t* data, size_t size) {
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	IccCurveType _type = IccCurveType::ICT_IDENTITY;
+	//Parametric function type 0-4
+	int _function_type = 0;
+	//Gamma for ICT_GAMMA, g, a, b, c, d, e, f for ICT_PARAMETRIC
+	double _params[7] = { 1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	//Samples of ICT_SAMPLED curve normalized to [0..1]
+	std::vector<double> _samples;
+	uint64_t _hash = 0;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Reads curve from 'curv' or 'para' tag data. Returns false if tag type is not a curve or data is truncated.
+	/// </summary>
+	static bool ReadCurveTag(const uint8_t* tag, size_t size, IccToneCurve& curve);
+
+	/// <summary>
+	/// Finds tag with given signature in the tag table and reads curve from it.
+	/// Returns false if there is no such tag, it is out of profile bounds or is not a supported curve.
+	/// </summary>
+	static bool ReadCurveBySignature(const uint8_t* profile, size_t size, uint32_t signature, IccToneCurve& curve);
+
+	/// <summary>
+	/// Checks if two curves give the same linear values up to half of 16 bit step.
+	/// Same curve may be stored in different forms, like one entry 'curv' and type 0 'para'.
+	/// </summary>
+	static bool AreCurvesEqual(const IccToneCurve& first, const IccToneCurve& second);
+
+	static inline uint32_t ReadUInt32(const uint8_t* data) {
+		return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+	}
+
+	static inline uint16_t ReadUInt16(const uint8_t* data) {
+		return static_cast<uint16_t>((data[0] << 8) | data[1]);
+	}
+
+	/// <summary>
+	/// Reads ICC s15Fixed16Number.
+	/// </summary>
+	static inline double ReadS15Fixed16(const uint8_t* data) {
+		return static_cast<double>(static_cast<int32_t>(ReadUInt32(data))) / 65536.0;
+	}
+};
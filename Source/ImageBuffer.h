@@ -4,8 +4,12 @@
 //STL
 #include <exception>
 #include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <memory_resource>
 //Internal
 #include "ImageBuffer_Base.h"
+#include "ImageBufferView.h"
 
 
 /// <summary>
@@ -28,6 +32,11 @@ public:
 	///</summary>
 	T** GetDataPtr() const { return _data; }
 
+	/// <summary>
+	/// Memory resource rows of this buffer are allocated from. Null means global heap.
+	/// </summary>
+	std::pmr::memory_resource* GetMemoryResource() const { return _memory; }
+
 	/// <summary>
 	/// Sets data array for this buffer and sets "allocated" flag to true.
 	/// Assumes that data layout and dimensions are correct.
@@ -36,6 +45,9 @@ public:
 	void SetData(uint8_t** data) {
 		_data = data;
 		_allocated = true;
+		_data_capacity = _height;
+		_rows_capacity = _height;
+		_row_capacity = GetCmpWidth();
 	}
 
 	/// <summary>
@@ -52,6 +64,9 @@ public:
 	/// </summary>
 	void SetAllocated() {
 		_allocated = true;
+		_data_capacity = _height;
+		_rows_capacity = _height;
+		_row_capacity = GetCmpWidth();
 	}
 
 	/// <summary>
@@ -61,6 +76,9 @@ public:
 	void SetDeallocated() {
 		_allocated = false;
 		_data = nullptr;
+		_data_capacity = 0;
+		_rows_capacity = 0;
+		_row_capacity = 0;
 	}
 
 	//--------------------------------
@@ -76,15 +94,18 @@ public:
 				throw new std::runtime_error("Cannot allocate image buffer with undefined layout.");
 
 			//Allocating array for row pointers
-			_data = new T * [_height];
+			_data = AllocateRowArray(_height);
 
 			//Allocating each row
 			int cmpWidth = _width * _numCmp;
 			for (int row = 0; row < _height; row++)
-				_data[row] = new T[cmpWidth];
+				_data[row] = AllocateRow(cmpWidth);
 
 			//Setting the flag
 			_allocated = true;
+			_data_capacity = _height;
+			_rows_capacity = _height;
+			_row_capacity = cmpWidth;
 		}
 	}
 
@@ -93,17 +114,47 @@ public:
 	/// </summary>
 	void DeallocateData() {
 		if (_allocated == true) {
-			//Deleting each data row
-			for (int row = 0; row < _height; row++)
-				delete[] _data[row];
+			//Deleting each data row (including reserved rows past the height)
+			for (int row = 0; row < _rows_capacity; row++)
+				DeallocateRow(_data[row], _row_capacity);
 
 			//Deleting array of rows
-			delete[] _data;
+			DeallocateRowArray(_data, _data_capacity);
 
 			//Setting flags
 			_allocated = false;
 			_data = nullptr;
+			_data_capacity = 0;
+			_rows_capacity = 0;
+			_row_capacity = 0;
+		}
+	}
+
+	/// <summary>
+	/// Changes dimensions and layout of the buffer reusing allocated memory when possible.
+	/// Rows are reused if new row fits into allocated rows and new height fits into allocated number of rows,
+	/// otherwise data is reallocated. Rows past the new height stay allocated for the later use.
+	/// Image content is not preserved and cannot be assumed.
+	/// </summary>
+	/// <param name="height">New height.</param>
+	/// <param name="width">New width.</param>
+	/// <param name="layout">New layout.</param>
+	void Reshape(int height, int width, ImagePixelLayout layout) {
+		if (layout == ImagePixelLayout::UNDEF)
+			throw new std::runtime_error("Cannot reshape image buffer to undefined layout.");
+
+		int cmp_width = width * NumComponentsOfLayout(layout);
+
+		//Allocated memory can hold the new shape
+		if (_allocated && height <= _rows_capacity && cmp_width <= _row_capacity) {
+			SetDimensions(height, width, layout);
+			return;
 		}
+
+		//Reallocating
+		DeallocateData();
+		SetDimensions(height, width, layout);
+		AllocateData();
 	}
 
 	/// <summary>
@@ -120,9 +171,10 @@ public:
 
 	/// <summary>
 	/// Makes a copy of this image buffer and returns a pointer on heap.
+	/// Copy uses the same memory resource.
 	/// </summary>
 	ImageBuffer<T, TMin, TMax, RGBtoG>* Clone() const {
-		ImageBuffer<T, TMin, TMax, RGBtoG>* copy = new ImageBuffer<T, TMin, TMax, RGBtoG>(_height, _width, _layout, _allocated);
+		ImageBuffer<T, TMin, TMax, RGBtoG>* copy = new ImageBuffer<T, TMin, TMax, RGBtoG>(_height, _width, _layout, _allocated, _memory);
 
 		//Copying data if it is allocated
 		if (_allocated) {
@@ -687,6 +739,10 @@ public:
 	/// Inserts given image into this image starting at a specified line.
 	/// If widths mismatch columns will be trimmed/expanded with black fill.
 	/// </summary>
+	/// <remarks>
+	/// Row array grows geometrically, so appending images one after another costs time proportional to the total number of rows.
+	/// Rows of the image with the same width and layout are copied once, otherwise the image is transformed first.
+	/// </remarks>
 	/// <param name="image"></param>
 	/// <param name="line"></param>
 	void InsertAtLine(const ImageBuffer<T, TMin, TMax, RGBtoG>& image, int line) {
@@ -698,72 +754,47 @@ public:
 		if (_allocated == false)
 			AllocateData();
 
-		//We create a new image that conforms to width and layout of this image
-		ImageBuffer<T, TMin, TMax, RGBtoG> trans_img = image.TransformBuffer(image.GetHeight(), this->_width, this->_layout);
-
-		//Aliases
-		T** img_data = trans_img.GetDataPtr();
-		int img_height = trans_img.GetHeight();
-		int new_height = _height + img_height;
-
 		//We check if there are new empty lines between this image and inserted one
-		if (line > _height)
-			new_height += line - _height;
-
-		//New data array
-		T** new_data = new T * [new_height];
-
-		if (line < _height) {
-			//Inserting given image between rows of this image (or prepending)
-			//We are only moving row pointers from copy of inserted image to resulting image
-
-			//Original rows before insert
-			for (int src_row = 0; src_row < line; src_row++)
-				new_data[src_row] = _data[src_row];
-			//Inserted rows
-			for (int img_row = 0; img_row < img_height; img_row++) {
-				int trg_row = line + img_row;
-				new_data[trg_row] = img_data[img_row];
-			}
-			//Original rows after the insert
-			for (int src_row = line; src_row < _height; src_row++) {
-				new_data[img_height + src_row] = _data[src_row];
-			}
-		}
-		else {
-			//Here given image will be put after this image possible with a set of empty lines in between
-			//We are only moving row pointers from copy of inserted image to resulting image
+		AddBlankRows(line);
 
-			int cmp_width = this->_width;
-
-			//Original rows
-			for (int src_row = 0; src_row < _height; src_row++)
-				new_data[src_row] = _data[src_row];
-			//Blank rows
-			for (int trg_row = _height; trg_row < line; trg_row++) {
-				new_data[trg_row] = new T[cmp_width];
-				for (int cmp = 0; cmp < cmp_width; cmp++)
-					new_data[trg_row][cmp] = 0;
-			}
-			//Inserted image
-			for (int img_row = 0; img_row < img_height; img_row++) {
-				int trg_row = line + img_row;
-				new_data[trg_row] = img_data[img_row];
-			}
+		if (&image != this && image._allocated && image._width == _width && image._layout == _layout)
+			CopyRowsFrom(image, line);
+		else {
+			//We create a new image that conforms to width and layout of this image and move its rows
+			ImageBuffer<T, TMin, TMax, RGBtoG> trans_img = image.TransformBuffer(image.GetHeight(), this->_width, this->_layout);
+			if (trans_img._allocated == false)
+				return;
+			if (CanMoveRowsFrom(trans_img))
+				MoveRowsFrom(trans_img, line);
+			else
+				CopyRowsFrom(trans_img, line);
 		}
+	}
 
-		//Disposing of img data array without deallocating individual rows (they were moved)
-		delete[] img_data;
-		trans_img.SetDeallocated();
+	/// <summary>
+	/// Inserts given image into this image starting at a specified line.
+	/// If width, layout, row capacity and memory resource of the image match rows are moved without copying and the image is left deallocated.
+	/// Otherwise works as insertion of a copy.
+	/// </summary>
+	/// <param name="image">Image to insert.</param>
+	/// <param name="line">Line in this image where first line of inserted image should be placed.</param>
+	void InsertAtLine(ImageBuffer<T, TMin, TMax, RGBtoG>&& image, int line) {
+		//Just a sanity check
+		if (line < 0)
+			return;
 
-		//Setting new height
-		_height = new_height;
+		if (&image != this && image._allocated && image._width == _width && image._layout == _layout) {
+			if (_allocated == false)
+				AllocateData();
 
-		//Removing old rows array
-		delete[] _data;
+			if (CanMoveRowsFrom(image)) {
+				AddBlankRows(line);
+				MoveRowsFrom(image, line);
+				return;
+			}
+		}
 
-		//Setting new data
-		_data = new_data;
+		InsertAtLine(static_cast<const ImageBuffer<T, TMin, TMax, RGBtoG>&>(image), line);
 	}
 
 	/// <summary>
@@ -775,6 +806,15 @@ public:
 		InsertAtLine(image, 0);
 	}
 
+	/// <summary>
+	/// Inserts given image into this image starting at the first line.
+	/// Rows are moved if width, layout and memory resource match.
+	/// </summary>
+	/// <param name="image">Image to prepend.</param>
+	void Prepend(ImageBuffer<T, TMin, TMax, RGBtoG>&& image) {
+		InsertAtLine(std::move(image), 0);
+	}
+
 	/// <summary>
 	/// Inserts given image into this image starting right after the last line.
 	/// If widths mismatch columns will be trimmed/expanded with black fill.
@@ -784,8 +824,37 @@ public:
 		InsertAtLine(image, _height);
 	}
 
+	/// <summary>
+	/// Inserts given image into this image starting right after the last line.
+	/// Rows are moved if width, layout and memory resource match, so accumulating slices does not copy pixels.
+	/// </summary>
+	/// <param name="image">Image to append.</param>
+	void Append(ImageBuffer<T, TMin, TMax, RGBtoG>&& image) {
+		InsertAtLine(std::move(image), _height);
+	}
+
+	/// <summary>
+	/// Makes room in the row array for `height` rows, so the image can grow to that height without reallocating it.
+	/// Rows themselves are allocated when added.
+	/// </summary>
+	/// <param name="height">Expected height of the image.</param>
+	void ReserveRows(int height) {
+		if (_allocated == false)
+			AllocateData();
+		if (height <= _data_capacity)
+			return;
+
+		T** new_data = AllocateRowArray(height);
+		for (int row = 0; row < _rows_capacity; row++)
+			new_data[row] = _data[row];
+		DeallocateRowArray(_data, _data_capacity);
+		_data = new_data;
+		_data_capacity = height;
+	}
+
 	/// <summary>
 	/// Returns Image Buffer that contains `height` rows of this buffer, strating with `pos` row.
+	/// Rows are copied, use GetRowsView to access them without copying.
 	/// </summary>
 	ImageBuffer<T, TMin, TMax, RGBtoG> GetSlice(int pos, int height) {
 		// Actual number of rows to return
@@ -810,6 +879,41 @@ public:
 		return trg_image;
 	}
 
+	//--------------------------------
+	//	VIEWS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns view of the whole buffer. Data is not copied.
+	/// View is valid while this buffer is alive and is not reshaped.
+	/// </summary>
+	ImageBufferView<T> GetView() const {
+		return ImageBufferView<T>(_allocated ? _data : nullptr, 0, _height, _width, _layout);
+	}
+
+	/// <summary>
+	/// Returns view of `height` rows of this buffer starting with `pos` row. Data is not copied.
+	/// Rows past the end of the buffer are cut.
+	/// </summary>
+	ImageBufferView<T> GetRowsView(int pos, int height) const {
+		return GetView().GetRows(pos, height);
+	}
+
+	/// <summary>
+	/// Returns view of rectangle of this buffer with top left corner at (row, col). Data is not copied.
+	/// Rows and columns past the end of the buffer are cut.
+	/// </summary>
+	ImageBufferView<T> GetRectView(int row, int col, int height, int width) const {
+		return GetView().GetRect(row, col, height, width);
+	}
+
+	/// <summary>
+	/// Buffer can be passed where view of the whole buffer is expected.
+	/// </summary>
+	operator ImageBufferView<T>() const {
+		return GetView();
+	}
+
 	//--------------------------------
 	//	CONSTRUCTORS
 	//--------------------------------
@@ -841,6 +945,16 @@ public:
 
 	}
 
+	///<summary>
+	///Creates empty image with given dimensions and layout which rows are allocated from given memory resource.
+	///Memory resource should outlive the buffer. Null memory resource means global heap.
+	///</summary>
+	ImageBuffer(int height, int width, ImagePixelLayout layout, bool isAllocated, std::pmr::memory_resource* memory)
+		: ImageBuffer_Base(height, width, layout), _memory(memory) {
+		if (isAllocated == true)
+			AllocateData();
+	}
+
 	//--------------------------------
 	//	COPY/MOVE
 	//--------------------------------
@@ -861,19 +975,26 @@ public:
 	///Move constructor.
 	///</summary>
 	ImageBuffer(ImageBuffer<T, TMin, TMax, RGBtoG>&& other)
-		: ImageBuffer_Base(other._height, other._width, other._layout) {
+		: ImageBuffer_Base(other._height, other._width, other._layout), _memory(other._memory) {
 
 		//Reassigning data
 		_allocated = other._allocated;
 
-		if (_allocated)
+		if (_allocated) {
 			_data = other._data;
+			_data_capacity = other._data_capacity;
+			_rows_capacity = other._rows_capacity;
+			_row_capacity = other._row_capacity;
+		}
 		else
 			_data = nullptr;
 
 		//Setting allocation flags, so other object can be safely disposed.
 		other._allocated = false;
 		other._data = nullptr;
+		other._data_capacity = 0;
+		other._rows_capacity = 0;
+		other._row_capacity = 0;
 	}
 
 	/// <summary>
@@ -895,16 +1016,24 @@ public:
 		_hasAlpha = other._hasAlpha;
 
 		//Reassigning data
+		_memory = other._memory;
 		_allocated = other._allocated;
 
-		if (_allocated)
+		if (_allocated) {
 			_data = other._data;
+			_data_capacity = other._data_capacity;
+			_rows_capacity = other._rows_capacity;
+			_row_capacity = other._row_capacity;
+		}
 		else
 			_data = nullptr;
 
 		//Setting allocation flags for other object, so it can be safely disposed.
 		other._allocated = false;
 		other._data = nullptr;
+		other._data_capacity = 0;
+		other._rows_capacity = 0;
+		other._row_capacity = 0;
 		
 		return *this;
 	}
@@ -956,6 +1085,160 @@ protected:
 	/// </summary>
 	bool _allocated = false;
 
+	/// <summary>
+	/// Number of allocated rows. Can be bigger than height when buffer was reshaped to fewer rows.
+	/// </summary>
+	int _rows_capacity = 0;
+
+	/// <summary>
+	/// Number of components each allocated row can hold.
+	/// </summary>
+	int _row_capacity = 0;
+
+	/// <summary>
+	/// Length of the row array. Can be bigger than number of allocated rows when rows were reserved for insertion.
+	/// </summary>
+	int _data_capacity = 0;
+
+	/// <summary>
+	/// Memory resource rows and row array are allocated from. Null means global heap (new[]/delete[]).
+	/// </summary>
+	std::pmr::memory_resource* _memory = nullptr;
+
+
+	//--------------------------------
+	//	ROW ALLOCATION
+	//--------------------------------
+
+	/// <summary>
+	/// Allocates row of `cmp_count` components.
+	/// </summary>
+	T* AllocateRow(int cmp_count) {
+		if (_memory == nullptr)
+			return new T[cmp_count];
+		return static_cast<T*>(_memory->allocate(static_cast<size_t>(cmp_count) * sizeof(T), alignof(T)));
+	}
+
+	/// <summary>
+	/// Deallocates row allocated with AllocateRow(cmp_count).
+	/// </summary>
+	void DeallocateRow(T* row, int cmp_count) {
+		if (_memory == nullptr)
+			delete[] row;
+		else
+			_memory->deallocate(row, static_cast<size_t>(cmp_count) * sizeof(T), alignof(T));
+	}
+
+	/// <summary>
+	/// Allocates array of `length` row pointers.
+	/// </summary>
+	T** AllocateRowArray(int length) {
+		if (_memory == nullptr)
+			return new T * [length];
+		return static_cast<T**>(_memory->allocate(static_cast<size_t>(length) * sizeof(T*), alignof(T*)));
+	}
+
+	/// <summary>
+	/// Deallocates row array allocated with AllocateRowArray(length).
+	/// </summary>
+	void DeallocateRowArray(T** row_array, int length) {
+		if (_memory == nullptr)
+			delete[] row_array;
+		else
+			_memory->deallocate(row_array, static_cast<size_t>(length) * sizeof(T*), alignof(T*));
+	}
+
+
+	//--------------------------------
+	//	INSERTION HELPERS
+	//--------------------------------
+
+	/// <summary>
+	/// Opens `count` slots in the row array starting at `line` (not past the height) and shifts following rows down.
+	/// Slots should be filled by the caller with rows of _row_capacity components.
+	/// </summary>
+	/// <remarks>
+	/// Row array is at least doubled when it is full, so series of appends reallocates it logarithmic number of times.
+	/// Reserved rows past the height are shifted too and stay allocated.
+	/// </remarks>
+	/// <returns>Pointer to the first slot.</returns>
+	T** OpenRows(int line, int count) {
+		int rows_needed = _rows_capacity + count;
+		if (rows_needed > _data_capacity)
+			ReserveRows(std::max(rows_needed, 2 * _data_capacity));
+
+		for (int row = _rows_capacity - 1; row >= line; row--)
+			_data[row + count] = _data[row];
+
+		_height += count;
+		_rows_capacity += count;
+		return _data + line;
+	}
+
+	/// <summary>
+	/// Adds blank rows after the last row until image has `line` rows. Reserved rows are used first.
+	/// </summary>
+	void AddBlankRows(int line) {
+		if (line <= _height)
+			return;
+
+		int cmp_width = GetCmpWidth();
+		int first_blank = _height;
+
+		//Reserved rows past the height
+		_height = std::min(line, _rows_capacity);
+
+		//Remaining rows are allocated
+		int new_count = line - _height;
+		T** new_rows = OpenRows(_height, new_count);
+		for (int row = 0; row < new_count; row++)
+			new_rows[row] = AllocateRow(_row_capacity);
+
+		//Filling with black
+		for (int row = first_blank; row < line; row++)
+			for (int cmp = 0; cmp < cmp_width; cmp++)
+				_data[row][cmp] = TMin;
+	}
+
+	/// <summary>
+	/// Copies rows of the image into new rows of this image starting at `line` (not past the height).
+	/// Image should have width and layout of this image.
+	/// </summary>
+	void CopyRowsFrom(const ImageBuffer<T, TMin, TMax, RGBtoG>& image, int line) {
+		int cmp_width = GetCmpWidth();
+		int img_height = image._height;
+		T** new_rows = OpenRows(line, img_height);
+		for (int img_row = 0; img_row < img_height; img_row++) {
+			new_rows[img_row] = AllocateRow(_row_capacity);
+			for (int cmp = 0; cmp < cmp_width; cmp++)
+				new_rows[img_row][cmp] = image._data[img_row][cmp];
+		}
+	}
+
+	/// <summary>
+	/// Tells if rows of the image can be owned by this image: both are allocated from the same memory resource with the same row capacity.
+	/// </summary>
+	bool CanMoveRowsFrom(const ImageBuffer<T, TMin, TMax, RGBtoG>& image) const {
+		return image._memory == _memory && image._row_capacity == _row_capacity;
+	}
+
+	/// <summary>
+	/// Moves rows of the image into this image starting at `line` (not past the height) and leaves the image deallocated.
+	/// Image should have width and layout of this image and CanMoveRowsFrom should be true.
+	/// </summary>
+	void MoveRowsFrom(ImageBuffer<T, TMin, TMax, RGBtoG>& image, int line) {
+		int img_height = image._height;
+		T** new_rows = OpenRows(line, img_height);
+		for (int img_row = 0; img_row < img_height; img_row++)
+			new_rows[img_row] = image._data[img_row];
+
+		//Disposing of image row array and its reserved rows, other rows were moved
+		for (int row = img_height; row < image._rows_capacity; row++)
+			image.DeallocateRow(image._data[row], image._row_capacity);
+		image.DeallocateRowArray(image._data, image._data_capacity);
+		image.SetDeallocated();
+	}
+
 
 	//--------------------------------
 	//	ARCHIVE
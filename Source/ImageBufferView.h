@@ -0,0 +1,190 @@
+#pragma once
+//STL
+#include <cstdint>
+#include <algorithm>
+//Internal
+#include "ImageBuffer_Base.h"
+
+/// <summary>
+/// Non-owning view of rows and columns of an image buffer.
+/// Creating a view or a view of its part does not copy pixel data.
+/// </summary>
+/// <remarks>
+/// Image buffers allocate each row separately, so instead of data pointer and stride
+/// view keeps pointer into the row array of the viewed buffer and offset of the first component in each row.
+/// View is valid while viewed buffer is alive and is not reshaped or reallocated.
+/// Pixel data is not incapsulated same as in ImageBuffer.
+/// </remarks>
+template <typename T>
+class ImageBufferView : public ImageBuffer_Base {
+public:
+	//--------------------------------
+	//	GET/SET
+	//--------------------------------
+
+	/// <summary>
+	/// Row of the view. Points to the first component of the first pixel of the view in this row.
+	/// </summary>
+	inline T* operator[](int row) const {
+		return _rows[row] + _cmp_offset;
+	}
+
+	/// <summary>
+	/// Tells if view points to any data.
+	/// </summary>
+	bool IsAllocated() const { return _rows != nullptr; }
+
+	//--------------------------------
+	//	SUB-VIEWS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns view of `height` rows of this view starting with `pos` row.
+	/// Rows past the end of this view are cut.
+	/// </summary>
+	ImageBufferView<T> GetRows(int pos, int height) const {
+		return GetRect(pos, 0, height, _width);
+	}
+
+	/// <summary>
+	/// Returns view of rectangle of this view with top left corner at (row, col).
+	/// Rows and columns past the end of this view are cut.
+	/// </summary>
+	ImageBufferView<T> GetRect(int row, int col, int height, int width) const {
+		row = std::clamp(row, 0, _height);
+		col = std::clamp(col, 0, _width);
+		height = std::clamp(height, 0, _height - row);
+		width = std::clamp(width, 0, _width - col);
+		if (_rows == nullptr)
+			return ImageBufferView<T>(nullptr, 0, height, width, _layout);
+		return ImageBufferView<T>(_rows + row, _cmp_offset + col * _numCmp, height, width, _layout);
+	}
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Empty view.
+	/// </summary>
+	ImageBufferView() : ImageBuffer_Base(0, 0, ImagePixelLayout::UNDEF) {}
+
+	/// <summary>
+	/// Creates view of `height` rows starting at rows[0], each row starts at component cmp_offset.
+	/// </summary>
+	ImageBufferView(T* const* rows, int cmp_offset, int height, int width, ImagePixelLayout layout)
+		: ImageBuffer_Base(height, width, layout), _rows(rows), _cmp_offset(cmp_offset) {}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	/// <summary>
+	/// Pointer to the first viewed row in the row array of the viewed buffer.
+	/// </summary>
+	T* const* _rows = nullptr;
+
+	/// <summary>
+	/// Number of components skipped at the beginning of each row.
+	/// </summary>
+	int _cmp_offset = 0;
+};
+
+using ImageBufferView_uint8 = ImageBufferView<uint8_t>;
+using ImageBufferView_uint16 = ImageBufferView<uint16_t>;
+using ImageBufferView_uint32 = ImageBufferView<uint32_t>;
+using ImageBufferView_float = ImageBufferView<float>;
+
+
+
+/// <summary>
+/// Non-owning view of ImageBuffer_Byte. Rows are byte arrays of samples of given bit depth.
+/// </summary>
+/// <remarks>
+/// Same as ImageBufferView, but keeps bit depth so codecs and gamma converters can accept views of any supported depth.
+/// </remarks>
+class ImageBufferView_Byte : public ImageBuffer_Base {
+public:
+	//--------------------------------
+	//	GET/SET
+	//--------------------------------
+
+	/// <summary>
+	/// Row of the view. Points to the first byte of the first pixel of the view in this row.
+	/// </summary>
+	inline uint8_t* operator[](int row) const {
+		return _rows[row] + _byte_offset;
+	}
+
+	BitDepth GetBitPerComponent() const { return _bitDepth; }
+
+	/// <summary>
+	/// Number of bytes in one row of the view.
+	/// </summary>
+	int GetRowBytes() const { return GetCmpWidth() * BytesPerSample(); }
+
+	/// <summary>
+	/// Tells if view points to any data.
+	/// </summary>
+	bool IsAllocated() const { return _rows != nullptr; }
+
+	//--------------------------------
+	//	SUB-VIEWS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns view of `height` rows of this view starting with `pos` row.
+	/// Rows past the end of this view are cut.
+	/// </summary>
+	ImageBufferView_Byte GetRows(int pos, int height) const {
+		return GetRect(pos, 0, height, _width);
+	}
+
+	/// <summary>
+	/// Returns view of rectangle of this view with top left corner at (row, col).
+	/// Rows and columns past the end of this view are cut.
+	/// </summary>
+	ImageBufferView_Byte GetRect(int row, int col, int height, int width) const {
+		row = std::clamp(row, 0, _height);
+		col = std::clamp(col, 0, _width);
+		height = std::clamp(height, 0, _height - row);
+		width = std::clamp(width, 0, _width - col);
+		if (_rows == nullptr)
+			return ImageBufferView_Byte(nullptr, 0, height, width, _layout, _bitDepth);
+		return ImageBufferView_Byte(_rows + row, _byte_offset + col * _numCmp * BytesPerSample(), height, width, _layout, _bitDepth);
+	}
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Creates view of `height` rows starting at rows[0], each row starts at byte byte_offset.
+	/// </summary>
+	ImageBufferView_Byte(uint8_t* const* rows, int byte_offset, int height, int width, ImagePixelLayout layout, BitDepth bit_depth)
+		: ImageBuffer_Base(height, width, layout), _rows(rows), _byte_offset(byte_offset), _bitDepth(bit_depth) {}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	/// <summary>
+	/// Pointer to the first viewed row in the row array of the viewed buffer.
+	/// </summary>
+	uint8_t* const* _rows = nullptr;
+
+	/// <summary>
+	/// Number of bytes skipped at the beginning of each row.
+	/// </summary>
+	int _byte_offset = 0;
+
+	BitDepth _bitDepth = BitDepth::BD_8_BIT;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	int BytesPerSample() const { return static_cast<int>(_bitDepth) / 8; }
+};
@@ -57,7 +57,23 @@ public:
 	///Creates image description with given dimensions and layout.
 	///Rows are not allocated.
 	///</summary>
-	ImageBuffer_Base(int height, int width, ImagePixelLayout layout) : _height(height), _width(width), _layout(layout) {
+	ImageBuffer_Base(int height, int width, ImagePixelLayout layout) {
+		SetDimensions(height, width, layout);
+	}
+
+protected:
+	//--------------------------------
+	//	PROTECTED METHODS
+	//--------------------------------
+
+	///<summary>
+	///Sets image dimensions and layout and derived layout parameters.
+	///Does not touch the data.
+	///</summary>
+	void SetDimensions(int height, int width, ImagePixelLayout layout) {
+		_height = height;
+		_width = width;
+		_layout = layout;
 
 		switch (_layout) {
 		case UNDEF:
@@ -85,7 +101,6 @@ public:
 		}
 	}
 
-protected:
 	//--------------------------------
 	//	FIELDS
 	//--------------------------------
@@ -23,6 +23,24 @@ uint8_t** ImageBuffer_Byte::GetDataPtr() const {
 	}
 }
 
+
+/// <summary>
+/// Memory resource rows of this buffer are allocated from. Null means global heap.
+/// </summary>
+std::pmr::memory_resource* ImageBuffer_Byte::GetMemoryResource() const {
+	switch (_bitDepth)
+	{
+		case BD_8_BIT:
+			return _image_8bit->_memory;
+		case BD_16_BIT:
+			return _image_16bit->_memory;
+		case BD_32_BIT:
+			return _image_32bit->_memory;
+		default:
+			return nullptr;
+	}
+}
+
 /// <summary>
 /// Tells if data for this buffer is allocated.
 /// </summary>
@@ -105,6 +123,44 @@ void ImageBuffer_Byte::AllocateData() {
 
 
 
+/// <summary>
+/// Changes dimensions and layout of the buffer reusing allocated memory when possible.
+/// Bit depth is not changed.
+/// Image content is not preserved and cannot be assumed.
+/// </summary>
+void ImageBuffer_Byte::Reshape(int height, int width, ImagePixelLayout layout) {
+	//Underlying image can be missing if this object was moved out
+	switch (_bitDepth)
+	{
+		case BD_8_BIT:
+			if (_image_8bit == nullptr) {
+				_image_8bit = new ImageBuffer_uint8(height, width, layout);
+				_image_base = static_cast<ImageBuffer_Base*>(_image_8bit);
+			}
+			else
+				_image_8bit->Reshape(height, width, layout);
+			return;
+		case BD_16_BIT:
+			if (_image_16bit == nullptr) {
+				_image_16bit = new ImageBuffer_uint16(height, width, layout);
+				_image_base = static_cast<ImageBuffer_Base*>(_image_16bit);
+			}
+			else
+				_image_16bit->Reshape(height, width, layout);
+			return;
+		case BD_32_BIT:
+			if (_image_32bit == nullptr) {
+				_image_32bit = new ImageBuffer_uint32(height, width, layout);
+				_image_base = static_cast<ImageBuffer_Base*>(_image_32bit);
+			}
+			else
+				_image_32bit->Reshape(height, width, layout);
+			return;
+	}
+}
+
+
+
 /// <summary>
 /// Returns a copy of this image with alpha channel removed.
 /// </summary>
@@ -403,6 +459,53 @@ void ImageBuffer_Byte::InsertAtLine(const ImageBuffer_Byte& image, const int lin
 }
 
 
+/// <summary>
+/// Inserts given image into this image starting at a specified line.
+/// If bit depth, width, layout and memory resource match rows are moved without copying and the image is left deallocated.
+/// </summary>
+/// <param name="image">Image to insert</param>
+/// <param name="line">Line in this image where first line of inserted image should be placed.</param>
+void ImageBuffer_Byte::InsertAtLine(ImageBuffer_Byte&& image, const int line) {
+	//Bit depth conversion makes a copy anyway
+	if (image._bitDepth != _bitDepth) {
+		InsertAtLine(static_cast<const ImageBuffer_Byte&>(image), line);
+		return;
+	}
+
+	switch (_bitDepth)
+	{
+		case BD_8_BIT:
+			this->_image_8bit->InsertAtLine(std::move(*(image._image_8bit)), line);
+			break;
+		case BD_16_BIT:
+			this->_image_16bit->InsertAtLine(std::move(*(image._image_16bit)), line);
+			break;
+		case BD_32_BIT:
+			this->_image_32bit->InsertAtLine(std::move(*(image._image_32bit)), line);
+			break;
+	}
+}
+
+
+/// <summary>
+/// Makes room in the row array for `height` rows, so the image can grow to that height without reallocating it.
+/// </summary>
+void ImageBuffer_Byte::ReserveRows(int height) {
+	switch (_bitDepth)
+	{
+		case BD_8_BIT:
+			_image_8bit->ReserveRows(height);
+			break;
+		case BD_16_BIT:
+			_image_16bit->ReserveRows(height);
+			break;
+		case BD_32_BIT:
+			_image_32bit->ReserveRows(height);
+			break;
+	}
+}
+
+
 //--------------------------------
 //	CONSTRUCTORS
 //--------------------------------
@@ -412,23 +515,33 @@ void ImageBuffer_Byte::InsertAtLine(const ImageBuffer_Byte& image, const int lin
 ///Creates empty image with given dimensions and layout.
 ///Data can be allocated or not.
 ///</summary>
-ImageBuffer_Byte::ImageBuffer_Byte(int height, int width, ImagePixelLayout layout, BitDepth bit_depth, bool isAllocated) {
+ImageBuffer_Byte::ImageBuffer_Byte(int height, int width, ImagePixelLayout layout, BitDepth bit_depth, bool isAllocated)
+	: ImageBuffer_Byte(height, width, layout, bit_depth, isAllocated, nullptr) {
+
+}
+
+
+///<summary>
+///Creates empty image with given dimensions and layout which rows are allocated from given memory resource.
+///Data can be allocated or not.
+///</summary>
+ImageBuffer_Byte::ImageBuffer_Byte(int height, int width, ImagePixelLayout layout, BitDepth bit_depth, bool isAllocated, std::pmr::memory_resource* memory) {
 	_bitDepth = bit_depth;
 
 	switch (bit_depth)
 	{
 		case BD_8_BIT:
-			_image_8bit = new ImageBuffer_uint8(height, width, layout, isAllocated);
+			_image_8bit = new ImageBuffer_uint8(height, width, layout, isAllocated, memory);
 			_image_base = static_cast<ImageBuffer_Base*>(_image_8bit);
 			break;
 
 		case BD_16_BIT:
-			_image_16bit = new ImageBuffer_uint16(height, width, layout, isAllocated);
+			_image_16bit = new ImageBuffer_uint16(height, width, layout, isAllocated, memory);
 			_image_base = static_cast<ImageBuffer_Base*>(_image_16bit);
 			break;
 
 		case BD_32_BIT:
-			_image_32bit = new ImageBuffer_uint32(height, width, layout, isAllocated);
+			_image_32bit = new ImageBuffer_uint32(height, width, layout, isAllocated, memory);
 			_image_base = static_cast<ImageBuffer_Base*>(_image_32bit);
 			break;
 
@@ -450,6 +563,24 @@ ImageBuffer_Byte::ImageBuffer_Byte(int height, int width, ImagePixelLayout layou
 }
 
 
+
+/// <summary>
+/// Creates ImageBuffer_Byte with a copy of pixels of given view.
+/// </summary>
+ImageBuffer_Byte ImageBuffer_Byte::BuildByCopying(const ImageBufferView_Byte& view) {
+	ImageBuffer_Byte result(view.GetHeight(), view.GetWidth(), view.GetLayout(), view.GetBitPerComponent(), view.IsAllocated());
+	if (!view.IsAllocated())
+		return result;
+
+	uint8_t** data = result.GetDataPtr();
+	int row_bytes = view.GetRowBytes();
+	for (int row = 0; row < view.GetHeight(); row++)
+		std::memcpy(data[row], view[row], row_bytes);
+
+	return result;
+}
+
+
 //--------------------------------
 //	COPY/MOVE
 //--------------------------------
@@ -578,12 +709,12 @@ ImageBuffer_Byte::~ImageBuffer_Byte() {
 		break;
 
 	case BD_16_BIT:
-		if (_image_8bit != nullptr)
+		if (_image_16bit != nullptr)
 			delete _image_16bit;
 		break;
 
 	case BD_32_BIT:
-		if (_image_8bit != nullptr)
+		if (_image_32bit != nullptr)
 			delete _image_32bit;
 		break;
 
@@ -1,6 +1,7 @@
 #pragma once
 //STL
 #include <exception>
+#include <cstring>
 #include "ImageBuffer.h"
 
 /// <summary>
@@ -22,6 +23,11 @@ public:
 	///</summary>
 	uint8_t** GetDataPtr() const;
 
+	/// <summary>
+	/// Memory resource rows of this buffer are allocated from. Null means global heap.
+	/// </summary>
+	std::pmr::memory_resource* GetMemoryResource() const;
+
 	///<summary>
 	///Layout of data in each pixel of the image.
 	///</summary>
@@ -129,6 +135,16 @@ public:
 	/// </summary>
 	void AllocateData();
 
+	/// <summary>
+	/// Changes dimensions and layout of the buffer reusing allocated memory when possible.
+	/// Bit depth is not changed.
+	/// Image content is not preserved and cannot be assumed.
+	/// </summary>
+	/// <param name="height">New height.</param>
+	/// <param name="width">New width.</param>
+	/// <param name="layout">New layout.</param>
+	void Reshape(int height, int width, ImagePixelLayout layout);
+
 	
 	/// <summary>
 	/// Returns a copy of this image with alpha channel removed.
@@ -179,6 +195,73 @@ public:
 	void Append(const ImageBuffer_Byte& image) {
 		InsertAtLine(image, GetHeight());
 	}
+
+	/// <summary>
+	/// Inserts given image into this image starting at a specified line.
+	/// If bit depth, width, layout and memory resource match rows are moved without copying and the image is left deallocated.
+	/// </summary>
+	/// <param name="image">Image to insert</param>
+	/// <param name="line">Line in this image where first line of inserted image should be placed.</param>
+	void InsertAtLine(ImageBuffer_Byte&& image, int line);
+
+	/// <summary>
+	/// Inserts given image into this image starting at the first line.
+	/// Rows are moved if bit depth, width, layout and memory resource match.
+	/// </summary>
+	/// <param name="image">Image to prepend.</param>
+	void Prepend(ImageBuffer_Byte&& image) {
+		InsertAtLine(std::move(image), 0);
+	}
+
+	/// <summary>
+	/// Inserts given image into this image starting right after the last line.
+	/// Rows are moved if bit depth, width, layout and memory resource match, so accumulating slices does not copy pixels.
+	/// </summary>
+	/// <param name="image">Image to append.</param>
+	void Append(ImageBuffer_Byte&& image) {
+		InsertAtLine(std::move(image), GetHeight());
+	}
+
+	/// <summary>
+	/// Makes room in the row array for `height` rows, so the image can grow to that height without reallocating it.
+	/// </summary>
+	/// <param name="height">Expected height of the image.</param>
+	void ReserveRows(int height);
+
+	//--------------------------------
+	//	VIEWS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns view of the whole buffer. Data is not copied.
+	/// View is valid while this buffer is alive and is not reshaped.
+	/// </summary>
+	ImageBufferView_Byte GetView() const {
+		return ImageBufferView_Byte(IsAllocated() ? GetDataPtr() : nullptr, 0, GetHeight(), GetWidth(), GetLayout(), _bitDepth);
+	}
+
+	/// <summary>
+	/// Returns view of `height` rows of this buffer starting with `pos` row. Data is not copied.
+	/// Rows past the end of the buffer are cut.
+	/// </summary>
+	ImageBufferView_Byte GetRowsView(int pos, int height) const {
+		return GetView().GetRows(pos, height);
+	}
+
+	/// <summary>
+	/// Returns view of rectangle of this buffer with top left corner at (row, col). Data is not copied.
+	/// Rows and columns past the end of the buffer are cut.
+	/// </summary>
+	ImageBufferView_Byte GetRectView(int row, int col, int height, int width) const {
+		return GetView().GetRect(row, col, height, width);
+	}
+
+	/// <summary>
+	/// Buffer can be passed where view of the whole buffer is expected.
+	/// </summary>
+	operator ImageBufferView_Byte() const {
+		return GetView();
+	}
 	
 
 
@@ -197,6 +280,12 @@ public:
 	///</summary>
 	ImageBuffer_Byte(int height, int width, ImagePixelLayout layout, BitDepth bit_depth, bool isAllocated);
 
+	///<summary>
+	///Creates empty image with given dimensions and layout which rows are allocated from given memory resource.
+	///Memory resource should outlive the buffer. Null memory resource means global heap.
+	///</summary>
+	ImageBuffer_Byte(int height, int width, ImagePixelLayout layout, BitDepth bit_depth, bool isAllocated, std::pmr::memory_resource* memory);
+
 
 	///<summary>
 	///Creates empty image with given dimensions and layout.
@@ -240,6 +329,11 @@ public:
 		return result;
 	}
 
+	/// <summary>
+	/// Creates ImageBuffer_Byte with a copy of pixels of given view.
+	/// </summary>
+	static ImageBuffer_Byte BuildByCopying(const ImageBufferView_Byte& view);
+
 	//--------------------------------
 	//	COPY/MOVE
 	//--------------------------------
@@ -38,7 +38,8 @@ enum BitDepth {
 /// </summary>
 enum RawImageGammaProfile {
 	sRGB,			//Gamma correction according to sRGB standart
-	PlainGamma		//Simple x^gamma correction
+	PlainGamma,		//Simple x^gamma correction
+	IccProfile		//Tone curve of ICC profile embedded in the file
 };
 
 
@@ -51,3 +52,53 @@ enum FileFormat {
 	FF_PNG
 };
 
+
+
+/// <summary>
+/// Tradeoff between strictness and speed of image decoders.
+/// </summary>
+enum DecodeProfile {
+	DP_STRICT,	//Accurate decoding with all integrity checks
+	DP_TRUSTED	//Faster decoding of previously validated files, integrity checks and accuracy are relaxed
+};
+
+
+
+/// <summary>
+/// Tradeoff between encoding speed and file size of image encoders.
+/// <para>JPEG encoder with EP_SMALLEST profile (optimized Huffman tables and progressive scans) buffers
+/// coefficients of the whole image and writes the file only after the last row.
+/// Other profiles write rows as they are passed.</para>
+/// </summary>
+enum EncoderProfile {
+	EP_FASTEST,		//Fastest encoding, bigger files
+	EP_BALANCED,	//Default settings of the codec library, used by overloads without profile
+	EP_SMALLEST		//Smallest files, slowest encoding, whole image is buffered by JPEG encoder
+};
+
+
+
+/// <summary>
+/// libjpeg-turbo API used for whole-file JPEG reading and writing.
+/// </summary>
+enum JpegCodecBackend {
+	JCB_LIBJPEG,	//Classic scanline API (JpegReader/JpegWriter)
+	JCB_TURBOJPEG	//TurboJPEG whole-image API (TurboJpegCodec)
+};
+
+
+
+/// <summary>
+/// Image orientation as defined by EXIF Orientation tag.
+/// Describes how stored pixels should be transformed to be displayed upright.
+/// </summary>
+enum ExifOrientation {
+	EO_NORMAL = 1,			//No transformation
+	EO_MIRROR_H = 2,		//Mirror horizontally
+	EO_ROTATE_180 = 3,		//Rotate 180 degrees
+	EO_MIRROR_V = 4,		//Mirror vertically
+	EO_TRANSPOSE = 5,		//Mirror along the main diagonal
+	EO_ROTATE_90_CW = 6,	//Rotate 90 degrees clockwise
+	EO_TRANSVERSE = 7,		//Mirror along the anti-diagonal
+	EO_ROTATE_90_CCW = 8	//Rotate 90 degrees counterclockwise
+};
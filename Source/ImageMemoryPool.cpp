@@ -0,0 +1,129 @@
+#include "ImageMemoryPool.h"
+
+//--------------------------------
+//	PUBLIC METHODS
+//--------------------------------
+
+/// <summary>
+/// Returns all kept blocks to the upstream resource.
+/// Should not be called while other threads use the pool.
+/// </summary>
+void ImageMemoryPool::Release() {
+	for (ThreadCache& cache : _thread_caches)
+		for (size_t size_class = 0; size_class < cache.size(); size_class++) {
+			for (void* block : cache[size_class])
+				_upstream->deallocate(block, ClassSize(static_cast<int>(size_class)), alignof(std::max_align_t));
+			cache[size_class].clear();
+		}
+
+	for (int size_class = 0; size_class < _num_classes; size_class++) {
+		std::lock_guard<std::mutex> lock(_shared[size_class].mutex);
+		for (void* block : _shared[size_class].blocks)
+			_upstream->deallocate(block, ClassSize(size_class), alignof(std::max_align_t));
+		_shared[size_class].blocks.clear();
+	}
+}
+
+
+
+//--------------------------------
+//	CONSTRUCTORS
+//--------------------------------
+
+/// <summary>
+/// Creates empty pool on top of given upstream resource.
+/// </summary>
+ImageMemoryPool::ImageMemoryPool(size_t max_block_size, size_t max_thread_blocks, std::pmr::memory_resource* upstream) :
+	_upstream(upstream),
+	_max_block_size(max_block_size),
+	_max_thread_blocks(max_thread_blocks)
+{
+	if (upstream == nullptr)
+		throw std::invalid_argument("ImageMemoryPool -- upstream resource is null.");
+	if (max_block_size < MIN_BLOCK_SIZE)
+		throw std::invalid_argument("ImageMemoryPool -- max block size is smaller than minimal block size.");
+
+	_num_classes = SizeClass(max_block_size) + 1;
+	_shared = std::make_unique<SharedList[]>(_num_classes);
+}
+
+
+
+//--------------------------------
+//	DESTRUCTOR
+//--------------------------------
+
+/// <summary>
+/// Returns all kept blocks to the upstream resource.
+/// </summary>
+ImageMemoryPool::~ImageMemoryPool() {
+	Release();
+}
+
+
+
+//--------------------------------
+//	MEMORY RESOURCE
+//--------------------------------
+
+/// <summary>
+/// Takes block of the size class from the thread cache, then from the shared list, then from the upstream resource.
+/// </summary>
+void* ImageMemoryPool::do_allocate(size_t bytes, size_t alignment) {
+	if (bytes > _max_block_size || alignment > alignof(std::max_align_t)) {
+		_upstream_allocation_count.fetch_add(1, std::memory_order_relaxed);
+		return _upstream->allocate(bytes, alignment);
+	}
+
+	int size_class = SizeClass(bytes);
+
+	// 1 - Thread cache
+	ThreadCache& cache = _thread_caches.local();
+	if (cache.empty())
+		cache.resize(_num_classes);
+	if (!cache[size_class].empty()) {
+		void* block = cache[size_class].back();
+		cache[size_class].pop_back();
+		return block;
+	}
+
+	// 2 - Shared list
+	{
+		std::lock_guard<std::mutex> lock(_shared[size_class].mutex);
+		std::vector<void*>& blocks = _shared[size_class].blocks;
+		if (!blocks.empty()) {
+			void* block = blocks.back();
+			blocks.pop_back();
+			return block;
+		}
+	}
+
+	// 3 - Upstream
+	_upstream_allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return _upstream->allocate(ClassSize(size_class), alignof(std::max_align_t));
+}
+
+
+
+/// <summary>
+/// Puts block of the size class into the thread cache, or into the shared list if the thread cache is full.
+/// </summary>
+void ImageMemoryPool::do_deallocate(void* block, size_t bytes, size_t alignment) {
+	if (bytes > _max_block_size || alignment > alignof(std::max_align_t)) {
+		_upstream->deallocate(block, bytes, alignment);
+		return;
+	}
+
+	int size_class = SizeClass(bytes);
+
+	ThreadCache& cache = _thread_caches.local();
+	if (cache.empty())
+		cache.resize(_num_classes);
+	if (cache[size_class].size() < _max_thread_blocks) {
+		cache[size_class].push_back(block);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_shared[size_class].mutex);
+	_shared[size_class].blocks.push_back(block);
+}
@@ -0,0 +1,175 @@
+#pragma once
+//STL
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <bit>
+#include <stdexcept>
+//Third party
+#include "oneapi/tbb.h"
+
+///<summary>
+///Memory resource for image rows and other slice sized blocks.
+///Works under ImageBuffer rather than on whole buffers: any buffer created with the pool takes its rows from size class lists
+///and gives them back when destroyed, so buffers that are created and dropped inside library code,
+///like Downscaler intermediates and slices returned by value from DownscaleNext, reuse memory without changes to the calling code.
+///</summary>
+///<remarks>
+///SliceBufferPool recycles whole buffers that the caller acquires and passes to Into methods, keeping row pointer arrays as well.
+///It is the choice when the caller owns every buffer of the pipeline and shapes repeat.
+///This pool is the choice when buffers are created by code the caller does not control, or shapes vary between slices,
+///since blocks of one class serve any request of close size. Pools are not meant to be stacked:
+///buffers kept by SliceBufferPool hold on to their memory, so this pool under it would serve only the first allocations.
+///
+///Size classes are spaced by quarter of a power of two starting at MIN_BLOCK_SIZE, so block is at most 25% bigger than requested.
+///Each thread keeps a small cache of released blocks per class and takes from it without locking.
+///Blocks released over the cache limit go to shared per class lists guarded by separate mutexes,
+///so buffers allocated on one thread and released on another are reused too.
+///
+///Blocks bigger than max block size and blocks with alignment over max_align_t are passed to the upstream resource.
+///Pool should outlive everything allocated from it. Kept blocks are returned to the upstream resource by Release or destructor.
+///</remarks>
+class ImageMemoryPool : public std::pmr::memory_resource {
+public:
+	//--------------------------------
+	//	CONSTANTS
+	//--------------------------------
+
+	/// <summary>
+	/// Size of the smallest block.
+	/// </summary>
+	static constexpr size_t MIN_BLOCK_SIZE = 256;
+
+	//--------------------------------
+	//	GET/SET
+	//--------------------------------
+
+	/// <summary>
+	/// Blocks bigger than this are not pooled.
+	/// </summary>
+	size_t GetMaxBlockSize() const { return _max_block_size; }
+
+	/// <summary>
+	/// Number of blocks requested from the upstream resource so far.
+	/// Stays constant once the pool has warmed up.
+	/// </summary>
+	size_t GetUpstreamAllocationCount() const { return _upstream_allocation_count.load(std::memory_order_relaxed); }
+
+	//--------------------------------
+	//	PUBLIC METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns all kept blocks to the upstream resource.
+	/// Should not be called while other threads use the pool.
+	/// </summary>
+	void Release();
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Creates empty pool on top of the global heap.
+	/// </summary>
+	/// <param name="max_block_size">Blocks bigger than this are passed to the heap directly.</param>
+	/// <param name="max_thread_blocks">Number of released blocks of each class kept by a thread before they are shared.</param>
+	ImageMemoryPool(size_t max_block_size, size_t max_thread_blocks) :
+		ImageMemoryPool(max_block_size, max_thread_blocks, std::pmr::new_delete_resource()) {}
+
+	/// <summary>
+	/// Creates empty pool on top of given upstream resource.
+	/// </summary>
+	/// <param name="max_block_size">Blocks bigger than this are passed to the upstream resource directly.</param>
+	/// <param name="max_thread_blocks">Number of released blocks of each class kept by a thread before they are shared.</param>
+	/// <param name="upstream">Resource blocks are allocated from.</param>
+	ImageMemoryPool(size_t max_block_size, size_t max_thread_blocks, std::pmr::memory_resource* upstream);
+
+	/// <summary>
+	/// Creates empty pool for blocks up to 64 MB on top of the global heap.
+	/// </summary>
+	ImageMemoryPool() : ImageMemoryPool(size_t(1) << 26, 16) {}
+
+	ImageMemoryPool(const ImageMemoryPool& other) = delete;
+	ImageMemoryPool& operator=(const ImageMemoryPool& other) = delete;
+
+	//--------------------------------
+	//	DESTRUCTOR
+	//--------------------------------
+
+	/// <summary>
+	/// Returns all kept blocks to the upstream resource.
+	/// </summary>
+	~ImageMemoryPool();
+
+protected:
+	//--------------------------------
+	//	MEMORY RESOURCE
+	//--------------------------------
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* block, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	//--------------------------------
+	//	PRIVATE TYPES
+	//--------------------------------
+
+	/// <summary>
+	/// Released blocks of one size class shared between threads.
+	/// </summary>
+	struct SharedList {
+		std::mutex mutex;
+		std::vector<void*> blocks;
+	};
+
+	/// <summary>
+	/// Released blocks of each size class kept by one thread.
+	/// </summary>
+	using ThreadCache = std::vector<std::vector<void*>>;
+
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	std::pmr::memory_resource* _upstream; //Resource blocks are allocated from
+	size_t _max_block_size; //Blocks bigger than this are not pooled
+	size_t _max_thread_blocks; //Number of blocks of each class kept by a thread
+	int _num_classes; //Number of size classes up to max block size
+	std::unique_ptr<SharedList[]> _shared; //Shared lists for each size class
+	tbb::enumerable_thread_specific<ThreadCache> _thread_caches; //Thread local lists for each size class
+	std::atomic<size_t> _upstream_allocation_count = 0; //Number of blocks allocated from the upstream resource
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Index of the smallest size class that holds given number of bytes.
+	/// </summary>
+	static int SizeClass(size_t bytes) {
+		if (bytes <= MIN_BLOCK_SIZE)
+			return 0;
+		//bytes is in (2^e, 2^(e+1)], class sizes in this range are 2^e + q * 2^(e-2) for q in [1..4]
+		int e = static_cast<int>(std::bit_width(bytes - 1)) - 1;
+		size_t step = size_t(1) << (e - 2);
+		size_t q = (bytes - (size_t(1) << e) + step - 1) / step;
+		return (e - static_cast<int>(std::bit_width(MIN_BLOCK_SIZE)) + 1) * 4 + static_cast<int>(q);
+	}
+
+	/// <summary>
+	/// Block size of the size class.
+	/// </summary>
+	static size_t ClassSize(int size_class) {
+		if (size_class == 0)
+			return MIN_BLOCK_SIZE;
+		int e = static_cast<int>(std::bit_width(MIN_BLOCK_SIZE)) - 1 + (size_class - 1) / 4;
+		size_t q = static_cast<size_t>((size_class - 1) % 4 + 1);
+		return (size_t(1) << e) + q * (size_t(1) << (e - 2));
+	}
+};
@@ -0,0 +1,302 @@
+#include "ImageProbe.h"
+
+//--------------------------------
+//	PROBING
+//--------------------------------
+
+///<summary>
+///Static method. Detects format of the file and reads its header.
+///For unknown format returns info with FF_UNSUPPORTED format.
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if header is corrupted or missing.</para>
+///</summary>
+ImageFileInfo ImageProbe::ProbeFile(std::filesystem::path file_path) {
+	FILE* file_handle = OpenCFileForBinaryReading(file_path);
+	ImageFileInfo info(file_path, FileFormat::FF_UNSUPPORTED);
+
+	try {
+		//----------------------------------------------------------------------
+		// 1 - Detecting the format
+
+		uint8_t signature[SIGNATURE_SIZE];
+		size_t signature_size = fread(signature, 1, SIGNATURE_SIZE, file_handle);
+		FileFormat format = DetectFormat(signature, signature_size);
+
+		//----------------------------------------------------------------------
+		// 2 - Parsing the header
+
+		switch (format) {
+		case FileFormat::FF_JPEG:
+			//Returning to the first marker after SOI
+			fseek(file_handle, 2, SEEK_SET);
+			ProbeJpeg(file_handle, info);
+			break;
+		case FileFormat::FF_PNG:
+			ProbePng(file_handle, info);
+			break;
+		default:
+			break;
+		}
+	}
+	catch (...) {
+		fclose(file_handle);
+		throw;
+	}
+
+	fclose(file_handle);
+	return info;
+}
+
+
+
+///<summary>
+///Static method. Probes list of files in parallel.
+///Result has the same order as the list.
+///Files that cannot be opened or have corrupted headers are reported with FF_UNSUPPORTED format instead of throwing.
+///</summary>
+std::vector<ImageFileInfo> ImageProbe::ProbeFiles(const std::vector<std::filesystem::path>& file_paths) {
+	std::vector<ImageFileInfo> infos;
+	infos.reserve(file_paths.size());
+	for (const std::filesystem::path& file_path : file_paths)
+		infos.emplace_back(file_path, FileFormat::FF_UNSUPPORTED);
+
+	//Probing is dominated by file open latency, so each file is a separate task
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, file_paths.size(), 1), [&](const tbb::blocked_range<size_t>& range) {
+		for (size_t i = range.begin(); i != range.end(); i++) {
+			try {
+				infos[i] = ProbeFile(file_paths[i]);
+			}
+			catch (std::ifstream::failure&) {
+			}
+			catch (codec_fatal_exception&) {
+			}
+		}
+	});
+
+	return infos;
+}
+
+
+
+//--------------------------------
+//	FORMAT DETECTION
+//--------------------------------
+
+///<summary>
+///Static method. Detects image format by signature at the start of the file data.
+///</summary>
+FileFormat ImageProbe::DetectFormat(const uint8_t* data, size_t size) {
+	//JPEG starts with SOI marker followed by another marker
+	if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+		return FileFormat::FF_JPEG;
+
+	//PNG signature
+	if (size >= SIGNATURE_SIZE && png_sig_cmp(data, 0, SIGNATURE_SIZE) == 0)
+		return FileFormat::FF_PNG;
+
+	return FileFormat::FF_UNSUPPORTED;
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Walks JPEG markers up to the frame header and fills the info.
+///File position is expected to be right after SOI marker.
+///</summary>
+void ImageProbe::ProbeJpeg(FILE* file_handle, ImageFileInfo& info) {
+	//Markers preceding the frame header which affect colorspace
+	bool saw_jfif = false;
+	bool saw_adobe = false;
+	uint8_t adobe_transform = 0;
+
+	while (true) {
+		//----------------------------------------------------------------------
+		// 1 - Finding next marker
+
+		uint8_t byte = 0;
+		ReadExactly(file_handle, &byte, 1, CodecExceptions::Jpeg_DecodingError);
+		if (byte != 0xFF)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "JPEG marker expected while probing header.");
+
+		//Any number of 0xFF fill bytes can precede the marker code
+		uint8_t marker = 0xFF;
+		while (marker == 0xFF)
+			ReadExactly(file_handle, &marker, 1, CodecExceptions::Jpeg_DecodingError);
+
+		//Standalone markers without length
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+			continue;
+
+		//Start of scan or end of image before the frame header
+		if (marker == 0xDA || marker == 0xD9)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "JPEG frame header not found.");
+
+		uint8_t length_bytes[2];
+		ReadExactly(file_handle, length_bytes, 2, CodecExceptions::Jpeg_DecodingError);
+		long payload_length = ((length_bytes[0] << 8) | length_bytes[1]) - 2;
+		if (payload_length < 0)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "Invalid JPEG marker length.");
+
+		//----------------------------------------------------------------------
+		// 2 - Frame header (SOF0-SOF15 except DHT, JPG and DAC)
+
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+			//Precision, height, width, number of components
+			uint8_t frame[6];
+			if (payload_length < 6)
+				throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "Invalid JPEG frame header length.");
+			ReadExactly(file_handle, frame, 6, CodecExceptions::Jpeg_DecodingError);
+
+			unsigned int height = (frame[1] << 8) | frame[2];
+			unsigned int width = (frame[3] << 8) | frame[4];
+			int num_components = frame[5];
+			if (height == 0 || width == 0 || num_components == 0 || payload_length < 6 + 3 * num_components)
+				throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "Invalid JPEG frame header.");
+
+			//Component identifiers are used to guess colorspace of files without JFIF/Adobe markers
+			uint8_t component_ids[4] = { 0, 0, 0, 0 };
+			for (int c = 0; c < num_components; c++) {
+				uint8_t component[3];
+				ReadExactly(file_handle, component, 3, CodecExceptions::Jpeg_DecodingError);
+				if (c < 4)
+					component_ids[c] = component[0];
+			}
+
+			JpegHeaderInfo jpeg_header(height, width, num_components, GuessJpegColorSpace(num_components, component_ids, saw_jfif, saw_adobe, adobe_transform));
+			info = ImageFileInfo(info.GetFilePath(), jpeg_header);
+			return;
+		}
+
+		//----------------------------------------------------------------------
+		// 3 - Colorspace markers
+
+		//JFIF APP0
+		if (marker == 0xE0 && payload_length >= 5) {
+			uint8_t identifier[5];
+			ReadExactly(file_handle, identifier, 5, CodecExceptions::Jpeg_DecodingError);
+			payload_length -= 5;
+			if (std::memcmp(identifier, "JFIF\0", 5) == 0)
+				saw_jfif = true;
+		}
+		//Adobe APP14
+		else if (marker == 0xEE && payload_length >= 12) {
+			uint8_t adobe[12];
+			ReadExactly(file_handle, adobe, 12, CodecExceptions::Jpeg_DecodingError);
+			payload_length -= 12;
+			if (std::memcmp(adobe, "Adobe", 5) == 0) {
+				saw_adobe = true;
+				adobe_transform = adobe[11];
+			}
+		}
+
+		//----------------------------------------------------------------------
+		// 4 - Skipping the rest of the segment without reading it
+
+		if (payload_length > 0 && fseek(file_handle, payload_length, SEEK_CUR) != 0)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "Unexpected end of file while probing JPEG header.");
+	}
+}
+
+
+
+///<summary>
+///Reads PNG IHDR chunk and fills the info.
+///File position is expected to be right after PNG signature.
+///</summary>
+void ImageProbe::ProbePng(FILE* file_handle, ImageFileInfo& info) {
+	//Chunk length, chunk type and 13 bytes of IHDR data
+	uint8_t chunk[8 + 13];
+	ReadExactly(file_handle, chunk, sizeof(chunk), CodecExceptions::Png_DecodingError);
+
+	uint32_t chunk_length = (static_cast<uint32_t>(chunk[0]) << 24) | (chunk[1] << 16) | (chunk[2] << 8) | chunk[3];
+	if (chunk_length != 13 || std::memcmp(chunk + 4, "IHDR", 4) != 0)
+		throw codec_fatal_exception(CodecExceptions::Png_DecodingError, "PNG file does not start with IHDR chunk.");
+
+	const uint8_t* ihdr = chunk + 8;
+	unsigned int width = (static_cast<uint32_t>(ihdr[0]) << 24) | (ihdr[1] << 16) | (ihdr[2] << 8) | ihdr[3];
+	unsigned int height = (static_cast<uint32_t>(ihdr[4]) << 24) | (ihdr[5] << 16) | (ihdr[6] << 8) | ihdr[7];
+	unsigned char bit_depth = ihdr[8];
+	unsigned char color_type = ihdr[9];
+	unsigned char interlace_type = ihdr[12];
+
+	ImagePixelLayout layout = PngReader::PngLayoutToImageLayout(color_type);
+	if (width == 0 || height == 0 || layout == ImagePixelLayout::UNDEF)
+		throw codec_fatal_exception(CodecExceptions::Png_DecodingError, "Invalid PNG header.");
+
+	PngHeaderInfo png_header(height, width, bit_depth, color_type, interlace_type);
+	info = ImageFileInfo(info.GetFilePath(), png_header);
+	info.SetImgBufferInfo(ImageBufferInfo(static_cast<int>(height), static_cast<int>(width), layout, PngReader::PngBitDepthToImageBitDepth(bit_depth)));
+}
+
+
+
+///<summary>
+///Chooses JPEG colorspace from the number of components and JFIF/Adobe markers the same way libjpeg does.
+///</summary>
+J_COLOR_SPACE ImageProbe::GuessJpegColorSpace(int num_components, const uint8_t* component_ids, bool saw_jfif, bool saw_adobe, uint8_t adobe_transform) {
+	switch (num_components) {
+	case 1:
+		return J_COLOR_SPACE::JCS_GRAYSCALE;
+
+	case 3:
+		if (saw_jfif)
+			return J_COLOR_SPACE::JCS_YCbCr;
+		if (saw_adobe)
+			return adobe_transform == 0 ? J_COLOR_SPACE::JCS_RGB : J_COLOR_SPACE::JCS_YCbCr;
+		//Component identifiers 'R', 'G', 'B'
+		if (component_ids[0] == 82 && component_ids[1] == 71 && component_ids[2] == 66)
+			return J_COLOR_SPACE::JCS_RGB;
+		return J_COLOR_SPACE::JCS_YCbCr;
+
+	case 4:
+		if (saw_adobe && adobe_transform == 2)
+			return J_COLOR_SPACE::JCS_YCCK;
+		return J_COLOR_SPACE::JCS_CMYK;
+
+	default:
+		return J_COLOR_SPACE::JCS_UNKNOWN;
+	}
+}
+
+
+
+///<summary>
+///Reads exactly size bytes. Throws codec_fatal_exception with given error code if file ends before that.
+///</summary>
+void ImageProbe::ReadExactly(FILE* file_handle, uint8_t* buffer, size_t size, CodecExceptions error) {
+	if (fread(buffer, 1, size, file_handle) != size)
+		throw codec_fatal_exception(error, "Unexpected end of file while probing image header.");
+}
+
+
+
+///<summary>
+///Opens file for binary reading. Throws std::ifstream::failure if failed to open file.
+///</summary>
+FILE* ImageProbe::OpenCFileForBinaryReading(std::filesystem::path file_path) {
+	FILE* file_handle = NULL;
+	//Extracting file path as UTF-8 c-style string to use with c file opener.
+	std::u8string u8_file_path = file_path.generic_u8string();
+	const char* c_file_path = reinterpret_cast<const char*>(u8_file_path.c_str());
+	errno_t fopen_error = fopen_s(&file_handle, c_file_path, "rb");
+
+	if (fopen_error != 0) {
+		//Constructing error message string
+		char err_msg_buffer[256];
+		errno_t strerror_error = strerror_s(err_msg_buffer, 256, fopen_error);
+		//Throwing exception
+		if (strerror_error == 0) //Message string constructed
+			throw std::ifstream::failure(std::string(err_msg_buffer));
+		else
+			throw std::ifstream::failure("");
+	}
+
+	//Header is small, buffer does not have to be bigger than a typical metadata segment
+	setvbuf(file_handle, NULL, _IOFBF, 4096);
+
+	return file_handle;
+}
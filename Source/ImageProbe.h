@@ -0,0 +1,104 @@
+#pragma once
+//STL
+#include <string>
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+//Third party
+#include "jpeglib.h"
+#include "png.h"
+#include "oneapi/tbb.h"
+//Internal
+#include "Exceptions.h"
+#include "ImageFileInfo.h"
+#include "PngReader.h"
+
+///<summary>
+///Fast image file header probe.
+///Detects file format by magic bytes and parses only the frame header (JPEG SOF or PNG IHDR)
+///without creating libjpeg or libpng decoder objects.
+///</summary>
+///<remarks>
+///Intended for batch planning where dimensions, layout and bit depth of many files are needed before decoding.
+///JPEG metadata segments preceding the frame header are skipped by seeking, so usually only the first few kilobytes are read.
+///
+///Reported buffer layout and bit depth are the ones JpegReader and PngReader produce for the file.
+///Probe keeps no state, so it can be called from any number of threads at once.
+///</remarks>
+class ImageProbe {
+public:
+	//--------------------------------
+	//	PROBING
+	//--------------------------------
+
+	///<summary>
+	///Static method. Detects format of the file and reads its header.
+	///For unknown format returns info with FF_UNSUPPORTED format.
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if header is corrupted or missing.</para>
+	///</summary>
+	///<param name="file_path">Path to the file to probe.</param>
+	static ImageFileInfo ProbeFile(std::filesystem::path file_path);
+
+	///<summary>
+	///Static method. Probes list of files in parallel.
+	///Result has the same order as the list.
+	///Files that cannot be opened or have corrupted headers are reported with FF_UNSUPPORTED format instead of throwing.
+	///</summary>
+	///<param name="file_paths">Paths to the files to probe.</param>
+	static std::vector<ImageFileInfo> ProbeFiles(const std::vector<std::filesystem::path>& file_paths);
+
+	//--------------------------------
+	//	FORMAT DETECTION
+	//--------------------------------
+
+	///<summary>
+	///Static method. Detects image format by signature at the start of the file data.
+	///</summary>
+	///<param name="data">Start of the file.</param>
+	///<param name="size">Number of bytes available (8 is enough).</param>
+	static FileFormat DetectFormat(const uint8_t* data, size_t size);
+
+	ImageProbe() = delete;
+
+private:
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Walks JPEG markers up to the frame header and fills the info.
+	///File position is expected to be right after SOI marker.
+	///</summary>
+	static void ProbeJpeg(FILE* file_handle, ImageFileInfo& info);
+
+	///<summary>
+	///Reads PNG IHDR chunk and fills the info.
+	///File position is expected to be right after PNG signature.
+	///</summary>
+	static void ProbePng(FILE* file_handle, ImageFileInfo& info);
+
+	///<summary>
+	///Chooses JPEG colorspace from the number of components and JFIF/Adobe markers the same way libjpeg does.
+	///</summary>
+	static J_COLOR_SPACE GuessJpegColorSpace(int num_components, const uint8_t* component_ids, bool saw_jfif, bool saw_adobe, uint8_t adobe_transform);
+
+	///<summary>
+	///Reads exactly size bytes. Throws codec_fatal_exception with given error code if file ends before that.
+	///</summary>
+	static void ReadExactly(FILE* file_handle, uint8_t* buffer, size_t size, CodecExceptions error);
+
+	///<summary>
+	///Opens file for binary reading. Throws std::ifstream::failure if failed to open file.
+	///</summary>
+	static FILE* OpenCFileForBinaryReading(std::filesystem::path file_path);
+
+	///<summary>
+	///Number of bytes used for format detection.
+	///</summary>
+	static constexpr size_t SIGNATURE_SIZE = 8;
+};
@@ -1,6 +1,7 @@
 #pragma once
 //STL
 #include <string>
+#include <vector>
 #include <filesystem>
 //Internal
 #include "ImageBuffer_Byte.h"
@@ -34,6 +35,11 @@ public:
 	///</summary>
 	ImageBufferInfo GetCommonHeader() { return _image_info; }
 
+	///<summary>
+	///ICC profile embedded in the file. Empty if the file has no profile.
+	///</summary>
+	const std::vector<uint8_t>& GetIccProfile() { return _icc_profile; }
+
 	///<summary>
 	///Returns how many rows are left to read in the image.
 	///</summary>
@@ -68,6 +74,18 @@ public:
 	///</summary>
 	virtual ImageBuffer_Byte ReadNextRows(int num_lines) = 0;
 
+	///<summary>
+	///Reads next block of rows starting at NextRow into caller provided buffer.
+	///Buffer is reshaped to the number of rows actually read, its allocated memory is reused when possible.
+	///If bit depth of the buffer does not match the image it is replaced.
+	///Advances NextRow by num_lines.
+	///When all rows are already read buffer is reshaped to zero rows.
+	///<para>Default implementation reads into a new buffer and moves it into the target.</para>
+	///</summary>
+	virtual void ReadNextRowsInto(int num_lines, ImageBuffer_Byte& target) {
+		target = ReadNextRows(num_lines);
+	}
+
 
 	//--------------------------------
 	//	PUBLIC CONSTRUCTORS
@@ -94,7 +112,9 @@ protected:
 	void OpenCFileForBinaryReading(std::filesystem::path file_path) {
 	
 		//Extracting file path as UTF-8 c-style string to use with c file opener.
-		const char* c_file_path = reinterpret_cast<const char*>(file_path.generic_u8string().c_str());
+		//String is kept in a variable, pointer into a temporary would be dangling by the time fopen_s reads it.
+		std::u8string u8_file_path = file_path.generic_u8string();
+		const char* c_file_path = reinterpret_cast<const char*>(u8_file_path.c_str());
 		//Trying to open the file in reading binary mode
 		errno_t fopen_error = fopen_s(&_file_handle, c_file_path, "rb");
 
@@ -113,6 +133,17 @@ protected:
 		_is_file_opened = true;
 	}
 
+	/// <summary>
+	/// Prepares caller provided buffer to receive given number of rows of this image.
+	/// Reuses buffer memory if bit depth matches, otherwise replaces the buffer.
+	/// </summary>
+	void PrepareTargetBuffer(ImageBuffer_Byte& target, int num_rows) {
+		if (target.GetBitPerComponent() == _image_info._bit_depth)
+			target.Reshape(num_rows, _image_info._width, _image_info._layout);
+		else
+			target = ImageBuffer_Byte(num_rows, _image_info._width, _image_info._layout, _image_info._bit_depth);
+	}
+
 	/// <summary>
 	/// Advances rows counter and returns how many of num_rows will actually be read.
 	/// </summary>
@@ -188,4 +219,9 @@ protected:
 	///</summary>
 	ImageBufferInfo _image_info;
 
+	///<summary>
+	///ICC profile embedded in the file.
+	///</summary>
+	std::vector<uint8_t> _icc_profile;
+
 };
\ No newline at end of file
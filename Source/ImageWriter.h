@@ -62,8 +62,9 @@ public:
 	///Writes next block of rows starting at NextRow.
 	///Advances NextRow by the height of given image.
 	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
+	///Image buffers are accepted as views of the whole buffer, slices of a bigger image can be passed as row views without copying.
 	///</summary>
-	virtual void WriteNextRows(const ImageBuffer_Byte& image) = 0;
+	virtual void WriteNextRows(const ImageBufferView_Byte& image) = 0;
 
 	//--------------------------------
 	//	PUBLIC CONSTRUCTORS
@@ -0,0 +1,109 @@
+#include "JpegPlanarImage.h"
+#include "Downscaler.h"
+
+//--------------------------------
+//	PROCESSING
+//--------------------------------
+
+///<summary>
+///Downscales every plane at its own resolution and returns planar image of the new size with the same sampling factors.
+///Planes are downscaled in parallel.
+///<para>Throws std::invalid_argument if new size is not positive or bigger than current size.</para>
+///</summary>
+JpegPlanarImage JpegPlanarImage::Downscale(int new_height, int new_width) const {
+	if (new_height <= 0 || new_width <= 0 || new_height > _height || new_width > _width)
+		throw std::invalid_argument("JpegPlanarImage -- Invalid downscaled size.");
+
+	int max_h_samp = GetMaxHSampFactor();
+	int max_v_samp = GetMaxVSampFactor();
+	int num_components = GetNumComponents();
+
+	std::vector<ImageBuffer_Byte> planes;
+	planes.reserve(num_components);
+	for (int ci = 0; ci < num_components; ci++)
+		planes.emplace_back(0, 0, ImagePixelLayout::G, BitDepth::BD_8_BIT, false);
+
+	//Planes are independent, chroma planes are smaller so luma plane dominates
+	tbb::task_group tasks;
+	for (int ci = 0; ci < num_components; ci++) {
+		tasks.run([&, ci] {
+			int plane_height = PlaneSize(new_height, _v_samp_factors[ci], max_v_samp);
+			int plane_width = PlaneSize(new_width, _h_samp_factors[ci], max_h_samp);
+			planes[ci] = DownscalePlane(_planes[ci], plane_height, plane_width);
+		});
+	}
+	tasks.wait();
+
+	return JpegPlanarImage(new_height, new_width, _color_space, _h_samp_factors, _v_samp_factors, std::move(planes));
+}
+
+
+
+//--------------------------------
+//	CONSTRUCTORS
+//--------------------------------
+
+///<summary>
+///Builds planar image from given planes.
+///<para>Throws std::invalid_argument if planes do not match image size and sampling factors.</para>
+///</summary>
+JpegPlanarImage::JpegPlanarImage(int height, int width, J_COLOR_SPACE color_space, std::vector<int> h_samp_factors, std::vector<int> v_samp_factors, std::vector<ImageBuffer_Byte>&& planes) :
+	_height(height),
+	_width(width),
+	_color_space(color_space),
+	_h_samp_factors(std::move(h_samp_factors)),
+	_v_samp_factors(std::move(v_samp_factors)),
+	_planes(std::move(planes))
+{
+	if (_planes.empty() || _planes.size() > static_cast<size_t>(MAX_COMPONENTS) || _h_samp_factors.size() != _planes.size() || _v_samp_factors.size() != _planes.size())
+		throw std::invalid_argument("JpegPlanarImage -- Number of planes does not match number of sampling factors.");
+
+	for (size_t ci = 0; ci < _planes.size(); ci++)
+		if (_h_samp_factors[ci] < 1 || _h_samp_factors[ci] > MAX_SAMP_FACTOR || _v_samp_factors[ci] < 1 || _v_samp_factors[ci] > MAX_SAMP_FACTOR)
+			throw std::invalid_argument("JpegPlanarImage -- Sampling factor is out of range.");
+
+	int max_h_samp = GetMaxHSampFactor();
+	int max_v_samp = GetMaxVSampFactor();
+	for (size_t ci = 0; ci < _planes.size(); ci++) {
+		const ImageBuffer_Byte& plane = _planes[ci];
+		if (plane.GetBitPerComponent() != BitDepth::BD_8_BIT || plane.GetLayout() != ImagePixelLayout::G)
+			throw std::invalid_argument("JpegPlanarImage -- Planes should be 8 bit single channel buffers.");
+		if (plane.GetHeight() != PlaneSize(_height, _v_samp_factors[ci], max_v_samp) || plane.GetWidth() != PlaneSize(_width, _h_samp_factors[ci], max_h_samp))
+			throw std::invalid_argument("JpegPlanarImage -- Plane size does not match image size and sampling factors.");
+	}
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Downscales single 8 bit plane with Downscaler.
+///</summary>
+ImageBuffer_Byte JpegPlanarImage::DownscalePlane(const ImageBuffer_Byte& plane, int new_height, int new_width) {
+	int height = plane.GetHeight();
+	int width = plane.GetWidth();
+
+	//Downscaler works with 16 bit samples, expanding 8 to 16 bit the same way as ImageBuffer_Byte::ChangeBitDepth
+	ImageBuffer_uint16 expanded(height, width, ImagePixelLayout::G);
+	uint8_t** src_data = plane.GetDataPtr();
+	uint16_t** exp_data = expanded.GetDataPtr();
+	for (int row = 0; row < height; row++)
+		for (int col = 0; col < width; col++)
+			exp_data[row][col] = static_cast<uint16_t>(src_data[row][col]) * 257;
+
+	Downscaler scaler(ImagePixelLayout::G, height, width, new_height, new_width);
+	ImageBuffer_uint16 downscaled = scaler.DownscaleNext(expanded);
+
+	//Rounding back to 8 bit
+	ImageBuffer_Byte result(new_height, new_width, ImagePixelLayout::G, BitDepth::BD_8_BIT);
+	uint16_t** dwn_data = downscaled.GetDataPtr();
+	uint8_t** res_data = result.GetDataPtr();
+	for (int row = 0; row < new_height; row++)
+		for (int col = 0; col < new_width; col++)
+			res_data[row][col] = static_cast<uint8_t>((static_cast<uint32_t>(dwn_data[row][col]) + 128) / 257);
+
+	return result;
+}
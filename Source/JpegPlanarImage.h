@@ -0,0 +1,110 @@
+#pragma once
+//STL
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+//Third party
+#include "jpeglib.h"
+#include "oneapi/tbb.h"
+//Internal
+#include "ImageBuffer.h"
+#include "ImageBuffer_Byte.h"
+
+///<summary>
+///Image stored as separate JPEG component planes (for example Y, Cb, Cr) at their native subsampled resolution.
+///Each plane is an 8 bit single channel (G) buffer.
+///</summary>
+///<remarks>
+///Size of a plane follows libjpeg rules: plane_width = ceil(image_width * h_samp_factor / max_h_samp_factor),
+///same for height with vertical factors.
+///
+///Planar image is read with JpegReader::ReadJpegFilePlanar and written with JpegWriter::WriteJpegPlanar,
+///so JPEG-to-JPEG resizing skips chroma upsampling, color conversion and chroma subsampling.
+///Planes are averaged as stored, without gamma removal, which is the usual tradeoff of resizing in YCbCr.
+///</remarks>
+class JpegPlanarImage {
+public:
+	//--------------------------------
+	//	ACCESSORS
+	//--------------------------------
+
+	int GetHeight() const { return _height; }
+	int GetWidth() const { return _width; }
+	J_COLOR_SPACE GetColorSpace() const { return _color_space; }
+	int GetNumComponents() const { return static_cast<int>(_planes.size()); }
+
+	int GetHSampFactor(int component) const { return _h_samp_factors[component]; }
+	int GetVSampFactor(int component) const { return _v_samp_factors[component]; }
+	int GetMaxHSampFactor() const { return *std::max_element(_h_samp_factors.begin(), _h_samp_factors.end()); }
+	int GetMaxVSampFactor() const { return *std::max_element(_v_samp_factors.begin(), _v_samp_factors.end()); }
+
+	///<summary>
+	///Plane of given component.
+	///</summary>
+	const ImageBuffer_Byte& GetPlane(int component) const { return _planes[component]; }
+
+	///<summary>
+	///Plane of given component.
+	///</summary>
+	ImageBuffer_Byte& GetPlane(int component) { return _planes[component]; }
+
+	///<summary>
+	///Size of the plane along one axis for given image size and sampling factors.
+	///</summary>
+	static int PlaneSize(int image_size, int samp_factor, int max_samp_factor) {
+		return (image_size * samp_factor + max_samp_factor - 1) / max_samp_factor;
+	}
+
+	//--------------------------------
+	//	PROCESSING
+	//--------------------------------
+
+	///<summary>
+	///Downscales every plane at its own resolution and returns planar image of the new size with the same sampling factors.
+	///Planes are downscaled in parallel.
+	///<para>Throws std::invalid_argument if new size is not positive or bigger than current size.</para>
+	///</summary>
+	JpegPlanarImage Downscale(int new_height, int new_width) const;
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	///<summary>
+	///Builds planar image from given planes.
+	///<para>Throws std::invalid_argument if planes do not match image size and sampling factors.</para>
+	///</summary>
+	///<param name="height">Image height in pixels.</param>
+	///<param name="width">Image width in pixels.</param>
+	///<param name="color_space">JPEG colorspace of the planes.</param>
+	///<param name="h_samp_factors">Horizontal sampling factor of each component (1-4).</param>
+	///<param name="v_samp_factors">Vertical sampling factor of each component (1-4).</param>
+	///<param name="planes">8 bit G planes of each component.</param>
+	JpegPlanarImage(int height, int width, J_COLOR_SPACE color_space, std::vector<int> h_samp_factors, std::vector<int> v_samp_factors, std::vector<ImageBuffer_Byte>&& planes);
+
+	JpegPlanarImage(JpegPlanarImage&& other) = default;
+	JpegPlanarImage& operator=(JpegPlanarImage&& other) = default;
+	JpegPlanarImage(const JpegPlanarImage& other) = delete;
+	JpegPlanarImage& operator=(const JpegPlanarImage& other) = delete;
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	int _height = 0;
+	int _width = 0;
+	J_COLOR_SPACE _color_space = J_COLOR_SPACE::JCS_UNKNOWN;
+	std::vector<int> _h_samp_factors;
+	std::vector<int> _v_samp_factors;
+	std::vector<ImageBuffer_Byte> _planes;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Downscales single 8 bit plane with Downscaler.
+	///</summary>
+	static ImageBuffer_Byte DownscalePlane(const ImageBuffer_Byte& plane, int new_height, int new_width);
+};
@@ -13,14 +13,36 @@
 ///When all rows are already read returns NULL.
 ///</summary>
 ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
-	
-	//----------------------------------------------------------------------
-	// 1 - Arguments check
-
 	//If reading has finished we return unallocated image buffer
 	if (_state == ReaderStates::Finished)
 		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth(), false);
 
+	//Simple argument sanity check (failed and uninitialized states are reported by ReadNextRowsInto)
+	if (num_rows <= 0 && (_state == ReaderStates::Ready_Start || _state == ReaderStates::Ready_Continue))
+		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth(), false);
+
+	//This object will represent the result of file reading.
+	ImageBuffer_Byte decompressed_image(0, _image_info._width, _image_info._layout, _image_info._bit_depth, false);
+	ReadNextRowsInto(num_rows, decompressed_image);
+
+	//Returning decompressed image object
+	return decompressed_image;
+}
+
+
+
+///<summary>
+///Reads next block of rows starting at NextRow into caller provided buffer.
+///Buffer is reshaped to the number of rows actually read, its allocated memory is reused when possible.
+///Advances NextRow by num_lines.
+///When all rows are already read buffer is reshaped to zero rows.
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+void JpegReader::ReadNextRowsInto(int num_rows, ImageBuffer_Byte& target) {
+	
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
 	//If reader has failed before we throw
 	if (_state == ReaderStates::Failed) {
 		CleanUp();
@@ -33,9 +55,11 @@ ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
 		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Trying to read a file using uninitialized reader object.");
 	}
 
-	//Simple argument sanity check
-	if (num_rows <= 0)
-		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth(), false);
+	//If reading has finished or nothing is requested there are no rows to return
+	if (_state == ReaderStates::Finished || num_rows <= 0) {
+		PrepareTargetBuffer(target, 0);
+		return;
+	}
 
 	//----------------------------------------------------------------------
 	// 2 - Remaining rows calculation
@@ -46,17 +70,13 @@ ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
 	//----------------------------------------------------------------------
 	// 3 - Decompressing the image
 
-	//This object will represent the result of file reading.
-	ImageBuffer_Byte decompressed_image(
-			actual_num_rows,
-			_image_info._width,
-			_image_info._layout,
-			_image_info._bit_depth);
+	//Reshaping the target to receive decompressed rows
+	PrepareTargetBuffer(target, actual_num_rows);
 
 	//Pointer to the beginning of array of rows where decompressed rows will be stored.
 	//JSAMPARRAY is an array of row pointers, where rows themselves are arrays of uchar. So, basically JSAMPARRAY = unsigned char**.
 	//This pointer is the beginning of ImageBuffer_Byte data array.
-	JSAMPARRAY decompressed_data_array = static_cast<JSAMPARRAY>(decompressed_image.GetDataPtr());
+	JSAMPARRAY decompressed_data_array = static_cast<JSAMPARRAY>(target.GetDataPtr());
 
 	try {
 		//Aqcuiring decompressed rows.
@@ -70,7 +90,6 @@ ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
 			);
 	}
 	catch (codec_fatal_exception e) {
-		/* delete decompressed_image; //Deleting the uncompressed image object */ //Archived from the times when the buffer was returned as a pointer
 		_state = ReaderStates::Failed;
 		CleanUp();
 		throw; //rethrowing
@@ -94,9 +113,6 @@ ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
 	//If this was first block to read we switch state to continue
 	if (_state == ReaderStates::Ready_Start)
 		_state = ReaderStates::Ready_Continue;
-
-	//Returning decompressed image object
-	return decompressed_image;
 }
 
 
@@ -114,9 +130,11 @@ ImageBuffer_Byte JpegReader::ReadNextRows(int num_rows) {
 ///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
 ///<param name="warningCallback">Pointer to function to handle warnings produced by libJpeg. Can be NULL.</param>
 ///<param name="warningCallbackArgsPtr">Arguments to be given to warning handler function. Can be NULL.</param>
-ImageBuffer_Byte JpegReader::ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
-	JpegReader reader(file_path, warning_callback_data);
+///<param name="num_bands_ptr">Writes number of parallel bands to this pointer, 1 if the file was decoded sequentially. If NULL it is ignored.</param>
+ImageBuffer_Byte JpegReader::ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, DecodeProfile profile, int* num_bands_ptr) {
+	JpegReader reader(file_path, warning_callback_data, profile);
 	JpegHeaderInfo header = reader.GetJpegHeader();
+	ImageBufferInfo image_info = reader.GetCommonHeader();
 
 	//Returning header content to the user
 	if (headerPtr != nullptr) {
@@ -125,7 +143,390 @@ ImageBuffer_Byte JpegReader::ReadJpegFile(std::filesystem::path file_path, JpegH
 		headerPtr->_color_space = header.GetColorSpace();
 		headerPtr->_num_components = header.GetNumComponents();
 	}
-	return reader.ReadNextRows(header._height);
+
+	//----------------------------------------------------------------------
+	// Checking if the file can be decoded in parallel bands
+
+	int rows_per_segment = reader.GetRowsPerRestartSegment();
+	int num_segments = rows_per_segment > 0 ? (image_info._height + rows_per_segment - 1) / rows_per_segment : 0;
+	//Each band also decodes one neighbouring segment on each side, so band is worth it only with at least two own segments
+	int num_bands = std::min(num_segments / 2, oneapi::tbb::info::default_concurrency());
+
+	//No restart markers (or too few of them) - reading the file sequentially
+	if (num_bands < 2) {
+		if (num_bands_ptr != NULL)
+			*num_bands_ptr = 1;
+		return reader.ReadNextRows(header._height);
+	}
+
+	//Releasing the reader. File must be closed before we can load it to memory.
+	reader.CleanUp();
+	reader._state = ReaderStates::Finished;
+
+	//----------------------------------------------------------------------
+	// Loading the file to memory
+
+	std::ifstream file_stream(file_path, std::ios::binary | std::ios::ate);
+	if (!file_stream.is_open())
+		throw std::ifstream::failure("Failed to open file.");
+	std::vector<uint8_t> file_data(static_cast<size_t>(file_stream.tellg()));
+	file_stream.seekg(0);
+	file_stream.read(reinterpret_cast<char*>(file_data.data()), file_data.size());
+	file_stream.close();
+
+	//----------------------------------------------------------------------
+	// Locating restart segments
+
+	RestartSegments segments;
+	if (!FindRestartSegments(file_data, image_info._height, rows_per_segment, segments)) {
+		//Markers are not where the header says they should be - falling back to sequential reading
+		if (num_bands_ptr != NULL)
+			*num_bands_ptr = 1;
+		JpegReader sequential_reader(file_path, warning_callback_data, profile);
+		return sequential_reader.ReadNextRows(header._height);
+	}
+
+	//----------------------------------------------------------------------
+	// Decoding the bands in parallel
+
+	ImageBuffer_Byte decompressed_image(
+		image_info._height,
+		image_info._width,
+		image_info._layout,
+		image_info._bit_depth);
+
+	//Each band collects its warnings separately, so user callback is never called from several threads
+	std::vector<std::vector<std::string>> band_warnings(num_bands);
+
+	oneapi::tbb::task_group band_tasks;
+	for (int band = 0; band < num_bands; band++) {
+		int first_segment = band * num_segments / num_bands;
+		int last_segment = (band + 1) * num_segments / num_bands;
+		std::vector<std::string>& warnings = band_warnings[band];
+		band_tasks.run([&file_data, &segments, &decompressed_image, &warnings, first_segment, last_segment, profile] {
+			DecodeRestartBand(file_data, segments, first_segment, last_segment, decompressed_image, warnings, profile);
+		});
+	}
+
+	//Reporting warnings in file order, also when decoding failed
+	auto report_warnings = [&band_warnings, &warning_callback_data] {
+		if (warning_callback_data.warningCallback == NULL)
+			return;
+		for (const std::vector<std::string>& warnings : band_warnings)
+			for (const std::string& message : warnings)
+				warning_callback_data.warningCallback(message, warning_callback_data.warningCallbackArgs_ptr);
+	};
+
+	//Exceptions thrown by decoding tasks are rethrown here
+	try {
+		band_tasks.wait();
+	}
+	catch (codec_fatal_exception e) {
+		report_warnings();
+		throw;
+	}
+	report_warnings();
+
+	if (num_bands_ptr != NULL)
+		*num_bands_ptr = num_bands;
+	return decompressed_image;
+}
+
+
+
+
+///<summary>
+///Static method. Reads reduced resolution version of the image for further downscaling.
+///<para>Image is decoded with the smallest DCT scaling (1/8, 1/4, 1/2 or 1/1) that gives at least min_height x min_width pixels.</para>
+///<para>Progressive file is read in buffered image mode and decoding stops after the first scan
+///that has delivered all coefficients used at chosen scale (for 1/8 scale that is DC scans only).
+///Later scans only refine precision of the coefficients and are never decompressed.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+///<param name="file_path">Path to file to read.</param>
+///<param name="min_height">Minimal height of the returned image (usually downscaling target height).</param>
+///<param name="min_width">Minimal width of the returned image (usually downscaling target width).</param>
+///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored. Header describes the full resolution image.</param>
+///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+ImageBuffer_Byte JpegReader::ReadJpegFileReduced(std::filesystem::path file_path, int min_height, int min_width, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Initializing decompressor
+	
+	//Reader object is used only to own the file and decompressor,
+	//since decompressor has to be set up differently before starting decompression.
+	//In case of exception reader destructor releases both.
+	JpegReader reader;
+	reader._warning_callback_data.warningCallback = warning_callback_data.warningCallback;
+	reader._warning_callback_data.warningCallbackArgs_ptr = warning_callback_data.warningCallbackArgs_ptr;
+
+	reader.OpenCFileForBinaryReading(file_path);
+
+	jpeg_decompress_struct& decomp = reader.jpeg_decomp;
+	decomp.err = jpeg_std_error(&reader.jerr_decomp);
+	reader.jerr_decomp.error_exit = &ErrorExitHandler;
+	reader.jerr_decomp.emit_message = &WarningHandler;
+	jpeg_create_decompress(&decomp);
+	jpeg_stdio_src(&decomp, reader._file_handle);
+	decomp.client_data = &reader._warning_callback_data;
+	reader._is_decompressor_initialized = true;
+
+	//----------------------------------------------------------------------
+	// 2 - Reading the header
+
+	jpeg_read_header(&decomp, TRUE);
+
+	if (headerPtr != nullptr) {
+		headerPtr->_height = decomp.image_height;
+		headerPtr->_width = decomp.image_width;
+		headerPtr->_color_space = decomp.jpeg_color_space;
+		headerPtr->_num_components = decomp.num_components;
+	}
+
+	//----------------------------------------------------------------------
+	// 3 - Choosing the scale
+
+	//Scale is scale_num/8. At scale N/8 only top-left NxN coefficients of each block are used.
+	//Last zigzag index of the NxN corner for N = 1, 2, 4, 8.
+	const int scale_nums[4] = { 1, 2, 4, 8 };
+	const int last_zigzag_indices[4] = { 0, 4, 24, 63 };
+
+	int scale_index = 3;
+	for (int i = 0; i < 4; i++) {
+		int scaled_height = static_cast<int>((static_cast<uint64_t>(decomp.image_height) * scale_nums[i] + 7) / 8);
+		int scaled_width = static_cast<int>((static_cast<uint64_t>(decomp.image_width) * scale_nums[i] + 7) / 8);
+		if (scaled_height >= min_height && scaled_width >= min_width) {
+			scale_index = i;
+			break;
+		}
+	}
+
+	decomp.scale_num = scale_nums[scale_index];
+	decomp.scale_denom = 8;
+
+	//Same output settings as used by sequential reader
+	if (decomp.jpeg_color_space == J_COLOR_SPACE::JCS_GRAYSCALE)
+		decomp.out_color_space = J_COLOR_SPACE::JCS_GRAYSCALE;
+	else
+		decomp.out_color_space = J_COLOR_SPACE::JCS_RGB;
+	decomp.dct_method = J_DCT_METHOD::JDCT_ISLOW;
+
+	//Progressive file is decoded in buffered image mode so we can output the image before all scans are read.
+	//Sequential files with components in separate scans also have multiple scans, but every scan carries
+	//all coefficients of its components, so they are decoded fully.
+	bool is_progressive = decomp.progressive_mode != FALSE;
+	decomp.buffered_image = is_progressive ? TRUE : FALSE;
+
+	jpeg_start_decompress(&decomp);
+
+	//----------------------------------------------------------------------
+	// 4 - Consuming scans (progressive only)
+
+	if (is_progressive) {
+		//Reading scans until coefficients required for chosen scale are there
+		while (true) {
+			int status = jpeg_consume_input(&decomp);
+			if (status == JPEG_REACHED_EOI || status == JPEG_SUSPENDED)
+				break;
+			if (status == JPEG_SCAN_COMPLETED && AreCoefficientsReceived(decomp, last_zigzag_indices[scale_index]))
+				break;
+		}
+
+		//Preparing output of everything received so far
+		jpeg_start_output(&decomp, decomp.input_scan_number);
+	}
+
+	//----------------------------------------------------------------------
+	// 5 - Decompressing the image
+
+	ImageBuffer_Byte reduced_image(
+		static_cast<int>(decomp.output_height),
+		static_cast<int>(decomp.output_width),
+		JpegLayoutToImageLayout(decomp.jpeg_color_space),
+		BitDepth::BD_8_BIT);
+	JSAMPARRAY image_rows = static_cast<JSAMPARRAY>(reduced_image.GetDataPtr());
+
+	while (decomp.output_scanline < decomp.output_height)
+		jpeg_read_scanlines(&decomp, &(image_rows[decomp.output_scanline]), decomp.output_height - decomp.output_scanline);
+
+	//----------------------------------------------------------------------
+	// 6 - Finishing
+
+	//Remaining scans are not needed, decompressor is destroyed without finishing
+	reader.CleanUp();
+	reader._state = ReaderStates::Finished;
+
+	return reduced_image;
+}
+
+
+
+
+///<summary>
+///Static method. Reads raw component planes (for example Y, Cb and Cr) of the file at their native subsampled resolution.
+///<para>Chroma upsampling and color conversion are skipped, planes are in the JPEG file colorspace.
+///Intended for JPEG-to-JPEG processing together with JpegWriter::WriteJpegPlanar.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+JpegPlanarImage JpegReader::ReadJpegFilePlanar(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Initializing decompressor
+
+	//Reader object is used only to own the file and decompressor.
+	//In case of exception reader destructor releases both.
+	JpegReader reader;
+	reader._warning_callback_data.warningCallback = warning_callback_data.warningCallback;
+	reader._warning_callback_data.warningCallbackArgs_ptr = warning_callback_data.warningCallbackArgs_ptr;
+
+	reader.OpenCFileForBinaryReading(file_path);
+
+	jpeg_decompress_struct& decomp = reader.jpeg_decomp;
+	decomp.err = jpeg_std_error(&reader.jerr_decomp);
+	reader.jerr_decomp.error_exit = &ErrorExitHandler;
+	reader.jerr_decomp.emit_message = &WarningHandler;
+	jpeg_create_decompress(&decomp);
+	jpeg_stdio_src(&decomp, reader._file_handle);
+	decomp.client_data = &reader._warning_callback_data;
+	reader._is_decompressor_initialized = true;
+
+	//----------------------------------------------------------------------
+	// 2 - Reading the header
+
+	jpeg_read_header(&decomp, TRUE);
+
+	if (headerPtr != nullptr) {
+		headerPtr->_height = decomp.image_height;
+		headerPtr->_width = decomp.image_width;
+		headerPtr->_color_space = decomp.jpeg_color_space;
+		headerPtr->_num_components = decomp.num_components;
+	}
+
+	//Raw output bypasses upsampling and color conversion
+	decomp.raw_data_out = TRUE;
+	decomp.out_color_space = decomp.jpeg_color_space;
+	decomp.dct_method = J_DCT_METHOD::JDCT_ISLOW;
+
+	jpeg_start_decompress(&decomp);
+
+	//----------------------------------------------------------------------
+	// 3 - Allocating planes
+
+	//Raw data is written in whole blocks and whole iMCU rows,
+	//so planes are allocated padded and reshaped to actual size after reading.
+	int num_components = decomp.num_components;
+	std::vector<ImageBuffer_Byte> planes;
+	std::vector<int> h_samp_factors(num_components);
+	std::vector<int> v_samp_factors(num_components);
+	planes.reserve(num_components);
+	for (int ci = 0; ci < num_components; ci++) {
+		jpeg_component_info* comp = &decomp.comp_info[ci];
+		h_samp_factors[ci] = comp->h_samp_factor;
+		v_samp_factors[ci] = comp->v_samp_factor;
+		planes.emplace_back(
+			static_cast<int>(decomp.total_iMCU_rows) * comp->v_samp_factor * DCTSIZE,
+			static_cast<int>(comp->width_in_blocks) * DCTSIZE,
+			ImagePixelLayout::G,
+			BitDepth::BD_8_BIT);
+	}
+
+	//----------------------------------------------------------------------
+	// 4 - Decompressing iMCU rows
+
+	int imcu_height = decomp.max_v_samp_factor * DCTSIZE;
+	std::vector<JSAMPARRAY> component_rows(num_components);
+	for (JDIMENSION imcu_row = 0; imcu_row < decomp.total_iMCU_rows; imcu_row++) {
+		for (int ci = 0; ci < num_components; ci++)
+			component_rows[ci] = static_cast<JSAMPARRAY>(planes[ci].GetDataPtr()) + imcu_row * v_samp_factors[ci] * DCTSIZE;
+		jpeg_read_raw_data(&decomp, component_rows.data(), imcu_height);
+	}
+
+	for (int ci = 0; ci < num_components; ci++)
+		planes[ci].Reshape(static_cast<int>(decomp.comp_info[ci].downsampled_height), static_cast<int>(decomp.comp_info[ci].downsampled_width), ImagePixelLayout::G);
+
+	//----------------------------------------------------------------------
+	// 5 - Finishing
+
+	jpeg_finish_decompress(&decomp);
+	reader.CleanUp();
+	reader._state = ReaderStates::Finished;
+
+	return JpegPlanarImage(
+		static_cast<int>(decomp.image_height),
+		static_cast<int>(decomp.image_width),
+		decomp.jpeg_color_space,
+		std::move(h_samp_factors),
+		std::move(v_samp_factors),
+		std::move(planes));
+}
+
+
+
+
+///<summary>
+///Static method. Decompresses JPEG image stored in memory (for example embedded preview) and returns an image buffer object.
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+///<param name="data">JPEG file contents.</param>
+///<param name="size">Size of JPEG file contents in bytes.</param>
+///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+ImageBuffer_Byte JpegReader::ReadJpegData(const uint8_t* data, size_t size, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Initializing decompressor
+
+	struct jpeg_decompress_struct decomp;
+	struct jpeg_error_mgr jerr;
+
+	decomp.err = jpeg_std_error(&jerr);
+	jerr.error_exit = &ErrorExitHandler;
+	jerr.emit_message = &WarningHandler;
+	jpeg_create_decompress(&decomp);
+	decomp.client_data = &warning_callback_data;
+
+	jpeg_mem_src(&decomp, data, static_cast<unsigned long>(size));
+
+	//----------------------------------------------------------------------
+	// 2 - Decompressing the image
+
+	try {
+		jpeg_read_header(&decomp, TRUE);
+
+		if (headerPtr != nullptr) {
+			headerPtr->_height = decomp.image_height;
+			headerPtr->_width = decomp.image_width;
+			headerPtr->_color_space = decomp.jpeg_color_space;
+			headerPtr->_num_components = decomp.num_components;
+		}
+
+		//Same output settings as used by sequential reader
+		if (decomp.jpeg_color_space == J_COLOR_SPACE::JCS_GRAYSCALE)
+			decomp.out_color_space = J_COLOR_SPACE::JCS_GRAYSCALE;
+		else
+			decomp.out_color_space = J_COLOR_SPACE::JCS_RGB;
+		decomp.dct_method = J_DCT_METHOD::JDCT_ISLOW;
+
+		jpeg_start_decompress(&decomp);
+
+		ImageBuffer_Byte image(
+			static_cast<int>(decomp.output_height),
+			static_cast<int>(decomp.output_width),
+			JpegLayoutToImageLayout(decomp.jpeg_color_space),
+			BitDepth::BD_8_BIT);
+		JSAMPARRAY image_rows = static_cast<JSAMPARRAY>(image.GetDataPtr());
+
+		while (decomp.output_scanline < decomp.output_height)
+			jpeg_read_scanlines(&decomp, &(image_rows[decomp.output_scanline]), decomp.output_height - decomp.output_scanline);
+
+		jpeg_finish_decompress(&decomp);
+		jpeg_destroy_decompress(&decomp);
+
+		return image;
+	}
+	catch (codec_fatal_exception e) {
+		jpeg_destroy_decompress(&decomp);
+		throw;
+	}
 }
 
 
@@ -141,7 +542,7 @@ ImageBuffer_Byte JpegReader::ReadJpegFile(std::filesystem::path file_path, JpegH
 ///<para>Can throw std::ifstream::failure if failed to open file.</para>
 ///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
 ///</summary>
-JpegReader::JpegReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data) : ImageReader(file_path) {
+JpegReader::JpegReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data, DecodeProfile profile) : ImageReader(file_path) {
 	//----------------------------------------------------------------------
 	// 0 - Setting initial state of the reader object
 
@@ -180,6 +581,9 @@ JpegReader::JpegReader(std::filesystem::path file_path, WarningCallbackData warn
 	//----------------------------------------------------------------------
 	// 3 - Reading the image header 
 
+	//Keeping APP2 markers that carry ICC profile
+	jpeg_save_markers(&jpeg_decomp, JPEG_APP0 + 2, 0xFFFF);
+
 	//Reading JPEG header to get the image info.
 	//If error is encountered ErrorExitHandler will be called.
 	try {
@@ -211,6 +615,14 @@ JpegReader::JpegReader(std::filesystem::path file_path, WarningCallbackData warn
 	_image_info._bit_depth = BitDepth::BD_8_BIT; //Jpeg can only be 8 bit per channel
 	_image_info._layout = JpegLayoutToImageLayout(_jpeg_header._color_space);
 
+	//ICC profile split between APP2 markers
+	JOCTET* icc_data = NULL;
+	unsigned int icc_size = 0;
+	if (jpeg_read_icc_profile(&jpeg_decomp, &icc_data, &icc_size)) {
+		_icc_profile.assign(icc_data, icc_data + icc_size);
+		free(icc_data);
+	}
+
 	//----------------------------------------------------------------------
 	// 4 - Setting the decompressor to the ready state
 
@@ -224,6 +636,7 @@ JpegReader::JpegReader(std::filesystem::path file_path, WarningCallbackData warn
 
 	//Setting decompression method choosing slow and accurate
 	jpeg_decomp.dct_method = J_DCT_METHOD::JDCT_ISLOW;
+	ApplyDecodeProfile(jpeg_decomp, profile);
 
 	//Setting decompressor to ready state
 	//Image info will be available after this call
@@ -259,6 +672,23 @@ ImagePixelLayout JpegReader::JpegLayoutToImageLayout(J_COLOR_SPACE jpeg_colorspa
 
 
 
+///<summary>
+///Applies decode profile to the decompressor after output parameters are set.
+///</summary>
+void JpegReader::ApplyDecodeProfile(jpeg_decompress_struct& decomp, DecodeProfile profile) {
+	if (profile != DecodeProfile::DP_TRUSTED)
+		return;
+
+	//Fast integer IDCT is slightly less accurate, the difference is lost after downscaling
+	decomp.dct_method = J_DCT_METHOD::JDCT_IFAST;
+	//Chroma is replicated instead of interpolated
+	decomp.do_fancy_upsampling = FALSE;
+	//No DC smoothing of blocks in progressive files
+	decomp.do_block_smoothing = FALSE;
+}
+
+
+
 
 //--------------------------------
 //	PRIVATE METHODS
@@ -282,6 +712,317 @@ void JpegReader::CleanUp() {
 }
 
 
+//--------------------------------
+//	RESTART SEGMENTS DECODING
+//--------------------------------
+
+///<summary>
+///Returns number of image rows covered by one restart segment
+///if decompressor state allows decoding restart segments independently.
+///Returns 0 otherwise (no restart markers, progressive or multiscan file,
+///or restart interval does not fall on MCU row boundaries).
+///</summary>
+int JpegReader::GetRowsPerRestartSegment() {
+	if (_state != ReaderStates::Ready_Start)
+		return 0;
+
+	//No restart markers
+	if (jpeg_decomp.restart_interval == 0)
+		return 0;
+
+	//Only files with a single scan containing all components can be split by restart markers
+	if (jpeg_decomp.progressive_mode || jpeg_decomp.comps_in_scan != jpeg_decomp.num_components)
+		return 0;
+
+	//MCU size in pixels.
+	//Single component scans are not interleaved and have MCU of one block.
+	int mcu_width = DCTSIZE;
+	int mcu_height = DCTSIZE;
+	if (jpeg_decomp.num_components > 1) {
+		mcu_width = DCTSIZE * jpeg_decomp.max_h_samp_factor;
+		mcu_height = DCTSIZE * jpeg_decomp.max_v_samp_factor;
+	}
+	int mcus_per_row = (static_cast<int>(jpeg_decomp.image_width) + mcu_width - 1) / mcu_width;
+
+	//Restart segment must consist of whole MCU rows
+	if (jpeg_decomp.restart_interval % mcus_per_row != 0)
+		return 0;
+
+	return (jpeg_decomp.restart_interval / mcus_per_row) * mcu_height;
+}
+
+
+///<summary>
+///Returns true if every component has received at least first approximation
+///of coefficients up to given zigzag index. Used in buffered image mode of progressive decoding.
+///</summary>
+bool JpegReader::AreCoefficientsReceived(const jpeg_decompress_struct& decomp, int last_zigzag_index) {
+	for (int cmp = 0; cmp < decomp.num_components; cmp++)
+		for (int coef = 0; coef <= last_zigzag_index; coef++)
+			//-1 means no scan has delivered this coefficient yet
+			if (decomp.coef_bits[cmp][coef] < 0)
+				return false;
+	return true;
+}
+
+
+
+///<summary>
+///Walks markers of a JPEG file loaded to memory and finds header segments and restart segments of the scan.
+///Returns false if the file structure is not suitable for band decoding,
+///in which case the file should be decoded sequentially.
+///</summary>
+bool JpegReader::FindRestartSegments(const std::vector<uint8_t>& file_data, int image_height, int rows_per_segment, RestartSegments& segments) {
+	size_t size = file_data.size();
+
+	//----------------------------------------------------------------------
+	// 1 - Header markers
+
+	//File must start with SOI
+	if (size < 4 || file_data[0] != 0xFF || file_data[1] != 0xD8)
+		return false;
+	segments.header_ranges.push_back(std::pair<size_t, size_t>(0, 2));
+
+	size_t pos = 2;
+	bool sof_found = false;
+	while (true) {
+		//Skipping fill bytes before the marker
+		while (pos + 1 < size && file_data[pos] == 0xFF && file_data[pos + 1] == 0xFF)
+			pos++;
+		if (pos + 4 > size || file_data[pos] != 0xFF)
+			return false;
+
+		uint8_t marker = file_data[pos + 1];
+		size_t length = (static_cast<size_t>(file_data[pos + 2]) << 8) | file_data[pos + 3];
+		size_t segment_end = pos + 2 + length;
+		if (length < 2 || segment_end > size)
+			return false;
+
+		//Baseline and extended sequential huffman frames
+		if (marker == 0xC0 || marker == 0xC1) {
+			if (length < 8)
+				return false;
+			segments.sof_height_offset = pos + 5;
+			sof_found = true;
+		}
+		//Any other frame type (progressive, lossless, arithmetic, hierarchical)
+		else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xCC)
+			return false;
+
+		//Metadata segments (APP1 - APP13, APP15, COM) are not needed by the decoder.
+		//APP0 (JFIF) and APP14 (Adobe) are kept since they define color transform.
+		bool is_metadata = (marker >= 0xE1 && marker <= 0xED) || marker == 0xEF || marker == 0xFE;
+		if (!is_metadata)
+			segments.header_ranges.push_back(std::pair<size_t, size_t>(pos, segment_end));
+
+		pos = segment_end;
+
+		//Scan header is the last one before entropy coded data
+		if (marker == 0xDA)
+			break;
+	}
+
+	if (!sof_found)
+		return false;
+	segments.scan_data_offset = pos;
+
+	//----------------------------------------------------------------------
+	// 2 - Restart segments of the scan
+
+	segments.segment_begins.push_back(pos);
+	while (pos + 1 < size) {
+		if (file_data[pos] != 0xFF) {
+			pos++;
+			continue;
+		}
+
+		uint8_t next = file_data[pos + 1];
+		//Stuffed zero byte or fill byte
+		if (next == 0x00 || next == 0xFF) {
+			pos += (next == 0x00) ? 2 : 1;
+			continue;
+		}
+		//Restart marker
+		if (next >= 0xD0 && next <= 0xD7) {
+			segments.segment_ends.push_back(pos);
+			segments.segment_begins.push_back(pos + 2);
+			pos += 2;
+			continue;
+		}
+		//End of image
+		if (next == 0xD9) {
+			segments.segment_ends.push_back(pos);
+			break;
+		}
+		//Any other marker (DNL, another scan) - can not split
+		return false;
+	}
+
+	//Truncated file - leaving it to sequential decoder to deal with it
+	if (segments.segment_ends.size() != segments.segment_begins.size())
+		return false;
+
+	//Number of segments must match the restart interval from the header
+	size_t expected_segments = static_cast<size_t>((image_height + rows_per_segment - 1) / rows_per_segment);
+	if (segments.segment_begins.size() != expected_segments)
+		return false;
+
+	segments.rows_per_segment = rows_per_segment;
+	return true;
+}
+
+
+///<summary>
+///Decodes restart segments [first_segment, last_segment) into corresponding rows of the image.
+///Neighbouring segments are decoded as well to provide context for chroma upsampling,
+///so band edges are identical to the sequentially decoded image.
+///<para>Uses its own decompressor object so it can be run in parallel with other bands.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+void JpegReader::DecodeRestartBand(
+	const std::vector<uint8_t>& file_data,
+	const RestartSegments& segments,
+	int first_segment,
+	int last_segment,
+	ImageBuffer_Byte& image,
+	std::vector<std::string>& band_warnings,
+	DecodeProfile profile) {
+
+	//----------------------------------------------------------------------
+	// 1 - Band geometry
+
+	int num_segments = static_cast<int>(segments.segment_begins.size());
+	int image_height = image.GetHeight();
+
+	//Decoded segments including context segments
+	int decode_first_segment = std::max(0, first_segment - 1);
+	int decode_last_segment = std::min(num_segments, last_segment + 1);
+
+	//Rows in image coordinates
+	int decode_first_row = decode_first_segment * segments.rows_per_segment;
+	int decode_last_row = std::min(image_height, decode_last_segment * segments.rows_per_segment);
+	int band_first_row = first_segment * segments.rows_per_segment;
+	int band_last_row = std::min(image_height, last_segment * segments.rows_per_segment);
+
+	//----------------------------------------------------------------------
+	// 2 - Building stand-alone JPEG stream for the band
+
+	std::vector<uint8_t> band_stream;
+	band_stream.reserve(segments.scan_data_offset + segments.segment_ends[decode_last_segment - 1] - segments.segment_begins[decode_first_segment] + 2);
+
+	//Header segments
+	size_t height_offset_in_stream = 0;
+	for (const std::pair<size_t, size_t>& range : segments.header_ranges) {
+		if (segments.sof_height_offset >= range.first && segments.sof_height_offset < range.second)
+			height_offset_in_stream = band_stream.size() + (segments.sof_height_offset - range.first);
+		band_stream.insert(band_stream.end(), file_data.begin() + range.first, file_data.begin() + range.second);
+	}
+
+	//Frame height is set to the height of the band
+	int decode_height = decode_last_row - decode_first_row;
+	band_stream[height_offset_in_stream] = static_cast<uint8_t>(decode_height >> 8);
+	band_stream[height_offset_in_stream + 1] = static_cast<uint8_t>(decode_height & 0xFF);
+
+	//Entropy coded segments. Restart markers are renumbered since decoder expects them to start from RST0.
+	//Own segments of the band are [own_begin, own_end) in the stream, header belongs to the first band and EOI to the last one.
+	//Decoder reads restart marker when it starts the following segment, so marker belongs to the following segment.
+	size_t own_begin = 0;
+	size_t own_end = std::numeric_limits<size_t>::max();
+	for (int segment = decode_first_segment; segment < decode_last_segment; segment++) {
+		band_stream.insert(band_stream.end(), file_data.begin() + segments.segment_begins[segment], file_data.begin() + segments.segment_ends[segment]);
+		if (segment != decode_last_segment - 1) {
+			if (segment + 1 == first_segment)
+				own_begin = band_stream.size();
+			if (segment + 1 == last_segment)
+				own_end = band_stream.size();
+			band_stream.push_back(0xFF);
+			band_stream.push_back(static_cast<uint8_t>(0xD0 + ((segment - decode_first_segment) & 7)));
+		}
+	}
+
+	//EOI
+	band_stream.push_back(0xFF);
+	band_stream.push_back(0xD9);
+
+	//----------------------------------------------------------------------
+	// 3 - Initializing decompressor
+
+	struct jpeg_decompress_struct decomp;
+	struct jpeg_error_mgr jerr;
+
+	decomp.err = jpeg_std_error(&jerr);
+	jerr.error_exit = &ErrorExitHandler;
+	jerr.emit_message = &WarningHandler;
+	jpeg_create_decompress(&decomp);
+
+	//Warnings are collected for the caller instead of being reported from the decoding thread
+	BandWarnings warnings;
+	warnings.decomp = &decomp;
+	warnings.stream = band_stream.data();
+	warnings.own_begin = own_begin;
+	warnings.own_end = own_end;
+	WarningCallbackData warning_callback_data(&CollectBandWarning, &warnings);
+	decomp.client_data = &warning_callback_data;
+
+	jpeg_mem_src(&decomp, band_stream.data(), static_cast<unsigned long>(band_stream.size()));
+
+	//----------------------------------------------------------------------
+	// 4 - Decompressing the band
+
+	JSAMPARRAY image_rows = static_cast<JSAMPARRAY>(image.GetDataPtr());
+
+	try {
+		jpeg_read_header(&decomp, TRUE);
+
+		//Same output settings as used by sequential reader
+		if (decomp.jpeg_color_space == J_COLOR_SPACE::JCS_GRAYSCALE)
+			decomp.out_color_space = J_COLOR_SPACE::JCS_GRAYSCALE;
+		else
+			decomp.out_color_space = J_COLOR_SPACE::JCS_RGB;
+		decomp.dct_method = J_DCT_METHOD::JDCT_ISLOW;
+		ApplyDecodeProfile(decomp, profile);
+
+		jpeg_start_decompress(&decomp);
+
+		//Context rows above the band are decoded into scratch row and discarded
+		std::vector<JSAMPLE> scratch_row(static_cast<size_t>(decomp.output_width) * decomp.output_components);
+		JSAMPROW scratch_row_ptr = scratch_row.data();
+		while (static_cast<int>(decomp.output_scanline) < band_first_row - decode_first_row)
+			jpeg_read_scanlines(&decomp, &scratch_row_ptr, 1);
+
+		//Band rows are decoded directly into the image
+		while (static_cast<int>(decomp.output_scanline) < band_last_row - decode_first_row) {
+			int row = decode_first_row + static_cast<int>(decomp.output_scanline);
+			jpeg_read_scanlines(&decomp, &(image_rows[row]), static_cast<JDIMENSION>(band_last_row - row));
+		}
+	}
+	catch (codec_fatal_exception e) {
+		jpeg_destroy_decompress(&decomp);
+		band_warnings = std::move(warnings.messages);
+		throw;
+	}
+
+	//Context rows below the band are not needed - decompressor is destroyed without finishing
+	jpeg_destroy_decompress(&decomp);
+	band_warnings = std::move(warnings.messages);
+}
+
+
+
+///<summary>
+///Warning callback of band decompressors.
+///Stores the message if it was produced by the band own segments, so warnings of context segments are not reported twice.
+///</summary>
+void JpegReader::CollectBandWarning(std::string message, void* band_warnings_ptr) {
+	BandWarnings* warnings = reinterpret_cast<BandWarnings*>(band_warnings_ptr);
+	size_t position = static_cast<size_t>(warnings->decomp->src->next_input_byte - warnings->stream);
+	if (position >= warnings->own_begin && position < warnings->own_end)
+		warnings->messages.push_back(std::move(message));
+}
+
+
+
+
 ///<summary>
 ///Static method. Reads and decompresses file pointed to by file_path and returns an image buffer object.
 ///<para>Can throw std::ifstream::failure if failed to open file.</para>
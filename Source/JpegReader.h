@@ -1,15 +1,22 @@
 #pragma once
 //STL
+#include <string>
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <vector>
+#include <algorithm>
+#include <limits>
 //Third party
 #include "jpeglib.h"
 #include "jerror.h"
+#include "oneapi/tbb.h"
 //Internal
 #include "ImageReader.h"
 #include "Exceptions.h"
 #include "JpegHeaderInfo.h"
+#include "JpegPlanarImage.h"
+#include "TurboJpegCodec.h"
 #include "LibJpegCallbacks.h"
 
 
@@ -59,19 +66,81 @@ public:
 	///</summary>
 	ImageBuffer_Byte ReadNextRows(int num_rows) override;
 
+	///<summary>
+	///Reads next block of rows starting at NextRow into caller provided buffer.
+	///Buffer is reshaped to the number of rows actually read, its allocated memory is reused when possible.
+	///Advances NextRow by num_lines.
+	///When all rows are already read buffer is reshaped to zero rows.
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	void ReadNextRowsInto(int num_rows, ImageBuffer_Byte& target) override;
+
 	//--------------------------------
 	//	WHOLE FILE READING
 	//--------------------------------
 
 	///<summary>
 	///Static method. Reads and decompresses file pointed to by file_path and returns an image buffer object.
+	///<para>If the file contains restart markers placed on MCU row boundaries the image is decoded in parallel bands,
+	///otherwise it is decoded sequentially.</para>
+	///<para>Warning callback is called only from the calling thread. Warnings of bands decoded in parallel
+	///are reported after decoding, in file order.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+		return ReadJpegFile(file_path, headerPtr, warning_callback_data, DecodeProfile::DP_STRICT);
+	}
+
+	///<summary>
+	///Static method. Reads and decompresses file pointed to by file_path with given decode profile and returns an image buffer object.
+	///<para>Trusted profile uses fast integer IDCT and disables fancy upsampling and block smoothing.</para>
+	///<para>If the file contains restart markers placed on MCU row boundaries the image is decoded in parallel bands,
+	///otherwise it is decoded sequentially.</para>
+	///<para>Warning callback is called only from the calling thread. Warnings of bands decoded in parallel
+	///are reported after decoding, in file order.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<param name="profile">Decoder strictness and speed tradeoff.</param>
+	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, DecodeProfile profile) {
+		return ReadJpegFile(file_path, headerPtr, warning_callback_data, profile, NULL);
+	}
+
+	///<summary>
+	///Static method. Reads and decompresses file pointed to by file_path with given decode profile and returns an image buffer object.
+	///Reports number of bands the image was decoded in.
 	///<para>Can throw std::ifstream::failure if failed to open file.</para>
 	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
 	///</summary>
 	///<param name="file_path">Path to file to read.</param>
 	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
 	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+	///<param name="profile">Decoder strictness and speed tradeoff.</param>
+	///<param name="num_bands_ptr">Writes number of parallel bands to this pointer, 1 if the file was decoded sequentially. If NULL it is ignored.</param>
+	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, DecodeProfile profile, int* num_bands_ptr);
+
+	///<summary>
+	///Static method. Reads and decompresses file pointed to by file_path with selected backend and returns an image buffer object.
+	///<para>TurboJPEG backend decodes whole file in one call and does not support CMYK and YCCK files.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<param name="backend">libjpeg-turbo API used for decoding.</param>
+	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, JpegCodecBackend backend) {
+		if (backend == JpegCodecBackend::JCB_TURBOJPEG)
+			return TurboJpegCodec::ReadJpegFile(file_path, 0, 0, false, headerPtr, warning_callback_data);
+		return ReadJpegFile(file_path, headerPtr, warning_callback_data);
+	}
 
 	///<summary>
 	///Static method. Reads and decompresses file pointed to by file_path and returns an image buffer object.
@@ -109,6 +178,44 @@ public:
 		return ReadJpegFile(file_path, NULL, WarningCallbackData(NULL,NULL));
 	};
 
+	///<summary>
+	///Static method. Reads reduced resolution version of the image for further downscaling.
+	///<para>Image is decoded with the smallest DCT scaling (1/8, 1/4, 1/2 or 1/1) that gives at least min_height x min_width pixels.</para>
+	///<para>Progressive file is read in buffered image mode and decoding stops after the first scan
+	///that has delivered all coefficients used at chosen scale (for 1/8 scale that is DC scans only).
+	///Later scans only refine precision of the coefficients and are never decompressed.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="min_height">Minimal height of the returned image (usually downscaling target height).</param>
+	///<param name="min_width">Minimal width of the returned image (usually downscaling target width).</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored. Header describes the full resolution image.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static ImageBuffer_Byte ReadJpegFileReduced(std::filesystem::path file_path, int min_height, int min_width, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Reads raw component planes (for example Y, Cb and Cr) of the file at their native subsampled resolution.
+	///<para>Chroma upsampling and color conversion are skipped, planes are in the JPEG file colorspace.
+	///Intended for JPEG-to-JPEG processing together with JpegWriter::WriteJpegPlanar.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static JpegPlanarImage ReadJpegFilePlanar(std::filesystem::path file_path, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Decompresses JPEG image stored in memory (for example embedded preview) and returns an image buffer object.
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="data">JPEG file contents.</param>
+	///<param name="size">Size of JPEG file contents in bytes.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static ImageBuffer_Byte ReadJpegData(const uint8_t* data, size_t size, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
 
 	//--------------------------------
 	//	PUBLIC CONSTRUCTORS
@@ -131,7 +238,19 @@ public:
 	///<para>Can throw std::ifstream::failure if failed to open file.</para>
 	///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
 	///</summary>
-	JpegReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data);
+	JpegReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data) : JpegReader(file_path, warning_callback_data, DecodeProfile::DP_STRICT) {
+
+	}
+
+	///<summary>
+	///<para>Opens file pointed by file_path and reads the file header.</para>
+	///<para>Header is accessible by calling GetCommonHeader() and GetJpegHeader().</para>
+	///<para>Trusted profile uses fast integer IDCT and disables fancy upsampling and block smoothing.
+	///Intended for previously validated files, usually when downscaling follows.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
+	///</summary>
+	JpegReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data, DecodeProfile profile);
 
 
 	//--------------------------------
@@ -141,8 +260,8 @@ public:
 	~JpegReader() {
 		//If reader is ready we finish its operations and close the file
 		if (_state == ReaderStates::Ready_Start || _state == ReaderStates::Ready_Continue) {
-			//Finalizing reading (not that well described step, may be unnecessary)
-			jpeg_finish_decompress(&jpeg_decomp);
+			//Aborting reading. jpeg_finish_decompress would fail since not all scanlines were read.
+			jpeg_abort_decompress(&jpeg_decomp);
 			//Releasing the decompressor object memory
 			jpeg_destroy_decompress(&jpeg_decomp);
 			_is_decompressor_initialized = false;
@@ -189,6 +308,11 @@ private:
 	/// </summary>
 	static ImagePixelLayout JpegLayoutToImageLayout(J_COLOR_SPACE jpeg_colorspace);
 
+	///<summary>
+	///Applies decode profile to the decompressor after output parameters are set.
+	///</summary>
+	static void ApplyDecodeProfile(jpeg_decompress_struct& decomp, DecodeProfile profile);
+
 	//--------------------------------
 	//	PRIVATE METHODS
 	//--------------------------------
@@ -199,6 +323,123 @@ private:
 	///</summary>
 	void CleanUp();
 
+	///<summary>
+	///Returns true if every component has received at least first approximation
+	///of coefficients up to given zigzag index. Used in buffered image mode of progressive decoding.
+	///</summary>
+	static bool AreCoefficientsReceived(const jpeg_decompress_struct& decomp, int last_zigzag_index);
+
+	//--------------------------------
+	//	RESTART SEGMENTS DECODING
+	//--------------------------------
+
+	///<summary>
+	///Layout of the restart segments of a baseline single scan JPEG file loaded to memory.
+	///</summary>
+	struct RestartSegments {
+		///<summary>
+		///Offset of the two bytes holding image height in the SOF segment.
+		///</summary>
+		size_t sof_height_offset = 0;
+
+		///<summary>
+		///Offset of the first byte of entropy coded data (right after SOS segment).
+		///</summary>
+		size_t scan_data_offset = 0;
+
+		///<summary>
+		///Header segments (from SOI to SOS inclusive) required by the decoder.
+		///Stored as pairs of [begin, end) offsets.
+		///</summary>
+		std::vector<std::pair<size_t, size_t>> header_ranges;
+
+		///<summary>
+		///Offsets of the first entropy coded byte of each restart segment.
+		///</summary>
+		std::vector<size_t> segment_begins;
+
+		///<summary>
+		///Offsets past the last entropy coded byte of each restart segment (position of the following RSTn or EOI marker).
+		///</summary>
+		std::vector<size_t> segment_ends;
+
+		///<summary>
+		///Number of image rows covered by one restart segment.
+		///</summary>
+		int rows_per_segment = 0;
+	};
+
+	///<summary>
+	///Returns number of image rows covered by one restart segment
+	///if decompressor state allows decoding restart segments independently.
+	///Returns 0 otherwise (no restart markers, progressive or multiscan file,
+	///or restart interval does not fall on MCU row boundaries).
+	///</summary>
+	int GetRowsPerRestartSegment();
+
+	///<summary>
+	///Walks markers of a JPEG file loaded to memory and finds header segments and restart segments of the scan.
+	///Returns false if the file structure is not suitable for band decoding,
+	///in which case the file should be decoded sequentially.
+	///</summary>
+	static bool FindRestartSegments(const std::vector<uint8_t>& file_data, int image_height, int rows_per_segment, RestartSegments& segments);
+
+	///<summary>
+	///Warnings emitted while decoding one band.
+	///Used as warning callback arguments of the band decompressor.
+	///</summary>
+	struct BandWarnings {
+		///<summary>
+		///Band decompressor. Its source position tells which part of the band stream produced the warning.
+		///</summary>
+		const jpeg_decompress_struct* decomp = nullptr;
+
+		///<summary>
+		///First byte of the band stream.
+		///</summary>
+		const uint8_t* stream = nullptr;
+
+		///<summary>
+		///Warnings produced at source positions in [own_begin, own_end) of the band stream are kept.
+		///Restart marker belongs to the segment that follows it, since decoder reads the marker when it starts that segment.
+		///</summary>
+		size_t own_begin = 0;
+
+		///<summary>
+		///See own_begin.
+		///</summary>
+		size_t own_end = 0;
+
+		///<summary>
+		///Kept warning messages in order they were emitted.
+		///</summary>
+		std::vector<std::string> messages;
+	};
+
+	///<summary>
+	///Warning callback of band decompressors.
+	///Stores the message if it was produced by the band own segments, so warnings of context segments are not reported twice.
+	///</summary>
+	static void CollectBandWarning(std::string message, void* band_warnings_ptr);
+
+	///<summary>
+	///Decodes restart segments [first_segment, last_segment) into corresponding rows of the image.
+	///Neighbouring segments are decoded as well to provide context for chroma upsampling,
+	///so band edges are identical to the sequentially decoded image.
+	///<para>Uses its own decompressor object so it can be run in parallel with other bands.
+	///Warnings are not reported from here but stored in band_warnings, only warnings of own segments are stored
+	///and header warnings are stored only by the first band.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	static void DecodeRestartBand(
+		const std::vector<uint8_t>& file_data, 
+		const RestartSegments& segments, 
+		int first_segment, 
+		int last_segment, 
+		ImageBuffer_Byte& image, 
+		std::vector<std::string>& band_warnings,
+		DecodeProfile profile);
+
 	//--------------------------------
 	//	PRIVATE CONSTRUCTOR
 	//--------------------------------
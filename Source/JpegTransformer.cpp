@@ -0,0 +1,579 @@
+#include "JpegTransformer.h"
+
+
+
+//--------------------------------
+//	WHOLE FILE TRANSFORMATION
+//--------------------------------
+
+///<summary>
+///Static method. Crops and transforms JPEG file without decoding it and writes the result to destination path.
+///<para>Transformation is given as EXIF orientation of the source, so passing orientation read from EXIF makes the image upright.</para>
+///<para>Crop is applied before the transformation. Crop origin must be aligned to the MCU size of the file (8 or 16 pixels).</para>
+///<para>APPn and COM markers are copied except JFIF and Adobe markers, which the compressor writes itself.
+///When transformation is applied, EXIF Orientation tag is reset to normal.</para>
+///<para>Source and destination can be the same file.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to transform the image.</para>
+///</summary>
+void JpegTransformer::TransformJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, ExifOrientation transform, JpegCropRegion crop, bool optimize_coding, WarningCallbackData warning_callback_data) {
+
+	//----------------------------------------------------------------------
+	// 0 - Arguments check
+
+	if (transform < ExifOrientation::EO_NORMAL || transform > ExifOrientation::EO_ROTATE_90_CCW)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Invalid JPEG transformation requested.");
+
+	if (crop.x < 0 || crop.y < 0 || crop.width < 0 || crop.height < 0)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Invalid JPEG crop region requested.");
+
+	//Same decomposition as in Downscaler: mirrors in source axes, then transposition
+	bool mirror_cols = transform == EO_MIRROR_H || transform == EO_ROTATE_180 || transform == EO_TRANSVERSE || transform == EO_ROTATE_90_CCW;
+	bool mirror_rows = transform == EO_ROTATE_180 || transform == EO_MIRROR_V || transform == EO_ROTATE_90_CW || transform == EO_TRANSVERSE;
+	bool transpose = transform >= ExifOrientation::EO_TRANSPOSE;
+
+	//----------------------------------------------------------------------
+	// 1 - Reading the source header
+
+	JpegTransformer transformer(source_path, warning_callback_data);
+	jpeg_decompress_struct& src = transformer._jpeg_decomp;
+	int num_components = src.num_components;
+	int image_height = static_cast<int>(src.image_height);
+	int image_width = static_cast<int>(src.image_width);
+
+	//----------------------------------------------------------------------
+	// 2 - Calculating crop region
+
+	//Single component files are not interleaved and consist of 8x8 MCUs regardless of sampling factors
+	int mcu_height = num_components == 1 ? DCTSIZE : src.max_v_samp_factor * DCTSIZE;
+	int mcu_width = num_components == 1 ? DCTSIZE : src.max_h_samp_factor * DCTSIZE;
+
+	if (crop.x >= image_width || crop.y >= image_height)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "JPEG crop region is outside of the image.");
+
+	if (crop.x % mcu_width != 0 || crop.y % mcu_height != 0)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "JPEG crop region origin is not aligned to MCU boundaries.");
+
+	int crop_height = image_height - crop.y;
+	if (crop.height != 0 && crop.height < crop_height)
+		crop_height = crop.height;
+	int crop_width = image_width - crop.x;
+	if (crop.width != 0 && crop.width < crop_width)
+		crop_width = crop.width;
+
+	//Partial MCU would be moved to the top-left by mirroring, so it is trimmed
+	if (mirror_rows)
+		crop_height -= crop_height % mcu_height;
+	if (mirror_cols)
+		crop_width -= crop_width % mcu_width;
+
+	if (crop_height == 0 || crop_width == 0)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "JPEG image is smaller than one MCU along the mirrored axis.");
+
+	int dst_height = transpose ? crop_width : crop_height;
+	int dst_width = transpose ? crop_height : crop_width;
+
+	//----------------------------------------------------------------------
+	// 3 - Requesting destination coefficient arrays
+
+	//Arrays have to be requested before jpeg_read_coefficients, which allocates all requested arrays at once.
+	//Sizes are rounded up to whole MCUs since compressor reads complete MCUs.
+	std::vector<jvirt_barray_ptr> destination_coefficients(num_components);
+	std::vector<JDIMENSION> dst_rows(num_components);
+	std::vector<JDIMENSION> dst_cols(num_components);
+	int dst_max_v_samp = transpose ? src.max_h_samp_factor : src.max_v_samp_factor;
+	int dst_max_h_samp = transpose ? src.max_v_samp_factor : src.max_h_samp_factor;
+	for (int ci = 0; ci < num_components; ci++) {
+		jpeg_component_info* comp = &src.comp_info[ci];
+		int dst_v_samp = transpose ? comp->h_samp_factor : comp->v_samp_factor;
+		int dst_h_samp = transpose ? comp->v_samp_factor : comp->h_samp_factor;
+
+		JDIMENSION rows_in_blocks = (dst_height * dst_v_samp + dst_max_v_samp * DCTSIZE - 1) / (dst_max_v_samp * DCTSIZE);
+		JDIMENSION cols_in_blocks = (dst_width * dst_h_samp + dst_max_h_samp * DCTSIZE - 1) / (dst_max_h_samp * DCTSIZE);
+		dst_rows[ci] = (rows_in_blocks + dst_v_samp - 1) / dst_v_samp * dst_v_samp;
+		dst_cols[ci] = (cols_in_blocks + dst_h_samp - 1) / dst_h_samp * dst_h_samp;
+
+		destination_coefficients[ci] = src.mem->request_virt_barray(reinterpret_cast<j_common_ptr>(&src), JPOOL_IMAGE, FALSE, dst_cols[ci], dst_rows[ci], dst_v_samp);
+	}
+
+	//----------------------------------------------------------------------
+	// 4 - Reading source coefficients
+
+	transformer.ReadCoefficients();
+
+	//----------------------------------------------------------------------
+	// 5 - Creating destination
+
+	transformer.OpenDestination(destination_path, optimize_coding);
+	jpeg_compress_struct& dst = transformer._jpeg_comp;
+	dst.image_height = dst_height;
+	dst.image_width = dst_width;
+
+	if (transpose) {
+		for (int ci = 0; ci < num_components; ci++)
+			std::swap(dst.comp_info[ci].h_samp_factor, dst.comp_info[ci].v_samp_factor);
+
+		//Pixel aspect ratio from JFIF header follows the axes
+		std::swap(dst.X_density, dst.Y_density);
+
+		//Coefficients are transposed inside the blocks, so quantization tables are transposed as well
+		for (int tbl = 0; tbl < NUM_QUANT_TBLS; tbl++) {
+			JQUANT_TBL* table = dst.quant_tbl_ptrs[tbl];
+			if (table == NULL)
+				continue;
+			for (int row = 0; row < DCTSIZE; row++)
+				for (int col = row + 1; col < DCTSIZE; col++)
+					std::swap(table->quantval[row * DCTSIZE + col], table->quantval[col * DCTSIZE + row]);
+		}
+	}
+
+	//----------------------------------------------------------------------
+	// 6 - Moving the blocks
+
+	for (int ci = 0; ci < num_components; ci++) {
+		jpeg_component_info* comp = &src.comp_info[ci];
+		int blocks_per_mcu_v = num_components == 1 ? 1 : comp->v_samp_factor;
+		int blocks_per_mcu_h = num_components == 1 ? 1 : comp->h_samp_factor;
+
+		//Crop region in blocks of this component
+		JDIMENSION row_offset = crop.y / mcu_height * blocks_per_mcu_v;
+		JDIMENSION col_offset = crop.x / mcu_width * blocks_per_mcu_h;
+		JDIMENSION crop_rows = (crop_height * comp->v_samp_factor + src.max_v_samp_factor * DCTSIZE - 1) / (src.max_v_samp_factor * DCTSIZE);
+		JDIMENSION crop_cols = (crop_width * comp->h_samp_factor + src.max_h_samp_factor * DCTSIZE - 1) / (src.max_h_samp_factor * DCTSIZE);
+
+		//Source arrays are padded to whole MCUs
+		JDIMENSION src_rows = (comp->height_in_blocks + comp->v_samp_factor - 1) / comp->v_samp_factor * comp->v_samp_factor;
+		JDIMENSION src_cols = (comp->width_in_blocks + comp->h_samp_factor - 1) / comp->h_samp_factor * comp->h_samp_factor;
+
+		for (JDIMENSION dst_row = 0; dst_row < dst_rows[ci]; dst_row++) {
+			//Rows are accessed one at a time, arrays are kept in memory so access is cheap
+			JBLOCKROW dst_blocks = src.mem->access_virt_barray(reinterpret_cast<j_common_ptr>(&src), destination_coefficients[ci], dst_row, 1, TRUE)[0];
+			JBLOCKROW src_blocks = NULL;
+			JDIMENSION src_blocks_row = src_rows;
+
+			for (JDIMENSION dst_col = 0; dst_col < dst_cols[ci]; dst_col++) {
+				//Position in cropped source before transposition
+				JDIMENSION row = transpose ? dst_col : dst_row;
+				JDIMENSION col = transpose ? dst_row : dst_col;
+
+				//Padding blocks of the destination MCUs are left empty
+				if (row >= crop_rows || col >= crop_cols) {
+					std::memset(dst_blocks[dst_col], 0, sizeof(JBLOCK));
+					continue;
+				}
+
+				if (mirror_rows)
+					row = crop_rows - 1 - row;
+				if (mirror_cols)
+					col = crop_cols - 1 - col;
+				row += row_offset;
+				col += col_offset;
+
+				if (row >= src_rows || col >= src_cols) {
+					std::memset(dst_blocks[dst_col], 0, sizeof(JBLOCK));
+					continue;
+				}
+
+				if (row != src_blocks_row) {
+					src_blocks = src.mem->access_virt_barray(reinterpret_cast<j_common_ptr>(&src), transformer._source_coefficients[ci], row, 1, FALSE)[0];
+					src_blocks_row = row;
+				}
+
+				TransformBlock(src_blocks[col], dst_blocks[dst_col], mirror_cols, mirror_rows, transpose);
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------
+	// 7 - Writing the destination
+
+	//Copied EXIF would otherwise ask viewers to rotate already upright image
+	transformer.WriteCoefficients(destination_coefficients.data(), transform != ExifOrientation::EO_NORMAL);
+}
+
+
+
+
+///<summary>
+///Static method. Recompresses JPEG file to the quantization tables of given quality without decoding it.
+///<para>Quantization step is never made finer than in the source, so requesting higher quality than the source has does not grow the file.</para>
+///<para>APPn and COM markers are copied except JFIF and Adobe markers, which the compressor writes itself.</para>
+///<para>Source and destination can be the same file.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to recompress the image or quality is out of range.</para>
+///</summary>
+void JpegTransformer::RequantizeJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, int quality, bool optimize_coding, WarningCallbackData warning_callback_data) {
+
+	//----------------------------------------------------------------------
+	// 0 - Arguments check
+
+	JpegWriter::CheckQuality(quality);
+
+	//----------------------------------------------------------------------
+	// 1 - Reading source coefficients
+
+	JpegTransformer transformer(source_path, warning_callback_data);
+	jpeg_decompress_struct& src = transformer._jpeg_decomp;
+	transformer.ReadCoefficients();
+
+	//----------------------------------------------------------------------
+	// 2 - Creating destination with tables of requested quality
+
+	transformer.OpenDestination(destination_path, optimize_coding);
+	jpeg_compress_struct& dst = transformer._jpeg_comp;
+
+	//Quality scaling defines luminance (0) and chrominance (1) tables only
+	for (int ci = 0; ci < dst.num_components; ci++)
+		if (dst.comp_info[ci].quant_tbl_no > 1)
+			dst.comp_info[ci].quant_tbl_no = 1;
+	JpegWriter::SetQuality(dst, quality);
+
+	//Final steps for each component.
+	//Finer step than in the source only adds bits for the quantization noise that is already there.
+	std::vector<JQUANT_TBL> destination_tables(src.num_components);
+	for (int ci = 0; ci < src.num_components; ci++) {
+		//Source table latched by the decompressor for this component
+		const JQUANT_TBL* source_table = src.comp_info[ci].quant_table;
+		if (source_table == NULL)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "JPEG component has no quantization table.");
+
+		const JQUANT_TBL* quality_table = dst.quant_tbl_ptrs[dst.comp_info[ci].quant_tbl_no];
+		for (int k = 0; k < DCTSIZE2; k++)
+			destination_tables[ci].quantval[k] = std::max(source_table->quantval[k], quality_table->quantval[k]);
+	}
+
+	//Components sharing a table in the destination should end up with the same steps,
+	//which holds unless source used different tables for them. In that case each component gets its own table slot.
+	int next_free_table = 2;
+	for (int ci = 0; ci < src.num_components; ci++) {
+		int table_number = dst.comp_info[ci].quant_tbl_no;
+		bool shared_table_differs = false;
+		for (int other = 0; other < ci; other++)
+			if (dst.comp_info[other].quant_tbl_no == table_number &&
+				std::memcmp(destination_tables[other].quantval, destination_tables[ci].quantval, sizeof(destination_tables[ci].quantval)) != 0)
+				shared_table_differs = true;
+
+		if (shared_table_differs) {
+			if (next_free_table >= NUM_QUANT_TBLS)
+				throw codec_fatal_exception(CodecExceptions::Jpeg_EncodingError, "Not enough JPEG quantization table slots for requantized components.");
+			table_number = next_free_table++;
+			dst.comp_info[ci].quant_tbl_no = table_number;
+			if (dst.quant_tbl_ptrs[table_number] == NULL)
+				dst.quant_tbl_ptrs[table_number] = jpeg_alloc_quant_table(reinterpret_cast<j_common_ptr>(&dst));
+		}
+
+		std::memcpy(dst.quant_tbl_ptrs[table_number]->quantval, destination_tables[ci].quantval, sizeof(destination_tables[ci].quantval));
+	}
+
+	//----------------------------------------------------------------------
+	// 3 - Requantizing the coefficients in place
+
+	for (int ci = 0; ci < src.num_components; ci++) {
+		jpeg_component_info* comp = &src.comp_info[ci];
+		const UINT16* source_steps = comp->quant_table->quantval;
+		const UINT16* destination_steps = destination_tables[ci].quantval;
+
+		//Arrays are padded to whole MCUs
+		JDIMENSION rows = (comp->height_in_blocks + comp->v_samp_factor - 1) / comp->v_samp_factor * comp->v_samp_factor;
+		JDIMENSION cols = (comp->width_in_blocks + comp->h_samp_factor - 1) / comp->h_samp_factor * comp->h_samp_factor;
+
+		for (JDIMENSION row = 0; row < rows; row++) {
+			JBLOCKROW blocks = src.mem->access_virt_barray(reinterpret_cast<j_common_ptr>(&src), transformer._source_coefficients[ci], row, 1, TRUE)[0];
+			for (JDIMENSION col = 0; col < cols; col++)
+				RequantizeBlock(blocks[col], source_steps, destination_steps);
+		}
+	}
+
+	//----------------------------------------------------------------------
+	// 4 - Writing the destination
+
+	transformer.WriteCoefficients(transformer._source_coefficients, false);
+}
+
+
+
+
+//--------------------------------
+//	PRIVATE CONSTRUCTOR
+//--------------------------------
+
+///<summary>
+///Opens source file and reads its header.
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to read the header.</para>
+///</summary>
+JpegTransformer::JpegTransformer(std::filesystem::path source_path, WarningCallbackData warning_callback_data) {
+	_warning_callback_data.warningCallback = warning_callback_data.warningCallback;
+	_warning_callback_data.warningCallbackArgs_ptr = warning_callback_data.warningCallbackArgs_ptr;
+
+	_source_file = OpenCFile(source_path, "rb");
+
+	try {
+		//Assigning error manager to decompressor
+		_jpeg_decomp.err = jpeg_std_error(&_jerr_decomp);
+		//Registering jpeg error handler
+		_jerr_decomp.error_exit = &ErrorExitHandler;
+		//Registering warning handler function
+		_jerr_decomp.emit_message = &WarningHandler;
+		//Initializing decompressor object
+		jpeg_create_decompress(&_jpeg_decomp);
+		//Referencing warning callback in the decompressor object
+		_jpeg_decomp.client_data = &_warning_callback_data;
+		_is_decompressor_initialized = true;
+
+		jpeg_stdio_src(&_jpeg_decomp, _source_file);
+
+		//Keeping metadata markers to copy them to the destination
+		jpeg_save_markers(&_jpeg_decomp, JPEG_COM, 0xFFFF);
+		for (int marker = 0; marker < 16; marker++)
+			jpeg_save_markers(&_jpeg_decomp, JPEG_APP0 + marker, 0xFFFF);
+
+		jpeg_read_header(&_jpeg_decomp, TRUE);
+	}
+	catch (...) {
+		//Destructor is not called when constructor throws
+		CleanUp();
+		throw;
+	}
+}
+
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Reads quantized DCT coefficients of the whole source image.
+///Arrays requested from the decompressor memory manager before this call are allocated together with the source arrays.
+///</summary>
+void JpegTransformer::ReadCoefficients() {
+	_source_coefficients = jpeg_read_coefficients(&_jpeg_decomp);
+
+	//Whole file is consumed, source is closed so destination may overwrite it
+	fclose(_source_file);
+	_source_file = NULL;
+}
+
+
+
+///<summary>
+///Opens destination file and creates compressor with critical parameters (dimensions, sampling, quantization tables) copied from the source.
+///Destination is opened after the source is read, so both can be the same file.
+///</summary>
+void JpegTransformer::OpenDestination(std::filesystem::path destination_path, bool optimize_coding) {
+	_destination_file = OpenCFile(destination_path, "wb");
+
+	//Assigning error manager to compressor
+	_jpeg_comp.err = jpeg_std_error(&_jerr_comp);
+	//Registering jpeg error handler
+	_jerr_comp.error_exit = &ErrorExitHandler;
+	//Registering warning handler function
+	_jerr_comp.emit_message = &WarningHandler;
+	//Initializing compressor object
+	jpeg_create_compress(&_jpeg_comp);
+	//Referencing warning callback in the compressor object
+	_jpeg_comp.client_data = &_warning_callback_data;
+	_is_compressor_initialized = true;
+
+	jpeg_stdio_dest(&_jpeg_comp, _destination_file);
+
+	jpeg_copy_critical_parameters(&_jpeg_decomp, &_jpeg_comp);
+	_jpeg_comp.optimize_coding = optimize_coding ? TRUE : FALSE;
+}
+
+
+
+///<summary>
+///Writes given coefficient arrays and saved source markers to the destination and closes it.
+///</summary>
+void JpegTransformer::WriteCoefficients(jvirt_barray_ptr* coefficients, bool reset_orientation) {
+	jpeg_write_coefficients(&_jpeg_comp, coefficients);
+	WriteMarkers(reset_orientation);
+	jpeg_finish_compress(&_jpeg_comp);
+
+	jpeg_destroy_compress(&_jpeg_comp);
+	_is_compressor_initialized = false;
+	fclose(_destination_file);
+	_destination_file = NULL;
+}
+
+
+
+///<summary>
+///Writes APPn and COM markers saved from the source to the destination.
+///JFIF and Adobe markers are skipped since the compressor writes its own ones.
+///Should be called after jpeg_write_coefficients and before the first scan is written.
+///</summary>
+void JpegTransformer::WriteMarkers(bool reset_orientation) {
+	for (jpeg_saved_marker_ptr marker = _jpeg_decomp.marker_list; marker != NULL; marker = marker->next) {
+		//JFIF header is written by the compressor for YCbCr and grayscale files
+		if (_jpeg_comp.write_JFIF_header && marker->marker == JPEG_APP0 &&
+			marker->data_length >= 5 && std::memcmp(marker->data, "JFIF", 5) == 0)
+			continue;
+
+		//Adobe marker is written by the compressor for CMYK and YCCK files
+		if (_jpeg_comp.write_Adobe_marker && marker->marker == JPEG_APP0 + 14 &&
+			marker->data_length >= 5 && std::memcmp(marker->data, "Adobe", 5) == 0)
+			continue;
+
+		//Saved data belongs to the decompressor, which is not used anymore, so it is edited in place
+		if (reset_orientation && marker->marker == JPEG_APP0 + 1)
+			ResetExifOrientation(marker->data, marker->data_length);
+
+		jpeg_write_marker(&_jpeg_comp, marker->marker, marker->data, marker->data_length);
+	}
+}
+
+
+
+///<summary>
+///Closes files and destroys decompressor and compressor if they exist.
+///</summary>
+void JpegTransformer::CleanUp() {
+	//Compressor goes first since destination coefficient arrays belong to the decompressor memory pool
+	if (_is_compressor_initialized) {
+		jpeg_destroy_compress(&_jpeg_comp);
+		_is_compressor_initialized = false;
+	}
+	if (_is_decompressor_initialized) {
+		jpeg_destroy_decompress(&_jpeg_decomp);
+		_is_decompressor_initialized = false;
+	}
+	if (_destination_file != NULL) {
+		fclose(_destination_file);
+		_destination_file = NULL;
+	}
+	if (_source_file != NULL) {
+		fclose(_source_file);
+		_source_file = NULL;
+	}
+}
+
+
+
+///<summary>
+///Opens file in C mode. Throws std::ifstream::failure if failed to open file.
+///</summary>
+FILE* JpegTransformer::OpenCFile(std::filesystem::path file_path, const char* mode) {
+	FILE* file_handle = NULL;
+	//Extracting file path as UTF-8 c-style string to use with c file opener.
+	std::u8string u8_file_path = file_path.generic_u8string();
+	const char* c_file_path = reinterpret_cast<const char*>(u8_file_path.c_str());
+	errno_t fopen_error = fopen_s(&file_handle, c_file_path, mode);
+
+	if (fopen_error != 0) {
+		//Constructing error message string
+		char err_msg_buffer[256];
+		errno_t strerror_error = strerror_s(err_msg_buffer, 256, fopen_error);
+		//Throwing exception
+		if (strerror_error == 0) //Message string constructed
+			throw std::ifstream::failure(std::string(err_msg_buffer));
+		else
+			throw std::ifstream::failure("");
+	}
+
+	return file_handle;
+}
+
+
+
+///<summary>
+///Copies block of coefficients applying mirroring and transposition.
+///Mirrors are applied in source axes before the transposition.
+///</summary>
+void JpegTransformer::TransformBlock(const JCOEF* source, JCOEF* destination, bool mirror_cols, bool mirror_rows, bool transpose) {
+	for (int row = 0; row < DCTSIZE; row++) {
+		for (int col = 0; col < DCTSIZE; col++) {
+			JCOEF value = source[row * DCTSIZE + col];
+
+			//Mirroring negates basis functions of odd frequency along the mirrored axis
+			bool negate_for_cols = mirror_cols && (col & 1);
+			bool negate_for_rows = mirror_rows && (row & 1);
+			if (negate_for_cols != negate_for_rows)
+				value = -value;
+
+			if (transpose)
+				destination[col * DCTSIZE + row] = value;
+			else
+				destination[row * DCTSIZE + col] = value;
+		}
+	}
+}
+
+
+
+///<summary>
+///Requantizes block of coefficients from source quantization steps to destination steps.
+///</summary>
+void JpegTransformer::RequantizeBlock(JCOEF* block, const UINT16* source_steps, const UINT16* destination_steps) {
+	for (int k = 0; k < DCTSIZE2; k++) {
+		if (block[k] == 0 || source_steps[k] == destination_steps[k])
+			continue;
+
+		//Dequantized value rounded to the new step, half away from zero
+		int value = block[k] * static_cast<int>(source_steps[k]);
+		int step = destination_steps[k];
+		if (value >= 0)
+			block[k] = static_cast<JCOEF>((value + step / 2) / step);
+		else
+			block[k] = static_cast<JCOEF>(-((-value + step / 2) / step));
+	}
+}
+
+
+
+///<summary>
+///Sets Orientation tag of IFD0 to normal in EXIF APP1 marker data in place.
+///Data that is not a valid EXIF block or has no Orientation tag is left unchanged.
+///</summary>
+void JpegTransformer::ResetExifOrientation(JOCTET* data, unsigned int length) {
+	//EXIF identifier followed by TIFF header: byte order, magic number 42, offset of IFD0
+	const unsigned int tiff_start = 6;
+	if (length < tiff_start + 8 || std::memcmp(data, "Exif\0\0", 6) != 0)
+		return;
+	JOCTET* tiff = data + tiff_start;
+	unsigned int tiff_length = length - tiff_start;
+
+	bool is_big_endian;
+	if (tiff[0] == 'M' && tiff[1] == 'M')
+		is_big_endian = true;
+	else if (tiff[0] == 'I' && tiff[1] == 'I')
+		is_big_endian = false;
+	else
+		return;
+
+	auto read16 = [&](unsigned int offset) -> unsigned int {
+		return is_big_endian ? (tiff[offset] << 8) | tiff[offset + 1] : tiff[offset] | (tiff[offset + 1] << 8);
+	};
+	auto read32 = [&](unsigned int offset) -> uint32_t {
+		return is_big_endian ?
+			(static_cast<uint32_t>(read16(offset)) << 16) | read16(offset + 2) :
+			read16(offset) | (static_cast<uint32_t>(read16(offset + 2)) << 16);
+	};
+
+	if (read16(2) != 42)
+		return;
+
+	//IFD0: entry count followed by 12 byte entries of tag, type, count and value
+	uint32_t ifd_offset = read32(4);
+	if (ifd_offset > tiff_length - 2)
+		return;
+	unsigned int entry_count = read16(ifd_offset);
+	for (unsigned int entry = 0; entry < entry_count; entry++) {
+		uint32_t entry_offset = ifd_offset + 2 + entry * 12;
+		if (entry_offset > tiff_length - 12)
+			return;
+
+		//Orientation is a single SHORT stored in the value field
+		const unsigned int orientation_tag = 0x0112;
+		const unsigned int short_type = 3;
+		if (read16(entry_offset) == orientation_tag && read16(entry_offset + 2) == short_type && read32(entry_offset + 4) == 1) {
+			const JOCTET normal = static_cast<JOCTET>(ExifOrientation::EO_NORMAL);
+			tiff[entry_offset + 8] = is_big_endian ? 0 : normal;
+			tiff[entry_offset + 9] = is_big_endian ? normal : 0;
+			return;
+		}
+	}
+}
@@ -0,0 +1,223 @@
+#pragma once
+//STL
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <utility>
+#include <algorithm>
+//Third party
+#include "jpeglib.h"
+#include "jerror.h"
+//Internal
+#include "ImageEnums.h"
+#include "Exceptions.h"
+#include "LibJpegCallbacks.h"
+#include "JpegWriter.h"
+#include "WarningCallbackData.h"
+
+///<summary>
+///Crop region of JPEG image in source image coordinates.
+///Width or height of zero means up to the image edge.
+///</summary>
+struct JpegCropRegion {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+
+
+///<summary>
+///Class for transformations of JPEG files in DCT coefficient domain.
+///Uses libjpeg-turbo to read quantized DCT coefficients and writes them back without decoding the image.
+///</summary>
+///<remarks>
+///Rotations and flips are done by reordering DCT blocks and transforming coefficients inside the blocks:
+///mirroring negates coefficients of odd frequencies along the mirrored axis, transposition transposes the block.
+///No IDCT, color conversion or requantization happens, so the transformation does not lose quality.
+///
+///Mirroring moves partial MCU at the right (bottom) edge of the image to the left (top) edge, where it cannot be represented.
+///Such partial MCU is trimmed the same way jpegtran -trim does it, so the output may be up to one MCU smaller than the source.
+///
+///Requantization divides coefficients by the ratio of new and old quantization steps.
+///It is lossy, but skips IDCT, color conversion and forward DCT of a decode/encode round trip.
+///
+///Error handling is the same as in JpegReader and JpegWriter: libjpeg fatal errors are thrown as codec_fatal_exception.
+///</remarks>
+class JpegTransformer : public LibJpegCallbacks
+{
+public:
+	//--------------------------------
+	//	WHOLE FILE TRANSFORMATION
+	//--------------------------------
+
+	///<summary>
+	///Static method. Crops and transforms JPEG file without decoding it and writes the result to destination path.
+	///<para>Transformation is given as EXIF orientation of the source, so passing orientation read from EXIF makes the image upright.</para>
+	///<para>Crop is applied before the transformation. Crop origin must be aligned to the MCU size of the file (8 or 16 pixels).</para>
+	///<para>APPn and COM markers are copied except JFIF and Adobe markers, which the compressor writes itself.
+	///When transformation is applied, EXIF Orientation tag is reset to normal.</para>
+	///<para>Source and destination can be the same file.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to transform the image.</para>
+	///</summary>
+	///<param name="source_path">Path to the file to read.</param>
+	///<param name="destination_path">Path to the output file.</param>
+	///<param name="transform">Transformation to apply.</param>
+	///<param name="crop">Crop region in source image coordinates.</param>
+	///<param name="optimize_coding">Compute optimal Huffman tables for the output (smaller file, slower).</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static void TransformJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, ExifOrientation transform, JpegCropRegion crop, bool optimize_coding, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Transforms JPEG file without decoding it and writes the result to destination path.
+	///<para>Transformation is given as EXIF orientation of the source, so passing orientation read from EXIF makes the image upright.</para>
+	///<para>Decoder warnings will be ignored.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to transform the image.</para>
+	///</summary>
+	///<param name="source_path">Path to the file to read.</param>
+	///<param name="destination_path">Path to the output file.</param>
+	///<param name="transform">Transformation to apply.</param>
+	static void TransformJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, ExifOrientation transform) {
+		TransformJpegFile(source_path, destination_path, transform, JpegCropRegion(), false, WarningCallbackData(NULL, NULL));
+	}
+
+	///<summary>
+	///Static method. Recompresses JPEG file to the quantization tables of given quality without decoding it.
+	///<para>Quantization step is never made finer than in the source, so requesting higher quality than the source has does not grow the file.</para>
+	///<para>APPn and COM markers are copied except JFIF and Adobe markers, which the compressor writes itself.</para>
+	///<para>Source and destination can be the same file.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to recompress the image or quality is out of range.</para>
+	///</summary>
+	///<param name="source_path">Path to the file to read.</param>
+	///<param name="destination_path">Path to the output file.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	///<param name="optimize_coding">Compute optimal Huffman tables for the output (smaller file, slower).</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static void RequantizeJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, int quality, bool optimize_coding, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Recompresses JPEG file to the quantization tables of given quality without decoding it.
+	///Huffman tables are optimized.
+	///<para>Decoder warnings will be ignored.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to recompress the image or quality is out of range.</para>
+	///</summary>
+	///<param name="source_path">Path to the file to read.</param>
+	///<param name="destination_path">Path to the output file.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	static void RequantizeJpegFile(std::filesystem::path source_path, std::filesystem::path destination_path, int quality) {
+		RequantizeJpegFile(source_path, destination_path, quality, true, WarningCallbackData(NULL, NULL));
+	}
+
+	//--------------------------------
+	//	DEFAULT DESTRUCTOR
+	//--------------------------------
+
+	~JpegTransformer() {
+		CleanUp();
+	}
+
+	JpegTransformer(const JpegTransformer& other) = delete;
+	JpegTransformer& operator=(const JpegTransformer& other) = delete;
+
+private:
+	//--------------------------------
+	//	LIBJPEG DATA STRUCTURES
+	//--------------------------------
+
+	struct jpeg_decompress_struct _jpeg_decomp;
+	struct jpeg_error_mgr _jerr_decomp;
+	struct jpeg_compress_struct _jpeg_comp;
+	struct jpeg_error_mgr _jerr_comp;
+
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	FILE* _source_file = NULL;
+	FILE* _destination_file = NULL;
+	bool _is_decompressor_initialized = false;
+	bool _is_compressor_initialized = false;
+
+	///<summary>
+	///Source coefficient arrays returned by jpeg_read_coefficients.
+	///</summary>
+	jvirt_barray_ptr* _source_coefficients = NULL;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Reads quantized DCT coefficients of the whole source image.
+	///Arrays requested from the decompressor memory manager before this call are allocated together with the source arrays.
+	///</summary>
+	void ReadCoefficients();
+
+	///<summary>
+	///Opens destination file and creates compressor with critical parameters (dimensions, sampling, quantization tables) copied from the source.
+	///Destination is opened after the source is read, so both can be the same file.
+	///</summary>
+	void OpenDestination(std::filesystem::path destination_path, bool optimize_coding);
+
+	///<summary>
+	///Writes given coefficient arrays and saved source markers to the destination and closes it.
+	///</summary>
+	///<param name="coefficients">Coefficient arrays of the destination.</param>
+	///<param name="reset_orientation">Set EXIF Orientation tag to normal in copied EXIF markers.</param>
+	void WriteCoefficients(jvirt_barray_ptr* coefficients, bool reset_orientation);
+
+	///<summary>
+	///Writes APPn and COM markers saved from the source to the destination.
+	///JFIF and Adobe markers are skipped since the compressor writes its own ones.
+	///Should be called after jpeg_write_coefficients and before the first scan is written.
+	///</summary>
+	void WriteMarkers(bool reset_orientation);
+
+	///<summary>
+	///Closes files and destroys decompressor and compressor if they exist.
+	///</summary>
+	void CleanUp();
+
+	///<summary>
+	///Opens file in C mode. Throws std::ifstream::failure if failed to open file.
+	///</summary>
+	static FILE* OpenCFile(std::filesystem::path file_path, const char* mode);
+
+	///<summary>
+	///Copies block of coefficients applying mirroring and transposition.
+	///Mirrors are applied in source axes before the transposition.
+	///</summary>
+	static void TransformBlock(const JCOEF* source, JCOEF* destination, bool mirror_cols, bool mirror_rows, bool transpose);
+
+	///<summary>
+	///Requantizes block of coefficients from source quantization steps to destination steps.
+	///</summary>
+	static void RequantizeBlock(JCOEF* block, const UINT16* source_steps, const UINT16* destination_steps);
+
+	///<summary>
+	///Sets Orientation tag of IFD0 to normal in EXIF APP1 marker data in place.
+	///Data that is not a valid EXIF block or has no Orientation tag is left unchanged.
+	///</summary>
+	static void ResetExifOrientation(JOCTET* data, unsigned int length);
+
+	//--------------------------------
+	//	PRIVATE CONSTRUCTOR
+	//--------------------------------
+
+	///<summary>
+	///Opens source file and reads its header.
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to read the header.</para>
+	///</summary>
+	JpegTransformer(std::filesystem::path source_path, WarningCallbackData warning_callback_data);
+};
@@ -11,7 +11,7 @@
 ///Advances NextRow by the height of given image.
 ///If number of lines in the provided image is bigger than number of rows left writes what is possible.
 ///</summary>
-void JpegWriter::WriteNextRows(const ImageBuffer_Byte& image) {
+void JpegWriter::WriteNextRows(const ImageBufferView_Byte& image) {
 	
 	//Aliases
 	int buffer_height = image.GetHeight();
@@ -79,14 +79,11 @@ void JpegWriter::WriteNextRows(const ImageBuffer_Byte& image) {
 		//So, we write one line at a time, but still have to pretend
 		//it is array of rows of type JSAMPARRAY.
 
-		//Image data alias
-		uint8_t** image_data = image.GetDataPtr();
-		
 		for (int row = 0; row < actual_num_rows; row++) {
 			//Jpeg compressor accepts JSAMPROW. It is unsigned char*
-			//Therefore we write next row:
-			JSAMPARRAY rows_to_write = static_cast<JSAMPARRAY>(&(image_data[row]));
-			jpeg_write_scanlines(&jpeg_comp, rows_to_write, 1);
+			//View row can start in the middle of buffer row, so row pointer is taken from the view
+			JSAMPROW row_to_write = static_cast<JSAMPROW>(image[row]);
+			jpeg_write_scanlines(&jpeg_comp, &row_to_write, 1);
 		}
 	}
 	catch (codec_fatal_exception e) {
@@ -130,14 +127,307 @@ void JpegWriter::WriteNextRows(const ImageBuffer_Byte& image) {
 /// <param name="header">Jpeg header data. Should contain output colorspace.</param>
 /// <param name="quality">Jpeg codec compression quality setting. 1-100</param>
 /// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-void JpegWriter::WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data) {
-	JpegWriter writer(file_path, header, quality, warning_callback_data);
+void JpegWriter::WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data, EncoderProfile profile) {
+	JpegWriter writer(file_path, header, quality, warning_callback_data, profile);
 	writer.WriteNextRows(image);
 }
 
 
 
 
+
+//--------------------------------
+//	PLANAR WRITING
+//--------------------------------
+
+///<summary>
+///Static method. Compresses component planes as they are and writes image file to the given path.
+///File colorspace and sampling factors are taken from the planar image,
+///chroma subsampling and color conversion are skipped.
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+///</summary>
+void JpegWriter::WriteJpegPlanar(std::filesystem::path file_path, const JpegPlanarImage& image, int quality, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	CheckQuality(quality);
+
+	J_COLOR_SPACE color_space = image.GetColorSpace();
+	if (color_space != J_COLOR_SPACE::JCS_GRAYSCALE &&
+		color_space != J_COLOR_SPACE::JCS_RGB &&
+		color_space != J_COLOR_SPACE::JCS_YCCK &&
+		color_space != J_COLOR_SPACE::JCS_CMYK &&
+		color_space != J_COLOR_SPACE::JCS_YCbCr)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Invalid JPEG file colorspace requested.");
+
+	//----------------------------------------------------------------------
+	// 2 - Initializing compressor
+
+	//Writer object is used only to own the file and compressor.
+	//In case of exception writer destructor releases both.
+	JpegWriter writer;
+	writer._warning_callback_data.warningCallback = warning_callback_data.warningCallback;
+	writer._warning_callback_data.warningCallbackArgs_ptr = warning_callback_data.warningCallbackArgs_ptr;
+
+	writer.OpenCFileForBinaryWriting(file_path);
+
+	jpeg_compress_struct& comp = writer.jpeg_comp;
+	comp.err = jpeg_std_error(&writer.jerr_comp);
+	writer.jerr_comp.error_exit = &ErrorExitHandler;
+	writer.jerr_comp.emit_message = &WarningHandler;
+	jpeg_create_compress(&comp);
+	jpeg_stdio_dest(&comp, writer._file_handle);
+	comp.client_data = &writer._warning_callback_data;
+	writer._is_compressor_initialized = true;
+
+	//----------------------------------------------------------------------
+	// 3 - Configuring compressor
+
+	int num_components = image.GetNumComponents();
+	comp.image_height = image.GetHeight();
+	comp.image_width = image.GetWidth();
+	//Input colorspace only matters for defaults, raw data bypasses color conversion
+	comp.in_color_space = color_space;
+	comp.input_components = num_components;
+
+	jpeg_set_defaults(&comp);
+	jpeg_set_colorspace(&comp, color_space);
+	if (comp.num_components != num_components)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Number of planes does not match JPEG colorspace.");
+
+	//Keeping sampling of the source planes
+	for (int ci = 0; ci < num_components; ci++) {
+		comp.comp_info[ci].h_samp_factor = image.GetHSampFactor(ci);
+		comp.comp_info[ci].v_samp_factor = image.GetVSampFactor(ci);
+	}
+
+	SetQuality(comp, quality);
+	comp.raw_data_in = TRUE;
+	comp.dct_method = JDCT_ISLOW;
+
+	jpeg_start_compress(&comp, TRUE);
+
+	//----------------------------------------------------------------------
+	// 4 - Compressing iMCU rows
+
+	//Compressor takes whole iMCU rows of whole blocks for every component.
+	//Rows are gathered in scratch buffers, plane edges are replicated into padding.
+	int imcu_height = comp.max_v_samp_factor * DCTSIZE;
+	std::vector<ImageBuffer_Byte> scratch;
+	std::vector<JSAMPARRAY> component_rows(num_components);
+	scratch.reserve(num_components);
+	for (int ci = 0; ci < num_components; ci++) {
+		scratch.emplace_back(
+			comp.comp_info[ci].v_samp_factor * DCTSIZE,
+			static_cast<int>(comp.comp_info[ci].width_in_blocks) * DCTSIZE,
+			ImagePixelLayout::G,
+			BitDepth::BD_8_BIT);
+		component_rows[ci] = static_cast<JSAMPARRAY>(scratch[ci].GetDataPtr());
+	}
+
+	for (JDIMENSION imcu_row = 0; imcu_row < comp.total_iMCU_rows; imcu_row++) {
+		for (int ci = 0; ci < num_components; ci++) {
+			const ImageBuffer_Byte& plane = image.GetPlane(ci);
+			uint8_t** plane_data = plane.GetDataPtr();
+			uint8_t** scratch_data = scratch[ci].GetDataPtr();
+			int plane_height = plane.GetHeight();
+			int plane_width = plane.GetWidth();
+			int rows = scratch[ci].GetHeight();
+			int padded_width = scratch[ci].GetWidth();
+			for (int row = 0; row < rows; row++) {
+				int src_row = std::min(static_cast<int>(imcu_row) * rows + row, plane_height - 1);
+				memcpy(scratch_data[row], plane_data[src_row], plane_width);
+				memset(scratch_data[row] + plane_width, plane_data[src_row][plane_width - 1], padded_width - plane_width);
+			}
+		}
+		jpeg_write_raw_data(&comp, component_rows.data(), imcu_height);
+	}
+
+	//----------------------------------------------------------------------
+	// 5 - Finishing
+
+	jpeg_finish_compress(&comp);
+	writer.CleanUp();
+	writer._state = WriterStates::Finished;
+}
+
+
+
+
+//--------------------------------
+//	SIZE-TARGETED WRITING
+//--------------------------------
+
+///<summary>
+///Static method. Compresses image to JPEG data in memory.
+///Image is expected to be 8 bit per channel and not containing alpha channels.
+///Image dimensions take precedence over header ones.
+///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+///</summary>
+std::vector<uint8_t> JpegWriter::CompressJpeg(const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, EncoderProfile profile, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	CheckQuality(quality);
+
+	J_COLOR_SPACE header_layout = header.GetColorSpace();
+	if (header_layout != J_COLOR_SPACE::JCS_GRAYSCALE &&
+		header_layout != J_COLOR_SPACE::JCS_RGB &&
+		header_layout != J_COLOR_SPACE::JCS_YCCK &&
+		header_layout != J_COLOR_SPACE::JCS_CMYK &&
+		header_layout != J_COLOR_SPACE::JCS_YCbCr)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Invalid JPEG file colorspace requested.");
+
+	if (image.GetBitPerComponent() != BitDepth::BD_8_BIT)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Trying to write image object that is not 8 bit per color component.");
+
+	if (image.GetLayout() != JpegLayoutToImageLayout(header_layout))
+		throw codec_fatal_exception(CodecExceptions::Jpeg_EncodingError, "Trying to write image object incompatible with JPEG header (layout mismatch).");
+
+	header._height = image.GetHeight();
+	header._width = image.GetWidth();
+
+	//----------------------------------------------------------------------
+	// 2 - Initializing compressor
+
+	//Writer object is used only to own the compressor.
+	//In case of exception writer destructor releases it.
+	JpegWriter writer;
+	writer._warning_callback_data.warningCallback = warning_callback_data.warningCallback;
+	writer._warning_callback_data.warningCallbackArgs_ptr = warning_callback_data.warningCallbackArgs_ptr;
+
+	jpeg_compress_struct& comp = writer.jpeg_comp;
+	comp.err = jpeg_std_error(&writer.jerr_comp);
+	writer.jerr_comp.error_exit = &ErrorExitHandler;
+	writer.jerr_comp.emit_message = &WarningHandler;
+	jpeg_create_compress(&comp);
+	comp.client_data = &writer._warning_callback_data;
+	writer._is_compressor_initialized = true;
+
+	//Compressed data is written directly into the result vector
+	std::vector<uint8_t> result;
+	MemoryDestination destination;
+	SetMemoryDestination(comp, destination, result);
+
+	//----------------------------------------------------------------------
+	// 3 - Compressing
+
+	ConfigureCompressor(comp, header, image.GetLayout(), quality, profile);
+	jpeg_start_compress(&comp, TRUE);
+
+	uint8_t** image_data = image.GetDataPtr();
+	for (int row = 0; row < image.GetHeight(); row++) {
+		JSAMPARRAY rows_to_write = static_cast<JSAMPARRAY>(&(image_data[row]));
+		jpeg_write_scanlines(&comp, rows_to_write, 1);
+	}
+
+	jpeg_finish_compress(&comp);
+
+	writer.CleanUp();
+	return result;
+}
+
+
+
+///<summary>
+///Static method. Finds the highest quality at which compressed image fits into max_bytes and returns data compressed at that quality.
+///<para>Several probe qualities are compressed concurrently, then the range between the highest fitting and the lowest
+///not fitting quality is narrowed by interpolating the size, compressing few neighbouring qualities concurrently each round.
+///Every compressed candidate is kept so the result is never compressed twice.</para>
+///<para>Warning callback can be called from several threads at once.</para>
+///<para>Can throw codec_fatal_exception if failed to compress the image or image does not fit at quality 1.</para>
+///</summary>
+std::vector<uint8_t> JpegWriter::CompressJpegToSize(const ImageBuffer_Byte& image, JpegHeaderInfo header, size_t max_bytes, EncoderProfile profile, int* quality_ptr, WarningCallbackData warning_callback_data) {
+	//Compressed data for every tried quality
+	std::map<int, std::vector<uint8_t>> candidates;
+
+	//Compresses given qualities concurrently and adds them to candidates
+	auto compress_qualities = [&](const std::vector<int>& qualities) {
+		std::vector<std::vector<uint8_t>> results(qualities.size());
+		tbb::parallel_for(0, static_cast<int>(qualities.size()), [&](int i) {
+			results[i] = CompressJpeg(image, header, qualities[i], profile, warning_callback_data);
+		});
+		for (size_t i = 0; i < qualities.size(); i++)
+			candidates[qualities[i]] = std::move(results[i]);
+	};
+
+	//----------------------------------------------------------------------
+	// 1 - Probing the whole quality range
+
+	compress_qualities({ 20, 40, 60, 75, 85, 95, 100 });
+
+	//----------------------------------------------------------------------
+	// 2 - Narrowing the range
+
+	int fit_quality;
+	while (true) {
+		//Highest quality that fits, 0 if none does
+		fit_quality = 0;
+		for (const auto& candidate : candidates)
+			if (candidate.second.size() <= max_bytes)
+				fit_quality = candidate.first;
+
+		if (fit_quality == 100)
+			break;
+
+		//Lowest tried quality above it does not fit
+		auto above = candidates.upper_bound(fit_quality);
+		int over_quality = above->first;
+		if (over_quality == fit_quality + 1) {
+			if (fit_quality == 0)
+				throw codec_fatal_exception(CodecExceptions::Jpeg_EncodingError, "Image does not fit the size budget at quality 1.");
+			break;
+		}
+
+		//Size is roughly linear in quality between close points
+		double fit_size = fit_quality == 0 ? 0.0 : static_cast<double>(candidates[fit_quality].size());
+		double over_size = static_cast<double>(above->second.size());
+		int guess = fit_quality + 1;
+		if (over_size > fit_size)
+			guess = fit_quality + static_cast<int>((static_cast<double>(max_bytes) - fit_size) * (over_quality - fit_quality) / (over_size - fit_size));
+		guess = std::clamp(guess, fit_quality + 1, over_quality - 1);
+
+		//Neighbours of the guess are compressed at the same time, usually closing the range in one round
+		std::vector<int> qualities;
+		for (int q = guess - 1; q <= guess + 1; q++)
+			if (q > fit_quality && q < over_quality)
+				qualities.push_back(q);
+		compress_qualities(qualities);
+	}
+
+	//----------------------------------------------------------------------
+	// 3 - Returning the fitting candidate
+
+	if (quality_ptr != nullptr)
+		*quality_ptr = fit_quality;
+	return std::move(candidates[fit_quality]);
+}
+
+
+
+///<summary>
+///Static method. Compresses image at the highest quality that fits into max_bytes and writes it to the given path.
+///See CompressJpegToSize.
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to compress the image or image does not fit at quality 1.</para>
+///</summary>
+int JpegWriter::WriteJpegToSize(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, size_t max_bytes, EncoderProfile profile, WarningCallbackData warning_callback_data) {
+	int quality = 0;
+	std::vector<uint8_t> jpeg_data = CompressJpegToSize(image, header, max_bytes, profile, &quality, warning_callback_data);
+
+	std::ofstream file_stream(file_path, std::ios::binary | std::ios::trunc);
+	if (!file_stream.is_open())
+		throw std::ifstream::failure("Failed to open file.");
+	file_stream.write(reinterpret_cast<const char*>(jpeg_data.data()), jpeg_data.size());
+	if (!file_stream)
+		throw std::ifstream::failure("Failed to write file.");
+
+	return quality;
+}
+
+
+
 //--------------------------------
 //	PUBLIC CONSTRUCTORS
 //--------------------------------
@@ -152,7 +442,7 @@ void JpegWriter::WriteJPEG(std::filesystem::path file_path, const ImageBuffer_By
 ///<param name="file_path">Path to the file to be written.</param>
 ///<param name="header">JPEG header describing the file.</param>
 ///<param name="quality">JPEG compression quality setting.</param>
-JpegWriter::JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data) : ImageWriter(file_path) {
+JpegWriter::JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data, EncoderProfile profile) : ImageWriter(file_path) {
 
 	//----------------------------------------------------------------------
 	// 0 - Setting initial state of the writer object
@@ -167,8 +457,7 @@ JpegWriter::JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, i
 	// 1 - Arguments check
 
 	//Jpeg quality setting
-	if (quality < 1 || quality > 100)
-		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Jpeg quality setting is out of range.");
+	CheckQuality(quality);
 
 	//JPEG file colorspace
 	//Those are the colorspaces actually supported by JPEG files
@@ -218,40 +507,13 @@ JpegWriter::JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, i
 	//----------------------------------------------------------------------
 	// 4 - Configuring compressor for given image
 
-	//Passing image dimensions
-	jpeg_comp.image_height = header._height;
-	jpeg_comp.image_width = header._width;
-
-	//Passing image buffer colorspace and number of color components as input for compressor.
 	//At this point with jpeg header colorspace check and JpegLayoutToImageLayout output
 	//expected layouts may only be RGB and GRAYSCALE
-	switch (_image_info._layout) {
-	case ImagePixelLayout::G: {
-		jpeg_comp.in_color_space = J_COLOR_SPACE::JCS_GRAYSCALE;
-		jpeg_comp.input_components = 1;
-		break;
-	}
-	case ImagePixelLayout::RGB:
-		jpeg_comp.in_color_space = J_COLOR_SPACE::JCS_RGB;
-		jpeg_comp.input_components = 3;
-		break;
-	}
+	ConfigureCompressor(jpeg_comp, header, _image_info._layout, quality, profile);
 
 	//----------------------------------------------------------------------
 	// 5 - Setting the compressor to the ready state
 
-	//Applying default settings
-	jpeg_set_defaults(&jpeg_comp);
-
-	//Setting the file colorspace according to the JpegHeader object
-	jpeg_set_colorspace(&jpeg_comp, header_layout);
-
-	//Setting quality
-	jpeg_set_quality(&jpeg_comp, quality, TRUE);
-
-	//Explicitly saying to use slow, but accurate compression method (default)
-	jpeg_comp.dct_method = JDCT_ISLOW;			
-
 	//Initializing compression procedure
 	jpeg_start_compress(&jpeg_comp, TRUE);
 
@@ -310,6 +572,137 @@ ImagePixelLayout JpegWriter::JpegLayoutToImageLayout(J_COLOR_SPACE jpeg_colorspa
 
 
 
+///<summary>
+///Sets DCT method, entropy coding, scan script and chroma sampling of the compressor for the profile.
+///Colorspace and quality should be already set.
+///</summary>
+void JpegWriter::ApplyEncoderProfile(jpeg_compress_struct& jpeg_comp, EncoderProfile profile) {
+	switch (profile) {
+	case EncoderProfile::EP_FASTEST:
+		//Fast integer DCT, standard Huffman tables, single pass
+		jpeg_comp.dct_method = JDCT_IFAST;
+		jpeg_comp.optimize_coding = FALSE;
+		break;
+	case EncoderProfile::EP_SMALLEST:
+		//Optimized Huffman tables for each scan of progressive file
+		jpeg_comp.dct_method = JDCT_ISLOW;
+		jpeg_comp.optimize_coding = TRUE;
+		jpeg_simple_progression(&jpeg_comp);
+		break;
+	default:
+		//Accurate DCT with standard Huffman tables in a single sequential scan.
+		//Rows are compressed and written as they come, output is the same as before profiles were added.
+		jpeg_comp.dct_method = JDCT_ISLOW;
+		jpeg_comp.optimize_coding = FALSE;
+		break;
+	}
+
+	//Chroma is subsampled 2x2 for YCbCr files in all profiles
+	if (jpeg_comp.jpeg_color_space == J_COLOR_SPACE::JCS_YCbCr) {
+		jpeg_comp.comp_info[0].h_samp_factor = 2;
+		jpeg_comp.comp_info[0].v_samp_factor = 2;
+		for (int ci = 1; ci < jpeg_comp.num_components; ci++) {
+			jpeg_comp.comp_info[ci].h_samp_factor = 1;
+			jpeg_comp.comp_info[ci].v_samp_factor = 1;
+		}
+	}
+}
+
+
+
+///<summary>
+///Sets image dimensions, input layout, file colorspace, quality and profile of created compressor.
+///After this call compression can be started.
+///</summary>
+void JpegWriter::ConfigureCompressor(jpeg_compress_struct& jpeg_comp, const JpegHeaderInfo& header, ImagePixelLayout layout, int quality, EncoderProfile profile) {
+	//Passing image dimensions
+	jpeg_comp.image_height = header._height;
+	jpeg_comp.image_width = header._width;
+
+	//Passing image buffer colorspace and number of color components as input for compressor.
+	switch (layout) {
+	case ImagePixelLayout::G: {
+		jpeg_comp.in_color_space = J_COLOR_SPACE::JCS_GRAYSCALE;
+		jpeg_comp.input_components = 1;
+		break;
+	}
+	case ImagePixelLayout::RGB:
+		jpeg_comp.in_color_space = J_COLOR_SPACE::JCS_RGB;
+		jpeg_comp.input_components = 3;
+		break;
+	}
+
+	//Applying default settings
+	jpeg_set_defaults(&jpeg_comp);
+
+	//Setting the file colorspace according to the JpegHeader object
+	jpeg_set_colorspace(&jpeg_comp, header._color_space);
+
+	//Setting quality
+	SetQuality(jpeg_comp, quality);
+
+	//DCT method, Huffman tables, scans and sampling
+	ApplyEncoderProfile(jpeg_comp, profile);
+}
+
+
+
+//--------------------------------
+//	MEMORY DESTINATION
+//--------------------------------
+
+///<summary>
+///Sets memory destination as compressor destination. Destination object should outlive compression.
+///</summary>
+void JpegWriter::SetMemoryDestination(jpeg_compress_struct& jpeg_comp, MemoryDestination& destination, std::vector<uint8_t>& data) {
+	destination.manager.init_destination = &MemoryDestination_Init;
+	destination.manager.empty_output_buffer = &MemoryDestination_Empty;
+	destination.manager.term_destination = &MemoryDestination_Term;
+	destination.manager.next_output_byte = NULL;
+	destination.manager.free_in_buffer = 0;
+	destination.data = &data;
+	jpeg_comp.dest = &destination.manager;
+}
+
+
+
+///<summary>
+///Libjpeg init_destination callback of memory destination.
+///</summary>
+void JpegWriter::MemoryDestination_Init(j_compress_ptr jpeg_comp_ptr) {
+	MemoryDestination* destination = reinterpret_cast<MemoryDestination*>(jpeg_comp_ptr->dest);
+	destination->data->resize(MEMORY_DESTINATION_CHUNK);
+	destination->manager.next_output_byte = destination->data->data();
+	destination->manager.free_in_buffer = destination->data->size();
+}
+
+
+
+///<summary>
+///Libjpeg empty_output_buffer callback of memory destination. Grows the vector.
+///Libjpeg calls it when the whole buffer is filled.
+///</summary>
+boolean JpegWriter::MemoryDestination_Empty(j_compress_ptr jpeg_comp_ptr) {
+	MemoryDestination* destination = reinterpret_cast<MemoryDestination*>(jpeg_comp_ptr->dest);
+	size_t used = destination->data->size();
+	destination->data->resize(used * 2);
+	destination->manager.next_output_byte = destination->data->data() + used;
+	destination->manager.free_in_buffer = destination->data->size() - used;
+	return TRUE;
+}
+
+
+
+///<summary>
+///Libjpeg term_destination callback of memory destination. Cuts the vector to the written size.
+///</summary>
+void JpegWriter::MemoryDestination_Term(j_compress_ptr jpeg_comp_ptr) {
+	MemoryDestination* destination = reinterpret_cast<MemoryDestination*>(jpeg_comp_ptr->dest);
+	destination->data->resize(destination->data->size() - destination->manager.free_in_buffer);
+}
+
+
+
 //--------------------------------
 //	ARCHIVED METHODS
 //--------------------------------
@@ -4,14 +4,22 @@
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <map>
 //Third party
 #include "jpeglib.h"
 #include "jerror.h"
+#include "oneapi/tbb.h"
 //Internal
 #include "ImageWriter.h"
 #include "Exceptions.h"
 #include "JpegHeaderInfo.h"
 #include "LibJpegCallbacks.h"
+#include "JpegPlanarImage.h"
+#include "TurboJpegCodec.h"
 
 
 
@@ -43,7 +51,7 @@ public:
 	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
 	///<para>Can throw codec_fatal_exception if failed to write.</para>
 	///</summary>
-	void WriteNextRows(const ImageBuffer_Byte& image) override;
+	void WriteNextRows(const ImageBufferView_Byte& image) override;
 
 
 	//--------------------------------
@@ -67,7 +75,7 @@ public:
 	///<param name="file_path">Path to the output file.</param>
 	///<param name="image">Image to write.</param>
 	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
-	static void WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, int quality) {
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, int quality) {
 		JpegHeaderInfo header_info;
 		header_info._height = image.GetHeight();
 		header_info._width = image.GetWidth();
@@ -109,7 +117,7 @@ public:
 	///<param name="image">Image to write.</param>
 	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
 	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static void WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, int quality, WarningCallbackData warning_callback_data) {
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, int quality, WarningCallbackData warning_callback_data) {
 		JpegHeaderInfo header_info;
 		header_info._height = image.GetHeight();
 		header_info._width = image.GetWidth();
@@ -151,7 +159,7 @@ public:
 	///<param name="image">Image to write.</param>
 	///<param name="header">Jpeg header data. Should contain output colorspace.</param>
 	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
-	static void WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality) {
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, JpegHeaderInfo header, int quality) {
 		WriteJPEG(file_path, image, header, quality, WarningCallbackData(NULL,NULL));
 	}
 
@@ -166,13 +174,157 @@ public:
 	/// <param name="header">Jpeg header data. Should contain output colorspace.</param>
 	/// <param name="quality">Jpeg codec compression quality setting. 1-100</param>
 	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static void WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data);
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data) {
+		WriteJPEG(file_path, image, header, quality, warning_callback_data, EncoderProfile::EP_BALANCED);
+	}
+
+	///<summary>
+	/// Static method. Compresses and writes image file to the given path with given encoder profile.
+	/// Image is expected to be 8 bit per channel and not containing alpha channels.
+	/// <para>Can throw std::ifstream::failure if failed to open file.</para>
+	/// <para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	/// </summary>
+	/// <param name="file_path">Path to the output file.</param>
+	/// <param name="image">Image to write.</param>
+	/// <param name="header">Jpeg header data. Should contain output colorspace.</param>
+	/// <param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	/// <param name="profile">Encoding speed and file size tradeoff.</param>
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBufferView_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data, EncoderProfile profile);
+
+	///<summary>
+	/// Static method. Compresses and writes image file to the given path with selected backend.
+	/// Image is expected to be 8 bit per channel and not containing alpha channels.
+	/// <para>TurboJPEG backend writes color images as YCbCr (4:4:4 for RGB header, 4:2:0 for YCbCr header).</para>
+	/// <para>Can throw std::ifstream::failure if failed to open file.</para>
+	/// <para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	/// </summary>
+	/// <param name="file_path">Path to the output file.</param>
+	/// <param name="image">Image to write.</param>
+	/// <param name="header">Jpeg header data. Should contain output colorspace.</param>
+	/// <param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	/// <param name="backend">libjpeg-turbo API used for encoding.</param>
+	static void WriteJPEG(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data, JpegCodecBackend backend) {
+		if (backend == JpegCodecBackend::JCB_TURBOJPEG)
+			TurboJpegCodec::WriteJpegFile(file_path, image, header, quality, false, warning_callback_data);
+		else
+			WriteJPEG(file_path, image, header, quality, warning_callback_data);
+	}
+
+
+	//--------------------------------
+	//	PLANAR WRITING
+	//--------------------------------
+
+	///<summary>
+	///Static method. Compresses component planes as they are and writes image file to the given path.
+	///Does not register warnings.
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to the output file.</param>
+	///<param name="image">Planar image to write.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	static void WriteJpegPlanar(std::filesystem::path file_path, const JpegPlanarImage& image, int quality) {
+		WriteJpegPlanar(file_path, image, quality, WarningCallbackData(NULL, NULL));
+	}
+
+	///<summary>
+	///Static method. Compresses component planes as they are and writes image file to the given path.
+	///File colorspace and sampling factors are taken from the planar image,
+	///chroma subsampling and color conversion are skipped.
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to the output file.</param>
+	///<param name="image">Planar image to write.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static void WriteJpegPlanar(std::filesystem::path file_path, const JpegPlanarImage& image, int quality, WarningCallbackData warning_callback_data);
+
+
+	//--------------------------------
+	//	SIZE-TARGETED WRITING
+	//--------------------------------
+
+	///<summary>
+	///Static method. Compresses image to JPEG data in memory.
+	///Image is expected to be 8 bit per channel and not containing alpha channels.
+	///Image dimensions take precedence over header ones.
+	///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	///</summary>
+	///<param name="image">Image to compress.</param>
+	///<param name="header">Jpeg header data. Should contain output colorspace.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<returns>Compressed JPEG file data.</returns>
+	static std::vector<uint8_t> CompressJpeg(const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, EncoderProfile profile, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Finds the highest quality at which compressed image fits into max_bytes and returns data compressed at that quality.
+	///<para>Several probe qualities are compressed concurrently, then the range between the highest fitting and the lowest
+	///not fitting quality is narrowed by interpolating the size, compressing few neighbouring qualities concurrently each round.
+	///Every compressed candidate is kept so the result is never compressed twice.</para>
+	///<para>Warning callback can be called from several threads at once.</para>
+	///<para>Can throw codec_fatal_exception if failed to compress the image or image does not fit at quality 1.</para>
+	///</summary>
+	///<param name="image">Image to compress.</param>
+	///<param name="header">Jpeg header data. Should contain output colorspace.</param>
+	///<param name="max_bytes">Size budget of the compressed file in bytes.</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	///<param name="quality_ptr">Writes chosen quality to this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<returns>Compressed JPEG file data.</returns>
+	static std::vector<uint8_t> CompressJpegToSize(const ImageBuffer_Byte& image, JpegHeaderInfo header, size_t max_bytes, EncoderProfile profile, int* quality_ptr, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Compresses image at the highest quality that fits into max_bytes and writes it to the given path.
+	///See CompressJpegToSize.
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to compress the image or image does not fit at quality 1.</para>
+	///</summary>
+	///<param name="file_path">Path to the output file.</param>
+	///<param name="image">Image to write.</param>
+	///<param name="header">Jpeg header data. Should contain output colorspace.</param>
+	///<param name="max_bytes">Size budget of the file in bytes.</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<returns>Quality of the written file.</returns>
+	static int WriteJpegToSize(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, size_t max_bytes, EncoderProfile profile, WarningCallbackData warning_callback_data);
 
 
 
 
 
 
+	//--------------------------------
+	//	QUALITY SETTING
+	//--------------------------------
+
+	///<summary>
+	///Checks JPEG quality setting and sets quantization tables of the compressor for it.
+	///Shared with JpegTransformer which requantizes coefficients to the tables of the same quality.
+	///<para>Can throw codec_fatal_exception if quality is out of 1-100 range.</para>
+	///</summary>
+	///<param name="jpeg_comp">Compressor with colorspace already set.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	static void SetQuality(jpeg_compress_struct& jpeg_comp, int quality) {
+		CheckQuality(quality);
+		//Tables are limited to baseline range (8 bit) so any decoder can read the file
+		jpeg_set_quality(&jpeg_comp, quality, TRUE);
+	}
+
+	///<summary>
+	///Checks that JPEG quality setting is in 1-100 range.
+	///<para>Can throw codec_fatal_exception if quality is out of range.</para>
+	///</summary>
+	static void CheckQuality(int quality) {
+		if (quality < 1 || quality > 100)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Jpeg quality setting is out of range.");
+	}
+
 	//--------------------------------
 	//	PUBLIC CONSTRUCTORS
 	//--------------------------------
@@ -187,7 +339,26 @@ public:
 	///<param name="file_path">Path to the file to be written.</param>
 	///<param name="header">JPEG header describing the file.</param>
 	///<param name="quality">JPEG compression quality setting.</param>
-	JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data);
+	JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data)
+		: JpegWriter(file_path, header, quality, warning_callback_data, EncoderProfile::EP_BALANCED) {
+
+	}
+
+	///<summary>
+	///<para>Opens file pointed by file_path and writes the header using given encoder profile.</para>
+	///<para>Fastest profile uses fast integer DCT and standard Huffman tables.
+	///Balanced profile uses accurate DCT and standard Huffman tables, same as the constructor without profile.
+	///Smallest profile uses accurate DCT, optimized Huffman tables and writes progressive file.
+	///Smallest profile keeps DCT coefficients of the whole image in memory and writes the data only when the last row is passed.
+	///All profiles use 4:2:0 chroma subsampling for YCbCr files.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to write the header.</para>
+	///</summary>
+	///<param name="file_path">Path to the file to be written.</param>
+	///<param name="header">JPEG header describing the file.</param>
+	///<param name="quality">JPEG compression quality setting.</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	JpegWriter(std::filesystem::path file_path, JpegHeaderInfo header, int quality, WarningCallbackData warning_callback_data, EncoderProfile profile);
 
 
 	//--------------------------------
@@ -195,7 +366,7 @@ public:
 	//--------------------------------
 
 	~JpegWriter() {
-		jpeg_destroy_compress(&jpeg_comp);
+		CleanUp();
 	}
 
 
@@ -233,6 +404,62 @@ private:
 	/// </summary>
 	static ImagePixelLayout JpegLayoutToImageLayout(J_COLOR_SPACE jpeg_colorspace);
 
+	///<summary>
+	///Sets DCT method, entropy coding, scan script and chroma sampling of the compressor for the profile.
+	///Colorspace and quality should be already set.
+	///</summary>
+	static void ApplyEncoderProfile(jpeg_compress_struct& jpeg_comp, EncoderProfile profile);
+
+	///<summary>
+	///Sets image dimensions, input layout, file colorspace, quality and profile of created compressor.
+	///After this call compression can be started.
+	///</summary>
+	///<param name="jpeg_comp">Created compressor with destination set.</param>
+	///<param name="header">JPEG header with dimensions and colorspace of the file.</param>
+	///<param name="layout">Layout of image buffers passed to the compressor. G or RGB.</param>
+	///<param name="quality">JPEG compression quality setting.</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	static void ConfigureCompressor(jpeg_compress_struct& jpeg_comp, const JpegHeaderInfo& header, ImagePixelLayout layout, int quality, EncoderProfile profile);
+
+	//--------------------------------
+	//	MEMORY DESTINATION
+	//--------------------------------
+
+	///<summary>
+	///Size of the first chunk of memory destination buffer. Buffer is doubled every time it is filled.
+	///</summary>
+	static constexpr size_t MEMORY_DESTINATION_CHUNK = 65536;
+
+	///<summary>
+	///Libjpeg destination manager that writes compressed data into a vector.
+	///Libjpeg manager is the first member so compressor dest pointer can be cast back to this structure.
+	///Compressed data is owned by the vector all the time, so it is released normally if compression throws.
+	///</summary>
+	struct MemoryDestination {
+		struct jpeg_destination_mgr manager;
+		std::vector<uint8_t>* data;
+	};
+
+	///<summary>
+	///Sets memory destination as compressor destination. Destination object should outlive compression.
+	///</summary>
+	static void SetMemoryDestination(jpeg_compress_struct& jpeg_comp, MemoryDestination& destination, std::vector<uint8_t>& data);
+
+	///<summary>
+	///Libjpeg init_destination callback of memory destination.
+	///</summary>
+	static void MemoryDestination_Init(j_compress_ptr jpeg_comp_ptr);
+
+	///<summary>
+	///Libjpeg empty_output_buffer callback of memory destination. Grows the vector.
+	///</summary>
+	static boolean MemoryDestination_Empty(j_compress_ptr jpeg_comp_ptr);
+
+	///<summary>
+	///Libjpeg term_destination callback of memory destination. Cuts the vector to the written size.
+	///</summary>
+	static void MemoryDestination_Term(j_compress_ptr jpeg_comp_ptr);
+
 	//--------------------------------
 	//	PRIVATE METHODS
 	//--------------------------------
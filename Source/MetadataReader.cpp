@@ -0,0 +1,161 @@
+#include "MetadataReader.h"
+
+//--------------------------------
+//	ACCESSORS
+//--------------------------------
+
+///<summary>
+///Returns image orientation from EXIF Orientation tag.
+///Returns EO_NORMAL if there is no metadata, no tag or the tag value is invalid.
+///</summary>
+ExifOrientation MetadataReader::GetOrientation() const {
+	if (!HasMetadata())
+		return ExifOrientation::EO_NORMAL;
+
+	try {
+		//exiv2 knows where orientation is stored in different formats (including maker notes)
+		const Exiv2::ExifData& exif_data = _exiv_image->exifData();
+		Exiv2::ExifData::const_iterator it = Exiv2::orientation(exif_data);
+		if (it == exif_data.end() || it->count() == 0)
+			return ExifOrientation::EO_NORMAL;
+
+		int64_t value = it->toInt64();
+		if (value < ExifOrientation::EO_NORMAL || value > ExifOrientation::EO_ROTATE_90_CCW)
+			return ExifOrientation::EO_NORMAL;
+
+		return static_cast<ExifOrientation>(value);
+	}
+	catch (Exiv2::Error&) {
+		return ExifOrientation::EO_NORMAL;
+	}
+}
+
+
+
+//--------------------------------
+//	PREVIEWS
+//--------------------------------
+
+///<summary>
+///Finds the smallest embedded JPEG preview (EXIF thumbnail or camera preview) that is at least min_height x min_width
+///and still corresponds to the main image, and decodes it into preview_image.
+///Returns false if there is no suitable preview, in which case the main image should be decoded.
+///<para>Preview is considered stale and is skipped if its aspect ratio differs from the main image
+///or if EXIF pixel dimensions do not match actual size of the main image (image was edited without updating the thumbnail).</para>
+///<para>Can throw codec_fatal_exception if failed to decompress chosen preview.</para>
+///</summary>
+bool MetadataReader::ReadPreview(int min_height, int min_width, int image_height, int image_width, ImageBuffer_Byte& preview_image, WarningCallbackData warning_callback_data) const {
+	if (!HasMetadata() || image_height <= 0 || image_width <= 0)
+		return false;
+
+	//----------------------------------------------------------------------
+	// 1 - Checking that metadata describes the main image
+
+	//If EXIF pixel dimensions are present they are written together with the thumbnail.
+	//Mismatch means the image was changed by software that did not update EXIF.
+	uint32_t exif_width = 0;
+	uint32_t exif_height = 0;
+	if (GetExifUint("Exif.Photo.PixelXDimension", exif_width) && GetExifUint("Exif.Photo.PixelYDimension", exif_height))
+		if (exif_width != static_cast<uint32_t>(image_width) || exif_height != static_cast<uint32_t>(image_height))
+			return false;
+
+	//----------------------------------------------------------------------
+	// 2 - Choosing the preview
+
+	Exiv2::PreviewPropertiesList previews;
+	try {
+		Exiv2::PreviewManager preview_manager(*_exiv_image);
+		//List is sorted by preview size, smallest first
+		previews = preview_manager.getPreviewProperties();
+
+		for (const Exiv2::PreviewProperties& properties : previews) {
+			if (properties.mimeType_ != "image/jpeg")
+				continue;
+			if (properties.height_ < static_cast<size_t>(min_height) || properties.width_ < static_cast<size_t>(min_width))
+				continue;
+			if (!IsPreviewFresh(properties.height_, properties.width_, image_height, image_width))
+				continue;
+
+			//----------------------------------------------------------------------
+			// 3 - Decoding the preview
+
+			Exiv2::PreviewImage preview = preview_manager.getPreviewImage(properties);
+			JpegHeaderInfo preview_header;
+			ImageBuffer_Byte decoded = JpegReader::ReadJpegData(preview.pData(), preview.size(), &preview_header, warning_callback_data);
+
+			//Size listed by exiv2 may come from tags, decoded size is what matters
+			if (decoded.GetHeight() < min_height || decoded.GetWidth() < min_width ||
+				!IsPreviewFresh(decoded.GetHeight(), decoded.GetWidth(), image_height, image_width))
+				continue;
+
+			preview_image = std::move(decoded);
+			return true;
+		}
+	}
+	catch (Exiv2::Error&) {
+		return false;
+	}
+
+	return false;
+}
+
+
+
+//--------------------------------
+//	PUBLIC CONSTRUCTORS
+//--------------------------------
+
+///<summary>
+///Opens file pointed by file_path and reads its metadata.
+///Does not throw if metadata cannot be read.
+///</summary>
+MetadataReader::MetadataReader(std::filesystem::path file_path) {
+	try {
+		_exiv_image = Exiv2::ImageFactory::open(file_path.string());
+		_exiv_image->readMetadata();
+	}
+	catch (Exiv2::Error&) {
+		_exiv_image.reset();
+	}
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Reads unsigned integer EXIF value by key.
+///Returns false if the tag is missing.
+///</summary>
+bool MetadataReader::GetExifUint(const std::string& key, uint32_t& value) const {
+	const Exiv2::ExifData& exif_data = _exiv_image->exifData();
+	Exiv2::ExifData::const_iterator it = exif_data.findKey(Exiv2::ExifKey(key));
+	if (it == exif_data.end() || it->count() == 0)
+		return false;
+
+	value = it->toUint32();
+	return true;
+}
+
+
+
+///<summary>
+///Checks that preview of given size still corresponds to the main image.
+///</summary>
+bool MetadataReader::IsPreviewFresh(size_t preview_height, size_t preview_width, int image_height, int image_width) const {
+	if (preview_height == 0 || preview_width == 0)
+		return false;
+
+	//Preview can not be bigger than the image it was made from
+	if (preview_height > static_cast<size_t>(image_height) || preview_width > static_cast<size_t>(image_width))
+		return false;
+
+	//Aspect ratios are compared by cross multiplication.
+	//Allowed difference is 2% - preview dimensions are rounded to whole pixels.
+	//Letterboxed thumbnails and thumbnails of rotated or cropped image fail this check.
+	int64_t preview_cross = static_cast<int64_t>(preview_width) * image_height;
+	int64_t image_cross = static_cast<int64_t>(image_width) * static_cast<int64_t>(preview_height);
+	return std::llabs(preview_cross - image_cross) * 50 <= image_cross;
+}
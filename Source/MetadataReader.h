@@ -0,0 +1,94 @@
+#pragma once
+//STL
+#include <string>
+#include <filesystem>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+//Third party
+#include "exiv2/exiv2.hpp"
+//Internal
+#include "ImageBuffer_Byte.h"
+#include "JpegReader.h"
+#include "WarningCallbackData.h"
+
+///<summary>
+///Class for reading image metadata (EXIF) and embedded preview images.
+///Uses exiv2 library.
+///</summary>
+///<remarks>
+///Metadata is optional for the image processing, so failure to read it is not an error.
+///If exiv2 cannot read the file the reader reports no metadata and no previews.
+///</remarks>
+class MetadataReader {
+public:
+	//--------------------------------
+	//	ACCESSORS
+	//--------------------------------
+
+	///<summary>
+	///Reports true if metadata was read from the file.
+	///</summary>
+	bool HasMetadata() const { return _exiv_image != nullptr; }
+
+	///<summary>
+	///Returns image orientation from EXIF Orientation tag.
+	///Returns EO_NORMAL if there is no metadata, no tag or the tag value is invalid.
+	///</summary>
+	ExifOrientation GetOrientation() const;
+
+	//--------------------------------
+	//	PREVIEWS
+	//--------------------------------
+
+	///<summary>
+	///Finds the smallest embedded JPEG preview (EXIF thumbnail or camera preview) that is at least min_height x min_width
+	///and still corresponds to the main image, and decodes it into preview_image.
+	///Returns false if there is no suitable preview, in which case the main image should be decoded.
+	///<para>Preview is considered stale and is skipped if its aspect ratio differs from the main image
+	///or if EXIF pixel dimensions do not match actual size of the main image (image was edited without updating the thumbnail).</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress chosen preview.</para>
+	///</summary>
+	///<param name="min_height">Minimal height of the preview (usually downscaling target height).</param>
+	///<param name="min_width">Minimal width of the preview (usually downscaling target width).</param>
+	///<param name="image_height">Actual height of the main image taken from its decoder header.</param>
+	///<param name="image_width">Actual width of the main image taken from its decoder header.</param>
+	///<param name="preview_image">Receives decoded preview.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments for the JPEG decoder.</param>
+	bool ReadPreview(int min_height, int min_width, int image_height, int image_width, ImageBuffer_Byte& preview_image, WarningCallbackData warning_callback_data) const;
+
+	//--------------------------------
+	//	PUBLIC CONSTRUCTORS
+	//--------------------------------
+
+	///<summary>
+	///Opens file pointed by file_path and reads its metadata.
+	///Does not throw if metadata cannot be read.
+	///</summary>
+	MetadataReader(std::filesystem::path file_path);
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	///<summary>
+	///exiv2 image object holding the metadata. NULL if metadata could not be read.
+	///</summary>
+	Exiv2::Image::UniquePtr _exiv_image;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Reads unsigned integer EXIF value by key.
+	///Returns false if the tag is missing.
+	///</summary>
+	bool GetExifUint(const std::string& key, uint32_t& value) const;
+
+	///<summary>
+	///Checks that preview of given size still corresponds to the main image.
+	///</summary>
+	bool IsPreviewFresh(size_t preview_height, size_t preview_width, int image_height, int image_width) const;
+};
@@ -15,20 +15,39 @@
 ///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
 ///</summary>
 ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
-
-	//----------------------------------------------------------------------
-	// 1 - Arguments check
-
 	//Simple argument sanity check
 	if (num_rows <= 0)
 		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth());
 
-	// Checking reader state -----------------------------------------------
-
 	//If reading has finished we return unallocated image
 	if (_state == ReaderStates::Finished)
 		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth());
 
+	//This object will represent the result of file reading.
+	ImageBuffer_Byte decompressed_image(0, _image_info._width, _image_info._layout, _image_info._bit_depth, false);
+	ReadNextRowsInto(num_rows, decompressed_image);
+
+	//Returning decompressed image container
+	return decompressed_image;
+}
+
+
+
+///<summary>
+///Reads next block of rows starting at NextRow into caller provided buffer.
+///Buffer is reshaped to the number of rows actually read, its allocated memory is reused when possible.
+///If bit depth of the buffer does not match the image it is replaced.
+///Advances NextRow by num_lines.
+///When all rows are already read buffer is reshaped to zero rows.
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+void PngReader::ReadNextRowsInto(int num_rows, ImageBuffer_Byte& target) {
+
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	// Checking reader state -----------------------------------------------
+
 	//If reader has failed before we throw
 	if (_state == ReaderStates::Failed) {
 		CleanUp();
@@ -41,6 +60,12 @@ ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
 		throw codec_fatal_exception(CodecExceptions::Png_InitError, "Trying to read a file using uninitialized reader object.");
 	}
 
+	//If reading has finished or nothing is requested there are no rows to return
+	if (_state == ReaderStates::Finished || num_rows <= 0) {
+		PrepareTargetBuffer(target, 0);
+		return;
+	}
+
 	//----------------------------------------------------------------------
 	// 2 - Remaining rows calculation
 
@@ -50,15 +75,11 @@ ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
 	//----------------------------------------------------------------------
 	// 3 - Decompressing the image
 
-	//This object will represent the result of file reading.
-	ImageBuffer_Byte decompressed_image(
-			actual_num_rows,
-			_image_info._width,
-			_image_info._layout,
-			_image_info._bit_depth);
+	//Reshaping the target to receive decompressed rows
+	PrepareTargetBuffer(target, actual_num_rows);
 
 	//Image data alias
-	png_bytepp decompressed_data = reinterpret_cast<png_bytepp>(decompressed_image.GetDataPtr()); 
+	png_bytepp decompressed_data = reinterpret_cast<png_bytepp>(target.GetDataPtr()); 
 
 	//As for writing of this code libpng documentation states
 	//that only two possible interlacement schemes exists for png -
@@ -78,7 +99,6 @@ ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
 			);
 	}
 	catch (codec_fatal_exception e) {
-		/* delete decompressed_image; //Deleting the uncompressed image object */ //Archived from the times when this method returned a pointer
 		_state = ReaderStates::Failed;
 		CleanUp();
 		throw; //rethrowing
@@ -98,9 +118,6 @@ ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
 		//Releasing the decompressor object memory
 		CleanUp();
 	}
-
-	//Returning decompressed image container
-	return decompressed_image;
 }
 
 
@@ -121,9 +138,9 @@ ImageBuffer_Byte PngReader::ReadNextRows(int num_rows) {
 ///<param name="headerPtr">Writes info to PNG header located at this pointer. If NULL it is ignored.</param>
 ///<param name="warningCallback">Pointer to function to handle warnings produced by libPng. Can be NULL.</param>
 ///<param name="warningCallbackArgsPtr">Arguments to be given to warning handler function. Can be NULL.</param>
-ImageBuffer_Byte PngReader::ReadPngFile(std::filesystem::path file_path, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+ImageBuffer_Byte PngReader::ReadPngFile(std::filesystem::path file_path, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, DecodeProfile profile) {
 	//Creating reader object
-	PngReader reader(file_path, warning_callback_data);
+	PngReader reader(file_path, warning_callback_data, profile);
 
 	PngHeaderInfo png_header = reader.GetPngHeader();
 
@@ -142,6 +159,58 @@ ImageBuffer_Byte PngReader::ReadPngFile(std::filesystem::path file_path, PngHead
 
 
 
+///<summary>
+///Static method. Reads reduced resolution version of the image for further downscaling.
+///<para>For Adam7 interlaced file decoding stops after the first pass whose accumulated pixel grid
+///is at least min_height x min_width, so the remaining passes are never decompressed.
+///Returned image is a subsampled version of the original (every 8th, 4th or 2nd pixel).</para>
+///<para>File without interlacing is read in full resolution.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+///<param name="file_path">Path to file to read.</param>
+///<param name="min_height">Minimal height of the returned image (usually downscaling target height).</param>
+///<param name="min_width">Minimal width of the returned image (usually downscaling target width).</param>
+///<param name="headerPtr">Writes info to PNG header located at this pointer. If NULL it is ignored. Header describes the full resolution image.</param>
+///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+ImageBuffer_Byte PngReader::ReadPngFileReduced(std::filesystem::path file_path, int min_height, int min_width, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	//Creating reader object
+	PngReader reader(file_path, warning_callback_data);
+
+	PngHeaderInfo png_header = reader.GetPngHeader();
+
+	//Filling header object for the user
+	if (headerPtr != nullptr) {
+		headerPtr->_height = png_header.GetHeight();
+		headerPtr->_width = png_header.GetWidth();
+		headerPtr->_bit_depth = png_header.GetBitDepth();
+		headerPtr->_png_color_type = png_header.GetPngColorType();
+		headerPtr->_png_interlace_type = png_header.GetPngInterlaceType();
+	}
+
+	int height = static_cast<int>(png_header.GetHeight());
+	int width = static_cast<int>(png_header.GetWidth());
+
+	//Image without interlacing has no reduced versions inside
+	if (png_header.GetPngInterlaceType() != PNG_INTERLACE_ADAM7)
+		return reader.ReadNextRows(height);
+
+	//Finding first pass that gives enough pixels
+	int last_pass = PNG_INTERLACE_ADAM7_PASSES - 1;
+	for (int pass = 0; pass < PNG_INTERLACE_ADAM7_PASSES; pass++) {
+		int grid_height = (height + ADAM7_GRID_ROW_STEP[pass] - 1) / ADAM7_GRID_ROW_STEP[pass];
+		int grid_width = (width + ADAM7_GRID_COL_STEP[pass] - 1) / ADAM7_GRID_COL_STEP[pass];
+		if (grid_height >= min_height && grid_width >= min_width) {
+			last_pass = pass;
+			break;
+		}
+	}
+
+	return reader.ReadAdam7Passes(last_pass);
+}
+
+
+
 
 //--------------------------------
 //	PUBLIC CONSTRUCTORS
@@ -153,7 +222,7 @@ ImageBuffer_Byte PngReader::ReadPngFile(std::filesystem::path file_path, PngHead
 ///<para>Can throw std::ifstream::failure if failed to open file.</para>
 ///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
 ///</summary>
-PngReader::PngReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data) : ImageReader(file_path) {
+PngReader::PngReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data, DecodeProfile profile) : ImageReader(file_path) {
 	//----------------------------------------------------------------------
 	// 0 - Setting initial state of the reader object
 
@@ -221,6 +290,9 @@ PngReader::PngReader(std::filesystem::path file_path, WarningCallbackData warnin
 	//Telling decoder that we want to ignore all unknown data chunks
 	png_set_keep_unknown_chunks(_png_read_struct_ptr, PNG_HANDLE_CHUNK_NEVER, NULL, 0);
 
+	//Relaxing checks for trusted files
+	ApplyDecodeProfile(profile);
+
 
 	//----------------------------------------------------------------------
 	// 3 - Reading the image header 
@@ -254,6 +326,14 @@ PngReader::PngReader(std::filesystem::path file_path, WarningCallbackData warnin
 	_image_info._bit_depth = PngBitDepthToImageBitDepth(_png_header._bit_depth);
 	_image_info._layout = PngLayoutToImageLayout(_png_header._png_color_type);
 
+	//ICC profile, decompressed by libpng
+	png_charp icc_name = NULL;
+	int icc_compression = 0;
+	png_bytep icc_data = NULL;
+	png_uint_32 icc_size = 0;
+	if (png_get_iCCP(_png_read_struct_ptr, _png_info_ptr, &icc_name, &icc_compression, &icc_data, &icc_size) == PNG_INFO_iCCP)
+		_icc_profile.assign(icc_data, icc_data + icc_size);
+
 
 	//----------------------------------------------------------------------
 	// 4 - Setting the decompressor to a ready state
@@ -313,6 +393,112 @@ void PngReader::CleanUp() {
 
 
 
+///<summary>
+///Applies decode profile to the png read structure before the header is read.
+///</summary>
+void PngReader::ApplyDecodeProfile(DecodeProfile profile) {
+	if (profile != DecodeProfile::DP_TRUSTED)
+		return;
+
+	//CRC of critical and ancillary chunks is not calculated
+	png_set_crc_action(_png_read_struct_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+
+#ifdef PNG_IGNORE_ADLER32
+	//Adler-32 checksum of compressed image data is not calculated
+	png_set_option(_png_read_struct_ptr, PNG_IGNORE_ADLER32, PNG_OPTION_ON);
+#endif
+
+	//Text and time chunks are skipped without parsing or decompressing
+	static const png_byte ignored_chunks[] = {
+		't', 'E', 'X', 't', '\0',
+		'z', 'T', 'X', 't', '\0',
+		'i', 'T', 'X', 't', '\0',
+		't', 'I', 'M', 'E', '\0'
+	};
+	png_set_keep_unknown_chunks(_png_read_struct_ptr, PNG_HANDLE_CHUNK_NEVER, ignored_chunks, 4);
+}
+
+
+
+
+///<summary>
+///Reads Adam7 passes up to and including last_pass without interlace handling
+///and places pixels of each pass on the pixel grid accumulated by last_pass.
+///Finishes the reader without decompressing remaining passes.
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+ImageBuffer_Byte PngReader::ReadAdam7Passes(int last_pass) {
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	if (_state != ReaderStates::Ready_Start) {
+		CleanUp();
+		throw codec_fatal_exception(CodecExceptions::Png_InitError, "Reduced resolution reading requires reader in initial state.");
+	}
+
+	//----------------------------------------------------------------------
+	// 2 - Preparing the result
+
+	int height = _image_info.GetHeight();
+	int width = _image_info.GetWidth();
+	int row_step = ADAM7_GRID_ROW_STEP[last_pass];
+	int col_step = ADAM7_GRID_COL_STEP[last_pass];
+
+	ImageBuffer_Byte reduced_image(
+		(height + row_step - 1) / row_step,
+		(width + col_step - 1) / col_step,
+		_image_info.GetLayout(),
+		_image_info.GetBitDepth());
+	uint8_t** reduced_data = reduced_image.GetDataPtr();
+
+	//Size of a pixel after transformations
+	size_t pixel_size = static_cast<size_t>(reduced_image.GetNumCmp()) * (static_cast<int>(_image_info.GetBitDepth()) / 8);
+
+	//Buffer for a single row of the pass. Full width row is enough for any pass.
+	std::vector<png_byte> pass_row(png_get_rowbytes(_png_read_struct_ptr, _png_info_ptr));
+
+	//----------------------------------------------------------------------
+	// 3 - Decompressing the passes
+
+	//Interlace handling is not requested from libpng, so each png_read_row returns next row of the current pass
+	//containing only pixels of that pass. Passes with no pixels are skipped by libpng, and so are they here.
+	try {
+		for (int pass = 0; pass <= last_pass; pass++) {
+			int pass_rows = static_cast<int>(PNG_PASS_ROWS(height, pass));
+			int pass_cols = static_cast<int>(PNG_PASS_COLS(width, pass));
+			if (pass_rows == 0 || pass_cols == 0)
+				continue;
+
+			for (int pass_row_index = 0; pass_row_index < pass_rows; pass_row_index++) {
+				png_read_row(_png_read_struct_ptr, pass_row.data(), NULL);
+
+				//Every pixel of passes up to last_pass lies on the grid of last_pass
+				uint8_t* reduced_row = reduced_data[PNG_ROW_FROM_PASS_ROW(pass_row_index, pass) / row_step];
+				for (int pass_col = 0; pass_col < pass_cols; pass_col++) {
+					size_t reduced_col = PNG_COL_FROM_PASS_COL(pass_col, pass) / col_step;
+					std::memcpy(reduced_row + reduced_col * pixel_size, pass_row.data() + pass_col * pixel_size, pixel_size);
+				}
+			}
+		}
+	}
+	catch (codec_fatal_exception e) {
+		_state = ReaderStates::Failed;
+		CleanUp();
+		throw; //rethrowing
+	}
+
+	//----------------------------------------------------------------------
+	// 4 - Finishing
+
+	//Remaining passes are not needed, decompressor is released without reading the rest of the file
+	AdvanceRows(height);
+	CleanUp();
+
+	return reduced_image;
+}
+
+
+
 
 //--------------------------------
 //	UTILITY METHODS
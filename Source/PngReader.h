@@ -4,6 +4,8 @@
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <vector>
+#include <cstring>
 //Third party
 #include "png.h"
 //Internal
@@ -45,6 +47,16 @@ public:
 	///</summary>
 	ImageBuffer_Byte ReadNextRows(int num_rows) override;
 
+	///<summary>
+	///Reads next block of rows starting at NextRow into caller provided buffer.
+	///Buffer is reshaped to the number of rows actually read, its allocated memory is reused when possible.
+	///If bit depth of the buffer does not match the image it is replaced.
+	///Advances NextRow by num_lines.
+	///When all rows are already read buffer is reshaped to zero rows.
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	void ReadNextRowsInto(int num_rows, ImageBuffer_Byte& target) override;
+
 
 	//--------------------------------
 	//	WHOLE FILE READING
@@ -58,7 +70,21 @@ public:
 	///<param name="file_path">Path to file to read.</param>
 	///<param name="headerPtr">Writes info to PNG header located at this pointer. If NULL it is ignored.</param>
 	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static ImageBuffer_Byte ReadPngFile(std::filesystem::path file_path, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+	static ImageBuffer_Byte ReadPngFile(std::filesystem::path file_path, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+		return ReadPngFile(file_path, headerPtr, warning_callback_data, DecodeProfile::DP_STRICT);
+	}
+
+	///<summary>
+	///Static method. Reads and decompresses file pointed to by file_path with given decode profile and returns an image buffer object.
+	///<para>Trusted profile skips CRC and zlib checksum verification and ignores text and time chunks.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="headerPtr">Writes info to PNG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<param name="profile">Decoder strictness and speed tradeoff.</param>
+	static ImageBuffer_Byte ReadPngFile(std::filesystem::path file_path, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data, DecodeProfile profile);
 
 	///<summary>
 	///Static method. Reads and decompresses file pointed to by file_path and returns an image buffer object.
@@ -99,6 +125,38 @@ public:
 		return ReadPngFile(file_path, NULL, warning_callback_data);
 	}
 
+	///<summary>
+	///Static method. Reads reduced resolution version of the image for further downscaling.
+	///<para>For Adam7 interlaced file decoding stops after the first pass whose accumulated pixel grid
+	///is at least min_height x min_width, so the remaining passes are never decompressed.
+	///Returned image is a subsampled version of the original (every 8th, 4th or 2nd pixel).</para>
+	///<para>File without interlacing is read in full resolution.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="min_height">Minimal height of the returned image (usually downscaling target height).</param>
+	///<param name="min_width">Minimal width of the returned image (usually downscaling target width).</param>
+	///<param name="headerPtr">Writes info to PNG header located at this pointer. If NULL it is ignored. Header describes the full resolution image.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static ImageBuffer_Byte ReadPngFileReduced(std::filesystem::path file_path, int min_height, int min_width, PngHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
+
+	//--------------------------------
+	//	UTILITY METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Translates PNG file color type (pixel layout) to corresponding pixel layot used in ImageBuffer objects.
+	/// </summary>
+	static ImagePixelLayout PngLayoutToImageLayout(unsigned char png_file_color_type);
+
+	/// <summary>
+	/// Translates PNG file bit depth to corresponding bit depth parameter used in ImageBuffer objects.
+	/// </summary>
+	/// <param name="png_bit_depth"></param>
+	/// <returns></returns>
+	static BitDepth PngBitDepthToImageBitDepth(unsigned int png_bit_depth);
 
 	//--------------------------------
 	//	PUBLIC CONSTRUCTORS
@@ -110,7 +168,20 @@ public:
 	///<para>Can throw std::ifstream::failure if failed to open file.</para>
 	///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
 	///</summary>
-	PngReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data);
+	PngReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data)
+		: PngReader(file_path, warning_callback_data, DecodeProfile::DP_STRICT) {
+
+	}
+
+	///<summary>
+	///<para>Opens file pointed by file_path and reads the file header.</para>
+	///<para>Header is accessible by calling GetCommonHeader() and GetPngHeader().</para>
+	///<para>Trusted profile skips CRC and zlib checksum verification and ignores text and time chunks.
+	///Intended for previously validated files.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the header.</para>
+	///</summary>
+	PngReader(std::filesystem::path file_path, WarningCallbackData warning_callback_data, DecodeProfile profile);
 
 	///<summary>
 	///<para>Opens file pointed by file_path and reads the file header.</para>
@@ -163,22 +234,6 @@ private:
 	png_structp _png_read_struct_ptr = NULL;
 	png_infop _png_info_ptr = NULL;
 
-	//--------------------------------
-	//	UTILITY METHODS
-	//--------------------------------
-
-	/// <summary>
-	/// Translates PNG file color type (pixel layout) to corresponding pixel layot used in ImageBuffer objects.
-	/// </summary>
-	static ImagePixelLayout PngLayoutToImageLayout(unsigned char png_file_color_type);
-
-	/// <summary>
-	/// Translates PNG file bit depth to corresponding bit depth parameter used in ImageBuffer objects.
-	/// </summary>
-	/// <param name="png_bit_depth"></param>
-	/// <returns></returns>
-	static BitDepth PngBitDepthToImageBitDepth(unsigned int png_bit_depth);
-
 	//--------------------------------
 	//	PRIVATE METHODS
 	//--------------------------------
@@ -189,6 +244,29 @@ private:
 	///</summary>
 	void CleanUp();
 
+	///<summary>
+	///Applies decode profile to the png read structure before the header is read.
+	///</summary>
+	void ApplyDecodeProfile(DecodeProfile profile);
+
+	///<summary>
+	///Reads Adam7 passes up to and including last_pass without interlace handling
+	///and places pixels of each pass on the pixel grid accumulated by last_pass.
+	///Finishes the reader without decompressing remaining passes.
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	ImageBuffer_Byte ReadAdam7Passes(int last_pass);
+
+	///<summary>
+	///Vertical step of the pixel grid accumulated after each Adam7 pass.
+	///</summary>
+	static constexpr int ADAM7_GRID_ROW_STEP[PNG_INTERLACE_ADAM7_PASSES] = { 8, 8, 4, 4, 2, 2, 1 };
+
+	///<summary>
+	///Horizontal step of the pixel grid accumulated after each Adam7 pass.
+	///</summary>
+	static constexpr int ADAM7_GRID_COL_STEP[PNG_INTERLACE_ADAM7_PASSES] = { 8, 4, 4, 2, 2, 1, 1 };
+
 	//--------------------------------
 	//	PRIVATE CONSTRUCTOR
 	//--------------------------------
@@ -15,8 +15,8 @@
 /// <param name="image">Image to write.</param>
 /// <param name="header">PNG header data. Should contain valid output colorspace.</param>
 /// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-void PngWriter::WritePng(std::filesystem::path file_path, const ImageBuffer_Byte& image, PngHeaderInfo header, WarningCallbackData warning_callback_data) {
-	PngWriter writer(file_path, header, warning_callback_data);
+void PngWriter::WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, PngHeaderInfo header, WarningCallbackData warning_callback_data, EncoderProfile profile) {
+	PngWriter writer(file_path, header, warning_callback_data, profile);
 	writer.WriteNextRows(image);
 }
 
@@ -27,7 +27,7 @@ void PngWriter::WritePng(std::filesystem::path file_path, const ImageBuffer_Byte
 	///Advances NextRow by the height of given image.
 	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
 	///</summary>
-void PngWriter::WriteNextRows(const ImageBuffer_Byte& image) {
+void PngWriter::WriteNextRows(const ImageBufferView_Byte& image) {
 
 	//Aliases
 	unsigned int header_bit_depth = _png_header.GetBitDepth();
@@ -105,16 +105,27 @@ void PngWriter::WriteNextRows(const ImageBuffer_Byte& image) {
 	if (_is_low_depth_grayscale)
 		bitcrushed_image = new ImageBuffer_Byte(std::move(CrushBitDepth(image, header_bit_depth)));
 
-	//Data alias for writing
-	png_bytepp image_data;
-	if (_is_low_depth_grayscale)
-		image_data = static_cast<png_bytepp>(bitcrushed_image->GetDataPtr());
+	//Row pointers for writing, view rows can start in the middle of buffer rows
+	_row_pointers.resize(actual_num_rows);
+	if (_is_low_depth_grayscale) {
+		uint8_t** bitcrushed_data = bitcrushed_image->GetDataPtr();
+		for (int row = 0; row < actual_num_rows; row++)
+			_row_pointers[row] = bitcrushed_data[row];
+	}
 	else
-		image_data = static_cast<png_bytepp>(image.GetDataPtr());
+		for (int row = 0; row < actual_num_rows; row++)
+			_row_pointers[row] = image[row];
+	png_bytepp image_data = _row_pointers.data();
 
 	//Appending image buffer rows to the file
 	try {
-		png_write_rows(png_ptr, image_data, actual_num_rows);
+		if (_is_sampled_filtering) {
+			int bytes_per_pixel = image.GetNumCmp() * (buffer_bit_depth / 8);
+			int first_row_index = static_cast<int>(GetNextRowIndex()) - actual_num_rows;
+			WriteRowsWithSampledFilters(image_data, actual_num_rows, first_row_index, image.GetWidth() * bytes_per_pixel, bytes_per_pixel);
+		}
+		else
+			png_write_rows(png_ptr, image_data, actual_num_rows);
 	}
 	catch (codec_fatal_exception e) {
 		_state = WriterStates::Failed;
@@ -162,7 +173,7 @@ void PngWriter::WriteNextRows(const ImageBuffer_Byte& image) {
 ///<param name="file_path">Path to the file to be written.</param>
 ///<param name="header">PNG header describing the file.</param>
 ///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-PngWriter::PngWriter(std::filesystem::path file_path, PngHeaderInfo header, WarningCallbackData warning_callback_data) : ImageWriter(file_path) {
+PngWriter::PngWriter(std::filesystem::path file_path, PngHeaderInfo header, WarningCallbackData warning_callback_data, EncoderProfile profile) : ImageWriter(file_path) {
 	//----------------------------------------------------------------------
 	// 0 - Setting initial state of the writer object
 
@@ -280,6 +291,9 @@ PngWriter::PngWriter(std::filesystem::path file_path, PngHeaderInfo header, Warn
 	//----------------------------------------------------------------------
 	// 4 - Configuring compressor for given image
 
+	//Filters and zlib parameters
+	ApplyEncoderProfile(profile);
+
 	//Providing encoder with basic info about the image and basic comression settings
 	png_set_IHDR(
 		png_ptr,	//PNG structure
@@ -338,7 +352,7 @@ PngWriter::PngWriter(std::filesystem::path file_path, PngHeaderInfo header, Warn
 /// </summary>
 /// <param name="image">Input image buffer assumed to be grayscale 8 bit per pixel.</param>
 /// <param name="bit_depth">Desired bit depth. Possible values are 1, 2, 4.</param>
-ImageBuffer_Byte PngWriter::CrushBitDepth(const ImageBuffer_Byte& src_image, int bit_depth) {
+ImageBuffer_Byte PngWriter::CrushBitDepth(const ImageBufferView_Byte& src_image, int bit_depth) {
 	//Aliases
 	int height = src_image.GetHeight();
 	int width = src_image.GetWidth();
@@ -347,7 +361,6 @@ ImageBuffer_Byte PngWriter::CrushBitDepth(const ImageBuffer_Byte& src_image, int
 	ImageBuffer_Byte trg_image(height, width, ImagePixelLayout::G, BitDepth::BD_8_BIT);
 
 	//Data alias
-	uint8_t** src_data = src_image.GetDataPtr();
 	uint8_t** trg_data = trg_image.GetDataPtr();
 
 	int divisor = 1;
@@ -367,7 +380,7 @@ ImageBuffer_Byte PngWriter::CrushBitDepth(const ImageBuffer_Byte& src_image, int
 
 	for (int row = 0; row < height; row++)
 		for (int px = 0; px < width; px++)
-			trg_data[row][px] = static_cast<uint8_t>(src_data[row][px] / divisor);
+			trg_data[row][px] = static_cast<uint8_t>(src_image[row][px] / divisor);
 
 	return trg_image;
 }
@@ -469,6 +482,166 @@ void PngWriter::CleanUp() {
 	}
 }
 
+
+
+///<summary>
+///Sets filters and zlib parameters of the encoder for the profile.
+///</summary>
+void PngWriter::ApplyEncoderProfile(EncoderProfile profile) {
+	switch (profile) {
+	case EncoderProfile::EP_FASTEST:
+		//Sub filter is the cheapest one that still helps photographic content
+		png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+		png_set_compression_level(png_ptr, 1);
+		png_set_compression_strategy(png_ptr, Z_RLE);
+		png_set_compression_mem_level(png_ptr, 8);
+		break;
+	case EncoderProfile::EP_SMALLEST:
+		//Filter is chosen for each row by minimum sum of absolute differences
+		png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_ALL_FILTERS);
+		png_set_compression_level(png_ptr, 9);
+		png_set_compression_strategy(png_ptr, Z_FILTERED);
+		png_set_compression_mem_level(png_ptr, 9);
+		break;
+	default:
+		//All filters are enabled so libpng allocates previous row buffer,
+		//then single filter is set for each band when writing
+		png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_ALL_FILTERS);
+		png_set_compression_level(png_ptr, 6);
+		png_set_compression_strategy(png_ptr, Z_FILTERED);
+		png_set_compression_mem_level(png_ptr, 8);
+		//Palette and low bit depth images are written unfiltered by libpng heuristic anyway,
+		//interlaced rows are reordered into passes so bands would not match
+		_is_sampled_filtering =
+			_png_header.GetBitDepth() >= 8
+			&& _png_header.GetPngColorType() != PNG_COLOR_TYPE_PALETTE
+			&& _png_header.GetPngInterlaceType() == PNG_INTERLACE_NONE;
+		break;
+	}
+}
+
+
+
+///<summary>
+///Writes rows to the encoder in bands, setting filter for each band chosen from sampled rows.
+///</summary>
+///<param name="rows">Rows to write.</param>
+///<param name="num_rows">Number of rows to write.</param>
+///<param name="first_row_index">Index of the first row in the image.</param>
+///<param name="row_bytes">Size of a row in bytes.</param>
+///<param name="bytes_per_pixel">Size of a pixel in bytes.</param>
+void PngWriter::WriteRowsWithSampledFilters(png_bytepp rows, int num_rows, int first_row_index, int row_bytes, int bytes_per_pixel) {
+	static const int filters[5] = { PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG, PNG_FILTER_PAETH };
+
+	int row = 0;
+	while (row < num_rows) {
+		//Bands are aligned to image rows so result does not depend on size of blocks passed to the writer
+		int image_row = first_row_index + row;
+		int band_rows = std::min(FILTER_BAND_HEIGHT - image_row % FILTER_BAND_HEIGHT, num_rows - row);
+
+		//Estimating filter costs on sampled rows of the band.
+		//16 bit rows are costed in buffer (little-endian) byte order although libpng filters them swapped.
+		//Swapping only permutes bytes inside each sample, and since pixel size is even every filter
+		//pairs bytes at the same position of the sample, so each filtered byte and the sums are the same.
+		uint64_t costs[5] = { 0, 0, 0, 0, 0 };
+		for (int sample = 0; sample < band_rows; sample += FILTER_SAMPLE_STEP) {
+			const uint8_t* prev_row = NULL;
+			if (row + sample > 0)
+				prev_row = rows[row + sample - 1];
+			else if (image_row > 0)
+				prev_row = _last_row.data();
+			AddFilterCosts(rows[row + sample], prev_row, row_bytes, bytes_per_pixel, costs);
+		}
+
+		int best = 0;
+		for (int f = 1; f < 5; f++)
+			if (costs[f] < costs[best])
+				best = f;
+
+		//With single filter set libpng skips its own per row search
+		png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, filters[best]);
+		png_write_rows(png_ptr, rows + row, band_rows);
+
+		row += band_rows;
+	}
+
+	//Keeping last row for the next block
+	if (num_rows > 0) {
+		_last_row.resize(row_bytes);
+		memcpy(_last_row.data(), rows[num_rows - 1], row_bytes);
+	}
+}
+
+
+
+///<summary>
+///Adds cost of each of five PNG filters (None, Sub, Up, Average, Paeth) on the row to costs.
+///Cost is the sum of absolute values of filtered bytes taken as signed, same metric libpng uses.
+///If there is no previous row zero row is assumed.
+///Costs do not depend on byte order of 16 bit samples.
+///</summary>
+void PngWriter::AddFilterCosts(const uint8_t* row, const uint8_t* prev_row, int row_bytes, int bytes_per_pixel, uint64_t costs[5]) {
+	//Loops are kept separate and branchless so compiler can vectorize each of them
+	uint32_t cost_none = 0;
+	uint32_t cost_sub = 0;
+	uint32_t cost_up = 0;
+	uint32_t cost_avg = 0;
+	uint32_t cost_paeth = 0;
+
+	//None
+	for (int i = 0; i < row_bytes; i++)
+		cost_none += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i]))));
+
+	//Sub
+	for (int i = 0; i < bytes_per_pixel; i++)
+		cost_sub += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i]))));
+	for (int i = bytes_per_pixel; i < row_bytes; i++)
+		cost_sub += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - row[i - bytes_per_pixel]))));
+
+	if (prev_row == NULL) {
+		//Against zero row Up equals None, Average uses half of the left byte and Paeth equals Sub
+		cost_up = cost_none;
+		for (int i = 0; i < bytes_per_pixel; i++)
+			cost_avg += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i]))));
+		for (int i = bytes_per_pixel; i < row_bytes; i++)
+			cost_avg += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - (row[i - bytes_per_pixel] >> 1)))));
+		cost_paeth = cost_sub;
+	}
+	else {
+		//Up
+		for (int i = 0; i < row_bytes; i++)
+			cost_up += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - prev_row[i]))));
+
+		//Average
+		for (int i = 0; i < bytes_per_pixel; i++)
+			cost_avg += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - (prev_row[i] >> 1)))));
+		for (int i = bytes_per_pixel; i < row_bytes; i++)
+			cost_avg += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - ((row[i - bytes_per_pixel] + prev_row[i]) >> 1)))));
+
+		//Paeth, first pixel predictor is the byte above
+		for (int i = 0; i < bytes_per_pixel; i++)
+			cost_paeth += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - prev_row[i]))));
+		for (int i = bytes_per_pixel; i < row_bytes; i++) {
+			int a = row[i - bytes_per_pixel];
+			int b = prev_row[i];
+			int c = prev_row[i - bytes_per_pixel];
+			int pa = std::abs(b - c);
+			int pb = std::abs(a - c);
+			int pc = std::abs(a + b - 2 * c);
+			int predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+			cost_paeth += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i] - predictor))));
+		}
+	}
+
+	costs[0] += cost_none;
+	costs[1] += cost_sub;
+	costs[2] += cost_up;
+	costs[3] += cost_avg;
+	costs[4] += cost_paeth;
+}
+
+
+
 //--------------------------------
 //	ARCHIVED METHODS
 //--------------------------------
@@ -5,8 +5,14 @@
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
 //Third party
 #include "png.h"
+#include "zlib.h"
 //Internal
 #include "ImageBuffer_Byte.h"
 #include "Exceptions.h"
@@ -32,7 +38,7 @@ public:
 	///Advances NextRow by the height of given image.
 	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
 	///</summary>
-	void WriteNextRows(const ImageBuffer_Byte& image);
+	void WriteNextRows(const ImageBufferView_Byte& image) override;
 
 	//--------------------------------
 	//	WHOLE FILE WRITING
@@ -53,7 +59,22 @@ public:
 	/// <param name="image">Image to write.</param>
 	/// <param name="header">PNG header that describes the file.</param>
 	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static void WritePng(std::filesystem::path file_path, const ImageBuffer_Byte& image, PngHeaderInfo header, WarningCallbackData warning_callback_data);
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, PngHeaderInfo header, WarningCallbackData warning_callback_data) {
+		WritePng(file_path, image, header, warning_callback_data, EncoderProfile::EP_BALANCED);
+	}
+
+	/// <summary>
+	/// <para>Static method. Compresses and writes image file to the given path with given encoder profile.</para>
+	/// <para>ImageBuffer parameters should match the header.</para>
+	/// <para>Can throw std::ifstream::failure if failed to open file.</para>
+	/// <para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	/// </summary>
+	/// <param name="file_path">Path to the output file.</param>
+	/// <param name="image">Image to write.</param>
+	/// <param name="header">PNG header that describes the file.</param>
+	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	/// <param name="profile">Encoding speed and file size tradeoff.</param>
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, PngHeaderInfo header, WarningCallbackData warning_callback_data, EncoderProfile profile);
 
 	/// <summary>
 	/// <para>Static method. Compresses and writes image file to the given path.</para>
@@ -64,7 +85,21 @@ public:
 	/// <param name="file_path">Path to the output file.</param>
 	/// <param name="image">Image to write.</param>
 	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	static void WritePng(std::filesystem::path file_path, const ImageBuffer_Byte& image, WarningCallbackData warning_callback_data) {
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, WarningCallbackData warning_callback_data) {
+		WritePng(file_path, image, warning_callback_data, EncoderProfile::EP_BALANCED);
+	}
+
+	/// <summary>
+	/// <para>Static method. Compresses and writes image file to the given path with given encoder profile.</para>
+	/// <para>Image parameters are deducted from the buffer.</para>
+	/// <para>Can throw std::ifstream::failure if failed to open file.</para>
+	/// <para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	/// </summary>
+	/// <param name="file_path">Path to the output file.</param>
+	/// <param name="image">Image to write.</param>
+	/// <param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	/// <param name="profile">Encoding speed and file size tradeoff.</param>
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, WarningCallbackData warning_callback_data, EncoderProfile profile) {
 			//Deducting header
 		PngHeaderInfo header_info(
 			image.GetHeight(),
@@ -73,7 +108,7 @@ public:
 			ImageLayoutToPngLayout(image.GetLayout()),
 			PNG_INTERLACE_NONE
 		);
-		WritePng(file_path, image, header_info, warning_callback_data);
+		WritePng(file_path, image, header_info, warning_callback_data, profile);
 	}
 
 	/// <summary>
@@ -86,7 +121,7 @@ public:
 	/// <param name="file_path">Path to the output file.</param>
 	/// <param name="image">Image to write.</param>
 	/// <param name="header">PNG header that describes the file.</param>
-	static void WritePng(std::filesystem::path file_path, const ImageBuffer_Byte& image, PngHeaderInfo header) {
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image, PngHeaderInfo header) {
 		WarningCallbackData warning_callback(NULL, NULL);
 		WritePng(file_path, image, header, warning_callback);
 	}
@@ -100,7 +135,7 @@ public:
 	/// </summary>
 	/// <param name="file_path">Path to the output file.</param>
 	/// <param name="image">Image to write.</param>
-	static void WritePng(std::filesystem::path file_path, const ImageBuffer_Byte& image) {
+	static void WritePng(std::filesystem::path file_path, const ImageBufferView_Byte& image) {
 		//Deducting header
 		PngHeaderInfo header_info(
 			image.GetHeight(),
@@ -130,7 +165,24 @@ public:
 	///<param name="file_path">Path to the file to be written.</param>
 	///<param name="header">PNG header describing the file.</param>
 	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
-	PngWriter(std::filesystem::path file_path, PngHeaderInfo header, WarningCallbackData warning_callback_data);
+	PngWriter(std::filesystem::path file_path, PngHeaderInfo header, WarningCallbackData warning_callback_data)
+		: PngWriter(file_path, header, warning_callback_data, EncoderProfile::EP_BALANCED) {
+
+	}
+
+	///<summary>
+	///<para>Opens file pointed by file_path and writes the header using given encoder profile.</para>
+	///<para>Fastest profile uses Sub filter only and zlib level 1 with run-length strategy.
+	///Balanced profile picks one filter per band of rows from a few sampled rows, with zlib level 6.
+	///Smallest profile tries all filters on every row with zlib level 9 and biggest zlib memory level.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to write the header.</para>
+	///</summary>
+	///<param name="file_path">Path to the file to be written.</param>
+	///<param name="header">PNG header describing the file.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	///<param name="profile">Encoding speed and file size tradeoff.</param>
+	PngWriter(std::filesystem::path file_path, PngHeaderInfo header, WarningCallbackData warning_callback_data, EncoderProfile profile);
 
 	///<summary>
 	///<para>Opens file pointed by file_path and writes the header.</para>
@@ -164,6 +216,33 @@ protected:
 	/// </summary>
 	bool _is_low_depth_grayscale = false;
 
+	/// <summary>
+	/// Flag that shows if filter is chosen by the writer for each band of rows
+	/// instead of libpng trying all filters on every row.
+	/// </summary>
+	bool _is_sampled_filtering = false;
+
+	/// <summary>
+	/// Copy of the last row passed to the encoder.
+	/// Used as previous row when sampled filtering estimates first row of the next block.
+	/// </summary>
+	std::vector<uint8_t> _last_row;
+
+	/// <summary>
+	/// Row pointers passed to the encoder, kept between calls so writing slices does not allocate.
+	/// </summary>
+	std::vector<png_bytep> _row_pointers;
+
+	/// <summary>
+	/// Number of rows that share one filter in sampled filtering.
+	/// </summary>
+	static constexpr int FILTER_BAND_HEIGHT = 32;
+
+	/// <summary>
+	/// Every FILTER_SAMPLE_STEP-th row of a band is used to estimate filter costs.
+	/// </summary>
+	static constexpr int FILTER_SAMPLE_STEP = 8;
+
 	//--------------------------------
 	//	LIBPNG DATA STRUCTURES
 	//--------------------------------
@@ -190,7 +269,7 @@ protected:
 	/// </summary>
 	/// <param name="image">Input image buffer assumed to be grayscale 8 bit per pixel.</param>
 	/// <param name="bit_depth">Desired bit depth. Possible values are 1, 2, 4.</param>
-	static ImageBuffer_Byte CrushBitDepth(const ImageBuffer_Byte& src_image, int bit_depth);
+	static ImageBuffer_Byte CrushBitDepth(const ImageBufferView_Byte& src_image, int bit_depth);
 	
 	/// <summary>
 	/// Translates Pixel Layout of ImageBuffer to png file layout.
@@ -224,6 +303,29 @@ protected:
 	///</summary>
 	void CleanUp();
 
+	///<summary>
+	///Sets filters and zlib parameters of the encoder for the profile.
+	///</summary>
+	void ApplyEncoderProfile(EncoderProfile profile);
+
+	///<summary>
+	///Writes rows to the encoder in bands, setting filter for each band chosen from sampled rows.
+	///</summary>
+	///<param name="rows">Rows to write.</param>
+	///<param name="num_rows">Number of rows to write.</param>
+	///<param name="first_row_index">Index of the first row in the image.</param>
+	///<param name="row_bytes">Size of a row in bytes.</param>
+	///<param name="bytes_per_pixel">Size of a pixel in bytes.</param>
+	void WriteRowsWithSampledFilters(png_bytepp rows, int num_rows, int first_row_index, int row_bytes, int bytes_per_pixel);
+
+	///<summary>
+	///Adds cost of each of five PNG filters (None, Sub, Up, Average, Paeth) on the row to costs.
+	///Cost is the sum of absolute values of filtered bytes taken as signed, same metric libpng uses.
+	///If there is no previous row zero row is assumed.
+	///Costs do not depend on byte order of 16 bit samples.
+	///</summary>
+	static void AddFilterCosts(const uint8_t* row, const uint8_t* prev_row, int row_bytes, int bytes_per_pixel, uint64_t costs[5]);
+
 	//--------------------------------
 	//	ARCHIVED METHODS
 	//--------------------------------
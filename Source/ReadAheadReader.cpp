@@ -0,0 +1,210 @@
+#include "ReadAheadReader.h"
+
+//--------------------------------
+//	PUBLIC METHODS
+//--------------------------------
+
+///<summary>
+///Reads next block of rows starting at NextRow.
+///Returns resulting bitmap.
+///Advances NextRow by num_lines.
+///If num_lines is bigger than number of rows left reads all available rows.
+///When all rows are already read returns unallocated buffer.
+///<para>Blocks until decode thread has provided required rows.</para>
+///<para>Rethrows exception thrown by the source reader.</para>
+///</summary>
+ImageBuffer_Byte ReadAheadReader::ReadNextRows(int num_rows) {
+
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	//If reading has finished we return unallocated image buffer
+	if (_state == ReaderStates::Finished)
+		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth(), false);
+
+	//If source has failed before we throw again
+	if (_state == ReaderStates::Failed)
+		throw std::runtime_error("Trying to read a file using failed reader object.");
+
+	//Simple argument sanity check
+	if (num_rows <= 0)
+		return ImageBuffer_Byte(_image_info.GetHeight(), _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth(), false);
+
+	//----------------------------------------------------------------------
+	// 2 - Remaining rows calculation
+
+	int actual_num_rows = AdvanceRows(num_rows);
+
+	if (_state == ReaderStates::Ready_Start)
+		_state = ReaderStates::Ready_Continue;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	try {
+		//----------------------------------------------------------------------
+		// 3 - Handing over whole slice
+
+		if (!WaitForSlice(lock))
+			throw std::runtime_error("ReadAheadReader -- source reader has ended before all rows were read.");
+
+		if (_front_slice_offset == 0 && _slices.front().GetHeight() == actual_num_rows) {
+			ImageBuffer_Byte slice(std::move(_slices.front()));
+			_slices.pop_front();
+			_slot_free.notify_one();
+			return slice;
+		}
+
+		//----------------------------------------------------------------------
+		// 4 - Assembling rows from several slices
+
+		ImageBuffer_Byte block(actual_num_rows, _image_info.GetWidth(), _image_info.GetLayout(), _image_info.GetBitDepth());
+		uint8_t** block_rows = block.GetDataPtr();
+		size_t row_size = static_cast<size_t>(block.GetCmpWidth()) * (static_cast<int>(_image_info.GetBitDepth()) / 8);
+
+		int rows_copied = 0;
+		while (rows_copied < actual_num_rows) {
+			if (!WaitForSlice(lock))
+				throw std::runtime_error("ReadAheadReader -- source reader has ended before all rows were read.");
+
+			ImageBuffer_Byte& front = _slices.front();
+			uint8_t** front_rows = front.GetDataPtr();
+			int rows_from_front = std::min(actual_num_rows - rows_copied, front.GetHeight() - _front_slice_offset);
+
+			for (int row = 0; row < rows_from_front; row++)
+				std::memcpy(block_rows[rows_copied + row], front_rows[_front_slice_offset + row], row_size);
+
+			rows_copied += rows_from_front;
+			_front_slice_offset += rows_from_front;
+
+			//Front slice is used up
+			if (_front_slice_offset == front.GetHeight()) {
+				_slices.pop_front();
+				_front_slice_offset = 0;
+				_slot_free.notify_one();
+			}
+		}
+
+		return block;
+	}
+	catch (...) {
+		_state = ReaderStates::Failed;
+		throw;
+	}
+}
+
+
+
+//--------------------------------
+//	PUBLIC CONSTRUCTORS
+//--------------------------------
+
+///<summary>
+///Wraps source reader and starts decode thread.
+///</summary>
+///<param name="source">Reader to read from in the background. Must be in initial state (no rows read).</param>
+///<param name="slice_height">Number of rows read from the source at once.</param>
+///<param name="queue_depth">Maximum number of decoded slices waiting for the consumer.</param>
+ReadAheadReader::ReadAheadReader(ImageReader& source, int slice_height, int queue_depth) :
+	ImageReader(source.GetFilePath()),
+	_source(source),
+	_slice_height(slice_height),
+	_queue_depth(queue_depth) {
+
+	if (slice_height <= 0)
+		throw std::invalid_argument("ReadAheadReader -- slice height must be positive.");
+	if (queue_depth <= 0)
+		throw std::invalid_argument("ReadAheadReader -- queue depth must be positive.");
+	if (source.GetNextRowIndex() != 0)
+		throw std::invalid_argument("ReadAheadReader -- source reader has already started reading.");
+
+	_image_info = source.GetCommonHeader();
+	_icc_profile = source.GetIccProfile();
+
+	//Nothing to read
+	if (source.IsFinished() || _image_info.GetHeight() == 0) {
+		_state = ReaderStates::Finished;
+		return;
+	}
+
+	_state = ReaderStates::Ready_Start;
+	_decode_thread = std::thread(&ReadAheadReader::DecodeLoop, this);
+}
+
+
+
+//--------------------------------
+//	DESTRUCTOR
+//--------------------------------
+
+///<summary>
+///Stops decode thread and waits for it to finish current slice.
+///</summary>
+ReadAheadReader::~ReadAheadReader() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop_requested = true;
+	}
+	_slot_free.notify_all();
+
+	if (_decode_thread.joinable())
+		_decode_thread.join();
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Decode thread procedure.
+///</summary>
+void ReadAheadReader::DecodeLoop() {
+	try {
+		while (!_source.IsFinished()) {
+			//Decoding outside of the lock
+			ImageBuffer_Byte slice = _source.ReadNextRows(_slice_height);
+
+			std::unique_lock<std::mutex> lock(_mutex);
+			_slot_free.wait(lock, [this] { return _stop_requested || static_cast<int>(_slices.size()) < _queue_depth; });
+
+			if (_stop_requested)
+				return;
+
+			if (slice.IsAllocated() && slice.GetHeight() > 0)
+				_slices.push_back(std::move(slice));
+			lock.unlock();
+			_slice_ready.notify_one();
+		}
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_source_exception = std::current_exception();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_source_finished = true;
+	}
+	_slice_ready.notify_one();
+}
+
+
+
+///<summary>
+///Waits until there is a slice in the queue.
+///Returns false if source has no more slices.
+///Rethrows source exception.
+///Expects the lock to be held by the caller.
+///</summary>
+bool ReadAheadReader::WaitForSlice(std::unique_lock<std::mutex>& lock) {
+	_slice_ready.wait(lock, [this] { return !_slices.empty() || _source_finished; });
+
+	if (!_slices.empty())
+		return true;
+
+	if (_source_exception)
+		std::rethrow_exception(_source_exception);
+
+	return false;
+}
@@ -0,0 +1,159 @@
+#pragma once
+//STL
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+//Internal
+#include "ImageReader.h"
+
+///<summary>
+///Asynchronous adaptor for any ImageReader.
+///Dedicated decode thread reads slices from the source reader ahead of the consumer
+///and keeps them in a bounded queue, so decoding of the next slice overlaps with processing of the current one.
+///Consumer pulls rows with the same ReadNextRows contract as any other reader.
+///</summary>
+///<remarks>
+///Source reader is not owned by the adaptor and must outlive it.
+///Source reader must not be used directly while the adaptor exists.
+///
+///When requested number of rows is equal to the read-ahead slice height slices are handed over by move,
+///otherwise rows are copied from queued slices to the output buffer.
+///
+///Exceptions thrown by the source reader on the decode thread are rethrown by ReadNextRows.
+///</remarks>
+class ReadAheadReader : public ImageReader {
+
+public:
+	//--------------------------------
+	//	PUBLIC METHODS
+	//--------------------------------
+
+	///<summary>
+	///Reads next block of rows starting at NextRow.
+	///Returns resulting bitmap.
+	///Advances NextRow by num_lines.
+	///If num_lines is bigger than number of rows left reads all available rows.
+	///When all rows are already read returns unallocated buffer.
+	///<para>Blocks until decode thread has provided required rows.</para>
+	///<para>Rethrows exception thrown by the source reader.</para>
+	///</summary>
+	ImageBuffer_Byte ReadNextRows(int num_rows) override;
+
+	//--------------------------------
+	//	PUBLIC CONSTRUCTORS
+	//--------------------------------
+
+	///<summary>
+	///Wraps source reader and starts decode thread.
+	///</summary>
+	///<param name="source">Reader to read from in the background. Must be in initial state (no rows read).</param>
+	///<param name="slice_height">Number of rows read from the source at once.</param>
+	///<param name="queue_depth">Maximum number of decoded slices waiting for the consumer.</param>
+	ReadAheadReader(ImageReader& source, int slice_height, int queue_depth);
+
+	//--------------------------------
+	//	DELETED COPY/MOVE
+	//--------------------------------
+
+	ReadAheadReader(const ReadAheadReader& other) = delete;
+	ReadAheadReader& operator=(const ReadAheadReader& other) = delete;
+	ReadAheadReader(ReadAheadReader&& other) = delete;
+	ReadAheadReader& operator=(ReadAheadReader&& other) = delete;
+
+	//--------------------------------
+	//	DESTRUCTOR
+	//--------------------------------
+
+	///<summary>
+	///Stops decode thread and waits for it to finish current slice.
+	///</summary>
+	~ReadAheadReader();
+
+private:
+
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	///<summary>
+	///Reader used by the decode thread.
+	///</summary>
+	ImageReader& _source;
+
+	///<summary>
+	///Number of rows read from the source at once.
+	///</summary>
+	int _slice_height;
+
+	///<summary>
+	///Maximum number of decoded slices waiting for the consumer.
+	///</summary>
+	int _queue_depth;
+
+	///<summary>
+	///Decoded slices waiting for the consumer.
+	///</summary>
+	std::deque<ImageBuffer_Byte> _slices;
+
+	///<summary>
+	///Number of rows of the front slice already consumed.
+	///</summary>
+	int _front_slice_offset = 0;
+
+	///<summary>
+	///Set by the decode thread when source has no more rows (or has failed).
+	///</summary>
+	bool _source_finished = false;
+
+	///<summary>
+	///Set by the destructor to stop decode thread.
+	///</summary>
+	bool _stop_requested = false;
+
+	///<summary>
+	///Exception thrown by the source reader on the decode thread.
+	///</summary>
+	std::exception_ptr _source_exception;
+
+	///<summary>
+	///Guards queue and flags.
+	///</summary>
+	std::mutex _mutex;
+
+	///<summary>
+	///Signalled when slice is added to the queue or source has finished.
+	///</summary>
+	std::condition_variable _slice_ready;
+
+	///<summary>
+	///Signalled when slice is taken from the queue or stop was requested.
+	///</summary>
+	std::condition_variable _slot_free;
+
+	///<summary>
+	///Decode thread.
+	///</summary>
+	std::thread _decode_thread;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Decode thread procedure.
+	///</summary>
+	void DecodeLoop();
+
+	///<summary>
+	///Waits until there is a slice in the queue.
+	///Returns false if source has no more slices.
+	///Rethrows source exception.
+	///Expects the lock to be held by the caller.
+	///</summary>
+	bool WaitForSlice(std::unique_lock<std::mutex>& lock);
+};
@@ -0,0 +1,61 @@
+#pragma once
+//STL
+#include <cstddef>
+#include <array>
+#include <vector>
+//Third party
+#include "oneapi/tbb.h"
+
+///<summary>
+///Per-thread scratch memory for row kernels.
+///Each thread gets its own set of growable arrays that are kept between calls,
+///so kernels running inside tbb loops do not allocate temporaries once arrays have grown to the row size.
+///</summary>
+///<remarks>
+///Array returned by Get is valid until the next Get of the same slot on the same thread.
+///Scratch should not be kept across calls that wait for other tbb tasks,
+///since the waiting thread can run another task that uses the same arena.
+///</remarks>
+class ScratchArena {
+public:
+	//--------------------------------
+	//	CONSTANTS
+	//--------------------------------
+
+	/// <summary>
+	/// Number of independent arrays each thread has.
+	/// </summary>
+	static constexpr int NUM_SLOTS = 4;
+
+	//--------------------------------
+	//	PUBLIC METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns scratch array of at least `count` elements for the calling thread. Contents are undefined.
+	/// </summary>
+	/// <param name="slot">Index of the array [0..NUM_SLOTS-1], different slots can be used at the same time.</param>
+	template <typename T>
+	T* Get(int slot, size_t count) {
+		std::vector<std::max_align_t>& storage = _slots.local()[slot];
+		size_t num_units = (count * sizeof(T) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		if (storage.size() < num_units)
+			storage.resize(num_units);
+		return reinterpret_cast<T*>(storage.data());
+	}
+
+	/// <summary>
+	/// Deallocates scratch arrays of all threads.
+	/// Should not be called while other threads use the arena.
+	/// </summary>
+	void Clear() {
+		_slots.clear();
+	}
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	tbb::enumerable_thread_specific<std::array<std::vector<std::max_align_t>, NUM_SLOTS>> _slots; //Arrays of each thread
+};
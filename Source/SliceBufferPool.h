@@ -0,0 +1,133 @@
+#pragma once
+//STL
+#include <vector>
+#include <mutex>
+#include <type_traits>
+#include <stdexcept>
+//Internal
+#include "ImageBuffer.h"
+#include "ImageBuffer_Byte.h"
+
+/// <summary>
+/// Thread-safe pool of image buffers for slice processing.
+/// Released buffers keep their memory and are reshaped on the next Acquire,
+/// so a pipeline that streams slices of similar size stops allocating after the first few slices.
+/// </summary>
+/// <remarks>
+/// TBuffer is one of ImageBuffer specializations or ImageBuffer_Byte.
+/// Pool of ImageBuffer_Byte is bound to a single bit depth given on construction,
+/// released buffers of other bit depth are dropped.
+/// Only buffers passed through Acquire and Release are pooled. Buffers created inside Downscaler or returned by value
+/// are pooled by giving it ImageMemoryPool instead, see its remarks on choosing between the two.
+/// </remarks>
+template <typename TBuffer>
+class SliceBufferPool {
+public:
+	//--------------------------------
+	//	PUBLIC METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Returns allocated buffer of given shape.
+	/// Reuses memory of a previously released buffer if there is one, allocates new buffer otherwise.
+	/// Contents of the buffer are undefined.
+	/// </summary>
+	TBuffer Acquire(int height, int width, ImagePixelLayout layout) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_free.empty()) {
+			lock.unlock();
+			return CreateBuffer(height, width, layout);
+		}
+
+		TBuffer buffer(std::move(_free.back()));
+		_free.pop_back();
+		lock.unlock();
+
+		//Reshaping outside of the lock since it may reallocate
+		buffer.Reshape(height, width, layout);
+		return buffer;
+	}
+
+	/// <summary>
+	/// Returns buffer to the pool.
+	/// Unallocated buffers and buffers over the pool capacity are dropped.
+	/// </summary>
+	void Release(TBuffer&& buffer) {
+		if (!buffer.IsAllocated())
+			return;
+
+		if constexpr (std::is_same_v<TBuffer, ImageBuffer_Byte>)
+			if (buffer.GetBitPerComponent() != _bit_depth)
+				return;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_free.size() < _max_free_buffers)
+			_free.push_back(std::move(buffer));
+	}
+
+	/// <summary>
+	/// Deallocates all buffers kept by the pool.
+	/// </summary>
+	void Clear() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_free.clear();
+	}
+
+	//--------------------------------
+	//	CONSTRUCTORS
+	//--------------------------------
+
+	/// <summary>
+	/// Creates empty pool.
+	/// </summary>
+	/// <param name="max_free_buffers">Maximum number of released buffers kept by the pool.</param>
+	/// <param name="memory">Memory resource for rows of created buffers, null means global heap. Should outlive the pool and its buffers.</param>
+	SliceBufferPool(size_t max_free_buffers, std::pmr::memory_resource* memory = nullptr) requires (!std::is_same_v<TBuffer, ImageBuffer_Byte>) :
+		_max_free_buffers(max_free_buffers),
+		_memory(memory) {
+		if (max_free_buffers == 0)
+			throw std::invalid_argument("SliceBufferPool -- pool capacity must be positive.");
+	}
+
+	/// <summary>
+	/// Creates empty pool of byte buffers with given bit depth.
+	/// </summary>
+	/// <param name="bit_depth">Bit depth of buffers created by the pool.</param>
+	/// <param name="max_free_buffers">Maximum number of released buffers kept by the pool.</param>
+	/// <param name="memory">Memory resource for rows of created buffers, null means global heap. Should outlive the pool and its buffers.</param>
+	SliceBufferPool(BitDepth bit_depth, size_t max_free_buffers, std::pmr::memory_resource* memory = nullptr) requires std::is_same_v<TBuffer, ImageBuffer_Byte> :
+		_max_free_buffers(max_free_buffers),
+		_bit_depth(bit_depth),
+		_memory(memory) {
+		if (max_free_buffers == 0)
+			throw std::invalid_argument("SliceBufferPool -- pool capacity must be positive.");
+	}
+
+	SliceBufferPool(const SliceBufferPool& other) = delete;
+	SliceBufferPool& operator=(const SliceBufferPool& other) = delete;
+
+private:
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	std::vector<TBuffer> _free; //Released buffers
+	size_t _max_free_buffers; //Maximum number of released buffers kept
+	BitDepth _bit_depth = BitDepth::BD_8_BIT; //Bit depth of created buffers (ImageBuffer_Byte only)
+	std::pmr::memory_resource* _memory = nullptr; //Memory resource for rows of created buffers
+	std::mutex _mutex; //Guards the list of released buffers
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	/// <summary>
+	/// Allocates new buffer of given shape.
+	/// </summary>
+	TBuffer CreateBuffer(int height, int width, ImagePixelLayout layout) {
+		if constexpr (std::is_same_v<TBuffer, ImageBuffer_Byte>)
+			return ImageBuffer_Byte(height, width, layout, _bit_depth, true, _memory);
+		else
+			return TBuffer(height, width, layout, true, _memory);
+	}
+};
@@ -6,9 +6,9 @@
 //	IO METHODS
 //--------------------------------
 
-//Opens an image
+//Opens an image with given decode profile
 //Returns image as a reference and writes image info object to given pointer
-ImageBuffer_Byte Tester_Base::OpenImage(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr) {
+ImageBuffer_Byte Tester_Base::OpenImage(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr, DecodeProfile profile) {
 	Stopwatch watch;
 
 	std::cout << tabs(num_tabs) << "Opening \"" << file_path.filename().string() << "\"" << std::endl;
@@ -33,7 +33,8 @@ ImageBuffer_Byte Tester_Base::OpenImage(int num_tabs, std::filesystem::path file
 				JpegReader::ReadJpegFile(
 					file_path, 
 					&header,
-					WarningCallbackData(&JPEGWarningHandler, &warning_args));
+					WarningCallbackData(&JPEGWarningHandler, &warning_args),
+					profile);
 			watch.Stop();
 			std::cout << tabs(num_tabs + 1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
 			Printer::EmptyLine();
@@ -61,7 +62,8 @@ ImageBuffer_Byte Tester_Base::OpenImage(int num_tabs, std::filesystem::path file
 				PngReader::ReadPngFile(
 					file_path, 
 					&header, 
-					WarningCallbackData(&PNGWarningHandler, &warning_args));
+					WarningCallbackData(&PNGWarningHandler, &warning_args),
+					profile);
 			watch.Stop();
 			std::cout << tabs(num_tabs + 1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
 			Printer::EmptyLine();
@@ -91,13 +93,13 @@ ImageBuffer_Byte Tester_Base::OpenImage(int num_tabs, std::filesystem::path file
 
 
 /// <summary>
-/// Opens an image and removes gamma.
+/// Opens an image with given decode profile and removes gamma.
 /// </summary>
-ImageBuffer_uint16 Tester_Base::OpenImageAndRemoveGamma(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr) {
+ImageBuffer_uint16 Tester_Base::OpenImageAndRemoveGamma(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr, DecodeProfile profile) {
 	Stopwatch watch;
 
 	//Reading the image
-	ImageBuffer_Byte corrected_image = OpenImage(num_tabs, file_path, info_ptr);
+	ImageBuffer_Byte corrected_image = OpenImage(num_tabs, file_path, info_ptr, profile);
 
 	//Removing gamma correction (sRGB assumed)
 	std::cout << tabs(num_tabs + 1) << "Removing gamma correction (sRGB assummed)." << std::endl;
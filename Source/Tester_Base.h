@@ -12,6 +12,8 @@
 #include "FixedMath.h"
 #include "JpegReader.h"
 #include "JpegWriter.h"
+#include "JpegTransformer.h"
+#include "ImageProbe.h"
 #include "PngReader.h"
 #include "PngWriter.h"
 //Debug
@@ -34,12 +36,26 @@ public:
 	/// <summary>
 	/// Opens an image.
 	/// </summary>
-	static ImageBuffer_Byte OpenImage(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr);
+	static ImageBuffer_Byte OpenImage(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr) {
+		return OpenImage(num_tabs, file_path, info_ptr, DecodeProfile::DP_STRICT);
+	}
+
+	/// <summary>
+	/// Opens an image with given decode profile.
+	/// </summary>
+	static ImageBuffer_Byte OpenImage(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr, DecodeProfile profile);
 
 	/// <summary>
 	/// Opens an image and removes gamma.
 	/// </summary>
-	static ImageBuffer_uint16 OpenImageAndRemoveGamma(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr);
+	static ImageBuffer_uint16 OpenImageAndRemoveGamma(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr) {
+		return OpenImageAndRemoveGamma(num_tabs, file_path, info_ptr, DecodeProfile::DP_STRICT);
+	}
+
+	/// <summary>
+	/// Opens an image with given decode profile and removes gamma.
+	/// </summary>
+	static ImageBuffer_uint16 OpenImageAndRemoveGamma(int num_tabs, std::filesystem::path file_path, ImageFileInfo* info_ptr, DecodeProfile profile);
 
 	/// <summary>
 	/// Writes image at given path.
@@ -3,6 +3,10 @@
 #include "Tester_Base.h"
 #include "GammaDispatcher.h"
 #include "Downscaler.h"
+#include "ImageMemoryPool.h"
+#include "ReadAheadReader.h"
+#include "WriteBehindWriter.h"
+#include "MetadataReader.h"
 
 class Tester_DS : Tester_Base {
 public:
@@ -48,30 +52,31 @@ public:
 
 		// Allocating result
 		ImageBuffer_uint16 trg_image(0, new_width, src_image.GetLayout(), true);
+		trg_image.ReserveRows(static_cast<int>(new_height));
 		
 		// Downscaling slices
 		watch.Start();
 		watch.Pause();
 		for (int slc = 0; slc < num_slices; slc++) {
 			std::cout << tabs(2) << "Slice [" << slc << "]: ";
-			ImageBuffer_uint16 src_slice = src_image.GetSlice(slc * slice_height, slice_height);
+			ImageBufferView_uint16 src_slice = src_image.GetRowsView(slc * slice_height, slice_height);
 			std::cout << src_slice.GetHeight() << "px --> ";
 			watch.Continue();
 			ImageBuffer_uint16 res_slice = scaler.DownscaleNext(src_slice);
 			watch.Pause();
-			trg_image.Append(res_slice);
 			std::cout << res_slice.GetHeight() << "px | Done! Elapsed time: " << watch.segment_string() << std::endl;
+			trg_image.Append(std::move(res_slice));
 		}
 		// Last slice
 		if (remainder_height > 0) {
 			std::cout << tabs(2) << "Remainder slice: ";
-			ImageBuffer_uint16 src_slice = src_image.GetSlice(num_slices * slice_height, remainder_height);
+			ImageBufferView_uint16 src_slice = src_image.GetRowsView(num_slices * slice_height, remainder_height);
 			std::cout << src_slice.GetHeight() << "px --> ";
 			watch.Continue();
 			ImageBuffer_uint16 res_slice = scaler.DownscaleNext(src_slice);
 			watch.Pause();
-			trg_image.Append(res_slice);
 			std::cout << src_slice.GetHeight() << " --> " << res_slice.GetHeight() << "px | Done! Elapsed time: " << watch.segment_string() << std::endl;
+			trg_image.Append(std::move(res_slice));
 		}
 		watch.Stop();
 		Printer::EmptyLine();
@@ -109,6 +114,398 @@ public:
 
 
 
+	/// <summary>
+	/// Reads reduced resolution version of the image (embedded preview, early Adam7 passes or early progressive JPEG scans),
+	/// downscales it to the target size in upright orientation and writes the result.
+	/// </summary>
+	static void Test_DownscaleReduced(double factor, std::string file_path) {
+		Stopwatch watch;
 
-};
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+		//Creating file folder for output
+		std::filesystem::path out_dir_path = CreateOutputFolder("Test_DownscaleReduced");
+
+		//Path for output file
+		std::filesystem::path out_file_path(out_dir_path);
+		out_file_path.replace_filename(in_file_path.filename());
+		out_file_path = AddAppendixToFilename(out_file_path, "_downscaled_reduced");
+
+		//Intro
+		std::cout << "Reading reduced resolution image and downscaling it." << std::endl;
+		std::cout << "\tFile path is:" << std::endl;
+		std::cout << "\t\t" << in_file_path << std::endl;
+		std::cout << std::endl;
+
+		if (factor > 1.0 || factor <= 0.0)
+			factor = 1.0;
+
+		int warning_args = 2;
+		WarningCallbackData warning_data(nullptr, &warning_args);
+		FileFormat format = GetImageTypeByExpension(in_file_path);
+
+		// Reading full size from the header
+		ImageBufferInfo full_info;
+		if (format == FileFormat::FF_JPEG) {
+			warning_data.warningCallback = JPEGWarningHandler;
+			full_info = JpegReader(in_file_path, warning_data).GetCommonHeader();
+		}
+		else if (format == FileFormat::FF_PNG) {
+			warning_data.warningCallback = PNGWarningHandler;
+			full_info = PngReader(in_file_path, warning_data).GetCommonHeader();
+		}
+		else
+			throw std::runtime_error("Trying to read image file of unknown type.");
+
+		uint32_t new_height = static_cast<uint32_t>(factor * static_cast<double>(full_info.GetHeight()));
+		uint32_t new_width = static_cast<uint32_t>(factor * static_cast<double>(full_info.GetWidth()));
+
+		// Reading reduced image
+		std::cout << tabs(1) << "Reading reduced image for target size [" << new_height << "x" << new_width << "]" << std::endl;
+		JpegHeaderInfo jpeg_header;
+		PngHeaderInfo png_header;
+		watch.Start();
+		// Embedded preview is the cheapest source if it is big enough
+		ImageBuffer_Byte reduced_image(0, 0, full_info.GetLayout(), full_info.GetBitDepth(), false);
+		MetadataReader metadata(in_file_path);
+		if (metadata.ReadPreview(new_height, new_width, full_info.GetHeight(), full_info.GetWidth(), reduced_image, warning_data)) {
+			std::cout << tabs(1) << "Using embedded preview." << std::endl;
+			if (format == FileFormat::FF_JPEG)
+				jpeg_header = JpegReader(in_file_path, warning_data).GetJpegHeader();
+			else
+				png_header = PngReader(in_file_path, warning_data).GetPngHeader();
+		}
+		else if (format == FileFormat::FF_JPEG)
+			reduced_image = JpegReader::ReadJpegFileReduced(in_file_path, new_height, new_width, &jpeg_header, warning_data);
+		else
+			reduced_image = PngReader::ReadPngFileReduced(in_file_path, new_height, new_width, &png_header, warning_data);
+		watch.Stop();
+		std::cout << tabs(1) << "Done! Full size [" << full_info.GetHeight() << "x" << full_info.GetWidth() << "], reduced size ["
+			<< reduced_image.GetHeight() << "x" << reduced_image.GetWidth() << "]. Elapsed time: " << watch.elapsed_string() << std::endl;
+		Printer::EmptyLine();
+
+		// Removing gamma and downscaling
+		GammaConverter* gc = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, nullptr);
+		ImageBuffer_uint16 linear_image = gc->RemoveGammaCorrection(reduced_image);
+
+		std::cout << tabs(1) << "Downscaling reduced image:" << std::endl;
+		watch.Start();
+		// Rotating to upright orientation at output resolution
+		ExifOrientation orientation = metadata.GetOrientation();
+		uint32_t out_height = orientation >= ExifOrientation::EO_TRANSPOSE ? new_width : new_height;
+		uint32_t out_width = orientation >= ExifOrientation::EO_TRANSPOSE ? new_height : new_width;
+		std::cout << tabs(1) << "EXIF orientation: " << static_cast<int>(orientation) << std::endl;
+		Downscaler scaler(linear_image.GetLayout(), linear_image.GetHeight(), linear_image.GetWidth(), out_height, out_width, orientation);
+		ImageBuffer_uint16 trg_image = scaler.DownscaleNext(linear_image);
+		watch.Stop();
+		std::cout << tabs(1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
+		Printer::EmptyLine();
+
+		// Writing the result
+		if (format == FileFormat::FF_JPEG) {
+			JpegHeaderInfo out_header(out_height, out_width, jpeg_header.GetNumComponents(), jpeg_header.GetColorSpace());
+			ImageFileInfo out_finfo(out_file_path, out_header);
+			ApplyGammaAndWriteImage(1, trg_image, out_finfo);
+		}
+		else {
+			PngHeaderInfo out_header(out_height, out_width, png_header.GetBitDepth(), png_header.GetPngColorType(), PNG_INTERLACE_NONE);
+			ImageFileInfo out_finfo(out_file_path, out_header);
+			ApplyGammaAndWriteImage(1, trg_image, out_finfo);
+		}
+	}
+
+
+	/// <summary>
+	/// Downscales the image slice by slice several times with downscaler and resulting slices allocated from shared memory pool.
+	/// Prints number of heap allocations made by the pool after each pass, it should not grow after the first pass.
+	/// </summary>
+	static void Test_DownscalePooled(int slice_height, double factor, int passes, std::string file_path) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+
+		//Intro
+		std::cout << "Downscaling image slice by slice with pooled memory." << std::endl;
+		std::cout << "\tFile path is:" << std::endl;
+		std::cout << "\t\t" << in_file_path << std::endl;
+		std::cout << std::endl;
+
+		// Reading original image
+		ImageFileInfo in_finfo(FileFormat::FF_UNSUPPORTED);
+		ImageBuffer_uint16 src_image = OpenImageAndRemoveGamma(1, in_file_path, &in_finfo);
+
+		if (factor > 1.0 || factor <= 0.0)
+			factor = 1.0;
+		uint32_t new_height = static_cast<uint32_t>(factor * static_cast<double>(src_image.GetHeight()));
+		uint32_t new_width = static_cast<uint32_t>(factor * static_cast<double>(src_image.GetWidth()));
+
+		ImageMemoryPool pool;
+		for (int pass = 0; pass < passes; pass++) {
+			watch.Start();
+			Downscaler scaler(src_image.GetLayout(), src_image.GetHeight(), src_image.GetWidth(), new_height, new_width, ExifOrientation::EO_NORMAL, &pool);
+			int rows_done = 0;
+			for (int pos = 0; pos < src_image.GetHeight(); pos += slice_height) {
+				//Resulting slice is dropped at once and its rows return to the pool
+				ImageBuffer_uint16 res_slice = scaler.DownscaleNext(src_image.GetRowsView(pos, slice_height));
+				rows_done += res_slice.GetHeight();
+			}
+			watch.Stop();
+			std::cout << tabs(1) << "Pass " << pass << ": " << rows_done << " rows, elapsed time " << watch.elapsed_string();
+			std::cout << ", heap allocations by the pool so far: " << pool.GetUpstreamAllocationCount() << std::endl;
+		}
+		Printer::EmptyLine();
+	}
+
+
+
+	/// <summary>
+	/// Accumulates synthetic slices in one image by appending them one after another.
+	/// Checks that row array is reallocated only a logarithmic number of times, that moved rows are taken without copying
+	/// and keep their data, that copied slices match and that rows added past the end are black.
+	/// </summary>
+	static void Test_AppendSlices(int slice_height, int num_slices, int width) {
+		std::cout << "Appending " << num_slices << " slices of " << slice_height << " rows to one image." << std::endl;
 
+		//Sample value depending on image row and component
+		auto sample_value = [](int row, int cmp) { return static_cast<uint16_t>((row * 31 + cmp * 7) % 65536); };
+
+		ImageBuffer_uint16 image(0, width, ImagePixelLayout::RGB);
+		int cmp_width = image.GetCmpWidth();
+		int reallocations = 0;
+		int moved_rows = 0;
+
+		// 1 - Moving slices in
+		for (int slice_index = 0; slice_index < num_slices; slice_index++) {
+			int first_row = image.GetHeight();
+			ImageBuffer_uint16 slice(slice_height, width, ImagePixelLayout::RGB);
+			std::vector<uint16_t*> slice_rows(slice_height);
+			for (int row = 0; row < slice_height; row++) {
+				slice_rows[row] = slice.GetDataPtr()[row];
+				for (int cmp = 0; cmp < cmp_width; cmp++)
+					slice[row][cmp] = sample_value(first_row + row, cmp);
+			}
+
+			uint16_t** row_array = image.GetDataPtr();
+			image.Append(std::move(slice));
+			if (image.GetDataPtr() != row_array)
+				reallocations++;
+			for (int row = 0; row < slice_height; row++)
+				if (image.GetDataPtr()[first_row + row] == slice_rows[row])
+					moved_rows++;
+		}
+
+		// 2 - Copying one more slice and adding rows past the end
+		int copied_first_row = image.GetHeight();
+		ImageBuffer_uint16 copied_slice(slice_height, width, ImagePixelLayout::RGB);
+		for (int row = 0; row < slice_height; row++)
+			for (int cmp = 0; cmp < cmp_width; cmp++)
+				copied_slice[row][cmp] = sample_value(copied_first_row + row, cmp);
+		image.Append(copied_slice);
+
+		int blank_first_row = image.GetHeight();
+		int blank_rows = slice_height;
+		image.InsertAtLine(copied_slice, blank_first_row + blank_rows);
+
+		// 3 - Checking
+		int total_rows = slice_height * num_slices;
+		int max_reallocations = static_cast<int>(std::bit_width(static_cast<unsigned int>(image.GetHeight()))) + 1;
+		std::cout << tabs(1) << "Row array reallocated " << reallocations << " times for " << num_slices << " appends";
+		std::cout << (reallocations <= max_reallocations ? "." : ", FAILED: growth is not geometric.") << std::endl;
+		std::cout << tabs(1) << moved_rows << " of " << total_rows << " rows moved without copying";
+		std::cout << (moved_rows == total_rows ? "." : ", FAILED.") << std::endl;
+
+		int wrong_rows = 0;
+		for (int row = 0; row < blank_first_row; row++)
+			for (int cmp = 0; cmp < cmp_width; cmp++)
+				if (image[row][cmp] != sample_value(row, cmp)) {
+					wrong_rows++;
+					break;
+				}
+		for (int row = blank_first_row; row < blank_first_row + blank_rows; row++)
+			for (int cmp = 0; cmp < cmp_width; cmp++)
+				if (image[row][cmp] != 0) {
+					wrong_rows++;
+					break;
+				}
+		if (wrong_rows == 0)
+			std::cout << tabs(1) << "Image data match." << std::endl;
+		else
+			std::cout << tabs(1) << "FAILED: " << wrong_rows << " rows do not match." << std::endl;
+		Printer::EmptyLine();
+	}
+
+
+
+	/// <summary>
+	/// Streams JPEG file through reader, gamma removal, downscaler, gamma application and writer slice by slice,
+	/// first with plain reader and writer, then with read-ahead and write-behind adaptors around them.
+	/// Prints time of each chain and checks that both written files are identical.
+	/// </summary>
+	static void Test_DownscaleStreamed(int slice_height, double factor, int queue_depth, std::string file_path) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+		//Creating file folder for output
+		std::filesystem::path out_dir_path = CreateOutputFolder("Test_DownscaleStreamed");
+
+		//Paths for output files
+		std::filesystem::path sync_file_path(out_dir_path);
+		sync_file_path.replace_filename(in_file_path.filename());
+		std::filesystem::path async_file_path = AddAppendixToFilename(sync_file_path, "_async");
+		sync_file_path = AddAppendixToFilename(sync_file_path, "_sync");
+
+		//Intro
+		std::cout << "Streaming JPEG image through downscaler with slice height of " << slice_height << " rows and queue depth of " << queue_depth << "." << std::endl;
+		std::cout << "\tFile path is:" << std::endl;
+		std::cout << "\t\t" << in_file_path << std::endl;
+		std::cout << std::endl;
+
+		if (IsJpeg_ByExtension(in_file_path) == false) {
+			std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+			return;
+		}
+
+		if (factor > 1.0 || factor <= 0.0)
+			factor = 1.0;
+
+		try {
+			// 1 - Plain reader and writer
+			{
+				watch.Start();
+				JpegReader reader(in_file_path);
+				JpegWriter writer = CreateStreamedWriter(reader, factor, sync_file_path);
+				DownscaleStream(reader, writer, slice_height, factor);
+				watch.Stop();
+				std::cout << tabs(1) << "Synchronous chain: " << watch.elapsed_string() << std::endl;
+			}
+
+			// 2 - Read-ahead and write-behind adaptors
+			{
+				watch.Start();
+				JpegReader reader(in_file_path);
+				JpegWriter writer = CreateStreamedWriter(reader, factor, async_file_path);
+				ReadAheadReader read_ahead(reader, slice_height, queue_depth);
+				WriteBehindWriter write_behind(writer, queue_depth);
+				DownscaleStream(read_ahead, write_behind, slice_height, factor);
+				write_behind.Finish();
+				watch.Stop();
+				std::cout << tabs(1) << "Asynchronous chain: " << watch.elapsed_string() << std::endl;
+			}
+		}
+		catch (std::ifstream::failure e) {
+			std::cout << e.what() << std::endl;
+			return;
+		}
+		catch (codec_fatal_exception e) {
+			std::cout << e.GetFullMessage() << std::endl;
+			return;
+		}
+
+		// 3 - Comparing written files
+		std::ifstream sync_stream(sync_file_path, std::ios::binary);
+		std::ifstream async_stream(async_file_path, std::ios::binary);
+		std::vector<char> sync_data((std::istreambuf_iterator<char>(sync_stream)), std::istreambuf_iterator<char>());
+		std::vector<char> async_data((std::istreambuf_iterator<char>(async_stream)), std::istreambuf_iterator<char>());
+		if (sync_data == async_data)
+			std::cout << tabs(1) << "Output files match (" << sync_data.size() << " bytes)." << std::endl;
+		else
+			std::cout << tabs(1) << "FAILED: Output files do not match." << std::endl;
+		Printer::EmptyLine();
+	}
+
+
+
+	/// <summary>
+	/// Reads JPEG component planes at native resolution, downscales each plane and writes them back without color conversion.
+	/// </summary>
+	static void Test_DownscalePlanar(double factor, std::string file_path) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+		//Creating file folder for output
+		std::filesystem::path out_dir_path = CreateOutputFolder("Test_DownscalePlanar");
+
+		//Path for output file
+		std::filesystem::path out_file_path(out_dir_path);
+		out_file_path.replace_filename(in_file_path.filename());
+		out_file_path = AddAppendixToFilename(out_file_path, "_downscaled_planar");
+
+		//Intro
+		std::cout << "Downscaling JPEG component planes." << std::endl;
+		std::cout << "\tFile path is:" << std::endl;
+		std::cout << "\t\t" << in_file_path << std::endl;
+		std::cout << std::endl;
+
+		if (factor > 1.0 || factor <= 0.0)
+			factor = 1.0;
+
+		int warning_args = 2;
+		WarningCallbackData warning_data(JPEGWarningHandler, &warning_args);
+
+		// Reading planes
+		std::cout << tabs(1) << "Reading planes:" << std::endl;
+		watch.Start();
+		JpegHeaderInfo jpeg_header;
+		JpegPlanarImage src_image = JpegReader::ReadJpegFilePlanar(in_file_path, &jpeg_header, warning_data);
+		watch.Stop();
+		std::cout << tabs(1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
+		for (int ci = 0; ci < src_image.GetNumComponents(); ci++)
+			std::cout << tabs(2) << "Plane " << ci << " [" << src_image.GetPlane(ci).GetHeight() << "x" << src_image.GetPlane(ci).GetWidth() << "]" << std::endl;
+		Printer::EmptyLine();
+
+		int new_height = std::max(1, static_cast<int>(factor * static_cast<double>(src_image.GetHeight())));
+		int new_width = std::max(1, static_cast<int>(factor * static_cast<double>(src_image.GetWidth())));
+
+		// Downscaling planes
+		std::cout << tabs(1) << "Downscaling to [" << new_height << "x" << new_width << "]:" << std::endl;
+		watch.Start();
+		JpegPlanarImage trg_image = src_image.Downscale(new_height, new_width);
+		watch.Stop();
+		std::cout << tabs(1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
+		Printer::EmptyLine();
+
+		// Writing planes
+		std::cout << tabs(1) << "Writing planes:" << std::endl;
+		watch.Start();
+		JpegWriter::WriteJpegPlanar(out_file_path, trg_image, 95, warning_data);
+		watch.Stop();
+		std::cout << tabs(1) << "Done! Elapsed time: " << watch.elapsed_string() << std::endl;
+		Printer::EmptyLine();
+	}
+
+
+private:
+	/// <summary>
+	/// Creates JPEG writer for the downscaled image read by given reader.
+	/// </summary>
+	static JpegWriter CreateStreamedWriter(JpegReader& reader, double factor, std::filesystem::path out_file_path) {
+		JpegHeaderInfo in_header = reader.GetJpegHeader();
+		uint32_t new_height = static_cast<uint32_t>(factor * static_cast<double>(in_header.GetHeight()));
+		uint32_t new_width = static_cast<uint32_t>(factor * static_cast<double>(in_header.GetWidth()));
+		JpegHeaderInfo out_header(new_height, new_width, in_header.GetNumComponents(), in_header.GetColorSpace());
+		return JpegWriter(out_file_path, out_header, 95, WarningCallbackData(NULL, NULL));
+	}
+
+	/// <summary>
+	/// Reads all rows of the reader slice by slice, downscales them in linear light and passes resulting slices to the writer.
+	/// </summary>
+	template <typename TWriter>
+	static void DownscaleStream(ImageReader& reader, TWriter& writer, int slice_height, double factor) {
+		ImageBufferInfo info = reader.GetCommonHeader();
+		uint32_t new_height = static_cast<uint32_t>(factor * static_cast<double>(info.GetHeight()));
+		uint32_t new_width = static_cast<uint32_t>(factor * static_cast<double>(info.GetWidth()));
+
+		GammaConverter* gc = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, nullptr);
+		Downscaler scaler(info.GetLayout(), info.GetHeight(), info.GetWidth(), new_height, new_width);
+
+		for (int pos = 0; pos < info.GetHeight(); pos += slice_height) {
+			ImageBuffer_Byte src_slice = reader.ReadNextRows(slice_height);
+			ImageBuffer_uint16 res_slice = scaler.DownscaleNext(gc->RemoveGammaCorrection(src_slice));
+			if (res_slice.GetHeight() > 0)
+				writer.WriteNextRows(gc->ApplyGammaCorrection(res_slice, BitDepth::BD_8_BIT));
+		}
+	}
+};
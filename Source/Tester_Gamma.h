@@ -1,8 +1,12 @@
 #pragma once
 
+#include <random>
 #include "Tester_Base.h"
 #include "GammaConverter.h"
 #include "GammaDispatcher.h"
+#include "GammaSliceConverter.h"
+#include "FloatGammaConverter.h"
+#include "Downscaler.h"
 #include "ImageBufferPrinter.h"
 
 class Tester_Gamma : Tester_Base{
@@ -68,4 +72,333 @@ public:
 
 
 
+	/// <summary>
+	/// Measures time of gamma removal and 8 and 16 bit gamma application for sRGB image.
+	/// </summary>
+	static void BenchmarkSRGBConversion(std::string file_path, int iterations) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+
+		std::cout << "Benchmarking SRGB conversion, " << iterations << " iterations." << std::endl;
+
+		if (iterations < 1)
+			iterations = 1;
+
+		//Opening the image
+		ImageFileInfo src_image_info(FileFormat::FF_UNSUPPORTED); //Will be rewritten
+		ImageBuffer_Byte src_image = OpenImage(1, in_file_path, &src_image_info);
+
+		//Producing srgb gamma converter
+		GammaConverter* gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL);
+
+		//Tables are built outside of measured loops
+		ImageBuffer_uint16 lin_image = gconv->RemoveGammaCorrection(src_image);
+		ImageBuffer_Byte trg_image_8 = gconv->ApplyGammaCorrection(lin_image, BitDepth::BD_8_BIT);
+		ImageBuffer_Byte trg_image_16 = gconv->ApplyGammaCorrection(lin_image, BitDepth::BD_16_BIT);
+
+		watch.Start();
+		for (int i = 0; i < iterations; i++)
+			gconv->RemoveGammaCorrectionInto(src_image, lin_image);
+		watch.Stop();
+		std::cout << tabs(1) << "To linear: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		watch.Start();
+		for (int i = 0; i < iterations; i++)
+			gconv->ApplyGammaCorrectionInto(lin_image, BitDepth::BD_8_BIT, trg_image_8);
+		watch.Stop();
+		std::cout << tabs(1) << "To sRGB 8 bit: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		watch.Start();
+		for (int i = 0; i < iterations; i++)
+			gconv->ApplyGammaCorrectionInto(lin_image, BitDepth::BD_16_BIT, trg_image_16);
+		watch.Stop();
+		std::cout << tabs(1) << "To sRGB 16 bit: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		watch.Start();
+		for (int i = 0; i < iterations; i++)
+			gconv->RemoveGammaCorrectionInto(trg_image_16, lin_image);
+		watch.Stop();
+		std::cout << tabs(1) << "To linear from 16 bit: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+	}
+
+
+
+	/// <summary>
+	/// Measures time of grayscale conversion done in three passes (linearization, layout change, gamma application)
+	/// and with fused single pass conversion.
+	/// </summary>
+	static void BenchmarkGrayscaleConversion(std::string file_path, int iterations) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+
+		std::cout << "Benchmarking grayscale conversion, " << iterations << " iterations." << std::endl;
+
+		if (iterations < 1)
+			iterations = 1;
+
+		//Opening the image
+		ImageFileInfo src_image_info(FileFormat::FF_UNSUPPORTED); //Will be rewritten
+		ImageBuffer_Byte src_image = OpenImage(1, in_file_path, &src_image_info);
+		int height = src_image.GetHeight();
+		int width = src_image.GetWidth();
+
+		GammaConverter* gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL);
+		gconv->InitializeTables();
+
+		watch.Start();
+		for (int i = 0; i < iterations; i++) {
+			ImageBuffer_uint16 lin_image = gconv->RemoveGammaCorrection(src_image);
+			ImageBuffer_uint16 lin_gray = lin_image.TransformBuffer(height, width, ImagePixelLayout::G);
+			ImageBuffer_Byte trg_image = gconv->ApplyGammaCorrection(lin_gray, BitDepth::BD_8_BIT);
+		}
+		watch.Stop();
+		std::cout << tabs(1) << "Three passes: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		ImageBuffer_Byte trg_image(0, width, ImagePixelLayout::G, BitDepth::BD_8_BIT, false);
+		watch.Start();
+		for (int i = 0; i < iterations; i++)
+			gconv->ConvertLayoutInto(src_image, ImagePixelLayout::G, BitDepth::BD_8_BIT, trg_image);
+		watch.Stop();
+		std::cout << tabs(1) << "Fused: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+	}
+
+
+
+	/// <summary>
+	/// Compares table based linearization to 16 bit with approximated float linearization.
+	/// Both paths convert the image to linear brightness and back, resulting images should be the same.
+	/// </summary>
+	static void BenchmarkFloatConversion(std::string file_path, int iterations) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+
+		std::cout << "Benchmarking float gamma conversion, " << iterations << " iterations." << std::endl;
+
+		if (iterations < 1)
+			iterations = 1;
+
+		//Opening the image
+		ImageFileInfo src_image_info(FileFormat::FF_UNSUPPORTED); //Will be rewritten
+		ImageBuffer_Byte src_image = OpenImage(1, in_file_path, &src_image_info);
+		BitDepth bit_depth = src_image.GetBitPerComponent();
+
+		GammaConverter* gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL);
+		gconv->InitializeTables();
+
+		ImageBuffer_uint16 lin_image;
+		ImageBuffer_Byte table_image(0, 0, src_image.GetLayout(), bit_depth, false);
+		watch.Start();
+		for (int i = 0; i < iterations; i++) {
+			gconv->RemoveGammaCorrectionInto(src_image, lin_image);
+			gconv->ApplyGammaCorrectionInto(lin_image, bit_depth, table_image);
+		}
+		watch.Stop();
+		std::cout << tabs(1) << "Tables, 16 bit linear: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		FloatGammaConverter fconv;
+		ImageBuffer_float lin_image_float;
+		ImageBuffer_Byte float_image(0, 0, src_image.GetLayout(), bit_depth, false);
+		watch.Start();
+		for (int i = 0; i < iterations; i++) {
+			fconv.RemoveGammaCorrectionInto(src_image, lin_image_float);
+			fconv.ApplyGammaCorrectionInto(lin_image_float, bit_depth, float_image);
+		}
+		watch.Stop();
+		std::cout << tabs(1) << "Approximation, float linear: " << watch.elapsed_microseconds() / iterations << " us." << std::endl;
+
+		//Comparing with the source
+		int mismatched_rows = 0;
+		int row_length = src_image.GetWidth() * src_image.GetNumCmp() * (bit_depth == BitDepth::BD_8_BIT ? 1 : 2);
+		for (int row = 0; row < src_image.GetHeight(); row++)
+			if (std::memcmp(src_image.GetDataPtr()[row], float_image.GetDataPtr()[row], row_length) != 0)
+				mismatched_rows++;
+		std::cout << tabs(1) << "Rows changed by float round trip: " << mismatched_rows << std::endl;
+	}
+
+
+
+	/// <summary>
+	/// Downscales PNG image reading, linearizing, downscaling, converting back and writing it slice by slice,
+	/// so memory use is bounded by slice size and does not depend on image size.
+	/// </summary>
+	static void TestSlicedLinearization(std::string file_path, int slice_height, double factor) {
+		Stopwatch watch;
+
+		//Creating file path object
+		std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+		//Creating file folder for output
+		std::filesystem::path out_dir_path = CreateOutputFolder("TestSlicedLinearization");
+
+		//Path for output file
+		std::filesystem::path out_file_path(out_dir_path);
+		out_file_path.replace_filename(in_file_path.filename());
+		out_file_path = AddAppendixToFilename(out_file_path, "_sliced_linear");
+
+		std::cout << "Downscaling PNG image in linear colorspace slice by slice with slice height of " << slice_height << " rows." << std::endl;
+
+		if (slice_height < 1)
+			slice_height = 1;
+		if (factor > 1.0 || factor <= 0.0)
+			factor = 1.0;
+
+		watch.Start();
+
+		//Opening the image
+		PngReader reader(in_file_path);
+		PngHeaderInfo in_header = reader.GetPngHeader();
+		ImageBufferInfo info = reader.GetCommonHeader();
+		uint32_t new_height = std::max(1u, static_cast<uint32_t>(factor * info.GetHeight()));
+		uint32_t new_width = std::max(1u, static_cast<uint32_t>(factor * info.GetWidth()));
+
+		//Pipeline stages
+		//Tone curve of embedded ICC profile is used if there is one, otherwise sRGB is assumed
+		std::vector<uint8_t> icc_profile = reader.GetIccProfile();
+		GammaConverter* gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::IccProfile, &icc_profile);
+		if (gconv == NULL)
+			gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL);
+		std::cout << tabs(1) << (icc_profile.empty() ? "No ICC profile" : "ICC profile") << ", using " << (gconv == GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL) ? "sRGB" : "ICC") << " tone curve." << std::endl;
+		GammaSliceConverter remover(gconv, GammaSliceDirection::GSD_REMOVE, info.GetLayout(), info.GetBitDepth(), info.GetHeight(), info.GetWidth());
+		Downscaler scaler(info.GetLayout(), info.GetHeight(), info.GetWidth(), new_height, new_width);
+		GammaSliceConverter applier(gconv, GammaSliceDirection::GSD_APPLY, info.GetLayout(), info.GetBitDepth(), new_height, new_width);
+
+		PngHeaderInfo out_header(new_height, new_width, in_header.GetBitDepth(), in_header.GetPngColorType(), PNG_INTERLACE_NONE);
+		PngWriter writer(out_file_path, out_header);
+
+		//Slice buffers are reused by every stage
+		ImageBuffer_Byte src_slice(0, info.GetWidth(), info.GetLayout(), info.GetBitDepth(), false);
+		ImageBuffer_uint16 linear_slice(0, info.GetWidth(), info.GetLayout(), false);
+		ImageBuffer_uint16 downscaled_slice(0, new_width, info.GetLayout(), false);
+		ImageBuffer_Byte trg_slice(0, new_width, info.GetLayout(), info.GetBitDepth(), false);
+
+		int num_slices = 0;
+		while (reader.RowsLeftToRead() > 0) {
+			reader.ReadNextRowsInto(slice_height, src_slice);
+			remover.RemoveNextInto(src_slice, linear_slice);
+			scaler.DownscaleNextInto(linear_slice, downscaled_slice);
+			if (downscaled_slice.GetHeight() > 0) {
+				applier.ApplyNextInto(downscaled_slice, trg_slice);
+				writer.WriteNextRows(trg_slice);
+			}
+			num_slices++;
+		}
+
+		watch.Stop();
+		std::cout << tabs(1) << "Done in " << num_slices << " slices! Elapsed time: " << watch.elapsed_string() << std::endl;
+		std::cout << tabs(1) << "Resulting image size [HxW]: " << new_height << "x" << new_width << ", rows written: " << applier.GetRowsConverted() << std::endl;
+	}
+
+
+
+	//--------------------------------
+	//	ROW KERNEL TESTER
+	//--------------------------------
+
+	/// <summary>
+	/// Compares AVX2 row kernels with scalar ones on random rows of every width up to 64 and a few long odd widths,
+	/// starting at unaligned positions, so both the 8 sample steps and the scalar tails are covered.
+	/// 16 bit lookup is tested with random table, including the last table index that AVX2 kernel masks out of the gather,
+	/// and in place. Compact 8 bit lookup is tested with random compact table and with sRGB tables against the full table.
+	/// </summary>
+	static void TestRowKernels(int iterations) {
+		std::cout << "Testing AVX2 row kernels against scalar kernels, " << iterations << " iterations." << std::endl;
+		if (!GammaConverter::HAS_AVX2) {
+			std::cout << tabs(1) << "Abort: Processor does not support AVX2." << std::endl;
+			return;
+		}
+
+		std::mt19937 rng(12345);
+		std::uniform_int_distribution<int> sample(0, MAX_16BIT);
+
+		//Random tables. Compact entries hold base output up to 254 and threshold up to 65536.
+		std::vector<uint16_t> table(WIDTH_16BIT);
+		for (uint16_t& value : table)
+			value = static_cast<uint16_t>(sample(rng));
+		std::vector<uint32_t> random_compact(GammaConverter::COMPACT_TABLE_WIDTH);
+		for (uint32_t& entry : random_compact)
+			entry = static_cast<uint32_t>(sample(rng) % 255) | (static_cast<uint32_t>(sample(rng) + 1) << 8);
+
+		//sRGB compact table and full table filled the same way as before compaction
+		GammaConverter* gconv = GammaDispatcher::GetConverter(RawImageGammaProfile::sRGB, NULL);
+		gconv->InitializeTables();
+		const uint32_t* srgb_compact = gconv->_is_table_toGamma_8bit_compact ? gconv->_table_toGamma_8bit_compact : nullptr;
+		if (srgb_compact == nullptr)
+			std::cout << tabs(1) << "sRGB converter has no compact table, sRGB compact lookup is skipped." << std::endl;
+		std::vector<uint8_t> srgb_full(WIDTH_16BIT);
+		gconv->FillTableToGamma_8bit(srgb_full.data());
+
+		std::vector<int> widths;
+		for (int width = 0; width <= 64; width++)
+			widths.push_back(width);
+		widths.push_back(1001);
+		widths.push_back(4099);
+
+		int mismatches_16bit = 0;
+		int mismatches_inplace = 0;
+		int mismatches_compact = 0;
+		int mismatches_srgb = 0;
+		const int max_offset = 7;
+		for (int iteration = 0; iteration < iterations; iteration++) {
+			for (int width : widths) {
+				int offset = iteration % (max_offset + 1);
+				std::vector<uint16_t> src(width + max_offset);
+				for (uint16_t& value : src)
+					value = static_cast<uint16_t>(sample(rng));
+				//Last index in the vector body and in the tail
+				if (width > 0) {
+					src[offset + sample(rng) % width] = MAX_16BIT;
+					src[offset + width - 1] = MAX_16BIT;
+				}
+				const uint16_t* row = src.data() + offset;
+
+				// 1 - 16 bit lookup
+				std::vector<uint16_t> dst_scalar(width + max_offset), dst_avx(width + max_offset);
+				GammaConverter::LookupRow(row, dst_scalar.data() + offset, width, table.data());
+				GammaConverter::LookupRow_16bit_AVX2(row, dst_avx.data() + offset, width, table.data());
+				if (dst_scalar != dst_avx)
+					mismatches_16bit++;
+
+				// 2 - 16 bit lookup in place
+				std::vector<uint16_t> inplace(src);
+				GammaConverter::LookupRow_16bit_AVX2(inplace.data() + offset, inplace.data() + offset, width, table.data());
+				if (!std::equal(inplace.begin() + offset, inplace.begin() + offset + width, dst_scalar.begin() + offset))
+					mismatches_inplace++;
+
+				// 3 - Compact lookup with random table
+				std::vector<uint8_t> out_scalar(width + max_offset), out_avx(width + max_offset);
+				GammaConverter::LookupRow_ToGamma_8bit_Compact_Scalar(row, out_scalar.data() + offset, width, random_compact.data());
+				GammaConverter::LookupRow_ToGamma_8bit_Compact_AVX2(row, out_avx.data() + offset, width, random_compact.data());
+				if (out_scalar != out_avx)
+					mismatches_compact++;
+
+				// 4 - Compact lookup with sRGB table against the full table
+				if (srgb_compact != nullptr) {
+					std::vector<uint8_t> out_full(width + max_offset);
+					GammaConverter::LookupRow(row, out_full.data() + offset, width, srgb_full.data());
+					GammaConverter::LookupRow_ToGamma_8bit_Compact_AVX2(row, out_avx.data() + offset, width, srgb_compact);
+					if (out_full != out_avx)
+						mismatches_srgb++;
+				}
+			}
+		}
+
+		int rows_tested = iterations * static_cast<int>(widths.size());
+		std::cout << tabs(1) << "16 bit lookup: " << mismatches_16bit << " of " << rows_tested << " rows differ." << std::endl;
+		std::cout << tabs(1) << "16 bit lookup in place: " << mismatches_inplace << " of " << rows_tested << " rows differ." << std::endl;
+		std::cout << tabs(1) << "Compact lookup, random table: " << mismatches_compact << " of " << rows_tested << " rows differ." << std::endl;
+		if (srgb_compact != nullptr)
+			std::cout << tabs(1) << "Compact lookup, sRGB table: " << mismatches_srgb << " of " << rows_tested << " rows differ from full table." << std::endl;
+		if (mismatches_16bit + mismatches_inplace + mismatches_compact + mismatches_srgb == 0)
+			std::cout << tabs(1) << "All rows match." << std::endl;
+		else
+			std::cout << tabs(1) << "FAILED: AVX2 and scalar kernels differ." << std::endl;
+	}
+
+
+
 };
\ No newline at end of file
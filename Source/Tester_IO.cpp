@@ -448,8 +448,798 @@ void Tester_IO::TestJpegReaderByChunks(std::string file_path, int chunk_size) {
 }
 
 
+/// <summary>
+/// Tests lossless JPEG transformation by writing the file in all 8 orientations.
+/// </summary>
+void Tester_IO::TestJpegTransform(std::string file_path) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("TestJpegTransform");
+
+	//Intro
+	std::cout << "TEST: Lossless JPEG transformation." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	try {
+		//Warning handler
+		int warning_tabs = 2;
+		WarningCallbackData warning_callback_data(&JPEGWarningHandler, &warning_tabs);
+
+		for (int orientation = ExifOrientation::EO_NORMAL; orientation <= ExifOrientation::EO_ROTATE_90_CCW; orientation++) {
+			//Path for output file
+			std::filesystem::path out_file_path(out_dir_path);
+			out_file_path.replace_filename(in_file_path.filename());
+			out_file_path = AddAppendixToFilename(out_file_path, "_orientation_" + std::to_string(orientation));
+
+			std::cout << "\tTransforming to orientation " << orientation << ".";
+			Stopwatch sw;
+			sw.Start();
+			JpegTransformer::TransformJpegFile(in_file_path, out_file_path, static_cast<ExifOrientation>(orientation), JpegCropRegion(), false, warning_callback_data);
+			sw.Stop();
+			std::cout << " -- Done in " << sw.elapsed_milliseconds() << " ms." << std::endl;
+		}
+
+		//Crop of the top-left quarter aligned to 16 pixels
+		JpegHeaderInfo header = JpegReader(in_file_path).GetJpegHeader();
+		JpegCropRegion crop;
+		crop.x = header.GetWidth() / 4 / 16 * 16;
+		crop.y = header.GetHeight() / 4 / 16 * 16;
+		crop.width = header.GetWidth() / 2;
+		crop.height = header.GetHeight() / 2;
+
+		std::filesystem::path out_file_path(out_dir_path);
+		out_file_path.replace_filename(in_file_path.filename());
+		out_file_path = AddAppendixToFilename(out_file_path, "_crop");
+		std::cout << "\tCropping the center of the image.";
+		JpegTransformer::TransformJpegFile(in_file_path, out_file_path, ExifOrientation::EO_NORMAL, crop, true, warning_callback_data);
+		std::cout << " -- Done!" << std::endl;
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+
+
+/// <summary>
+/// Tests coefficient domain requantization of JPEG file to several qualities.
+/// </summary>
+void Tester_IO::TestJpegRequantize(std::string file_path) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("TestJpegRequantize");
+
+	//Intro
+	std::cout << "TEST: JPEG requantization." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	std::cout << "\tSource size: " << std::filesystem::file_size(in_file_path) << " bytes." << std::endl;
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	try {
+		//Warning handler
+		int warning_tabs = 2;
+		WarningCallbackData warning_callback_data(&JPEGWarningHandler, &warning_tabs);
+
+		int qualities[] = { 90, 75, 50, 25 };
+		for (int quality : qualities) {
+			//Path for output file
+			std::filesystem::path out_file_path(out_dir_path);
+			out_file_path.replace_filename(in_file_path.filename());
+			out_file_path = AddAppendixToFilename(out_file_path, "_q" + std::to_string(quality));
+
+			std::cout << "\tRequantizing to quality " << quality << ".";
+			Stopwatch sw;
+			sw.Start();
+			JpegTransformer::RequantizeJpegFile(in_file_path, out_file_path, quality, true, warning_callback_data);
+			sw.Stop();
+			std::cout << " -- Done in " << sw.elapsed_milliseconds() << " ms, " << std::filesystem::file_size(out_file_path) << " bytes." << std::endl;
+		}
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+
+/// <summary>
+/// Writes copy of the image with ICC profile and EXIF orientation, transforms it upright and requantizes it.
+/// Checks that the profile is kept in both files, orientation is reset only by the transformation and JFIF marker is not duplicated.
+/// </summary>
+void Tester_IO::TestJpegTransformMetadata(std::string file_path) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("TestJpegTransformMetadata");
+
+	//Intro
+	std::cout << "TEST: Metadata of transformed JPEG files." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	try {
+		//Warning handler
+		int warning_tabs = 2;
+		WarningCallbackData warning_callback_data(&JPEGWarningHandler, &warning_tabs);
+
+		// 1 ---------------------
+		//Writing tagged source. Profile content is not parsed on the way, so any data spanning several APP2 markers will do.
+		ImageBuffer_Byte image = JpegReader::ReadJpegFile(in_file_path, NULL, WarningCallbackData(NULL, NULL));
+		if (image.GetLayout() != ImagePixelLayout::RGB) {
+			std::cout << "\tAbort: Image is not RGB." << std::endl;
+			return;
+		}
+		std::vector<uint8_t> icc_profile(100000);
+		for (size_t i = 0; i < icc_profile.size(); i++)
+			icc_profile[i] = static_cast<uint8_t>(i * 7 + i / 251);
+
+		std::filesystem::path tagged_file_path(out_dir_path);
+		tagged_file_path.replace_filename(in_file_path.filename());
+		tagged_file_path = AddAppendixToFilename(tagged_file_path, "_tagged");
+		WriteTaggedJpeg(tagged_file_path, image, icc_profile, ExifOrientation::EO_ROTATE_90_CW);
+
+		//Checks markers of output file
+		auto check_markers = [&](std::filesystem::path out_file_path, int expected_orientation) {
+			int jfif_count = 0;
+			int orientation = ReadTaggedJpegOrientation(out_file_path, &jfif_count);
+			JpegReader out_reader(out_file_path);
+
+			if (out_reader.GetIccProfile() == icc_profile)
+				std::cout << "\t\tICC profile kept." << std::endl;
+			else
+				std::cout << "\t\tFAILED: ICC profile of " << out_reader.GetIccProfile().size() << " bytes does not match." << std::endl;
+			if (orientation == expected_orientation)
+				std::cout << "\t\tEXIF orientation is " << orientation << "." << std::endl;
+			else
+				std::cout << "\t\tFAILED: EXIF orientation is " << orientation << ", expected " << expected_orientation << "." << std::endl;
+			if (jfif_count == 1)
+				std::cout << "\t\tSingle JFIF marker." << std::endl;
+			else
+				std::cout << "\t\tFAILED: " << jfif_count << " JFIF markers." << std::endl;
+		};
+
+		// 2 ---------------------
+		//Transforming upright resets orientation
+		std::filesystem::path upright_file_path(out_dir_path);
+		upright_file_path.replace_filename(in_file_path.filename());
+		upright_file_path = AddAppendixToFilename(upright_file_path, "_upright");
+		JpegTransformer::TransformJpegFile(tagged_file_path, upright_file_path, ExifOrientation::EO_ROTATE_90_CW, JpegCropRegion(), false, warning_callback_data);
+
+		std::cout << "\tTransformed file:" << std::endl;
+		check_markers(upright_file_path, ExifOrientation::EO_NORMAL);
+
+		// 3 ---------------------
+		//Requantization keeps orientation
+		std::filesystem::path requantized_file_path(out_dir_path);
+		requantized_file_path.replace_filename(in_file_path.filename());
+		requantized_file_path = AddAppendixToFilename(requantized_file_path, "_q50");
+		JpegTransformer::RequantizeJpegFile(tagged_file_path, requantized_file_path, 50, true, warning_callback_data);
+
+		std::cout << "\tRequantized file:" << std::endl;
+		check_markers(requantized_file_path, ExifOrientation::EO_ROTATE_90_CW);
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+/// <summary>
+/// Benchmarks whole-file reading and writing of JPEG file with libjpeg and TurboJPEG backends.
+/// </summary>
+void Tester_IO::BenchmarkJpegBackends(std::string file_path, int iterations) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("BenchmarkJpegBackends");
+
+	//Intro
+	std::cout << "BENCHMARK: JPEG whole-file backends, " << iterations << " iterations." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	if (iterations < 1)
+		iterations = 1;
+
+	try {
+		JpegCodecBackend backends[] = { JpegCodecBackend::JCB_LIBJPEG, JpegCodecBackend::JCB_TURBOJPEG };
+		const char* backend_names[] = { "libjpeg  ", "TurboJPEG" };
+		for (int b = 0; b < 2; b++) {
+			//Path for output file
+			std::filesystem::path out_file_path(out_dir_path);
+			out_file_path.replace_filename(in_file_path.filename());
+			out_file_path = AddAppendixToFilename(out_file_path, b == 0 ? "_libjpeg" : "_turbojpeg");
+
+			JpegHeaderInfo header;
+			Stopwatch sw;
+
+			//Reading
+			sw.Start();
+			for (int i = 0; i < iterations - 1; i++)
+				JpegReader::ReadJpegFile(in_file_path, NULL, WarningCallbackData(NULL, NULL), backends[b]);
+			ImageBuffer_Byte image = JpegReader::ReadJpegFile(in_file_path, &header, WarningCallbackData(NULL, NULL), backends[b]);
+			sw.Stop();
+			long long read_us = sw.elapsed_microseconds() / iterations;
+
+			//Writing
+			JpegHeaderInfo out_header(image.GetHeight(), image.GetWidth(), header.GetNumComponents(), header.GetColorSpace());
+			sw.Start();
+			for (int i = 0; i < iterations; i++)
+				JpegWriter::WriteJPEG(out_file_path, image, out_header, 90, WarningCallbackData(NULL, NULL), backends[b]);
+			sw.Stop();
+			long long write_us = sw.elapsed_microseconds() / iterations;
+
+			std::cout << "\t" << backend_names[b] << " -- read " << read_us << " us, write " << write_us << " us, "
+				<< std::filesystem::file_size(out_file_path) << " bytes." << std::endl;
+		}
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+
+/// <summary>
+/// Benchmarks strict and trusted decode profiles on JPEG and PNG files.
+/// </summary>
+void Tester_IO::BenchmarkDecodeProfiles(std::string jpeg_file_path, std::string png_file_path, int iterations) {
+	//Creating file path objects
+	std::filesystem::path jpeg_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + jpeg_file_path);
+	std::filesystem::path png_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + png_file_path);
+
+	//Intro
+	std::cout << "BENCHMARK: Strict and trusted decode profiles, " << iterations << " iterations." << std::endl;
+	Printer::PrintFilePath(1, jpeg_path);
+	Printer::PrintFilePath(1, png_path);
+	Printer::EmptyLine();
+
+	if (iterations < 1)
+		iterations = 1;
+
+	try {
+		DecodeProfile profiles[] = { DecodeProfile::DP_STRICT, DecodeProfile::DP_TRUSTED };
+		const char* profile_names[] = { "strict ", "trusted" };
+		long long jpeg_us[2] = { 0, 0 };
+		long long png_us[2] = { 0, 0 };
+		Stopwatch sw;
+
+		for (int p = 0; p < 2; p++) {
+			sw.Start();
+			for (int i = 0; i < iterations; i++)
+				JpegReader::ReadJpegFile(jpeg_path, NULL, WarningCallbackData(NULL, NULL), profiles[p]);
+			sw.Stop();
+			jpeg_us[p] = sw.elapsed_microseconds() / iterations;
+
+			sw.Start();
+			for (int i = 0; i < iterations; i++)
+				PngReader::ReadPngFile(png_path, NULL, WarningCallbackData(NULL, NULL), profiles[p]);
+			sw.Stop();
+			png_us[p] = sw.elapsed_microseconds() / iterations;
+
+			std::cout << "\t" << profile_names[p] << " -- JPEG " << jpeg_us[p] << " us, PNG " << png_us[p] << " us." << std::endl;
+		}
+
+		std::cout << "\tTrusted speedup -- JPEG " << static_cast<double>(jpeg_us[0]) / std::max(1LL, jpeg_us[1])
+			<< "x, PNG " << static_cast<double>(png_us[0]) / std::max(1LL, png_us[1]) << "x." << std::endl;
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
 
 
+/// <summary>
+/// Benchmarks fastest, balanced and smallest encoder profiles on JPEG and PNG files, reporting time and size.
+/// </summary>
+void Tester_IO::BenchmarkEncoderProfiles(std::string jpeg_file_path, std::string png_file_path, int iterations) {
+	//Creating file path objects
+	std::filesystem::path jpeg_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + jpeg_file_path);
+	std::filesystem::path png_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + png_file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("BenchmarkEncoderProfiles");
+
+	//Intro
+	std::cout << "BENCHMARK: Encoder profiles, " << iterations << " iterations." << std::endl;
+	Printer::PrintFilePath(1, jpeg_path);
+	Printer::PrintFilePath(1, png_path);
+	Printer::EmptyLine();
+
+	if (iterations < 1)
+		iterations = 1;
+
+	try {
+		//Source images
+		JpegHeaderInfo jpeg_header;
+		ImageBuffer_Byte jpeg_image = JpegReader::ReadJpegFile(jpeg_path, &jpeg_header, WarningCallbackData(NULL, NULL));
+		JpegHeaderInfo out_jpeg_header(jpeg_image.GetHeight(), jpeg_image.GetWidth(), jpeg_header.GetNumComponents(), jpeg_header.GetColorSpace());
+		ImageBuffer_Byte png_image = PngReader::ReadPngFile(png_path, NULL, WarningCallbackData(NULL, NULL));
+
+		EncoderProfile profiles[] = { EncoderProfile::EP_FASTEST, EncoderProfile::EP_BALANCED, EncoderProfile::EP_SMALLEST };
+		const char* profile_names[] = { "fastest ", "balanced", "smallest" };
+		const char* profile_appendices[] = { "_fastest", "_balanced", "_smallest" };
+		Stopwatch sw;
+
+		for (int p = 0; p < 3; p++) {
+			//Paths for output files
+			std::filesystem::path out_jpeg_path(out_dir_path);
+			out_jpeg_path.replace_filename(jpeg_path.filename());
+			out_jpeg_path = AddAppendixToFilename(out_jpeg_path, profile_appendices[p]);
+			std::filesystem::path out_png_path(out_dir_path);
+			out_png_path.replace_filename(png_path.filename());
+			out_png_path = AddAppendixToFilename(out_png_path, profile_appendices[p]);
+
+			sw.Start();
+			for (int i = 0; i < iterations; i++)
+				JpegWriter::WriteJPEG(out_jpeg_path, jpeg_image, out_jpeg_header, 90, WarningCallbackData(NULL, NULL), profiles[p]);
+			sw.Stop();
+			long long jpeg_us = sw.elapsed_microseconds() / iterations;
+
+			sw.Start();
+			for (int i = 0; i < iterations; i++)
+				PngWriter::WritePng(out_png_path, png_image, WarningCallbackData(NULL, NULL), profiles[p]);
+			sw.Stop();
+			long long png_us = sw.elapsed_microseconds() / iterations;
+
+			std::cout << "\t" << profile_names[p]
+				<< " -- JPEG " << jpeg_us << " us, " << std::filesystem::file_size(out_jpeg_path) << " bytes"
+				<< "; PNG " << png_us << " us, " << std::filesystem::file_size(out_png_path) << " bytes." << std::endl;
+		}
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+/// <summary>
+/// Tests size-targeted JPEG writing of downscaled thumbnail against several byte budgets.
+/// </summary>
+void Tester_IO::TestJpegToSize(std::string file_path, int thumbnail_width) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("TestJpegToSize");
+
+	//Intro
+	std::cout << "TEST: Size-targeted JPEG writing." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	try {
+		//Reading and downscaling to thumbnail with planar path
+		JpegHeaderInfo header;
+		JpegPlanarImage planar = JpegReader::ReadJpegFilePlanar(in_file_path, &header, WarningCallbackData(NULL, NULL));
+		int thumbnail_height = std::max(1, planar.GetHeight() * thumbnail_width / planar.GetWidth());
+		std::filesystem::path thumbnail_path(out_dir_path);
+		thumbnail_path.replace_filename(in_file_path.filename());
+		thumbnail_path = AddAppendixToFilename(thumbnail_path, "_thumbnail");
+		JpegWriter::WriteJpegPlanar(thumbnail_path, planar.Downscale(thumbnail_height, thumbnail_width), 100);
+		ImageBuffer_Byte thumbnail = JpegReader::ReadJpegFile(thumbnail_path, &header, WarningCallbackData(NULL, NULL));
+		JpegHeaderInfo out_header(thumbnail.GetHeight(), thumbnail.GetWidth(), header.GetNumComponents(), header.GetColorSpace());
+
+		std::cout << "\tThumbnail " << thumbnail.GetWidth() << "x" << thumbnail.GetHeight() << "." << std::endl;
+
+		size_t budgets[] = { 4000, 8000, 16000, 32000, 64000 };
+		for (size_t budget : budgets) {
+			std::filesystem::path out_file_path(out_dir_path);
+			out_file_path.replace_filename(in_file_path.filename());
+			out_file_path = AddAppendixToFilename(out_file_path, "_" + std::to_string(budget));
+
+			Stopwatch sw;
+			sw.Start();
+			int quality = JpegWriter::WriteJpegToSize(out_file_path, thumbnail, out_header, budget, EncoderProfile::EP_BALANCED, WarningCallbackData(NULL, NULL));
+			sw.Stop();
+
+			std::cout << "\tBudget " << budget << " bytes -- quality " << quality << ", "
+				<< std::filesystem::file_size(out_file_path) << " bytes, " << sw.elapsed_microseconds() << " us." << std::endl;
+		}
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+/// <summary>
+/// Decodes JPEG file with restart markers in parallel bands and sequentially, and compares the images and warnings.
+/// </summary>
+void Tester_IO::TestJpegBandDecoding(std::string file_path) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+
+	//Intro
+	std::cout << "TEST: JPEG restart band decoding against sequential decoding." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	//Warnings of each decoding are collected to compare them
+	void (*collect_warning)(std::string, void*) = [](std::string message, void* args) {
+		reinterpret_cast<std::vector<std::string>*>(args)->push_back(message);
+	};
+	std::vector<std::string> band_warnings;
+	std::vector<std::string> sequential_warnings;
+
+	try {
+		// 1 ---------------------
+		//Whole file reading, decodes in parallel bands when restart markers allow it
+		int num_bands = 0;
+		Stopwatch sw;
+		sw.Start();
+		ImageBuffer_Byte band_image = JpegReader::ReadJpegFile(in_file_path, NULL, WarningCallbackData(collect_warning, &band_warnings), DecodeProfile::DP_STRICT, &num_bands);
+		sw.Stop();
+		std::cout << "\tWhole file reading: " << sw.elapsed_milliseconds() << " ms, " << num_bands << " bands, " << band_warnings.size() << " warnings." << std::endl;
+
+		//Comparison below means nothing if whole file reading fell back to sequential decoding
+		if (num_bands < 2) {
+			if (oneapi::tbb::info::default_concurrency() < 2)
+				std::cout << "\tAbort: Single hardware thread, bands are not used." << std::endl;
+			else
+				std::cout << "\tFAILED: File was decoded sequentially. It should have restart markers on MCU row boundaries." << std::endl;
+			return;
+		}
+
+		// 2 ---------------------
+		//Chunk reader always decodes sequentially
+		sw.Start();
+		JpegReader reader(in_file_path, WarningCallbackData(collect_warning, &sequential_warnings));
+		ImageBuffer_Byte sequential_image = reader.ReadNextRows(reader.GetJpegHeader().GetHeight());
+		sw.Stop();
+		std::cout << "\tSequential reading: " << sw.elapsed_milliseconds() << " ms, " << sequential_warnings.size() << " warnings." << std::endl;
+
+		// 3 ---------------------
+		//Comparing
+		if (band_image.GetHeight() != sequential_image.GetHeight() ||
+			band_image.GetWidth() != sequential_image.GetWidth() ||
+			band_image.GetNumCmp() != sequential_image.GetNumCmp()) {
+			std::cout << "\tFAILED: Image dimensions do not match." << std::endl;
+			return;
+		}
+
+		size_t row_length = static_cast<size_t>(band_image.GetWidth()) * band_image.GetNumCmp();
+		int mismatched_rows = 0;
+		for (int row = 0; row < band_image.GetHeight(); row++)
+			if (std::memcmp(band_image.GetDataPtr()[row], sequential_image.GetDataPtr()[row], row_length) != 0)
+				mismatched_rows++;
+
+		if (mismatched_rows == 0)
+			std::cout << "\tImage data match." << std::endl;
+		else
+			std::cout << "\tFAILED: " << mismatched_rows << " rows do not match." << std::endl;
+
+		if (band_warnings == sequential_warnings)
+			std::cout << "\tWarnings match." << std::endl;
+		else
+			std::cout << "\tFAILED: Warnings do not match." << std::endl;
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+
+/// <summary>
+/// Writes the image as interleaved sequential, non-interleaved sequential (one scan per component) and progressive JPEG,
+/// reads each with reduced reader and checks that both sequential files give the same image.
+/// </summary>
+void Tester_IO::TestJpegReducedMultiScan(std::string file_path, int min_width) {
+	//Creating file path object
+	std::filesystem::path in_file_path(std::string(TEST_IMAGES_PATH_STR) + "\\" + file_path);
+	//Creating file folder for output
+	std::filesystem::path out_dir_path = CreateOutputFolder("TestJpegReducedMultiScan");
+
+	//Intro
+	std::cout << "TEST: Reduced JPEG reading of files with several scans." << std::endl;
+	Printer::PrintFilePath(1, in_file_path);
+	Printer::EmptyLine();
+
+	if (IsJpeg_ByExtension(std::filesystem::path(file_path)) == false) {
+		std::cout << "\tAbort: File is not a JPEG by extension." << std::endl;
+		return;
+	}
+
+	try {
+		// 1 ---------------------
+		//Writing the image with each scan structure
+		ImageBuffer_Byte image = JpegReader::ReadJpegFile(in_file_path, NULL, WarningCallbackData(NULL, NULL));
+		if (image.GetLayout() != ImagePixelLayout::RGB) {
+			std::cout << "\tAbort: Image is not RGB." << std::endl;
+			return;
+		}
+
+		const char* appendices[3] = { "_interleaved", "_per_component", "_progressive" };
+		std::filesystem::path out_file_paths[3];
+		for (int mode = 0; mode < 3; mode++) {
+			out_file_paths[mode] = out_dir_path;
+			out_file_paths[mode].replace_filename(in_file_path.filename());
+			out_file_paths[mode] = AddAppendixToFilename(out_file_paths[mode], appendices[mode]);
+			WriteTestJpeg(out_file_paths[mode], image, static_cast<TestScanMode>(mode));
+		}
+
+		// 2 ---------------------
+		//Reading reduced images
+		int min_height = std::max(1, image.GetHeight() * min_width / image.GetWidth());
+		ImageBuffer_Byte reduced[3] = {
+			JpegReader::ReadJpegFileReduced(out_file_paths[0], min_height, min_width, NULL, WarningCallbackData(NULL, NULL)),
+			JpegReader::ReadJpegFileReduced(out_file_paths[1], min_height, min_width, NULL, WarningCallbackData(NULL, NULL)),
+			JpegReader::ReadJpegFileReduced(out_file_paths[2], min_height, min_width, NULL, WarningCallbackData(NULL, NULL))
+		};
+		for (int mode = 0; mode < 3; mode++)
+			std::cout << "\t" << appendices[mode] + 1 << ": " << reduced[mode].GetWidth() << "x" << reduced[mode].GetHeight() << "." << std::endl;
+
+		// 3 ---------------------
+		//Sequential files hold the same coefficients, so images must be the same
+		if (reduced[0].GetHeight() != reduced[1].GetHeight() || reduced[0].GetWidth() != reduced[1].GetWidth()) {
+			std::cout << "\tFAILED: Dimensions of sequential images do not match." << std::endl;
+			return;
+		}
+		size_t row_length = static_cast<size_t>(reduced[0].GetWidth()) * reduced[0].GetNumCmp();
+		int mismatched_rows = 0;
+		for (int row = 0; row < reduced[0].GetHeight(); row++)
+			if (std::memcmp(reduced[0].GetDataPtr()[row], reduced[1].GetDataPtr()[row], row_length) != 0)
+				mismatched_rows++;
+
+		if (mismatched_rows == 0)
+			std::cout << "\tSequential images match." << std::endl;
+		else
+			std::cout << "\tFAILED: " << mismatched_rows << " rows of sequential images do not match." << std::endl;
+	}
+	catch (std::ifstream::failure e) {
+		std::cout << e.what() << std::endl;
+		return;
+	}
+	catch (codec_fatal_exception e) {
+		std::cout << e.GetFullMessage() << std::endl;
+		return;
+	}
+}
+
+
+
+/// <summary>
+/// Writes 8 bit RGB image to JPEG file with given scan structure directly with libjpeg.
+/// </summary>
+void Tester_IO::WriteTestJpeg(std::filesystem::path file_path, const ImageBuffer_Byte& image, TestScanMode scan_mode) {
+	jpeg_compress_struct comp;
+	jpeg_error_mgr error_manager;
+	comp.err = jpeg_std_error(&error_manager);
+	jpeg_create_compress(&comp);
+
+	unsigned char* buffer = NULL;
+	unsigned long buffer_size = 0;
+	jpeg_mem_dest(&comp, &buffer, &buffer_size);
+
+	comp.image_height = image.GetHeight();
+	comp.image_width = image.GetWidth();
+	comp.input_components = 3;
+	comp.in_color_space = J_COLOR_SPACE::JCS_RGB;
+	jpeg_set_defaults(&comp);
+	jpeg_set_quality(&comp, 90, TRUE);
+
+	//One full spectrum scan for each component
+	jpeg_scan_info scans[3];
+	if (scan_mode == TSM_PER_COMPONENT) {
+		for (int cmp = 0; cmp < 3; cmp++) {
+			scans[cmp].comps_in_scan = 1;
+			scans[cmp].component_index[0] = cmp;
+			scans[cmp].Ss = 0;
+			scans[cmp].Se = 63;
+			scans[cmp].Ah = 0;
+			scans[cmp].Al = 0;
+		}
+		comp.scan_info = scans;
+		comp.num_scans = 3;
+	}
+	else if (scan_mode == TSM_PROGRESSIVE)
+		jpeg_simple_progression(&comp);
+
+	jpeg_start_compress(&comp, TRUE);
+	uint8_t** rows = image.GetDataPtr();
+	while (comp.next_scanline < comp.image_height)
+		jpeg_write_scanlines(&comp, &rows[comp.next_scanline], comp.image_height - comp.next_scanline);
+	jpeg_finish_compress(&comp);
+	jpeg_destroy_compress(&comp);
+
+	std::ofstream file_stream(file_path, std::ios::binary | std::ios::trunc);
+	file_stream.write(reinterpret_cast<const char*>(buffer), buffer_size);
+	free(buffer);
+}
+
+
+
+/// <summary>
+/// Writes 8 bit RGB image to baseline JPEG file with ICC profile and little endian EXIF block holding only Orientation tag.
+/// </summary>
+void Tester_IO::WriteTaggedJpeg(std::filesystem::path file_path, const ImageBuffer_Byte& image, const std::vector<uint8_t>& icc_profile, int orientation) {
+	jpeg_compress_struct comp;
+	jpeg_error_mgr error_manager;
+	comp.err = jpeg_std_error(&error_manager);
+	jpeg_create_compress(&comp);
+
+	unsigned char* buffer = NULL;
+	unsigned long buffer_size = 0;
+	jpeg_mem_dest(&comp, &buffer, &buffer_size);
+
+	comp.image_height = image.GetHeight();
+	comp.image_width = image.GetWidth();
+	comp.input_components = 3;
+	comp.in_color_space = J_COLOR_SPACE::JCS_RGB;
+	jpeg_set_defaults(&comp);
+	jpeg_set_quality(&comp, 90, TRUE);
+	jpeg_start_compress(&comp, TRUE);
+
+	//EXIF identifier, TIFF header with IFD0 at offset 8, one SHORT entry and no next IFD
+	uint8_t exif[] = {
+		'E', 'x', 'i', 'f', 0, 0,
+		'I', 'I', 42, 0, 8, 0, 0, 0,
+		1, 0,
+		0x12, 0x01, 3, 0, 1, 0, 0, 0, static_cast<uint8_t>(orientation), 0, 0, 0,
+		0, 0, 0, 0
+	};
+	jpeg_write_marker(&comp, JPEG_APP0 + 1, exif, sizeof(exif));
+	jpeg_write_icc_profile(&comp, icc_profile.data(), static_cast<unsigned int>(icc_profile.size()));
+
+	uint8_t** rows = image.GetDataPtr();
+	while (comp.next_scanline < comp.image_height)
+		jpeg_write_scanlines(&comp, &rows[comp.next_scanline], comp.image_height - comp.next_scanline);
+	jpeg_finish_compress(&comp);
+	jpeg_destroy_compress(&comp);
+
+	std::ofstream file_stream(file_path, std::ios::binary | std::ios::trunc);
+	file_stream.write(reinterpret_cast<const char*>(buffer), buffer_size);
+	free(buffer);
+}
+
+
+
+/// <summary>
+/// Reads markers of JPEG file written by WriteTaggedJpeg or transformed from it.
+/// Returns orientation from EXIF block, 0 if there is no EXIF. Number of JFIF markers is written to jfif_count.
+/// </summary>
+int Tester_IO::ReadTaggedJpegOrientation(std::filesystem::path file_path, int* jfif_count) {
+	std::ifstream file_stream(file_path, std::ios::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file_stream)), std::istreambuf_iterator<char>());
+
+	jpeg_decompress_struct decomp;
+	jpeg_error_mgr error_manager;
+	decomp.err = jpeg_std_error(&error_manager);
+	jpeg_create_decompress(&decomp);
+	jpeg_mem_src(&decomp, data.data(), static_cast<unsigned long>(data.size()));
+	jpeg_save_markers(&decomp, JPEG_APP0, 0xFFFF);
+	jpeg_save_markers(&decomp, JPEG_APP0 + 1, 0xFFFF);
+	jpeg_read_header(&decomp, TRUE);
+
+	int orientation = 0;
+	*jfif_count = 0;
+	for (jpeg_saved_marker_ptr marker = decomp.marker_list; marker != NULL; marker = marker->next) {
+		if (marker->marker == JPEG_APP0 && marker->data_length >= 5 && std::memcmp(marker->data, "JFIF", 5) == 0)
+			(*jfif_count)++;
+		//Value of the single IFD0 entry
+		if (marker->marker == JPEG_APP0 + 1 && marker->data_length >= 26 && std::memcmp(marker->data, "Exif\0\0II", 8) == 0)
+			orientation = marker->data[24] | (marker->data[25] << 8);
+	}
+
+	jpeg_destroy_decompress(&decomp);
+	return orientation;
+}
+
+//--------------------------------
+//	PROBE TESTERS
+//--------------------------------
+
+
+/// <summary>
+/// Probes headers of all files in TestImages folder in parallel and prints them.
+/// </summary>
+void Tester_IO::TestImageProbe() {
+	std::filesystem::path images_path(TEST_IMAGES_PATH_STR);
+
+	//Intro
+	std::cout << "TEST: Probing image headers." << std::endl;
+	Printer::PrintFilePath(1, images_path);
+	Printer::EmptyLine();
+
+	std::vector<std::filesystem::path> file_paths;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(images_path))
+		if (entry.is_regular_file())
+			file_paths.push_back(entry.path());
+
+	Stopwatch sw;
+	sw.Start();
+	std::vector<ImageFileInfo> infos = ImageProbe::ProbeFiles(file_paths);
+	sw.Stop();
+
+	for (const ImageFileInfo& info : infos) {
+		Printer::PrintFilePath(1, info.GetFilePath());
+		Printer::PrintImageFileInfo(2, info);
+	}
+
+	std::cout << "\tProbed " << infos.size() << " files in " << sw.elapsed_microseconds() << " us." << std::endl;
+}
+
 
 
 //--------------------------------
@@ -3,6 +3,7 @@
 //STL
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 //Internal - debug
 #include "Tester_Base.h"
 #include "ImageGenerator.h"
@@ -47,6 +48,63 @@ public:
 	/// </summary>
 	static void TestJpegReaderByChunks(std::string file_path, int chunk_size);
 
+	/// <summary>
+	/// Tests lossless JPEG transformation by writing the file in all 8 orientations.
+	/// </summary>
+	static void TestJpegTransform(std::string file_path);
+
+	/// <summary>
+	/// Tests coefficient domain requantization of JPEG file to several qualities.
+	/// </summary>
+	static void TestJpegRequantize(std::string file_path);
+
+	/// <summary>
+	/// Writes copy of the image with ICC profile and EXIF orientation, transforms it upright and requantizes it.
+	/// Checks that the profile is kept in both files, orientation is reset only by the transformation and JFIF marker is not duplicated.
+	/// </summary>
+	static void TestJpegTransformMetadata(std::string file_path);
+
+	/// <summary>
+	/// Benchmarks whole-file reading and writing of JPEG file with libjpeg and TurboJPEG backends.
+	/// </summary>
+	static void BenchmarkJpegBackends(std::string file_path, int iterations);
+
+	/// <summary>
+	/// Benchmarks strict and trusted decode profiles on JPEG and PNG files.
+	/// </summary>
+	static void BenchmarkDecodeProfiles(std::string jpeg_file_path, std::string png_file_path, int iterations);
+
+	/// <summary>
+	/// Benchmarks fastest, balanced and smallest encoder profiles on JPEG and PNG files, reporting time and size.
+	/// </summary>
+	static void BenchmarkEncoderProfiles(std::string jpeg_file_path, std::string png_file_path, int iterations);
+
+	/// <summary>
+	/// Tests size-targeted JPEG writing of downscaled thumbnail against several byte budgets.
+	/// </summary>
+	static void TestJpegToSize(std::string file_path, int thumbnail_width);
+
+	/// <summary>
+	/// Decodes JPEG file with restart markers in parallel bands and sequentially, and compares the images and warnings.
+	/// Fails if whole file reading did not actually use parallel bands.
+	/// </summary>
+	static void TestJpegBandDecoding(std::string file_path);
+
+	/// <summary>
+	/// Writes the image as interleaved sequential, non-interleaved sequential (one scan per component) and progressive JPEG,
+	/// reads each with reduced reader and checks that both sequential files give the same image.
+	/// </summary>
+	static void TestJpegReducedMultiScan(std::string file_path, int min_width);
+
+	//--------------------------------
+	//	PROBE TESTERS
+	//--------------------------------
+
+	/// <summary>
+	/// Probes headers of all files in TestImages folder in parallel and prints them.
+	/// </summary>
+	static void TestImageProbe();
+
 	//--------------------------------
 	//	PNG TESTERS
 	//--------------------------------
@@ -76,7 +134,30 @@ public:
 
 
 private:
+	/// <summary>
+	/// Scan structure of a test JPEG file.
+	/// </summary>
+	enum TestScanMode {
+		TSM_INTERLEAVED,	//Single scan with all components
+		TSM_PER_COMPONENT,	//Sequential scan for each component
+		TSM_PROGRESSIVE		//libjpeg default progression
+	};
+
+	/// <summary>
+	/// Writes 8 bit RGB image to JPEG file with given scan structure directly with libjpeg.
+	/// </summary>
+	static void WriteTestJpeg(std::filesystem::path file_path, const ImageBuffer_Byte& image, TestScanMode scan_mode);
 
+	/// <summary>
+	/// Writes 8 bit RGB image to baseline JPEG file with ICC profile and little endian EXIF block holding only Orientation tag.
+	/// </summary>
+	static void WriteTaggedJpeg(std::filesystem::path file_path, const ImageBuffer_Byte& image, const std::vector<uint8_t>& icc_profile, int orientation);
+
+	/// <summary>
+	/// Reads markers of JPEG file written by WriteTaggedJpeg or transformed from it.
+	/// Returns orientation from EXIF block, 0 if there is no EXIF. Number of JFIF markers is written to jfif_count.
+	/// </summary>
+	static int ReadTaggedJpegOrientation(std::filesystem::path file_path, int* jfif_count);
 
 
 };
\ No newline at end of file
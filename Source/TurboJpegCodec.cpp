@@ -0,0 +1,253 @@
+#include "TurboJpegCodec.h"
+
+
+
+//--------------------------------
+//	READING
+//--------------------------------
+
+///<summary>
+///Static method. Reads and decompresses whole JPEG file.
+///<para>Image is decoded with the smallest TurboJPEG scaling factor that gives at least min_height x min_width pixels.
+///Zero minimal size means full size.</para>
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+ImageBuffer_Byte TurboJpegCodec::ReadJpegFile(std::filesystem::path file_path, int min_height, int min_width, bool fast_dct, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	ThreadContext& context = GetThreadContext();
+
+	//Loading the file to the thread buffer
+	std::ifstream file_stream(file_path, std::ios::binary | std::ios::ate);
+	if (!file_stream.is_open())
+		throw std::ifstream::failure("Failed to open file.");
+	context.file_data.resize(static_cast<size_t>(file_stream.tellg()));
+	file_stream.seekg(0);
+	file_stream.read(reinterpret_cast<char*>(context.file_data.data()), context.file_data.size());
+	file_stream.close();
+
+	return ReadJpegData(context.file_data.data(), context.file_data.size(), min_height, min_width, fast_dct, headerPtr, warning_callback_data);
+}
+
+
+
+///<summary>
+///Static method. Decompresses JPEG image stored in memory.
+///<para>Image is decoded with the smallest TurboJPEG scaling factor that gives at least min_height x min_width pixels.
+///Zero minimal size means full size.</para>
+///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+///</summary>
+ImageBuffer_Byte TurboJpegCodec::ReadJpegData(const uint8_t* data, size_t size, int min_height, int min_width, bool fast_dct, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data) {
+	ThreadContext& context = GetThreadContext();
+
+	//----------------------------------------------------------------------
+	// 1 - Reading the header
+
+	int width = 0;
+	int height = 0;
+	int subsampling = 0;
+	int color_space = 0;
+	if (tjDecompressHeader3(context.decompressor, data, static_cast<unsigned long>(size), &width, &height, &subsampling, &color_space) != 0)
+		HandleError(context.decompressor, CodecExceptions::Jpeg_DecodingError, warning_callback_data);
+
+	if (color_space == TJCS_CMYK || color_space == TJCS_YCCK)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_DecodingError, "CMYK and YCCK files are not supported by TurboJPEG backend.");
+
+	bool is_grayscale = color_space == TJCS_GRAY;
+	if (headerPtr != nullptr)
+		*headerPtr = JpegHeaderInfo(height, width, is_grayscale ? 1 : 3, TurboColorSpaceToJpeg(color_space));
+
+	//----------------------------------------------------------------------
+	// 2 - Choosing the scale
+
+	//Scaling factors are listed from the biggest to the smallest
+	int num_factors = 0;
+	tjscalingfactor* factors = tjGetScalingFactors(&num_factors);
+	int scaled_height = height;
+	int scaled_width = width;
+	for (int i = 0; i < num_factors; i++) {
+		//Only downscaling factors are considered
+		if (factors[i].num > factors[i].denom)
+			continue;
+		int factor_height = TJSCALED(height, factors[i]);
+		int factor_width = TJSCALED(width, factors[i]);
+		if (factor_height >= min_height && factor_width >= min_width) {
+			scaled_height = factor_height;
+			scaled_width = factor_width;
+		}
+	}
+
+	//----------------------------------------------------------------------
+	// 3 - Decompressing to the contiguous buffer
+
+	int pixel_format = is_grayscale ? TJPF_GRAY : TJPF_RGB;
+	int pitch = scaled_width * tjPixelSize[pixel_format];
+	context.pixels.resize(static_cast<size_t>(pitch) * scaled_height);
+
+	int flags = fast_dct ? (TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) : TJFLAG_ACCURATEDCT;
+	if (tjDecompress2(context.decompressor, data, static_cast<unsigned long>(size), context.pixels.data(), scaled_width, pitch, scaled_height, pixel_format, flags) != 0)
+		HandleError(context.decompressor, CodecExceptions::Jpeg_DecodingError, warning_callback_data);
+
+	//----------------------------------------------------------------------
+	// 4 - Copying to image rows
+
+	ImageBuffer_Byte decompressed_image(scaled_height, scaled_width, is_grayscale ? ImagePixelLayout::G : ImagePixelLayout::RGB, BitDepth::BD_8_BIT);
+	uint8_t** image_data = decompressed_image.GetDataPtr();
+	for (int row = 0; row < scaled_height; row++)
+		memcpy(image_data[row], context.pixels.data() + static_cast<size_t>(row) * pitch, pitch);
+
+	return decompressed_image;
+}
+
+
+
+
+//--------------------------------
+//	WRITING
+//--------------------------------
+
+///<summary>
+///Static method. Compresses image and writes it to the file.
+///Image is expected to be 8 bit grayscale or RGB.
+///<para>Can throw std::ifstream::failure if failed to open file.</para>
+///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+///</summary>
+void TurboJpegCodec::WriteJpegFile(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, bool fast_dct, WarningCallbackData warning_callback_data) {
+	//----------------------------------------------------------------------
+	// 1 - Arguments check
+
+	if (quality < 1 || quality > 100)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Jpeg quality setting is out of range.");
+
+	if (image.GetBitPerComponent() != BitDepth::BD_8_BIT)
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Trying to write image object that is not 8 bit per color component.");
+
+	int pixel_format;
+	switch (image.GetLayout()) {
+	case ImagePixelLayout::G:
+		pixel_format = TJPF_GRAY;
+		break;
+	case ImagePixelLayout::RGB:
+		pixel_format = TJPF_RGB;
+		break;
+	default:
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "Trying to write image object with alpha channel.");
+	}
+
+	int subsampling;
+	switch (header.GetColorSpace()) {
+	case J_COLOR_SPACE::JCS_GRAYSCALE:
+		subsampling = TJSAMP_GRAY;
+		break;
+	case J_COLOR_SPACE::JCS_YCbCr:
+		//Same sampling as libjpeg defaults
+		subsampling = pixel_format == TJPF_GRAY ? TJSAMP_GRAY : TJSAMP_420;
+		break;
+	case J_COLOR_SPACE::JCS_RGB:
+		subsampling = pixel_format == TJPF_GRAY ? TJSAMP_GRAY : TJSAMP_444;
+		break;
+	default:
+		throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, "JPEG file colorspace is not supported by TurboJPEG backend.");
+	}
+
+	ThreadContext& context = GetThreadContext();
+
+	//----------------------------------------------------------------------
+	// 2 - Copying image rows to the contiguous buffer
+
+	int height = image.GetHeight();
+	int width = image.GetWidth();
+	int pitch = width * tjPixelSize[pixel_format];
+	context.pixels.resize(static_cast<size_t>(pitch) * height);
+	uint8_t** image_data = image.GetDataPtr();
+	for (int row = 0; row < height; row++)
+		memcpy(context.pixels.data() + static_cast<size_t>(row) * pitch, image_data[row], pitch);
+
+	//----------------------------------------------------------------------
+	// 3 - Compressing
+
+	//Compressed data buffer is kept by the thread and grown by TurboJPEG when it is too small.
+	//TurboJPEG remembers capacity of the buffer it returned, so for the reused buffer passed size is only checked to be non-zero
+	//(zero makes it allocate a new buffer). Size of the last compressed image is passed, which never exceeds the capacity.
+	unsigned long jpeg_size = context.jpeg_data_size;
+	int flags = fast_dct ? TJFLAG_FASTDCT : TJFLAG_ACCURATEDCT;
+	if (tjCompress2(context.compressor, context.pixels.data(), width, pitch, height, pixel_format, &context.jpeg_buffer, &jpeg_size, subsampling, quality, flags) != 0)
+		HandleError(context.compressor, CodecExceptions::Jpeg_EncodingError, warning_callback_data);
+	context.jpeg_data_size = jpeg_size;
+
+	//----------------------------------------------------------------------
+	// 4 - Writing the file
+
+	std::ofstream file_stream(file_path, std::ios::binary | std::ios::trunc);
+	if (!file_stream.is_open())
+		throw std::ifstream::failure("Failed to open file.");
+	file_stream.write(reinterpret_cast<const char*>(context.jpeg_buffer), jpeg_size);
+	if (!file_stream)
+		throw std::ifstream::failure("Failed to write file.");
+}
+
+
+
+
+//--------------------------------
+//	THREAD DATA
+//--------------------------------
+
+///<summary>
+///Context of the calling thread. Handles are created on first use.
+///</summary>
+TurboJpegCodec::ThreadContext& TurboJpegCodec::GetThreadContext() {
+	thread_local ThreadContext context;
+	if (context.decompressor == NULL) {
+		context.decompressor = tjInitDecompress();
+		if (context.decompressor == NULL)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, tjGetErrorStr2(NULL));
+	}
+	if (context.compressor == NULL) {
+		context.compressor = tjInitCompress();
+		if (context.compressor == NULL)
+			throw codec_fatal_exception(CodecExceptions::Jpeg_InitError, tjGetErrorStr2(NULL));
+	}
+	return context;
+}
+
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Reports TurboJPEG error of the handle. Warnings go to the callback, errors are thrown as codec_fatal_exception.
+///</summary>
+void TurboJpegCodec::HandleError(tjhandle handle, CodecExceptions error, WarningCallbackData& warning_callback_data) {
+	std::string message(tjGetErrorStr2(handle));
+	if (tjGetErrorCode(handle) == TJERR_WARNING) {
+		if (warning_callback_data.warningCallback != NULL)
+			warning_callback_data.warningCallback(message, warning_callback_data.warningCallbackArgs_ptr);
+		return;
+	}
+	throw codec_fatal_exception(error, message);
+}
+
+
+
+///<summary>
+///Translates TurboJPEG colorspace to libjpeg colorspace.
+///</summary>
+J_COLOR_SPACE TurboJpegCodec::TurboColorSpaceToJpeg(int tj_color_space) {
+	switch (tj_color_space) {
+	case TJCS_RGB:
+		return J_COLOR_SPACE::JCS_RGB;
+	case TJCS_YCbCr:
+		return J_COLOR_SPACE::JCS_YCbCr;
+	case TJCS_GRAY:
+		return J_COLOR_SPACE::JCS_GRAYSCALE;
+	case TJCS_CMYK:
+		return J_COLOR_SPACE::JCS_CMYK;
+	case TJCS_YCCK:
+		return J_COLOR_SPACE::JCS_YCCK;
+	default:
+		return J_COLOR_SPACE::JCS_UNKNOWN;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+//STL
+#include <string>
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+//Third party
+#include "turbojpeg.h"
+//Internal
+#include "Exceptions.h"
+#include "ImageBuffer_Byte.h"
+#include "JpegHeaderInfo.h"
+#include "WarningCallbackData.h"
+
+///<summary>
+///Whole-file JPEG reading and writing through TurboJPEG API of libjpeg-turbo.
+///Alternative backend for JpegReader::ReadJpegFile and JpegWriter::WriteJPEG
+///selected per call with JpegCodecBackend.
+///</summary>
+///<remarks>
+///TurboJPEG decodes and encodes the whole image in one call from a contiguous buffer with SIMD color conversion,
+///which makes it faster than scanline API for small images where per-call overhead dominates.
+///
+///Each thread keeps its own compressor and decompressor handles, file buffer and contiguous pixel buffer,
+///so repeated calls from the same thread do not allocate. Pixels are copied between the contiguous buffer
+///and ImageBuffer_Byte rows, since image buffer rows are allocated individually.
+///
+///Supported input files are grayscale and YCbCr/RGB JPEGs. CMYK and YCCK files should be read with libjpeg backend.
+///</remarks>
+class TurboJpegCodec {
+public:
+	//--------------------------------
+	//	READING
+	//--------------------------------
+
+	///<summary>
+	///Static method. Reads and decompresses whole JPEG file.
+	///<para>Image is decoded with the smallest TurboJPEG scaling factor that gives at least min_height x min_width pixels.
+	///Zero minimal size means full size.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to file to read.</param>
+	///<param name="min_height">Minimal height of decoded image.</param>
+	///<param name="min_width">Minimal width of decoded image.</param>
+	///<param name="fast_dct">Use fast integer inverse DCT and fast upsampling instead of accurate ones.</param>
+	///<param name="headerPtr">Writes info to JPEG header located at this pointer. If NULL it is ignored.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static ImageBuffer_Byte ReadJpegFile(std::filesystem::path file_path, int min_height, int min_width, bool fast_dct, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
+	///<summary>
+	///Static method. Decompresses JPEG image stored in memory.
+	///<para>Image is decoded with the smallest TurboJPEG scaling factor that gives at least min_height x min_width pixels.
+	///Zero minimal size means full size.</para>
+	///<para>Can throw codec_fatal_exception if failed to decompress the image.</para>
+	///</summary>
+	static ImageBuffer_Byte ReadJpegData(const uint8_t* data, size_t size, int min_height, int min_width, bool fast_dct, JpegHeaderInfo* headerPtr, WarningCallbackData warning_callback_data);
+
+	//--------------------------------
+	//	WRITING
+	//--------------------------------
+
+	///<summary>
+	///Static method. Compresses image and writes it to the file.
+	///Image is expected to be 8 bit grayscale or RGB.
+	///<para>Grayscale header gives grayscale file, YCbCr header gives 4:2:0 file,
+	///RGB header gives 4:4:4 YCbCr file since TurboJPEG always converts color images to YCbCr.</para>
+	///<para>Can throw std::ifstream::failure if failed to open file.</para>
+	///<para>Can throw codec_fatal_exception if failed to compress the image.</para>
+	///</summary>
+	///<param name="file_path">Path to the output file.</param>
+	///<param name="image">Image to write.</param>
+	///<param name="header">Jpeg header data. Should contain output colorspace.</param>
+	///<param name="quality">Jpeg codec compression quality setting. 1-100</param>
+	///<param name="fast_dct">Use fast integer forward DCT instead of accurate one.</param>
+	///<param name="warning_callback_data">Warning callback and its arguments. Both can be set to NULL inside the structure.</param>
+	static void WriteJpegFile(std::filesystem::path file_path, const ImageBuffer_Byte& image, JpegHeaderInfo header, int quality, bool fast_dct, WarningCallbackData warning_callback_data);
+
+	TurboJpegCodec() = delete;
+
+private:
+	//--------------------------------
+	//	THREAD DATA
+	//--------------------------------
+
+	///<summary>
+	///TurboJPEG handles and buffers reused by all calls made from one thread.
+	///</summary>
+	struct ThreadContext {
+		tjhandle decompressor = NULL;
+		tjhandle compressor = NULL;
+		///<summary>Contents of the last read file.</summary>
+		std::vector<uint8_t> file_data;
+		///<summary>Contiguous interleaved pixels.</summary>
+		std::vector<uint8_t> pixels;
+		///<summary>Compressed data buffer allocated by TurboJPEG, grown on demand.</summary>
+		unsigned char* jpeg_buffer = NULL;
+		///<summary>Size of the last image compressed to jpeg_buffer as reported by TurboJPEG. Not the buffer capacity.</summary>
+		unsigned long jpeg_data_size = 0;
+
+		~ThreadContext() {
+			if (decompressor != NULL)
+				tjDestroy(decompressor);
+			if (compressor != NULL)
+				tjDestroy(compressor);
+			if (jpeg_buffer != NULL)
+				tjFree(jpeg_buffer);
+		}
+	};
+
+	///<summary>
+	///Context of the calling thread. Handles are created on first use.
+	///</summary>
+	static ThreadContext& GetThreadContext();
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Reports TurboJPEG error of the handle. Warnings go to the callback, errors are thrown as codec_fatal_exception.
+	///</summary>
+	static void HandleError(tjhandle handle, CodecExceptions error, WarningCallbackData& warning_callback_data);
+
+	///<summary>
+	///Translates TurboJPEG colorspace to libjpeg colorspace.
+	///</summary>
+	static J_COLOR_SPACE TurboColorSpaceToJpeg(int tj_color_space);
+};
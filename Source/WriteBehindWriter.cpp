@@ -0,0 +1,173 @@
+#include "WriteBehindWriter.h"
+
+//--------------------------------
+//	PUBLIC METHODS
+//--------------------------------
+
+///<summary>
+///Queues copy of the given block of rows for writing. View rows are copied, since they can change after the call.
+///Advances NextRow by the height of given image.
+///If number of lines in the provided image is bigger than number of rows left writes what is possible.
+///<para>Blocks while the queue is full.</para>
+///<para>Rethrows exception thrown by the target writer.</para>
+///</summary>
+void WriteBehindWriter::WriteNextRows(const ImageBufferView_Byte& image) {
+	WriteNextRows(ImageBuffer_Byte::BuildByCopying(image));
+}
+
+
+
+///<summary>
+///Moves given block of rows into the queue for writing.
+///Advances NextRow by the height of given image.
+///If number of lines in the provided image is bigger than number of rows left writes what is possible.
+///<para>Blocks while the queue is full.</para>
+///<para>Rethrows exception thrown by the target writer.</para>
+///</summary>
+void WriteBehindWriter::WriteNextRows(ImageBuffer_Byte&& image) {
+	//Writer has finished or failed - nothing to do
+	if (_state == WriterStates::Finished || _state == WriterStates::Failed)
+		return;
+
+	if (image.GetHeight() <= 0 || !image.IsAllocated())
+		return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_slot_free.wait(lock, [this] { return _target_exception || static_cast<int>(_slices.size()) < _queue_depth; });
+
+	if (_target_exception) {
+		_state = WriterStates::Failed;
+		std::rethrow_exception(_target_exception);
+	}
+
+	//Target writer will cut the excess rows by itself, we only track the counter
+	AdvanceRows(image.GetHeight());
+	if (_state == WriterStates::Ready_Start)
+		_state = WriterStates::Ready_Continue;
+
+	_slices.push_back(std::move(image));
+	lock.unlock();
+	_slice_ready.notify_one();
+}
+
+
+
+///<summary>
+///Waits until all queued slices are written and stops encode thread.
+///<para>Rethrows exception thrown by the target writer.</para>
+///</summary>
+void WriteBehindWriter::Finish() {
+	StopEncodeThread();
+
+	if (_target_exception) {
+		_state = WriterStates::Failed;
+		std::rethrow_exception(_target_exception);
+	}
+}
+
+
+
+//--------------------------------
+//	PUBLIC CONSTRUCTORS
+//--------------------------------
+
+///<summary>
+///Wraps target writer and starts encode thread.
+///</summary>
+///<param name="target">Writer to write to in the background. Must be in initial state (no rows written).</param>
+///<param name="queue_depth">Maximum number of slices waiting for encoding.</param>
+WriteBehindWriter::WriteBehindWriter(ImageWriter& target, int queue_depth) :
+	ImageWriter(target.GetFilePath()),
+	_target(target),
+	_queue_depth(queue_depth) {
+
+	if (queue_depth <= 0)
+		throw std::invalid_argument("WriteBehindWriter -- queue depth must be positive.");
+	if (target.GetNextRowIndex() != 0)
+		throw std::invalid_argument("WriteBehindWriter -- target writer has already started writing.");
+
+	_image_info = target.GetCommonHeader();
+
+	//Nothing to write
+	if (target.IsFinished()) {
+		_state = WriterStates::Finished;
+		return;
+	}
+
+	_state = WriterStates::Ready_Start;
+	_encode_thread = std::thread(&WriteBehindWriter::EncodeLoop, this);
+}
+
+
+
+//--------------------------------
+//	DESTRUCTOR
+//--------------------------------
+
+///<summary>
+///Writes remaining queued slices and stops encode thread.
+///Exceptions of the target writer are not rethrown, call Finish to get them.
+///</summary>
+WriteBehindWriter::~WriteBehindWriter() {
+	StopEncodeThread();
+}
+
+
+
+//--------------------------------
+//	PRIVATE METHODS
+//--------------------------------
+
+///<summary>
+///Encode thread procedure.
+///</summary>
+void WriteBehindWriter::EncodeLoop() {
+	while (true) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_slice_ready.wait(lock, [this] { return !_slices.empty() || _input_closed; });
+
+		//Queue is drained and no more slices will come
+		if (_slices.empty())
+			return;
+
+		//Slice stays in the queue while it is encoded, so the queue depth accounts for it
+		ImageBuffer_Byte& slice = _slices.front();
+		lock.unlock();
+
+		try {
+			_target.WriteNextRows(slice);
+		}
+		catch (...) {
+			lock.lock();
+			_target_exception = std::current_exception();
+			_slices.clear();
+			lock.unlock();
+			_slot_free.notify_all();
+			return;
+		}
+
+		lock.lock();
+		_slices.pop_front();
+		lock.unlock();
+		_slot_free.notify_one();
+	}
+}
+
+
+
+///<summary>
+///Closes the queue and joins encode thread.
+///</summary>
+void WriteBehindWriter::StopEncodeThread() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_input_closed = true;
+	}
+	_slice_ready.notify_all();
+
+	if (_encode_thread.joinable())
+		_encode_thread.join();
+
+	if (_state != WriterStates::Failed)
+		_state = WriterStates::Finished;
+}
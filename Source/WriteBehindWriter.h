@@ -0,0 +1,151 @@
+#pragma once
+//STL
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+//Internal
+#include "ImageWriter.h"
+
+///<summary>
+///Asynchronous adaptor for any ImageWriter.
+///Slices given to WriteNextRows are put into a bounded queue
+///and encoded by the target writer on a dedicated thread, so encoding overlaps with processing of the next slice.
+///</summary>
+///<remarks>
+///Target writer is not owned by the adaptor and must outlive it.
+///Target writer must not be used directly while the adaptor exists.
+///
+///Slices passed as rvalue are moved into the queue, slices passed by const reference or as views are copied.
+///
+///Exceptions thrown by the target writer on the encode thread are rethrown
+///by the next call to WriteNextRows or by Finish.
+///</remarks>
+class WriteBehindWriter : public ImageWriter {
+
+public:
+	//--------------------------------
+	//	PUBLIC METHODS
+	//--------------------------------
+
+	///<summary>
+	///Queues copy of the given block of rows for writing. View rows are copied, since they can change after the call.
+	///Advances NextRow by the height of given image.
+	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
+	///<para>Blocks while the queue is full.</para>
+	///<para>Rethrows exception thrown by the target writer.</para>
+	///</summary>
+	void WriteNextRows(const ImageBufferView_Byte& image) override;
+
+	///<summary>
+	///Moves given block of rows into the queue for writing.
+	///Advances NextRow by the height of given image.
+	///If number of lines in the provided image is bigger than number of rows left writes what is possible.
+	///<para>Blocks while the queue is full.</para>
+	///<para>Rethrows exception thrown by the target writer.</para>
+	///</summary>
+	void WriteNextRows(ImageBuffer_Byte&& image);
+
+	///<summary>
+	///Waits until all queued slices are written and stops encode thread.
+	///<para>Rethrows exception thrown by the target writer.</para>
+	///</summary>
+	void Finish();
+
+	//--------------------------------
+	//	PUBLIC CONSTRUCTORS
+	//--------------------------------
+
+	///<summary>
+	///Wraps target writer and starts encode thread.
+	///</summary>
+	///<param name="target">Writer to write to in the background. Must be in initial state (no rows written).</param>
+	///<param name="queue_depth">Maximum number of slices waiting for encoding.</param>
+	WriteBehindWriter(ImageWriter& target, int queue_depth);
+
+	//--------------------------------
+	//	DELETED COPY/MOVE
+	//--------------------------------
+
+	WriteBehindWriter(const WriteBehindWriter& other) = delete;
+	WriteBehindWriter& operator=(const WriteBehindWriter& other) = delete;
+	WriteBehindWriter(WriteBehindWriter&& other) = delete;
+	WriteBehindWriter& operator=(WriteBehindWriter&& other) = delete;
+
+	//--------------------------------
+	//	DESTRUCTOR
+	//--------------------------------
+
+	///<summary>
+	///Writes remaining queued slices and stops encode thread.
+	///Exceptions of the target writer are not rethrown, call Finish to get them.
+	///</summary>
+	~WriteBehindWriter();
+
+private:
+
+	//--------------------------------
+	//	PRIVATE DATA
+	//--------------------------------
+
+	///<summary>
+	///Writer used by the encode thread.
+	///</summary>
+	ImageWriter& _target;
+
+	///<summary>
+	///Maximum number of slices waiting for encoding.
+	///</summary>
+	int _queue_depth;
+
+	///<summary>
+	///Slices waiting for encoding.
+	///</summary>
+	std::deque<ImageBuffer_Byte> _slices;
+
+	///<summary>
+	///Set when no more slices will be queued.
+	///</summary>
+	bool _input_closed = false;
+
+	///<summary>
+	///Exception thrown by the target writer on the encode thread.
+	///</summary>
+	std::exception_ptr _target_exception;
+
+	///<summary>
+	///Guards queue and flags.
+	///</summary>
+	std::mutex _mutex;
+
+	///<summary>
+	///Signalled when slice is added to the queue or input is closed.
+	///</summary>
+	std::condition_variable _slice_ready;
+
+	///<summary>
+	///Signalled when slice is taken from the queue or target writer has failed.
+	///</summary>
+	std::condition_variable _slot_free;
+
+	///<summary>
+	///Encode thread.
+	///</summary>
+	std::thread _encode_thread;
+
+	//--------------------------------
+	//	PRIVATE METHODS
+	//--------------------------------
+
+	///<summary>
+	///Encode thread procedure.
+	///</summary>
+	void EncodeLoop();
+
+	///<summary>
+	///Closes the queue and joins encode thread.
+	///</summary>
+	void StopEncodeThread();
+};